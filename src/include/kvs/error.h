@@ -155,6 +155,7 @@ extern "C" {
 #define STATUS_INVALID_TIMER_COUNT_VALUE   STATUS_TIMER_QUEUE_BASE + 0x00000002
 #define STATUS_INVALID_TIMER_PERIOD_VALUE  STATUS_TIMER_QUEUE_BASE + 0x00000003
 #define STATUS_MAX_TIMER_COUNT_REACHED     STATUS_TIMER_QUEUE_BASE + 0x00000004
+#define STATUS_TIMER_QUEUE_SHUTDOWN        STATUS_TIMER_QUEUE_BASE + 0x00000005
 /******************************************************************************
  * Semaphore error codes
  ******************************************************************************/
@@ -367,6 +368,8 @@ extern "C" {
 #define STATUS_RTP_NULL_ARG               STATUS_RTP_BASE + 0x00000005
 #define STATUS_RTP_BUFFER_TOO_SMALL       STATUS_RTP_BASE + 0x00000006
 #define STATUS_RTP_NOT_ENOUGH_MEMORY      STATUS_RTP_BASE + 0x00000007
+#define STATUS_RTP_INVALID_ENCODING       STATUS_RTP_BASE + 0x00000008
+#define STATUS_RTP_EXTENSION_NOT_FOUND    STATUS_RTP_BASE + 0x00000009
 /******************************************************************************
  * Signaling error codes
  ******************************************************************************/
@@ -36,6 +36,23 @@ extern "C" {
 #define WSS_DISPATCH_THREAD_SIZE  10240
 #define PEER_TIMER_NAME           "peerTimer"
 #define PEER_TIMER_SIZE           10240
+#ifndef PEER_TIMER_COUNT //!< the most timers of all the peer connections together, which share the peer timer thread.
+#ifdef KVS_PLAT_ESP_FREERTOS
+#define PEER_TIMER_COUNT 64
+#else
+#define PEER_TIMER_COUNT 1024
+#endif
+#endif
+// PEER_TIMER_COUNT / PEER_TIMER_COUNT_PER_PEER peer connections share the peer timer thread, the ones created while it is
+// full run a timer thread of their own.
+#ifndef PEER_TIMER_COUNT_PER_PEER //!< the timers set aside for every peer connection, on the peer timer thread or its own.
+#define PEER_TIMER_COUNT_PER_PEER 16
+#endif
+#define SRTP_DECRYPT_THREAD_NAME  "srtpDecrypt" //!< the parameters of the srtp decrypt workers, which run the receive path.
+#define SRTP_DECRYPT_THREAD_SIZE  8192
+#define FRAME_RELEASE_THREAD_NAME "frameRelease" //!< the parameters of the thread of a peer connection which hands held frames out.
+#define FRAME_RELEASE_THREAD_SIZE 8192
+#define RTC_RUNTIME_THREAD_NAME   "rtcWorker" //!< the name of the runtime workers, which run the timers of their peer connections.
 
 // Tag for the logging
 #ifndef LOG_CLASS
@@ -360,6 +360,10 @@ typedef struct {
     UINT64 bytesDiscardedOnSend;     //!< Total number of bytes for this SSRC that have been discarded due to socket errors
     UINT64 retransmittedPacketsSent; //!< The total number of packets that were retransmitted for this SSRC
     UINT64 retransmittedBytesSent;   //!< The total number of PAYLOAD bytes retransmitted for this SSRC
+    UINT64 retransmissionsSuppressed;   //!< Non-standard. Number of NACKed packets not resent because they were resent within the last round trip
+    UINT64 retransmissionsRateLimited;  //!< Non-standard. Number of NACKed packets not resent because the retransmission budget was exhausted
+    UINT64 nackHistoryMisses;           //!< Non-standard. Number of NACKed packets not resent because they were no longer kept for retransmission
+    UINT64 retransmissionsFailed;       //!< Non-standard. Number of NACKed packets kept for retransmission which could not be read back or sent
     UINT64 targetBitrate;            //!< Current target TIAS bitrate configured for this particular SSRC
     UINT64 totalEncodedBytesTarget;  //!< Increased by the target frame size in bytes every time a frame has been encoded
     DOUBLE framesPerSecond;          //!< Only valid for video. The number of encoded frames during the last second
@@ -387,6 +391,9 @@ typedef struct {
     DOUBLE fractionLost;              //!< The fraction packet loss reported for this SSRC
     UINT64 reportsReceived;           //!< Total number of RTCP RR blocks received for this SSRC
     UINT64 roundTripTimeMeasurements; //!< Total number of RTCP RR blocks received for this SSRC that contain a valid round trip time
+    UINT32 ssrc;                      //!< The SSRC the remote endpoint reported on, the primary or a simulcast ssrc of the sender
+    INT64 packetsLost;                //!< Total number of packets of this SSRC reported lost by the remote endpoint, may be negative
+    DOUBLE jitter;                    //!< Packet jitter (seconds) measured by the remote endpoint for this SSRC
 } RtcRemoteInboundRtpStreamStats, *PRtcRemoteInboundRtpStreamStats;
 
 typedef struct {
@@ -491,14 +498,16 @@ typedef struct {
     //!< packets can be calculated by adding packetsDuplicated to packetsLost; this will always result in a positive number,
     //!< but not the same number as RFC 3550 would calculate.
 
-    UINT32 nackCount; //!< TODO Count the total number of Negative ACKnowledgement (NACK) packets sent by this receiver.
-    UINT32 firCount;  //!< TODO Only valid for video. Count the total number of Full Intra Request (FIR) packets sent by this receiver.
-    UINT32 pliCount;  //!< TODO Only valid for video. Count the total number of Picture Loss Indication (PLI) packets sent by this receiver.
+    UINT32 nackCount; //!< Count the total number of Negative ACKnowledgement (NACK) packets sent by this receiver.
+    UINT32 firCount;  //!< Only valid for video. Count the total number of Full Intra Request (FIR) packets sent by this receiver.
+    UINT32 pliCount;  //!< Only valid for video. Count the total number of Picture Loss Indication (PLI) packets sent by this receiver.
     UINT32 sliCount;  //!< TODO Only valid for video. Count the total number of Slice Loss Indication (SLI) packets sent by this receiver.
     DOMHighResTimeStamp estimatedPlayoutTimestamp; //!< TODO This is the estimated playout time of this receiver's track.
-    DOUBLE jitterBufferDelay; //!< TODO It is the sum of the time, in seconds, each audio sample or video frame takes from the time it is received and
+    DOUBLE jitterBufferDelay; //!< It is the sum of the time, in seconds, each audio sample or video frame takes from the time it is received and
                               //!< to the time it exits the jitter buffer.
-    UINT64 jitterBufferEmittedCount; //!< TODO The total number of audio samples or video frames that have come out of the jitter buffer (increasing
+    DOUBLE jitterBufferTargetDelay;  //!< The sum of the target delay, in seconds, of the jitter buffer each time a frame is emitted. Only grows
+                                     //!< when KvsRtcConfiguration.enableAdaptiveJitterBuffer is set.
+    UINT64 jitterBufferEmittedCount; //!< The total number of audio samples or video frames that have come out of the jitter buffer (increasing
                                      //!< jitterBufferDelay).
     UINT64 totalSamplesReceived; //!< TODO Only valid for audio. The total number of samples that have been received on this RTP stream. This includes
                                  //!< concealedSamples.
@@ -580,6 +589,18 @@ typedef struct {
     UINT32 numberOfReconnects;       //!< Number of reconnects in the session
 } SignalingClientStats, PSignalingClientStats;
 
+/**
+ * @brief Key frame requests of all the transceivers sharing a media source
+ *
+ * NOTE: RtcKeyFrameRequestStats is a KVS specific struct
+ */
+typedef struct {
+    UINT64 keyFrameRequestsReceived;  //!< Number of PLI, FIR and local key frame requests from the transceivers of the source
+    UINT64 keyFrameRequestsCoalesced; //!< Number of requests merged into a request already made within the minimum key frame interval
+    UINT64 keyFrameRequestsSatisfied; //!< Number of times merged requests were answered by a key frame written before the end of the interval
+    UINT64 keyFrameRequestsFired;     //!< Number of times the RtcOnPictureLoss callback of the source was fired
+} RtcKeyFrameRequestStats, *PRtcKeyFrameRequestStats;
+
 /**
  * @brief RTCStatsObject Represents an object passed in by the application developer which will
  * be populated internally
@@ -114,6 +114,16 @@ extern "C" {
  */
 #define MAX_MEDIA_STREAM_ID_LEN 64
 
+/**
+ * Maximum number of simulcast encodings a single RtcRtpTransceiver can send
+ */
+#define MAX_RTP_SEND_ENCODINGS 3
+
+/**
+ * Maximum length of an RTP stream id (RID) used to identify a simulcast encoding
+ */
+#define MAX_RTP_RID_LEN 16
+
 /**
  * Max certificates an RtcConfiguration can accept
  */
@@ -283,6 +293,16 @@ extern "C" {
  * Default jitter buffer tolerated latency, frame will be dropped if it is out of window
  */
 #define DEFAULT_JITTER_BUFFER_MAX_LATENCY (2000L * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+/**
+ * Default minimum interval between two key frame requests of a media source
+ */
+#define DEFAULT_MIN_KEY_FRAME_REQUEST_INTERVAL (500L * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+/**
+ * Maximum number of worker threads of a runtime
+ */
+#define MAX_RTC_RUNTIME_WORKER_COUNT 16
 /*!@} */
 
 /**
@@ -620,11 +640,45 @@ typedef enum {
  * @brief RtcOnFrame is fired everytime a frame is received from
  * the remote peer. It is available via the RtpRec
  *
+ * It is fired on the thread receiving the packets, or, when the jitter buffer holds frames for an adaptive delay or for
+ * playout sync, on a frame release thread of the peer connection. A slow callback delays the frames of its own peer
+ * connection only.
+ *
  * NOTE: RtcOnFrame is a KVS specific method
  * @{
  */
 typedef VOID (*RtcOnFrame)(UINT64, PFrame);
 
+/**
+ * @brief One contiguous piece of a received frame, pointing into the packet it was carried in.
+ */
+typedef struct {
+    PBYTE pData; //!< Start of the piece, owned by the SDK
+    UINT32 size; //!< Length of the piece in bytes
+} RtcFrameSlice, *PRtcFrameSlice;
+
+/**
+ * @brief A received frame handed out as a list of slices instead of one contiguous copy. The slices stay valid until
+ * the frame is given back with rtp_transceiver_releaseSlicedFrame.
+ */
+typedef struct {
+    UINT32 index;           //!< Index of the frame, same as Frame.index
+    UINT64 decodingTs;      //!< Decoding timestamp in 100ns
+    UINT64 presentationTs;  //!< Presentation timestamp in 100ns
+    UINT32 size;            //!< Sum of the sizes of all the slices
+    UINT32 sliceCount;      //!< Number of entries in pSlices
+    PRtcFrameSlice pSlices; //!< The frame payload in order, concatenating them gives the same data as RtcOnFrame
+} RtcSlicedFrame, *PRtcSlicedFrame;
+
+/**
+ * @brief RtcOnSlicedFrame is fired instead of RtcOnFrame everytime a frame is received from the remote peer once it is
+ * set, the frame is not copied into a contiguous buffer. Each frame must be given back with
+ * rtp_transceiver_releaseSlicedFrame, from any thread. It is fired on the same threads as RtcOnFrame.
+ *
+ * NOTE: RtcOnSlicedFrame is a KVS specific method
+ */
+typedef VOID (*RtcOnSlicedFrame)(UINT64, PRtcSlicedFrame);
+
 /**
  * @brief RtcOnBandwidthEstimation is fired everytime a bandwidth estimation value
  * is computed. This will be fired for sender or receiver side estimation
@@ -717,6 +771,44 @@ typedef struct {
     UINT32 version; //!< Version of peer connection structure
 } RtcPeerConnection, *PRtcPeerConnection;
 
+/**
+ * @brief RtcMediaSource is shared by the transceivers that send the output of the same encoder,
+ * e.g. one camera streamed to several viewers. Key frame requests of all of them are merged.
+ *
+ * NOTE: RtcMediaSource is a KVS specific struct
+ */
+typedef struct {
+    UINT32 version; //!< Version of media source structure
+} RtcMediaSource, *PRtcMediaSource;
+
+/**
+ * @brief RtcRuntime owns a fixed set of worker threads which run the timers of the peer connections created with it.
+ * A peer connection is given one of the workers when it is created and keeps it, its ICE listener runs on the cpu of
+ * that worker.
+ *
+ * NOTE: RtcRuntime is a KVS specific struct
+ */
+typedef struct {
+    UINT32 version; //!< Version of runtime structure
+} RtcRuntime, *PRtcRuntime;
+
+/**
+ * @brief The configuration of an RtcRuntime
+ *
+ * NOTE: RtcRuntimeConfiguration is a KVS specific struct
+ */
+typedef struct {
+    UINT32 workerCount; //!< Number of worker threads, at most MAX_RTC_RUNTIME_WORKER_COUNT
+
+    UINT32 workerStackSize; //!< Stack size of the worker threads. Uses the stack size of the peer timer thread if 0
+
+    UINT32 maxTimerCountPerWorker; //!< The most timers a worker runs at once, PEER_TIMER_COUNT_PER_PEER per peer. Uses PEER_TIMER_COUNT if 0
+
+    BOOL pinWorkers; //!< Pin each worker thread to the cpu at the same index of workerCpus
+
+    UINT32 workerCpus[MAX_RTC_RUNTIME_WORKER_COUNT]; //!< The cpu of each worker thread, only used if pinWorkers is TRUE
+} RtcRuntimeConfiguration, *PRtcRuntimeConfiguration;
+
 /**
  * @brief Represents a single track in a MediaStream
  *
@@ -825,6 +917,28 @@ typedef struct {
 
     IceSetInterfaceFilterFunc iceSetInterfaceFilterFunc; //!< Filter function callback to be set when the developer
                                                          //!< would like to whitelist/blacklist specific network interfaces
+
+    //!< Hold received frames to a target delay adapted to the measured network jitter instead of delivering them as soon
+    //!< as they are complete. Smooths the playout at the cost of latency, see jitterBufferTargetDelay in the inbound stats.
+    BOOL enableAdaptiveJitterBuffer;
+
+    //!< Synchronize the playout of the first received audio and video transceivers with the RTCP sender reports. The stream
+    //!< which is ready sooner is held for the other one, and the frames of both carry the capture time on the wall clock
+    //!< of the remote sender as presentationTs.
+    BOOL enablePlayoutSync;
+
+    //!< Decrypt the received rtp packets on that many worker threads instead of the thread which receives them, for
+    //!< streams whose bitrate is more than a core can decrypt. The packets are handed on in the order they were received,
+    //!< on the worker threads. Decrypting on the receiving thread if 0.
+    UINT32 srtpDecryptWorkerCount;
+
+    //!< The most bytes the senders keep together for retransmission, shared among them by the bit rate expected for their kind
+    //!< of media. A packet is kept for a few round trip times at most. Uses a platform default if 0.
+    UINT32 maxRetransmissionHistoryBytes;
+
+    //!< Run the timers of the peer connection on one of the workers of this runtime, and pin its ICE listener thread to
+    //!< the cpu of that worker. The timers of all the peer connections share one thread if NULL.
+    PRtcRuntime pRuntime;
 } KvsRtcConfiguration, *PKvsRtcConfiguration;
 
 /**
@@ -1082,6 +1196,17 @@ typedef struct {
     RTC_RTP_TRANSCEIVER_DIRECTION direction; //!< Transceiver direction - SENDONLY, RECVONLY, SENDRECV
 } RtcRtpTransceiverInit, *PRtcRtpTransceiverInit;
 
+/**
+ * @brief RtcRtpEncodingParameters describes one simulcast encoding sent by an RtcRtpTransceiver
+ *
+ * Each encoding is sent on its own SSRC and is tagged with its rid in the RTP stream id header extension
+ *
+ * Reference: https://www.w3.org/TR/webrtc/#dom-rtcrtpencodingparameters
+ */
+typedef struct {
+    CHAR rid[MAX_RTP_RID_LEN + 1]; //!< RTP stream id of this encoding. Must be alphanumeric and unique within the transceiver
+} RtcRtpEncodingParameters, *PRtcRtpEncodingParameters;
+
 /**
  * @brief RtcDataChannelInit dictionary used to configure properties of the
  * underlying channel such as data reliability
@@ -1396,6 +1521,27 @@ PUBLIC_API STATUS pc_addTransceiver(PRtcPeerConnection, PRtcMediaStreamTrack, PR
  */
 STATUS rtp_transceiver_onFrame(PRtcRtpTransceiver pRtcRtpTransceiver, UINT64 customData, RtcOnFrame rtcOnFrame);
 
+/**
+ * @brief Set a callback receiving the frames of the transceiver as slices of the received packets, without copying
+ * them into a contiguous buffer. RtcOnFrame is not fired anymore once it is set.
+ *
+ * @param[in] pRtcRtpTransceiver Populated RtcRtpTransceiver struct
+ * @param[in] customData User customData that will be passed along when RtcOnSlicedFrame is called
+ * @param[in] rtcOnSlicedFrame User RtcOnSlicedFrame callback
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_transceiver_onSlicedFrame(PRtcRtpTransceiver, UINT64, RtcOnSlicedFrame);
+
+/**
+ * @brief Give back a frame received by RtcOnSlicedFrame, its slices must not be used afterwards
+ *
+ * @param[in] pRtcSlicedFrame The frame passed to RtcOnSlicedFrame
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_transceiver_releaseSlicedFrame(PRtcSlicedFrame);
+
 /**
  * @brief Set a callback for bandwidth estimation results
  *
@@ -1418,6 +1564,76 @@ PUBLIC_API STATUS rtp_transceiver_onBandwidthEstimation(PRtcRtpTransceiver, UINT
  */
 PUBLIC_API STATUS rtp_transceiver_onPictureLoss(PRtcRtpTransceiver, UINT64, RtcOnPictureLoss);
 
+/**
+ * @brief Create a media source that merges the key frame requests of the transceivers attached to it.
+ *
+ * The callback fires at most once per minimum interval. Requests arriving within the interval are
+ * merged and fired at its end unless a key frame was written to one of the transceivers meanwhile.
+ *
+ * NOTE: The media source must outlive the peer connections of the transceivers attached to it.
+ *
+ * @param[in] UINT64 Minimum interval between two key frame requests in 100ns, DEFAULT_MIN_KEY_FRAME_REQUEST_INTERVAL is recommended
+ * @param[in] UINT64 User customData that will be passed along when RtcOnPictureLoss is called
+ * @param[in] RtcOnPictureLoss User RtcOnPictureLoss callback
+ * @param[out] PRtcMediaSource* Created media source
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS media_source_create(UINT64, UINT64, RtcOnPictureLoss, PRtcMediaSource*);
+
+/**
+ * @brief Free a media source created with media_source_create
+ *
+ * @param[in,out] PRtcMediaSource* Media source to free, set to NULL
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS media_source_free(PRtcMediaSource*);
+
+/**
+ * @brief Get the key frame request stats of a media source
+ *
+ * @param[in] PRtcMediaSource Media source
+ * @param[out] PRtcKeyFrameRequestStats Stats of the key frame requests of the source
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS media_source_getKeyFrameRequestStats(PRtcMediaSource, PRtcKeyFrameRequestStats);
+
+/**
+ * @brief Attach a transceiver to a media source. Its PLI and FIR then fire the callback of the
+ * media source instead of the RtcOnPictureLoss callback of the transceiver.
+ *
+ * @param[in] PRtcRtpTransceiver Populated RtcRtpTransceiver struct
+ * @param[in] PRtcMediaSource Media source, NULL to detach
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_transceiver_setMediaSource(PRtcRtpTransceiver, PRtcMediaSource);
+
+/**
+ * @brief Create a runtime whose worker threads run the timers of the peer connections configured with it.
+ *
+ * The peer connections are spread over the workers in the order they are created.
+ *
+ * NOTE: A peer connection keeps its worker running until it is freed, the runtime may be freed before it.
+ *
+ * @param[in] PRtcRuntimeConfiguration Configuration of the runtime
+ * @param[out] PRtcRuntime* Created runtime
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtc_runtime_create(PRtcRuntimeConfiguration, PRtcRuntime*);
+
+/**
+ * @brief Free a runtime created with rtc_runtime_create
+ *
+ * @param[in,out] PRtcRuntime* Runtime to free, set to NULL
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtc_runtime_free(PRtcRuntime*);
+
 /**
  * @brief Frees the previously created transceiver object
  *
@@ -1466,6 +1682,59 @@ PUBLIC_API STATUS pc_addSupportedCodec(PRtcPeerConnection, RTC_CODEC);
  */
 PUBLIC_API STATUS rtp_writeFrame(PRtcRtpTransceiver, PFrame);
 
+/**
+ * @brief Configures the simulcast encodings sent by a video RtcRtpTransceiver
+ *
+ * NOTE: Must be called before the offer or answer is created. Encoding 0 keeps the SSRC the transceiver
+ * was created with, every other encoding is allocated its own SSRC and RTX SSRC.
+ *
+ * Reference: https://www.w3.org/TR/webrtc/#dom-rtcrtptransceiverinit-sendencodings
+ *
+ * @param[in] PRtcRtpTransceiver Video RtcRtpTransceiver created with a send direction
+ * @param[in] PRtcRtpEncodingParameters Array of encodings, ordered from the highest to the lowest quality
+ * @param[in] UINT32 Number of encodings in the array, at most MAX_RTP_SEND_ENCODINGS
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_transceiver_setSendEncodings(PRtcRtpTransceiver, PRtcRtpEncodingParameters, UINT32);
+
+/**
+ * @brief Packetizes and sends media on a single simulcast encoding of the RtcRtpTransceiver
+ *
+ * rtp_writeFrame is equivalent to calling this function with encoding index 0.
+ * Frames written to an encoding the remote has not negotiated are silently discarded.
+ *
+ * @param[in] PRtcRtpTransceiver Configured and connected RtcRtpTransceiver to send media
+ * @param[in] UINT32 Index of the encoding as passed to rtp_transceiver_setSendEncodings
+ * @param[in] PFrame Frame of media that will be sent
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_writeSimulcastFrame(PRtcRtpTransceiver, UINT32, PFrame);
+
+/**
+ * @brief Get the outbound RTP stats of a single simulcast encoding
+ *
+ * @param[in] PRtcRtpTransceiver RtcRtpTransceiver the encoding belongs to
+ * @param[in] UINT32 Index of the encoding as passed to rtp_transceiver_setSendEncodings
+ * @param[in,out] PRtcOutboundRtpStreamStats Stats of the encoding, rid and ssrc identify the layer
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_transceiver_getSendEncodingStats(PRtcRtpTransceiver, UINT32, PRtcOutboundRtpStreamStats);
+
+/**
+ * @brief Get the remote inbound stats of one encoding of the sender, i.e. the round trip time, loss and jitter
+ *        the remote endpoint reported in its RTCP report blocks for the ssrc of the encoding.
+ *
+ * @param[in] PRtcRtpTransceiver RtcRtpTransceiver the encoding belongs to
+ * @param[in] UINT32 Index of the encoding as passed to rtp_transceiver_setSendEncodings
+ * @param[in,out] PRtcRemoteInboundRtpStreamStats Remote inbound stats of the encoding
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_transceiver_getSendEncodingRemoteInboundStats(PRtcRtpTransceiver, UINT32, PRtcRemoteInboundRtpStreamStats);
+
 /** @brief call this function to update stats which depend on external encoder
  *  @param[in] PRtcRtpTransceiver transceiver for which encoder stats will be updated
  *  @param[in] PRtcEncoderStats populated in the application layer which is then consumed as part
@@ -133,9 +133,8 @@ STATUS metrics_getRtpRemoteInboundStats(PRtcPeerConnection pRtcPeerConnection, P
     }
     // check if specified transceiver belongs to this connection
     CHK_STATUS(rtp_findTransceiverByssrc(pKvsPeerConnection, pKvsRtpTransceiver->sender.ssrc));
-    MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
-    *pRtcRemoteInboundRtpStreamStats = pKvsRtpTransceiver->remoteInboundStats;
-    MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+    rtp_transceiver_readStats(pKvsRtpTransceiver, &pKvsRtpTransceiver->remoteInboundStats, pRtcRemoteInboundRtpStreamStats,
+                              SIZEOF(RtcRemoteInboundRtpStreamStats));
 CleanUp:
 #endif
     return retStatus;
@@ -161,9 +160,7 @@ STATUS metrics_getRtpOutboundStats(PRtcPeerConnection pRtcPeerConnection, PRtcRt
 
     // check if specified transceiver belongs to this connection
     CHK_STATUS(rtp_findTransceiverByssrc(pKvsPeerConnection, pKvsRtpTransceiver->sender.ssrc));
-    MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
-    *pRtcOutboundRtpStreamStats = pKvsRtpTransceiver->outboundStats;
-    MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+    rtp_transceiver_readStats(pKvsRtpTransceiver, &pKvsRtpTransceiver->outboundStats, pRtcOutboundRtpStreamStats, SIZEOF(RtcOutboundRtpStreamStats));
 CleanUp:
 #endif
     return retStatus;
@@ -190,9 +187,7 @@ STATUS metrics_getRtpInboundStats(PRtcPeerConnection pRtcPeerConnection, PRtcRtp
     // check if specified transceiver belongs to this connection
     CHK_STATUS(rtp_findTransceiverByssrc(pKvsPeerConnection, pKvsRtpTransceiver->jitterBufferSsrc));
 
-    MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
-    *pRtcInboundRtpStreamStats = pKvsRtpTransceiver->inboundStats;
-    MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+    rtp_transceiver_readStats(pKvsRtpTransceiver, &pKvsRtpTransceiver->inboundStats, pRtcInboundRtpStreamStats, SIZEOF(RtcInboundRtpStreamStats));
 CleanUp:
 #endif
     return retStatus;
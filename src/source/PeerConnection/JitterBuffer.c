@@ -3,6 +3,144 @@
 
 #include "JitterBuffer.h"
 
+/**
+ * @brief the distance jitter_buffer_pop walks from lastRemovedSequenceNumber to reach the sequence number.
+ */
+static UINT16 jitter_buffer_getDistance(PJitterBuffer pJitterBuffer, UINT16 seqNum)
+{
+    return (UINT16)(seqNum - pJitterBuffer->lastRemovedSequenceNumber);
+}
+
+static PRtpPacket jitter_buffer_getRingPacket(PJitterBuffer pJitterBuffer, UINT16 seqNum)
+{
+    PRtpPacket pRtpPacket = pJitterBuffer->pPacketRing[JITTER_BUFFER_RING_INDEX(pJitterBuffer, seqNum)];
+
+    // the slot may still hold a packet 'ringSize * n' sequence numbers away.
+    if (pRtpPacket != NULL && pRtpPacket->header.sequenceNumber != seqNum) {
+        pRtpPacket = NULL;
+    }
+
+    return pRtpPacket;
+}
+
+/**
+ * @brief rescan the ring for the tail once lastRemovedSequenceNumber no longer moves in order.
+ */
+static VOID jitter_buffer_findTail(PJitterBuffer pJitterBuffer)
+{
+    UINT32 i;
+    UINT16 distance, maxDistance = 0;
+    BOOL found = FALSE;
+    PRtpPacket pCurPacket = NULL;
+
+    for (i = 0; i < pJitterBuffer->ringSize; i++) {
+        pCurPacket = pJitterBuffer->pPacketRing[i];
+        if (pCurPacket != NULL) {
+            distance = jitter_buffer_getDistance(pJitterBuffer, pCurPacket->header.sequenceNumber);
+            if (!found || distance > maxDistance) {
+                maxDistance = distance;
+                pJitterBuffer->tailSequenceNumber = pCurPacket->header.sequenceNumber;
+                found = TRUE;
+            }
+        }
+    }
+}
+
+/**
+ * @brief convert a wall clock time to the rtp clock without overflowing the 64 bit multiplication.
+ */
+static UINT32 jitter_buffer_toClockRate(PJitterBuffer pJitterBuffer, UINT64 time)
+{
+    return (UINT32)((time / HUNDREDS_OF_NANOS_IN_A_SECOND) * pJitterBuffer->clockRate +
+                    (time % HUNDREDS_OF_NANOS_IN_A_SECOND) * pJitterBuffer->clockRate / HUNDREDS_OF_NANOS_IN_A_SECOND);
+}
+
+/**
+ * @brief the smallest power of two ring holding the packets of maxLatency, in clockRate units, at the highest expected packet rate.
+ */
+static UINT32 jitter_buffer_getRingSize(UINT64 maxLatency, UINT32 clockRate)
+{
+    UINT64 packetRate = clockRate >= JITTER_BUFFER_VIDEO_CLOCK_RATE ? JITTER_BUFFER_MAX_VIDEO_PACKET_RATE : JITTER_BUFFER_MAX_AUDIO_PACKET_RATE;
+    UINT64 packetCount = maxLatency * packetRate / clockRate + 1;
+    UINT32 ringSize = JITTER_BUFFER_RING_MIN_SIZE;
+
+    while (ringSize < JITTER_BUFFER_RING_MAX_SIZE && ringSize < packetCount) {
+        ringSize <<= 1;
+    }
+
+    return ringSize;
+}
+
+/**
+ * @brief account the delay of a pushed packet and update the target delay to the percentile of the histogram. Only the
+ *        fastest packet is tracked when the adaptive mode is off, for the extra delay.
+ */
+static VOID jitter_buffer_updateDelayEstimate(PJitterBuffer pJitterBuffer, PRtpPacket pRtpPacket)
+{
+    PJitterBufferDelayEstimator pEstimator = &pJitterBuffer->delayEstimator;
+    UINT32 arrival, transit, delay, bucket, i;
+    UINT64 total = 0, sum = 0;
+
+    arrival = jitter_buffer_toClockRate(pJitterBuffer, pRtpPacket->receivedTime);
+    transit = arrival - pRtpPacket->header.timestamp;
+    // a release check may already have looked past a packet which was queued before it was pushed
+    if (!pEstimator->started || (INT32)(arrival - pEstimator->now) > 0) {
+        pEstimator->now = arrival;
+    }
+    if (!pEstimator->started) {
+        pEstimator->started = TRUE;
+        pEstimator->baseTransit = transit;
+        pEstimator->windowMinTransit = transit;
+        pEstimator->windowStartTime = pRtpPacket->receivedTime;
+    }
+
+    // the base moves to the fastest packet of the last window, or right away to a faster one
+    if ((INT32)(transit - pEstimator->windowMinTransit) < 0) {
+        pEstimator->windowMinTransit = transit;
+    }
+    if (pRtpPacket->receivedTime - pEstimator->windowStartTime >= JITTER_BUFFER_DELAY_BASE_WINDOW) {
+        pEstimator->baseTransit = pEstimator->windowMinTransit;
+        pEstimator->windowMinTransit = transit;
+        pEstimator->windowStartTime = pRtpPacket->receivedTime;
+    }
+    if ((INT32)(transit - pEstimator->baseTransit) < 0) {
+        pEstimator->baseTransit = transit;
+    }
+
+    if (!pEstimator->enabled) {
+        return;
+    }
+
+    delay = transit - pEstimator->baseTransit;
+    bucket = MIN(delay / pEstimator->bucketWidth, JITTER_BUFFER_DELAY_BUCKET_COUNT - 1);
+    for (i = 0; i < JITTER_BUFFER_DELAY_BUCKET_COUNT; i++) {
+        pEstimator->histogram[i] -= pEstimator->histogram[i] >> JITTER_BUFFER_DELAY_FORGET_SHIFT;
+        total += pEstimator->histogram[i];
+    }
+    pEstimator->histogram[bucket] += JITTER_BUFFER_DELAY_SAMPLE_WEIGHT;
+    total += JITTER_BUFFER_DELAY_SAMPLE_WEIGHT;
+
+    // the upper edge of the bucket the percentile falls into
+    for (i = 0; i < JITTER_BUFFER_DELAY_BUCKET_COUNT - 1; i++) {
+        sum += pEstimator->histogram[i];
+        if (sum * 100 >= total * JITTER_BUFFER_DELAY_PERCENTILE) {
+            break;
+        }
+    }
+    pEstimator->targetDelay = MIN((i + 1) * pEstimator->bucketWidth, (UINT32) pJitterBuffer->maxLatency);
+}
+
+/**
+ * @brief whether the frame of the timestamp has been held for the target and extra delay, as of the last packet or release check.
+ */
+static BOOL jitter_buffer_isFrameDue(PJitterBuffer pJitterBuffer, UINT32 timestamp)
+{
+    PJitterBufferDelayEstimator pEstimator = &pJitterBuffer->delayEstimator;
+
+    return (!pEstimator->enabled && pEstimator->extraDelay == 0) || !pEstimator->started ||
+        (INT32)(pEstimator->now - timestamp - pEstimator->baseTransit) >= (INT32)(pEstimator->targetDelay + pEstimator->extraDelay);
+}
+
 STATUS jitter_buffer_create(FrameReadyFunc onFrameReadyFunc, FrameDroppedFunc onFrameDroppedFunc, DepayRtpPayloadFunc depayRtpPayloadFunc,
                             UINT32 maxLatency, UINT32 clockRate, UINT64 customData, PJitterBuffer* ppJitterBuffer)
 {
@@ -13,7 +151,7 @@ STATUS jitter_buffer_create(FrameReadyFunc onFrameReadyFunc, FrameDroppedFunc on
     CHK(ppJitterBuffer != NULL && onFrameReadyFunc != NULL && onFrameDroppedFunc != NULL && depayRtpPayloadFunc != NULL, STATUS_NULL_ARG);
     CHK(clockRate != 0, STATUS_INVALID_ARG);
 
-    pJitterBuffer = (PJitterBuffer) MEMALLOC(SIZEOF(JitterBuffer));
+    pJitterBuffer = (PJitterBuffer) MEMCALLOC(1, SIZEOF(JitterBuffer));
     CHK(pJitterBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
 
     pJitterBuffer->onFrameReadyFn = onFrameReadyFunc;
@@ -26,15 +164,21 @@ STATUS jitter_buffer_create(FrameReadyFunc onFrameReadyFunc, FrameDroppedFunc on
         pJitterBuffer->maxLatency = DEFAULT_JITTER_BUFFER_MAX_LATENCY;
     }
     pJitterBuffer->maxLatency = pJitterBuffer->maxLatency * pJitterBuffer->clockRate / HUNDREDS_OF_NANOS_IN_A_SECOND;
+    pJitterBuffer->delayEstimator.bucketWidth =
+        MAX((UINT32)(JITTER_BUFFER_DELAY_BUCKET_WIDTH * pJitterBuffer->clockRate / HUNDREDS_OF_NANOS_IN_A_SECOND), 1);
 
     pJitterBuffer->lastPushTimestamp = 0;
     pJitterBuffer->lastPopTimestamp = MAX_UINT32;
     pJitterBuffer->lastRemovedSequenceNumber = MAX_SEQUENCE_NUM;
     pJitterBuffer->started = FALSE;
+    pJitterBuffer->tailSequenceNumber = MAX_SEQUENCE_NUM;
+    pJitterBuffer->packetCount = 0;
 
     pJitterBuffer->customData = customData;
-    CHK_STATUS(hash_table_createWithParams(JITTER_BUFFER_HASH_TABLE_BUCKET_COUNT, JITTER_BUFFER_HASH_TABLE_BUCKET_LENGTH,
-                                           &pJitterBuffer->pPkgBufferHashTable));
+    pJitterBuffer->ringSize = jitter_buffer_getRingSize(pJitterBuffer->maxLatency, pJitterBuffer->clockRate);
+    pJitterBuffer->ringMask = pJitterBuffer->ringSize - 1;
+    pJitterBuffer->pPacketRing = (PRtpPacket*) MEMCALLOC(pJitterBuffer->ringSize, SIZEOF(PRtpPacket));
+    CHK(pJitterBuffer->pPacketRing != NULL, STATUS_NOT_ENOUGH_MEMORY);
 
 CleanUp:
     if (STATUS_FAILED(retStatus) && pJitterBuffer != NULL) {
@@ -56,6 +200,7 @@ STATUS jitter_buffer_free(PJitterBuffer* ppJitterBuffer)
 
     STATUS retStatus = STATUS_SUCCESS;
     PJitterBuffer pJitterBuffer = NULL;
+    UINT32 i;
 
     CHK(ppJitterBuffer != NULL, STATUS_NULL_ARG);
     // jitter_buffer_free is idempotent
@@ -65,8 +210,13 @@ STATUS jitter_buffer_free(PJitterBuffer* ppJitterBuffer)
 
     jitter_buffer_pop(pJitterBuffer, TRUE);
     jitter_buffer_dropBufferData(pJitterBuffer, 0, MAX_SEQUENCE_NUM, 0);
-    hash_table_free(pJitterBuffer->pPkgBufferHashTable);
-    pJitterBuffer->pPkgBufferHashTable = NULL;
+    if (pJitterBuffer->pPacketRing != NULL) {
+        // release what is left behind lastRemovedSequenceNumber, pop never reaches it.
+        for (i = 0; i < pJitterBuffer->ringSize; i++) {
+            rtp_packet_free(&pJitterBuffer->pPacketRing[i]);
+        }
+        SAFE_MEMFREE(pJitterBuffer->pPacketRing);
+    }
 
     MEMFREE(*ppJitterBuffer);
 
@@ -80,11 +230,12 @@ CleanUp:
 STATUS jitter_buffer_push(PJitterBuffer pJitterBuffer, PRtpPacket pRtpPacket, PBOOL pPacketDiscarded)
 {
     ENTERS();
-    STATUS retStatus = STATUS_SUCCESS, status = STATUS_SUCCESS;
-    UINT64 hashValue = 0;
-    PRtpPacket pCurPacket = NULL;
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT16 seqNum;
+    PRtpPacket* pSlot = NULL;
 
     CHK(pJitterBuffer != NULL && pRtpPacket != NULL, STATUS_NULL_ARG);
+    seqNum = pRtpPacket->header.sequenceNumber;
 
     if (!pJitterBuffer->started ||
         (pJitterBuffer->lastPopTimestamp == pRtpPacket->header.sequenceNumber &&
@@ -92,6 +243,10 @@ STATUS jitter_buffer_push(PJitterBuffer pJitterBuffer, PRtpPacket pRtpPacket, PB
         // Set to started and initialize the sequence number
         pJitterBuffer->started = TRUE;
         pJitterBuffer->lastRemovedSequenceNumber = UINT16_DEC(pRtpPacket->header.sequenceNumber);
+        pJitterBuffer->assembly.valid = FALSE;
+        if (pJitterBuffer->packetCount > 0) {
+            jitter_buffer_findTail(pJitterBuffer);
+        }
     }
 
     if (pJitterBuffer->lastPushTimestamp < pRtpPacket->header.timestamp) {
@@ -100,17 +255,34 @@ STATUS jitter_buffer_push(PJitterBuffer pJitterBuffer, PRtpPacket pRtpPacket, PB
 
     if ((pRtpPacket->header.timestamp < pJitterBuffer->maxLatency && pJitterBuffer->lastPushTimestamp <= pJitterBuffer->maxLatency) ||
         pRtpPacket->header.timestamp >= pJitterBuffer->lastPushTimestamp - pJitterBuffer->maxLatency) {
-        // check the same sequence number is existed or not.
-        status = hash_table_get(pJitterBuffer->pPkgBufferHashTable, pRtpPacket->header.sequenceNumber, &hashValue);
-        pCurPacket = (PRtpPacket) hashValue;
-        // remove the old sequence number.
-        if (STATUS_SUCCEEDED(status) && pCurPacket != NULL) {
-            rtp_packet_free(&pCurPacket);
-            CHK_STATUS(hash_table_remove(pJitterBuffer->pPkgBufferHashTable, pRtpPacket->header.sequenceNumber));
+        pSlot = &pJitterBuffer->pPacketRing[JITTER_BUFFER_RING_INDEX(pJitterBuffer, seqNum)];
+        // remove the old packet of the same sequence number, or the stale one sharing its slot.
+        if (*pSlot != NULL) {
+            if ((*pSlot)->header.sequenceNumber != seqNum) {
+                DLOGW("Jitter buffer slot of seqNum %u is still held by seqNum %u, dropping it", seqNum, (*pSlot)->header.sequenceNumber);
+                pJitterBuffer->assembly.valid = FALSE;
+            }
+            rtp_packet_free(pSlot);
+            pJitterBuffer->packetCount--;
         }
         // push the new sequence number.
-        CHK_STATUS(hash_table_put(pJitterBuffer->pPkgBufferHashTable, pRtpPacket->header.sequenceNumber, (UINT64) pRtpPacket));
+        *pSlot = pRtpPacket;
+        pJitterBuffer->packetCount++;
+        if (pJitterBuffer->packetCount == 1 ||
+            jitter_buffer_getDistance(pJitterBuffer, seqNum) > jitter_buffer_getDistance(pJitterBuffer, pJitterBuffer->tailSequenceNumber)) {
+            pJitterBuffer->tailSequenceNumber = seqNum;
+        } else if (jitter_buffer_getRingPacket(pJitterBuffer, pJitterBuffer->tailSequenceNumber) == NULL) {
+            // the tail was the stale packet
+            jitter_buffer_findTail(pJitterBuffer);
+        }
+        // a late or duplicate packet in front of where assembly stopped changes what was already walked
+        if (jitter_buffer_getDistance(pJitterBuffer, seqNum) < jitter_buffer_getDistance(pJitterBuffer, pJitterBuffer->assembly.nextSequenceNumber)) {
+            pJitterBuffer->assembly.valid = FALSE;
+        }
         pJitterBuffer->lastPopTimestamp = MIN(pJitterBuffer->lastPopTimestamp, pRtpPacket->header.timestamp);
+        if (pJitterBuffer->delayEstimator.enabled || pJitterBuffer->delayEstimator.extraDelay != 0) {
+            jitter_buffer_updateDelayEstimate(pJitterBuffer, pRtpPacket);
+        }
         DLOGS("jitter_buffer_push get packet timestamp %lu seqNum %lu", pRtpPacket->header.timestamp, pRtpPacket->header.sequenceNumber);
     } else {
         // Free the packet if it is out of range, jitter buffer need to own the packet and do free
@@ -142,35 +314,48 @@ STATUS jitter_buffer_pop(PJitterBuffer pJitterBuffer, BOOL bufferClosed)
     UINT16 startDropIndex = 0;
     UINT32 curFrameSize = 0;
     UINT32 partialFrameSize = 0;
-    UINT64 hashValue = 0;
-    BOOL isStart = FALSE, containStartForEarliestFrame = FALSE, hasEntry = FALSE;
+    BOOL isStart = FALSE, containStartForEarliestFrame = FALSE, hasEntry = FALSE, resumable = FALSE;
     UINT16 lastNonNullIndex = 0;
     PRtpPacket pCurPacket = NULL;
+    PJitterBufferFrameAssembly pAssembly = NULL;
 
     CHK(pJitterBuffer != NULL && pJitterBuffer->onFrameDroppedFn != NULL && pJitterBuffer->onFrameReadyFn != NULL, STATUS_NULL_ARG);
     CHK(pJitterBuffer->lastPushTimestamp != 0, retStatus);
+    // nothing but holes to walk through
+    CHK(pJitterBuffer->packetCount > 0, retStatus);
 
     if (pJitterBuffer->lastPushTimestamp > pJitterBuffer->maxLatency) {
         earliestTimestamp = pJitterBuffer->lastPushTimestamp - pJitterBuffer->maxLatency;
     }
 
-    lastIndex = pJitterBuffer->lastRemovedSequenceNumber;
+    // Slots past the tail are all empty, stop there rather than walking the whole sequence number space.
+    lastIndex = pJitterBuffer->tailSequenceNumber + 1;
     index = pJitterBuffer->lastRemovedSequenceNumber + 1;
     startDropIndex = index;
+
+    // Pick up the earliest frame where the last pop left it. An expired frame or a closing buffer takes the decisions the
+    // last walk skipped, so they start over from lastRemovedSequenceNumber.
+    pAssembly = &pJitterBuffer->assembly;
+    if (pAssembly->valid && !bufferClosed && pAssembly->timestamp == pJitterBuffer->lastPopTimestamp &&
+        pJitterBuffer->lastPopTimestamp >= earliestTimestamp && pAssembly->firstSequenceNumber == index &&
+        jitter_buffer_getDistance(pJitterBuffer, pAssembly->nextSequenceNumber) <= jitter_buffer_getDistance(pJitterBuffer, lastIndex)) {
+        index = pAssembly->nextSequenceNumber;
+        lastNonNullIndex = pAssembly->lastSequenceNumber;
+        curFrameSize = pAssembly->frameSize;
+        containStartForEarliestFrame = pAssembly->startSeen;
+        isFrameDataContinuous = pAssembly->continuous;
+    }
+    pAssembly->valid = FALSE;
+    resumable = !bufferClosed;
+
     for (; index != lastIndex; index++) {
-        CHK_STATUS(hash_table_contains(pJitterBuffer->pPkgBufferHashTable, index, &hasEntry));
-        if (!hasEntry) {
-            isFrameDataContinuous = FALSE;
+        pCurPacket = jitter_buffer_getRingPacket(pJitterBuffer, index);
+        if (pCurPacket == NULL) {
+            // wait for the hole to be filled or the frame to expire
             CHK(pJitterBuffer->lastPopTimestamp < earliestTimestamp || bufferClosed, retStatus);
+            isFrameDataContinuous = FALSE;
         } else {
             lastNonNullIndex = index;
-            retStatus = hash_table_get(pJitterBuffer->pPkgBufferHashTable, index, &hashValue);
-            pCurPacket = (PRtpPacket) hashValue;
-            if (retStatus == STATUS_SUCCESS || retStatus == STATUS_HASH_KEY_NOT_PRESENT) {
-                retStatus = STATUS_SUCCESS;
-            } else {
-                CHK(FALSE, retStatus);
-            }
             curTimestamp = pCurPacket->header.timestamp;
             if (curTimestamp != pJitterBuffer->lastPopTimestamp) {
                 if (pJitterBuffer->lastPopTimestamp < earliestTimestamp || bufferClosed) {
@@ -185,6 +370,8 @@ STATUS jitter_buffer_pop(PJitterBuffer pJitterBuffer, BOOL bufferClosed)
                                                                    pJitterBuffer->lastPopTimestamp));
                         CHK_STATUS(jitter_buffer_dropBufferData(pJitterBuffer, startDropIndex, UINT16_DEC(index), curTimestamp));
                         curFrameSize = 0;
+                        // the start belonged to the dropped frame
+                        containStartForEarliestFrame = FALSE;
                         isFrameDataContinuous = TRUE;
                     }
                     startDropIndex = index;
@@ -192,6 +379,8 @@ STATUS jitter_buffer_pop(PJitterBuffer pJitterBuffer, BOOL bufferClosed)
                     if (containStartForEarliestFrame) {
                         CHK(!bufferClosed, retStatus);
                         if (isFrameDataContinuous) {
+                            // complete, but held until the target delay, this packet is walked again by the next pop
+                            CHK(jitter_buffer_isFrameDue(pJitterBuffer, pJitterBuffer->lastPopTimestamp), retStatus);
                             // TODO: if switch to curBuffer, need to carefully calculate ptr of UINT16_DEC(index) as it is a circulate buffer
                             CHK_STATUS(pJitterBuffer->onFrameReadyFn(pJitterBuffer->customData, startDropIndex, UINT16_DEC(index), curFrameSize));
                             CHK_STATUS(jitter_buffer_dropBufferData(pJitterBuffer, startDropIndex, UINT16_DEC(index), curTimestamp));
@@ -216,10 +405,9 @@ STATUS jitter_buffer_pop(PJitterBuffer pJitterBuffer, BOOL bufferClosed)
         curFrameSize = 0;
         hasEntry = TRUE;
         for (index = startDropIndex; UINT16_DEC(index) != lastNonNullIndex && hasEntry; index++) {
-            CHK_STATUS(hash_table_contains(pJitterBuffer->pPkgBufferHashTable, index, &hasEntry));
+            pCurPacket = jitter_buffer_getRingPacket(pJitterBuffer, index);
+            hasEntry = (pCurPacket != NULL);
             if (hasEntry) {
-                CHK_STATUS(hash_table_get(pJitterBuffer->pPkgBufferHashTable, index, &hashValue));
-                pCurPacket = (PRtpPacket) hashValue;
                 CHK_STATUS(pJitterBuffer->depayPayloadFn(pCurPacket->payload, pCurPacket->payloadLength, NULL, &partialFrameSize, NULL));
                 curFrameSize += partialFrameSize;
             }
@@ -237,6 +425,17 @@ STATUS jitter_buffer_pop(PJitterBuffer pJitterBuffer, BOOL bufferClosed)
     }
 
 CleanUp:
+    if (STATUS_SUCCEEDED(retStatus) && resumable) {
+        pAssembly->valid = TRUE;
+        pAssembly->timestamp = pJitterBuffer->lastPopTimestamp;
+        pAssembly->firstSequenceNumber = startDropIndex;
+        pAssembly->lastSequenceNumber = lastNonNullIndex;
+        pAssembly->nextSequenceNumber = index;
+        pAssembly->frameSize = curFrameSize;
+        pAssembly->startSeen = containStartForEarliestFrame;
+        pAssembly->continuous = isFrameDataContinuous;
+    }
+
     CHK_LOG_ERR(retStatus);
 
     LEAVES();
@@ -248,23 +447,43 @@ STATUS jitter_buffer_dropBufferData(PJitterBuffer pJitterBuffer, UINT16 startInd
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     UINT16 index = startIndex;
-    UINT64 hashValue;
-    PRtpPacket pCurPacket = NULL;
-    BOOL hasEntry = FALSE;
+    UINT16 prevRemovedSequenceNumber;
+    // the range is empty when endIndex is right before startIndex
+    UINT16 rangeLength = (UINT16)(endIndex - startIndex + 1);
+    UINT32 i;
+    PRtpPacket* pSlot = NULL;
 
     CHK(pJitterBuffer != NULL, STATUS_NULL_ARG);
-    for (; UINT16_DEC(index) != endIndex; index++) {
-        CHK_STATUS(hash_table_contains(pJitterBuffer->pPkgBufferHashTable, index, &hasEntry));
-        if (hasEntry) {
-            CHK_STATUS(hash_table_get(pJitterBuffer->pPkgBufferHashTable, index, &hashValue));
-            pCurPacket = (PRtpPacket) hashValue;
-            rtp_packet_free(&pCurPacket);
-            CHK_STATUS(hash_table_remove(pJitterBuffer->pPkgBufferHashTable, index));
+    if (rangeLength <= pJitterBuffer->ringSize) {
+        for (; UINT16_DEC(index) != endIndex; index++) {
+            pSlot = &pJitterBuffer->pPacketRing[JITTER_BUFFER_RING_INDEX(pJitterBuffer, index)];
+            if (*pSlot != NULL && (*pSlot)->header.sequenceNumber == index) {
+                rtp_packet_free(pSlot);
+                pJitterBuffer->packetCount--;
+            }
+        }
+    } else {
+        // cheaper to visit every slot once than every sequence number of the range
+        for (i = 0; i < pJitterBuffer->ringSize && pJitterBuffer->packetCount > 0; i++) {
+            pSlot = &pJitterBuffer->pPacketRing[i];
+            if (*pSlot != NULL && (UINT16)((*pSlot)->header.sequenceNumber - startIndex) < rangeLength) {
+                rtp_packet_free(pSlot);
+                pJitterBuffer->packetCount--;
+            }
         }
     }
+    prevRemovedSequenceNumber = pJitterBuffer->lastRemovedSequenceNumber;
+    pJitterBuffer->assembly.valid = FALSE;
     pJitterBuffer->lastPopTimestamp = nextTimestamp;
     pJitterBuffer->lastRemovedSequenceNumber = endIndex;
 
+    // jitter_buffer_pop drops in order from the head which keeps the tail, anything else needs a rescan.
+    if (pJitterBuffer->packetCount > 0 &&
+        (startIndex != (UINT16)(prevRemovedSequenceNumber + 1) || jitter_buffer_getRingPacket(pJitterBuffer, prevRemovedSequenceNumber) != NULL ||
+         jitter_buffer_getRingPacket(pJitterBuffer, pJitterBuffer->tailSequenceNumber) == NULL)) {
+        jitter_buffer_findTail(pJitterBuffer);
+    }
+
 CleanUp:
     CHK_LOG_ERR(retStatus);
 
@@ -278,7 +497,6 @@ STATUS jitter_buffer_fillFrameData(PJitterBuffer pJitterBuffer, PBYTE pFrame, UI
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     UINT16 index = startIndex;
-    UINT64 hashValue;
     PRtpPacket pCurPacket = NULL;
     PBYTE pCurPtrInFrame = pFrame;
     UINT32 remainingFrameSize = frameSize;
@@ -286,14 +504,7 @@ STATUS jitter_buffer_fillFrameData(PJitterBuffer pJitterBuffer, PBYTE pFrame, UI
 
     CHK(pJitterBuffer != NULL && pFrame != NULL && pFilledSize != NULL, STATUS_NULL_ARG);
     for (; UINT16_DEC(index) != endIndex; index++) {
-        hashValue = 0;
-        retStatus = hash_table_get(pJitterBuffer->pPkgBufferHashTable, index, &hashValue);
-        pCurPacket = (PRtpPacket) hashValue;
-        if (retStatus == STATUS_SUCCESS || retStatus == STATUS_HASH_KEY_NOT_PRESENT) {
-            retStatus = STATUS_SUCCESS;
-        } else {
-            CHK(FALSE, retStatus);
-        }
+        pCurPacket = jitter_buffer_getRingPacket(pJitterBuffer, index);
         CHK(pCurPacket != NULL, STATUS_NULL_ARG);
         partialFrameSize = remainingFrameSize;
         CHK_STATUS(pJitterBuffer->depayPayloadFn(pCurPacket->payload, pCurPacket->payloadLength, pCurPtrInFrame, &partialFrameSize, NULL));
@@ -310,4 +521,132 @@ CleanUp:
     LEAVES();
     return retStatus;
 }
+
+STATUS jitter_buffer_fillFrameSlices(PJitterBuffer pJitterBuffer, DepayRtpPayloadSlicesFunc depayPayloadSlicesFn, PRtcFrameSlice pSlices,
+                                     PUINT32 pSliceCount, UINT16 startIndex, UINT16 endIndex)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT16 index = startIndex;
+    PRtpPacket pCurPacket = NULL;
+    UINT32 sliceCount = 0, partialSliceCount = 0;
+
+    CHK(pJitterBuffer != NULL && depayPayloadSlicesFn != NULL && pSliceCount != NULL, STATUS_NULL_ARG);
+    for (; UINT16_DEC(index) != endIndex; index++) {
+        pCurPacket = jitter_buffer_getRingPacket(pJitterBuffer, index);
+        CHK(pCurPacket != NULL, STATUS_NULL_ARG);
+        partialSliceCount = *pSliceCount - sliceCount;
+        CHK_STATUS(depayPayloadSlicesFn(pCurPacket->payload, pCurPacket->payloadLength, pSlices == NULL ? NULL : pSlices + sliceCount,
+                                        &partialSliceCount));
+        sliceCount += partialSliceCount;
+    }
+
+CleanUp:
+    if (pSliceCount != NULL) {
+        *pSliceCount = sliceCount;
+    }
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS jitter_buffer_detachPackets(PJitterBuffer pJitterBuffer, PRtpPacket* pPackets, UINT16 startIndex, UINT16 endIndex)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT16 index = startIndex;
+    PRtpPacket* pSlot = NULL;
+
+    CHK(pJitterBuffer != NULL && pPackets != NULL, STATUS_NULL_ARG);
+    for (; UINT16_DEC(index) != endIndex; index++) {
+        pSlot = &pJitterBuffer->pPacketRing[JITTER_BUFFER_RING_INDEX(pJitterBuffer, index)];
+        CHK(*pSlot != NULL && (*pSlot)->header.sequenceNumber == index, STATUS_NULL_ARG);
+        *pPackets++ = *pSlot;
+        *pSlot = NULL;
+        pJitterBuffer->packetCount--;
+    }
+    pJitterBuffer->assembly.valid = FALSE;
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS jitter_buffer_getPacket(PJitterBuffer pJitterBuffer, UINT16 seqNum, PRtpPacket* ppRtpPacket)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pJitterBuffer != NULL && ppRtpPacket != NULL, STATUS_NULL_ARG);
+
+    *ppRtpPacket = jitter_buffer_getRingPacket(pJitterBuffer, seqNum);
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS jitter_buffer_setAdaptiveDelay(PJitterBuffer pJitterBuffer, BOOL enabled)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pJitterBuffer != NULL, STATUS_NULL_ARG);
+    pJitterBuffer->delayEstimator.enabled = enabled;
+    pJitterBuffer->delayEstimator.started = FALSE;
+    pJitterBuffer->delayEstimator.targetDelay = 0;
+    MEMSET(pJitterBuffer->delayEstimator.histogram, 0x00, SIZEOF(pJitterBuffer->delayEstimator.histogram));
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS jitter_buffer_getTargetDelay(PJitterBuffer pJitterBuffer, PUINT64 pTargetDelay)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pJitterBuffer != NULL && pTargetDelay != NULL, STATUS_NULL_ARG);
+    *pTargetDelay = (UINT64) pJitterBuffer->delayEstimator.targetDelay * HUNDREDS_OF_NANOS_IN_A_SECOND / pJitterBuffer->clockRate;
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS jitter_buffer_setExtraDelay(PJitterBuffer pJitterBuffer, UINT64 extraDelay)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pJitterBuffer != NULL, STATUS_NULL_ARG);
+    pJitterBuffer->delayEstimator.extraDelay = jitter_buffer_toClockRate(pJitterBuffer, extraDelay);
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS jitter_buffer_releaseDueFrames(PJitterBuffer pJitterBuffer, UINT64 currentTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PJitterBufferDelayEstimator pEstimator = NULL;
+    UINT32 now;
+
+    CHK(pJitterBuffer != NULL, STATUS_NULL_ARG);
+    pEstimator = &pJitterBuffer->delayEstimator;
+    // frames are released as soon as they are complete, or nothing has been pushed yet
+    CHK((pEstimator->enabled || pEstimator->extraDelay != 0) && pEstimator->started, retStatus);
+
+    now = jitter_buffer_toClockRate(pJitterBuffer, currentTime);
+    if ((INT32)(now - pEstimator->now) > 0) {
+        pEstimator->now = now;
+    }
+    CHK_STATUS(jitter_buffer_pop(pJitterBuffer, FALSE));
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    return retStatus;
+}
 #endif
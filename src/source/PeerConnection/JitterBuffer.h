@@ -27,7 +27,6 @@ extern "C" {
 #include "kvs/common_defs.h"
 #include "kvs/platform_utils.h"
 #include "kvs/webrtc_client.h"
-#include "hash_table.h"
 #include "RtpPacket.h"
 
 /******************************************************************************
@@ -37,8 +36,74 @@ typedef STATUS (*FrameReadyFunc)(UINT64, UINT16, UINT16, UINT32);
 typedef STATUS (*FrameDroppedFunc)(UINT64, UINT16, UINT16, UINT32);
 #define UINT16_DEC(a) ((UINT16)((a) -1))
 
-#define JITTER_BUFFER_HASH_TABLE_BUCKET_COUNT  3000
-#define JITTER_BUFFER_HASH_TABLE_BUCKET_LENGTH 2
+/**
+ * Packets are kept in a ring indexed by (sequence number & ringMask). The ring is a power of two sized at creation for the
+ * packets of maxLatency at the highest packet rate expected for the clock rate, up to the whole sequence number space.
+ * A stream sending faster overflows the ring: a newer packet evicts the older one landing on the same slot, and the frame
+ * of the evicted packet is dropped once it is popped or expires.
+ */
+#define JITTER_BUFFER_RING_MIN_SIZE 512
+#define JITTER_BUFFER_RING_MAX_SIZE 65536
+// streams of this clock rate and above are video
+#define JITTER_BUFFER_VIDEO_CLOCK_RATE 90000
+// about 40 Mbps in 1200 byte packets
+#ifndef JITTER_BUFFER_MAX_VIDEO_PACKET_RATE
+#define JITTER_BUFFER_MAX_VIDEO_PACKET_RATE 4000
+#endif
+// 5 ms audio frames
+#define JITTER_BUFFER_MAX_AUDIO_PACKET_RATE             200
+#define JITTER_BUFFER_RING_INDEX(pJitterBuffer, seqNum) ((seqNum) & (pJitterBuffer)->ringMask)
+
+/**
+ * Where jitter_buffer_pop stopped walking the frame at lastPopTimestamp, so the next pop resumes at the hole or the tail
+ * instead of depacketizing the frame from lastRemovedSequenceNumber again. Only valid while nothing in front of
+ * nextSequenceNumber changes and the frame has not expired.
+ */
+typedef struct __JitterBufferFrameAssembly {
+    BOOL valid;
+    UINT32 timestamp;
+    UINT16 firstSequenceNumber;
+    UINT16 lastSequenceNumber;
+    UINT16 nextSequenceNumber;
+    UINT32 frameSize;
+    BOOL startSeen;
+    BOOL continuous;
+} JitterBufferFrameAssembly, *PJitterBufferFrameAssembly;
+
+/**
+ * Adaptive playout delay. The delay of every packet relative to the fastest packet of the recent past is collected in a
+ * histogram which slowly forgets old samples, and complete frames are held until they are as old as the
+ * JITTER_BUFFER_DELAY_PERCENTILE of those delays. The relative delay covers both the interarrival jitter and the time a
+ * frame waits for its last, possibly retransmitted, packet.
+ */
+#define JITTER_BUFFER_DELAY_BUCKET_COUNT 64
+#define JITTER_BUFFER_DELAY_BUCKET_WIDTH (10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define JITTER_BUFFER_DELAY_PERCENTILE   95
+// every sample scales the histogram by 1 - 2^-JITTER_BUFFER_DELAY_FORGET_SHIFT, roughly the last 512 packets count
+#define JITTER_BUFFER_DELAY_FORGET_SHIFT 9
+#define JITTER_BUFFER_DELAY_SAMPLE_WEIGHT (1 << 16)
+// the fastest packet is searched again over windows this long, so that clock drift does not accumulate
+#define JITTER_BUFFER_DELAY_BASE_WINDOW (2 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+// held frames are checked this often by jitter_buffer_releaseDueFrames, the resolution of the target delay
+#define JITTER_BUFFER_RELEASE_CHECK_PERIOD JITTER_BUFFER_DELAY_BUCKET_WIDTH
+
+typedef struct __JitterBufferDelayEstimator {
+    BOOL enabled;
+    BOOL started;
+    // arrival time minus rtp timestamp of the fastest packet, clockRate units
+    UINT32 baseTransit;
+    UINT32 windowMinTransit;
+    UINT64 windowStartTime; // 100ns precision
+    // held frames are checked against this time, the arrival of the last pushed packet or the later time passed to
+    // jitter_buffer_releaseDueFrames, clockRate units
+    UINT32 now;
+    UINT32 bucketWidth; // clockRate units
+    UINT32 histogram[JITTER_BUFFER_DELAY_BUCKET_COUNT];
+    // frames are held until they are this much older than the fastest packet, clockRate units
+    UINT32 targetDelay;
+    // held on top of targetDelay, e.g. for a stream to wait for the one it is synchronized with, clockRate units
+    UINT32 extraDelay;
+} JitterBufferDelayEstimator, *PJitterBufferDelayEstimator;
 
 typedef struct __JitterBuffer {
     FrameReadyFunc onFrameReadyFn;
@@ -59,7 +124,14 @@ typedef struct __JitterBuffer {
     UINT64 customData;
     UINT32 clockRate;
     BOOL started;
-    PHashTable pPkgBufferHashTable;
+    // the packet furthest from lastRemovedSequenceNumber, jitter_buffer_pop does not need to look past it
+    UINT16 tailSequenceNumber;
+    UINT32 packetCount;
+    PRtpPacket* pPacketRing;
+    UINT32 ringSize;
+    UINT32 ringMask;
+    JitterBufferFrameAssembly assembly;
+    JitterBufferDelayEstimator delayEstimator;
 } JitterBuffer, *PJitterBuffer;
 
 /******************************************************************************
@@ -71,6 +143,80 @@ STATUS jitter_buffer_push(PJitterBuffer, PRtpPacket, PBOOL);
 STATUS jitter_buffer_pop(PJitterBuffer, BOOL);
 STATUS jitter_buffer_dropBufferData(PJitterBuffer, UINT16, UINT16, UINT32);
 STATUS jitter_buffer_fillFrameData(PJitterBuffer, PBYTE, UINT32, PUINT32, UINT16, UINT16);
+/**
+ * @brief describe the frame [startIndex, endIndex] as slices pointing into its packets instead of copying it.
+ *
+ * @param[in] pJitterBuffer the jitter buffer.
+ * @param[in] depayPayloadSlicesFn the slicing counterpart of the depay function of the jitter buffer.
+ * @param[out] pSlices the slices, NULL to only count them.
+ * @param[in, out] pSliceCount the capacity of the slices, the number of slices of the frame.
+ * @param[in] startIndex the first sequence number of the frame.
+ * @param[in] endIndex the last sequence number of the frame.
+ *
+ * @return STATUS status of execution
+ */
+STATUS jitter_buffer_fillFrameSlices(PJitterBuffer, DepayRtpPayloadSlicesFunc, PRtcFrameSlice, PUINT32, UINT16, UINT16);
+/**
+ * @brief take the packets of the frame [startIndex, endIndex] out of the jitter buffer, the caller frees them. Used to keep
+ *        the slices of a frame alive after jitter_buffer_dropBufferData, which skips the detached packets.
+ *
+ * @param[in] pJitterBuffer the jitter buffer.
+ * @param[out] pPackets the packets in sequence number order, one per sequence number of the range.
+ * @param[in] startIndex the first sequence number of the frame.
+ * @param[in] endIndex the last sequence number of the frame.
+ *
+ * @return STATUS status of execution
+ */
+STATUS jitter_buffer_detachPackets(PJitterBuffer, PRtpPacket*, UINT16, UINT16);
+/**
+ * @brief get the packet of the sequence number held by the jitter buffer.
+ *
+ * @param[in] pJitterBuffer the jitter buffer.
+ * @param[in] seqNum the sequence number.
+ * @param[out] ppRtpPacket the packet, NULL if the jitter buffer does not hold it.
+ *
+ * @return STATUS status of execution
+ */
+STATUS jitter_buffer_getPacket(PJitterBuffer, UINT16, PRtpPacket*);
+/**
+ * @brief hold complete frames to an adaptive target delay instead of releasing them right away. The receivedTime of
+ *        the pushed packets drives the estimate, a held frame goes out with the first packet arriving after its target
+ *        or with the first jitter_buffer_releaseDueFrames past it.
+ *
+ * @param[in] pJitterBuffer the jitter buffer.
+ * @param[in] enabled TRUE to hold frames to the target delay.
+ *
+ * @return STATUS status of execution
+ */
+STATUS jitter_buffer_setAdaptiveDelay(PJitterBuffer, BOOL);
+/**
+ * @brief get the current target delay of the adaptive mode.
+ *
+ * @param[in] pJitterBuffer the jitter buffer.
+ * @param[out] pTargetDelay the target delay in 100ns, 0 when the adaptive mode is off.
+ *
+ * @return STATUS status of execution
+ */
+STATUS jitter_buffer_getTargetDelay(PJitterBuffer, PUINT64);
+/**
+ * @brief hold complete frames for an extra delay on top of the target delay, also when the adaptive mode is off.
+ *
+ * @param[in] pJitterBuffer the jitter buffer.
+ * @param[in] extraDelay the extra delay in 100ns, 0 to release frames as before.
+ *
+ * @return STATUS status of execution
+ */
+STATUS jitter_buffer_setExtraDelay(PJitterBuffer, UINT64);
+/**
+ * @brief release the held frames which reached their target and extra delay by the current time, so that they do not
+ *        wait for the next packet. Does nothing when frames are not held.
+ *
+ * @param[in] pJitterBuffer the jitter buffer.
+ * @param[in] currentTime the current time in 100ns, on the clock of the receivedTime of the pushed packets.
+ *
+ * @return STATUS status of execution
+ */
+STATUS jitter_buffer_releaseDueFrames(PJitterBuffer, UINT64);
 
 #ifdef __cplusplus
 }
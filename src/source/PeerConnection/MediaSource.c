@@ -0,0 +1,155 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "MediaSource"
+
+#include "MediaSource.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS media_source_create(UINT64 minKeyFrameInterval, UINT64 customData, RtcOnPictureLoss onPictureLoss, PRtcMediaSource* ppRtcMediaSource)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsMediaSource pKvsMediaSource = NULL;
+
+    CHK(ppRtcMediaSource != NULL && onPictureLoss != NULL, STATUS_NULL_ARG);
+
+    pKvsMediaSource = (PKvsMediaSource) MEMCALLOC(1, SIZEOF(KvsMediaSource));
+    CHK(pKvsMediaSource != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pKvsMediaSource->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pKvsMediaSource->lock), STATUS_INVALID_OPERATION);
+    pKvsMediaSource->minKeyFrameInterval = minKeyFrameInterval;
+    pKvsMediaSource->customData = customData;
+    pKvsMediaSource->onPictureLoss = onPictureLoss;
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        media_source_free((PRtcMediaSource*) &pKvsMediaSource);
+    }
+    if (ppRtcMediaSource != NULL) {
+        *ppRtcMediaSource = (PRtcMediaSource) pKvsMediaSource;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS media_source_free(PRtcMediaSource* ppRtcMediaSource)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsMediaSource pKvsMediaSource = NULL;
+
+    CHK(ppRtcMediaSource != NULL, STATUS_NULL_ARG);
+    pKvsMediaSource = (PKvsMediaSource) *ppRtcMediaSource;
+    CHK(pKvsMediaSource != NULL, retStatus);
+
+    if (IS_VALID_MUTEX_VALUE(pKvsMediaSource->lock)) {
+        MUTEX_FREE(pKvsMediaSource->lock);
+    }
+    SAFE_MEMFREE(*ppRtcMediaSource);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+STATUS media_source_getKeyFrameRequestStats(PRtcMediaSource pRtcMediaSource, PRtcKeyFrameRequestStats pRtcKeyFrameRequestStats)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsMediaSource pKvsMediaSource = (PKvsMediaSource) pRtcMediaSource;
+
+    CHK(pKvsMediaSource != NULL && pRtcKeyFrameRequestStats != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pKvsMediaSource->lock);
+    *pRtcKeyFrameRequestStats = pKvsMediaSource->stats;
+    MUTEX_UNLOCK(pKvsMediaSource->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS media_source_requestKeyFrame(PKvsMediaSource pKvsMediaSource)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL fire = FALSE;
+    UINT64 now = GETTIME();
+
+    CHK(pKvsMediaSource != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pKvsMediaSource->lock);
+    pKvsMediaSource->stats.keyFrameRequestsReceived++;
+    if (pKvsMediaSource->stats.keyFrameRequestsFired == 0 || now >= pKvsMediaSource->lastKeyFrameRequestTime + pKvsMediaSource->minKeyFrameInterval) {
+        fire = TRUE;
+        pKvsMediaSource->keyFrameRequestPending = FALSE;
+        pKvsMediaSource->lastKeyFrameRequestTime = now;
+        pKvsMediaSource->stats.keyFrameRequestsFired++;
+    } else {
+        // the key frame of the previous request may still be on its way, fire at the end of the interval if it is not
+        pKvsMediaSource->keyFrameRequestPending = TRUE;
+        pKvsMediaSource->stats.keyFrameRequestsCoalesced++;
+    }
+    MUTEX_UNLOCK(pKvsMediaSource->lock);
+
+    // Fire outside of the lock, the application may write a key frame right from the callback
+    if (fire) {
+        pKvsMediaSource->onPictureLoss(pKvsMediaSource->customData);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS media_source_onFrameSent(PKvsMediaSource pKvsMediaSource, BOOL isKeyFrame)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL fire = FALSE;
+    UINT64 now;
+
+    CHK(pKvsMediaSource != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pKvsMediaSource->lock);
+    if (pKvsMediaSource->keyFrameRequestPending) {
+        now = GETTIME();
+        if (isKeyFrame) {
+            pKvsMediaSource->keyFrameRequestPending = FALSE;
+            pKvsMediaSource->stats.keyFrameRequestsSatisfied++;
+        } else if (now >= pKvsMediaSource->lastKeyFrameRequestTime + pKvsMediaSource->minKeyFrameInterval) {
+            fire = TRUE;
+            pKvsMediaSource->keyFrameRequestPending = FALSE;
+            pKvsMediaSource->lastKeyFrameRequestTime = now;
+            pKvsMediaSource->stats.keyFrameRequestsFired++;
+        }
+    }
+    MUTEX_UNLOCK(pKvsMediaSource->lock);
+
+    if (fire) {
+        pKvsMediaSource->onPictureLoss(pKvsMediaSource->customData);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_MEDIA_SOURCE__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_MEDIA_SOURCE__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/webrtc_client.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+typedef struct {
+    RtcMediaSource mediaSource;
+
+    MUTEX lock;
+    UINT64 minKeyFrameInterval;
+    UINT64 customData;
+    RtcOnPictureLoss onPictureLoss;
+
+    // 100ns precision, time the callback last fired
+    UINT64 lastKeyFrameRequestTime;
+    // a request arrived within the minimum interval and no key frame has been sent since
+    BOOL keyFrameRequestPending;
+
+    RtcKeyFrameRequestStats stats;
+} KvsMediaSource, *PKvsMediaSource;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief a transceiver of the source needs a key frame. The callback of the source fires right away unless it
+ *        already fired within the minimum interval, in which case the request is merged and fired at the end of
+ *        the interval by media_source_onFrameSent.
+ *
+ * @param[in] pKvsMediaSource the media source.
+ *
+ * @return STATUS status of execution
+ */
+STATUS media_source_requestKeyFrame(PKvsMediaSource);
+/**
+ * @brief a frame of the source was written to one of its transceivers. A key frame satisfies the pending requests,
+ *        otherwise a pending request fires once the minimum interval has passed.
+ *
+ * @param[in] pKvsMediaSource the media source.
+ * @param[in] isKeyFrame whether the frame is a key frame.
+ *
+ * @return STATUS status of execution
+ */
+STATUS media_source_onFrameSent(PKvsMediaSource, BOOL);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_MEDIA_SOURCE__ */
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "NackGenerator"
+
+#include "NackGenerator.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS nack_generator_create(UINT16 maxRetries, PNackGenerator* ppNackGenerator)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PNackGenerator pNackGenerator = NULL;
+
+    CHK(ppNackGenerator != NULL, STATUS_NULL_ARG);
+
+    pNackGenerator = (PNackGenerator) MEMCALLOC(1, SIZEOF(NackGenerator));
+    CHK(pNackGenerator != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pNackGenerator->maxRetries = maxRetries != 0 ? maxRetries : NACK_GENERATOR_DEFAULT_MAX_RETRIES;
+
+CleanUp:
+    if (ppNackGenerator != NULL) {
+        *ppNackGenerator = pNackGenerator;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS nack_generator_free(PNackGenerator* ppNackGenerator)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(ppNackGenerator != NULL, STATUS_NULL_ARG);
+    SAFE_MEMFREE(*ppNackGenerator);
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * @brief remove the requests [index, index + count) and keep the rest in order.
+ */
+static VOID nack_generator_removeRequests(PNackGenerator pNackGenerator, UINT32 index, UINT32 count)
+{
+    MEMMOVE(&pNackGenerator->requests[index], &pNackGenerator->requests[index + count],
+            (pNackGenerator->requestCount - index - count) * SIZEOF(NackRequest));
+    pNackGenerator->requestCount -= count;
+}
+
+STATUS nack_generator_onPacketReceived(PNackGenerator pNackGenerator, UINT16 sequenceNumber, UINT64 now)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT16 distance, missing, i;
+    UINT32 overflow;
+
+    CHK(pNackGenerator != NULL, STATUS_NULL_ARG);
+
+    if (!pNackGenerator->started) {
+        pNackGenerator->started = TRUE;
+        pNackGenerator->highestSequenceNumber = sequenceNumber;
+        CHK(FALSE, retStatus);
+    }
+
+    distance = (UINT16)(sequenceNumber - pNackGenerator->highestSequenceNumber);
+    // duplicate of the highest packet
+    CHK(distance != 0, retStatus);
+
+    if (distance >= 0x8000) {
+        // late or retransmitted packet
+        for (i = 0; i < pNackGenerator->requestCount; i++) {
+            if (pNackGenerator->requests[i].sequenceNumber == sequenceNumber) {
+                nack_generator_removeRequests(pNackGenerator, i, 1);
+                break;
+            }
+        }
+        CHK(FALSE, retStatus);
+    }
+
+    pNackGenerator->highestSequenceNumber = sequenceNumber;
+    missing = distance - 1;
+    CHK(missing != 0, retStatus);
+
+    if (missing > NACK_GENERATOR_MAX_GAP) {
+        DLOGW("Gap of %u packets before sequence number %u is not repaired", missing, sequenceNumber);
+        pNackGenerator->requestCount = 0;
+        CHK(FALSE, retStatus);
+    }
+
+    if (pNackGenerator->requestCount + missing > NACK_GENERATOR_MAX_PENDING) {
+        overflow = pNackGenerator->requestCount + missing - NACK_GENERATOR_MAX_PENDING;
+        nack_generator_removeRequests(pNackGenerator, 0, overflow);
+    }
+
+    for (i = missing; i > 0; i--) {
+        pNackGenerator->requests[pNackGenerator->requestCount].sequenceNumber = (UINT16)(sequenceNumber - i);
+        pNackGenerator->requests[pNackGenerator->requestCount].retries = 0;
+        pNackGenerator->requests[pNackGenerator->requestCount].nextSendTime = now;
+        pNackGenerator->requestCount++;
+    }
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS nack_generator_cancelUpTo(PNackGenerator pNackGenerator, UINT16 sequenceNumber)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 count = 0;
+
+    CHK(pNackGenerator != NULL, STATUS_NULL_ARG);
+
+    while (count < pNackGenerator->requestCount && (INT16)(pNackGenerator->requests[count].sequenceNumber - sequenceNumber) <= 0) {
+        count++;
+    }
+    if (count > 0) {
+        nack_generator_removeRequests(pNackGenerator, 0, count);
+    }
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS nack_generator_getNackList(PNackGenerator pNackGenerator, UINT64 now, UINT64 retryInterval, PUINT16 pSequenceNumberList,
+                                  PUINT32 pSequenceNumberListLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PNackRequest pRequest;
+    UINT32 i, kept = 0, listLen = 0;
+
+    CHK(pNackGenerator != NULL && pSequenceNumberList != NULL && pSequenceNumberListLen != NULL, STATUS_NULL_ARG);
+
+    retryInterval = MAX(retryInterval, NACK_GENERATOR_MIN_RETRY_INTERVAL);
+    for (i = 0; i < pNackGenerator->requestCount; i++) {
+        pRequest = &pNackGenerator->requests[i];
+        if (pRequest->nextSendTime <= now && listLen < *pSequenceNumberListLen) {
+            pSequenceNumberList[listLen++] = pRequest->sequenceNumber;
+            pRequest->retries++;
+            pRequest->nextSendTime = now + retryInterval;
+        }
+        // the last attempt has been sent, stop tracking the packet
+        if (pRequest->retries < pNackGenerator->maxRetries) {
+            pNackGenerator->requests[kept++] = *pRequest;
+        }
+    }
+    pNackGenerator->requestCount = kept;
+
+CleanUp:
+    if (pSequenceNumberListLen != NULL) {
+        *pSequenceNumberListLen = listLen;
+    }
+    return retStatus;
+}
+#endif
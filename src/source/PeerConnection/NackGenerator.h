@@ -0,0 +1,104 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_NACK_GENERATOR__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_NACK_GENERATOR__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+// missing packets tracked at once, the oldest request is given up when a new gap does not fit
+#define NACK_GENERATOR_MAX_PENDING 128
+// a gap larger than this is not worth repairing, a key frame is needed anyway
+#define NACK_GENERATOR_MAX_GAP NACK_GENERATOR_MAX_PENDING
+// a missing packet is requested at most this many times
+#define NACK_GENERATOR_DEFAULT_MAX_RETRIES 10
+// requests are repeated once per round trip time, but not faster than this
+#define NACK_GENERATOR_MIN_RETRY_INTERVAL (20 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+// round trip time assumed until the remote receiver reports have measured one
+#define NACK_GENERATOR_DEFAULT_RTT (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+typedef struct {
+    UINT16 sequenceNumber;
+    UINT16 retries;
+    UINT64 nextSendTime; // 100ns precision
+} NackRequest, *PNackRequest;
+
+/**
+ * Missing packets of one inbound ssrc. The requests are kept in sequence number order, oldest first.
+ */
+typedef struct __NackGenerator {
+    BOOL started;
+    UINT16 highestSequenceNumber;
+    UINT16 maxRetries;
+    UINT32 requestCount;
+    NackRequest requests[NACK_GENERATOR_MAX_PENDING];
+} NackGenerator, *PNackGenerator;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS nack_generator_create(UINT16, PNackGenerator*);
+STATUS nack_generator_free(PNackGenerator*);
+/**
+ * @brief track an inbound packet. A sequence number ahead of the highest one received so far schedules a request
+ *        for every packet skipped in between, an older one is a late or retransmitted packet and cancels its request.
+ *
+ * @param[in] pNackGenerator the generator.
+ * @param[in] sequenceNumber the sequence number of the packet.
+ * @param[in] now the current time in 100ns.
+ *
+ * @return STATUS status of execution
+ */
+STATUS nack_generator_onPacketReceived(PNackGenerator, UINT16, UINT64);
+/**
+ * @brief stop requesting the packets up to and including a sequence number, e.g. once the jitter buffer
+ *        emitted or dropped the frame they belong to.
+ *
+ * @param[in] pNackGenerator the generator.
+ * @param[in] sequenceNumber the last sequence number which is not needed anymore.
+ *
+ * @return STATUS status of execution
+ */
+STATUS nack_generator_cancelUpTo(PNackGenerator, UINT16);
+/**
+ * @brief collect the requests which are due. Every returned request is rescheduled one retry interval later
+ *        and given up after maxRetries attempts.
+ *
+ * @param[in] pNackGenerator the generator.
+ * @param[in] now the current time in 100ns.
+ * @param[in] retryInterval the time between two requests of the same packet in 100ns, usually the round trip time.
+ * @param[out] pSequenceNumberList the due sequence numbers, oldest first.
+ * @param[in, out] pSequenceNumberListLen the capacity of the list, the number of sequence numbers returned.
+ *
+ * @return STATUS status of execution
+ */
+STATUS nack_generator_getNackList(PNackGenerator, UINT64, UINT64, PUINT16, PUINT32);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_NACK_GENERATOR__ */
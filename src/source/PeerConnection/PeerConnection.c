@@ -45,6 +45,8 @@
 #define PC_LEAVES() // LEAVES()
 
 static volatile ATOMIC_BOOL gKvsWebRtcInitialized = (SIZE_T) FALSE;
+// the timer queue the peer connections attach to, one thread runs the timers of all of them
+static TIMER_QUEUE_HANDLE gPeerTimerQueueHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
 
 /******************************************************************************
  * FUNCTIONS
@@ -67,9 +69,14 @@ STATUS pc_allocateSrtp(PKvsPeerConnection pKvsPeerConnection)
     MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
     locked = TRUE;
 
-    CHK_STATUS(srtp_session_init(pKvsPeerConnection->dtlsIsServer ? pDtlsKeyingMaterial->clientWriteKey : pDtlsKeyingMaterial->serverWriteKey,
-                                 pKvsPeerConnection->dtlsIsServer ? pDtlsKeyingMaterial->serverWriteKey : pDtlsKeyingMaterial->clientWriteKey,
-                                 pDtlsKeyingMaterial->srtpProfile, &(pKvsPeerConnection->pSrtpSession)));
+    CHK_STATUS(srtp_session_initWithReceiveShards(
+        pKvsPeerConnection->dtlsIsServer ? pDtlsKeyingMaterial->clientWriteKey : pDtlsKeyingMaterial->serverWriteKey,
+        pKvsPeerConnection->dtlsIsServer ? pDtlsKeyingMaterial->serverWriteKey : pDtlsKeyingMaterial->clientWriteKey,
+        pDtlsKeyingMaterial->srtpProfile, pKvsPeerConnection->srtpDecryptWorkerCount, &(pKvsPeerConnection->pSrtpSession)));
+    if (pKvsPeerConnection->srtpDecryptWorkerCount > 0) {
+        CHK_STATUS(srtp_pipeline_create(pKvsPeerConnection->pSrtpSession, pKvsPeerConnection->srtpDecryptWorkerCount, SRTP_PIPELINE_DEFAULT_DEPTH,
+                                        pc_onDecryptedRtpPacket, (UINT64) pKvsPeerConnection, &pKvsPeerConnection->pSrtpPipeline));
+    }
 
 CleanUp:
     if (locked) {
@@ -255,90 +262,196 @@ CleanUp:
 }
 
 #ifdef ENABLE_STREAMING
-STATUS pc_sendPacketToRtpReceiver(PKvsPeerConnection pKvsPeerConnection, PBYTE pBuffer, UINT32 bufferLen)
+/**
+ * @brief the transceiver which receives the ssrc. The map also holds the ssrcs the transceivers send with.
+ */
+static PKvsRtpTransceiver pc_findReceivingTransceiver(PKvsPeerConnection pKvsPeerConnection, UINT32 ssrc)
+{
+    PKvsRtpTransceiver pTransceiver;
+    UINT64 item;
+
+    if (STATUS_FAILED(ssrc_map_get(pKvsPeerConnection->pSsrcMap, ssrc, &item))) {
+        return NULL;
+    }
+    pTransceiver = (PKvsRtpTransceiver) item;
+    if (pTransceiver->jitterBufferSsrc == ssrc || (pTransceiver->jitterBufferRtxSsrc != 0 && pTransceiver->jitterBufferRtxSsrc == ssrc)) {
+        return pTransceiver;
+    }
+    return NULL;
+}
+
+/**
+ * @brief hand a received packet to the jitter buffer of its transceiver, once it was decrypted.
+ *
+ * @param[in] pTransceiver the transceiver receiving the ssrc of the packet.
+ * @param[in] pPacket the decrypted packet, which is taken over. NULL or the encrypted packet when decryptStatus failed.
+ * @param[in] packetLen the length of the packet.
+ * @param[in] receivedTime the time the packet was received at.
+ * @param[in] decryptStatus the status of the decryption.
+ */
+static STATUS pc_receiveRtpPacket(PKvsRtpTransceiver pTransceiver, PBYTE pPacket, UINT32 packetLen, UINT64 receivedTime, STATUS decryptStatus)
 {
     PC_ENTER();
     STATUS retStatus = STATUS_SUCCESS;
-    PDoubleListNode pCurNode = NULL;
-    PKvsRtpTransceiver pTransceiver;
-    UINT64 item, now;
     UINT32 ssrc;
+    UINT16 sequenceNumber;
+    UINT8 paddingLength;
     PRtpPacket pRtpPacket = NULL;
-    PBYTE pPayload = NULL;
-    BOOL ownedByJitterBuffer = FALSE, discarded = FALSE;
-    UINT64 packetsReceived = 0, packetsFailedDecryption = 0, lastPacketReceivedTimestamp = 0, headerBytesReceived = 0, bytesReceived = 0,
-           packetsDiscarded = 0;
+    BOOL ownedByJitterBuffer = FALSE, discarded = FALSE, isRepair, isMediaPacket = FALSE, locked = FALSE;
+    UINT64 lastPacketReceivedTimestamp = 0, headerBytesReceived = 0, bytesReceived = 0, packetsDiscarded = 0;
     INT64 arrival, r_ts, transit, delta;
 
-    CHK(pKvsPeerConnection != NULL && pBuffer != NULL, STATUS_PEER_CONN_NULL_ARG);
-    CHK(bufferLen >= MIN_HEADER_LENGTH, STATUS_INVALID_ARG);
-
-    ssrc = getInt32(*(PUINT32)(pBuffer + SSRC_OFFSET));
-
-    CHK_STATUS(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
-    while (pCurNode != NULL) {
-        CHK_STATUS(double_list_getNodeData(pCurNode, &item));
-        pTransceiver = (PKvsRtpTransceiver) item;
-
-        if (pTransceiver->jitterBufferSsrc == ssrc) {
-            packetsReceived++;
-            if (STATUS_FAILED(retStatus = srtp_session_decryptSrtpPacket(pKvsPeerConnection->pSrtpSession, pBuffer, (PINT32) &bufferLen))) {
-                DLOGW("srtp_session_decryptSrtpPacket failed with 0x%08x", retStatus);
-                packetsFailedDecryption++;
-                CHK(FALSE, STATUS_SUCCESS);
-            }
-            now = GETTIME();
-            CHK(NULL != (pPayload = (PBYTE) MEMALLOC(bufferLen)), STATUS_PEER_CONN_NOT_ENOUGH_MEMORY);
-            MEMCPY(pPayload, pBuffer, bufferLen);
-            CHK_STATUS(rtp_packet_createFromBytes(pPayload, bufferLen, &pRtpPacket));
-            pRtpPacket->receivedTime = now;
-
-            // https://tools.ietf.org/html/rfc3550#section-6.4.1
-            // https://tools.ietf.org/html/rfc3550#appendix-A.8
-            // interarrival jitter
-            // arrival, the current time in the same units.
-            // r_ts, the timestamp from   the incoming packet
-            arrival = KVS_CONVERT_TIMESCALE(now, HUNDREDS_OF_NANOS_IN_A_SECOND, pTransceiver->pJitterBuffer->clockRate);
-            r_ts = pRtpPacket->header.timestamp;
-            transit = arrival - r_ts;
-            delta = transit - pTransceiver->pJitterBuffer->transit;
-            pTransceiver->pJitterBuffer->transit = transit;
-            pTransceiver->pJitterBuffer->jitter += (1. / 16.) * ((DOUBLE) ABS(delta) - pTransceiver->pJitterBuffer->jitter);
-            CHK_STATUS(jitter_buffer_push(pTransceiver->pJitterBuffer, pRtpPacket, &discarded));
-            if (discarded) {
-                packetsDiscarded++;
-            }
-            lastPacketReceivedTimestamp = KVS_CONVERT_TIMESCALE(now, HUNDREDS_OF_NANOS_IN_A_SECOND, 1000);
-            headerBytesReceived += RTP_HEADER_LEN(pRtpPacket);
-            bytesReceived += pRtpPacket->rawPacketLength - RTP_HEADER_LEN(pRtpPacket);
-            ownedByJitterBuffer = TRUE;
-            CHK(FALSE, STATUS_SUCCESS);
-        }
-        pCurNode = pCurNode->pNext;
+    CHK(pTransceiver != NULL, STATUS_PEER_CONN_NULL_ARG);
+    if (STATUS_FAILED(decryptStatus)) {
+        DLOGW("srtp_session_decryptSrtpPacket failed with 0x%08x", decryptStatus);
+        CHK(FALSE, STATUS_SUCCESS);
     }
+    CHK(pPacket != NULL, STATUS_PEER_CONN_NULL_ARG);
 
-    DLOGW("No transceiver to handle inbound ssrc %u", ssrc);
+    ssrc = getInt32(*(PUINT32)(pPacket + SSRC_OFFSET));
+    isRepair = pTransceiver->jitterBufferRtxSsrc != 0 && pTransceiver->jitterBufferRtxSsrc == ssrc;
+    retStatus = rtp_packet_createFromBytes(pPacket, packetLen, &pRtpPacket);
+    // the packet is freed with pRtpPacket from now on, createFromBytes already freed it when it did not parse
+    if (pRtpPacket != NULL || retStatus != STATUS_NOT_ENOUGH_MEMORY) {
+        pPacket = NULL;
+    }
+    CHK_STATUS(retStatus);
+    pRtpPacket->receivedTime = receivedTime;
+
+    if (isRepair) {
+        // https://tools.ietf.org/html/rfc4588#section-4
+        // the payload of a retransmission starts with the original sequence number, padding only packets
+        // sent on the rtx ssrc to probe bandwidth carry no media
+        paddingLength = pRtpPacket->header.padding ? pRtpPacket->pRawPacket[pRtpPacket->rawPacketLength - 1] : 0;
+        CHK(pRtpPacket->payloadLength > SIZEOF(UINT16) + paddingLength, STATUS_SUCCESS);
+        pRtpPacket->header.sequenceNumber = (UINT16) getUnalignedInt16BigEndian(pRtpPacket->payload);
+        pRtpPacket->header.ssrc = pTransceiver->jitterBufferSsrc;
+        pRtpPacket->payload += SIZEOF(UINT16);
+        pRtpPacket->payloadLength -= SIZEOF(UINT16);
+    } else {
+        // https://tools.ietf.org/html/rfc3550#section-6.4.1
+        // https://tools.ietf.org/html/rfc3550#appendix-A.8
+        // interarrival jitter, retransmissions are left out as they are late by design
+        // arrival, the current time in the same units.
+        // r_ts, the timestamp from   the incoming packet
+        arrival = KVS_CONVERT_TIMESCALE(receivedTime, HUNDREDS_OF_NANOS_IN_A_SECOND, pTransceiver->pJitterBuffer->clockRate);
+        r_ts = pRtpPacket->header.timestamp;
+        transit = arrival - r_ts;
+        delta = transit - pTransceiver->pJitterBuffer->transit;
+        pTransceiver->pJitterBuffer->transit = transit;
+        pTransceiver->pJitterBuffer->jitter += (1. / 16.) * ((DOUBLE) ABS(delta) - pTransceiver->pJitterBuffer->jitter);
+    }
+    // the packet may be freed by the jitter buffer
+    sequenceNumber = pRtpPacket->header.sequenceNumber;
+    lastPacketReceivedTimestamp = KVS_CONVERT_TIMESCALE(receivedTime, HUNDREDS_OF_NANOS_IN_A_SECOND, 1000);
+    headerBytesReceived += RTP_HEADER_LEN(pRtpPacket);
+    bytesReceived += pRtpPacket->rawPacketLength - RTP_HEADER_LEN(pRtpPacket);
+    // the timer releasing held frames pops the jitter buffer too
+    MUTEX_LOCK(pTransceiver->jitterBufferLock);
+    locked = TRUE;
+    if (pTransceiver->pNackGenerator != NULL) {
+        CHK_STATUS(nack_generator_onPacketReceived(pTransceiver->pNackGenerator, sequenceNumber, receivedTime));
+    }
+    CHK_STATUS(jitter_buffer_push(pTransceiver->pJitterBuffer, pRtpPacket, &discarded));
+    ownedByJitterBuffer = TRUE;
+    isMediaPacket = !isRepair;
+    if (discarded) {
+        packetsDiscarded++;
+    }
+    if (pTransceiver->pNackGenerator != NULL && STATUS_FAILED(rtcp_sendNackRequests(pTransceiver, receivedTime))) {
+        DLOGW("Failed to send NACK for ssrc %u", ssrc);
+    }
 
 CleanUp:
-    if (packetsReceived > 0) {
-        MUTEX_LOCK(pTransceiver->statsLock);
-        pTransceiver->inboundStats.received.packetsReceived += packetsReceived;
-        pTransceiver->inboundStats.packetsFailedDecryption += packetsFailedDecryption;
+    if (locked) {
+        MUTEX_UNLOCK(pTransceiver->jitterBufferLock);
+    }
+    if (pTransceiver != NULL) {
+        rtp_transceiver_lockStats(pTransceiver);
+        pTransceiver->inboundStats.received.packetsReceived++;
+        if (STATUS_FAILED(decryptStatus)) {
+            pTransceiver->inboundStats.packetsFailedDecryption++;
+        }
         pTransceiver->inboundStats.lastPacketReceivedTimestamp = lastPacketReceivedTimestamp;
         pTransceiver->inboundStats.headerBytesReceived += headerBytesReceived;
         pTransceiver->inboundStats.bytesReceived += bytesReceived;
         pTransceiver->inboundStats.received.jitter = pTransceiver->pJitterBuffer->jitter / pTransceiver->pJitterBuffer->clockRate;
         pTransceiver->inboundStats.received.packetsDiscarded = packetsDiscarded;
-        MUTEX_UNLOCK(pTransceiver->statsLock);
+        // retransmissions are a separate rtp stream, https://tools.ietf.org/html/rfc4588#section-5
+        if (isMediaPacket) {
+            rtcp_packet_updateReceptionStats(&pTransceiver->receptionStats, sequenceNumber);
+        }
+        rtp_transceiver_unlockStats(pTransceiver);
     }
     if (!ownedByJitterBuffer) {
-        SAFE_MEMFREE(pPayload);
+        SAFE_MEMFREE(pPacket);
         rtp_packet_free(&pRtpPacket);
         CHK_LOG_ERR(retStatus);
     }
     PC_LEAVE();
     return retStatus;
 }
+
+STATUS pc_sendPacketToRtpReceiver(PKvsPeerConnection pKvsPeerConnection, PBYTE pBuffer, UINT32 bufferLen)
+{
+    PC_ENTER();
+    STATUS retStatus = STATUS_SUCCESS, decryptStatus;
+    PKvsRtpTransceiver pTransceiver;
+    UINT64 now;
+    UINT32 ssrc;
+    PBYTE pPayload = NULL;
+
+    CHK(pKvsPeerConnection != NULL && pBuffer != NULL, STATUS_PEER_CONN_NULL_ARG);
+    CHK(bufferLen >= MIN_HEADER_LENGTH, STATUS_INVALID_ARG);
+
+    ssrc = getInt32(*(PUINT32)(pBuffer + SSRC_OFFSET));
+    if (NULL == (pTransceiver = pc_findReceivingTransceiver(pKvsPeerConnection, ssrc))) {
+        DLOGW("No transceiver to handle inbound ssrc %u", ssrc);
+        CHK(FALSE, STATUS_SUCCESS);
+    }
+
+    now = GETTIME();
+    if (pKvsPeerConnection->pSrtpPipeline != NULL) {
+        // the buffer belongs to the listener, the workers decrypt a copy in place
+        CHK(NULL != (pPayload = (PBYTE) MEMALLOC(bufferLen)), STATUS_PEER_CONN_NOT_ENOUGH_MEMORY);
+        MEMCPY(pPayload, pBuffer, bufferLen);
+        CHK_STATUS(srtp_pipeline_submit(pKvsPeerConnection->pSrtpPipeline, (UINT16) getUnalignedInt16BigEndian(pBuffer + SEQ_NUMBER_OFFSET),
+                                        pPayload, bufferLen, now));
+        // taken over by the pipeline also when it failed
+        pPayload = NULL;
+    } else {
+        decryptStatus = srtp_session_decryptSrtpPacket(pKvsPeerConnection->pSrtpSession, pBuffer, (PINT32) &bufferLen);
+        if (STATUS_SUCCEEDED(decryptStatus)) {
+            CHK(NULL != (pPayload = (PBYTE) MEMALLOC(bufferLen)), STATUS_PEER_CONN_NOT_ENOUGH_MEMORY);
+            MEMCPY(pPayload, pBuffer, bufferLen);
+        }
+        retStatus = pc_receiveRtpPacket(pTransceiver, pPayload, bufferLen, now, decryptStatus);
+        pPayload = NULL;
+    }
+
+CleanUp:
+    SAFE_MEMFREE(pPayload);
+    PC_LEAVE();
+    return retStatus;
+}
+
+STATUS pc_onDecryptedRtpPacket(UINT64 customData, PBYTE pPacket, UINT32 packetLen, UINT64 receivedTime, STATUS decryptStatus)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection = (PKvsPeerConnection) customData;
+    PKvsRtpTransceiver pTransceiver;
+
+    CHK(pKvsPeerConnection != NULL && pPacket != NULL, STATUS_PEER_CONN_NULL_ARG);
+    // checked when the packet was submitted, the transceiver is still there as the pipeline is freed first
+    pTransceiver = pc_findReceivingTransceiver(pKvsPeerConnection, getInt32(*(PUINT32)(pPacket + SSRC_OFFSET)));
+    CHK(pTransceiver != NULL, STATUS_SUCCESS);
+    retStatus = pc_receiveRtpPacket(pTransceiver, pPacket, packetLen, receivedTime, decryptStatus);
+    pPacket = NULL;
+
+CleanUp:
+    SAFE_MEMFREE(pPacket);
+    return retStatus;
+}
 #endif
 
 STATUS pc_changeState(PKvsPeerConnection pKvsPeerConnection, RTC_PEER_CONNECTION_STATE newState)
@@ -382,6 +495,53 @@ CleanUp:
 }
 
 #ifdef ENABLE_STREAMING
+/**
+ * @brief hand the frame [startIndex, endIndex] to onSlicedFrame. Its packets leave the jitter buffer with it and are freed
+ *        when the application releases the frame.
+ */
+static STATUS pc_emitSlicedFrame(PKvsRtpTransceiver pTransceiver, UINT16 startIndex, UINT16 endIndex, UINT32 frameSize, UINT32 index,
+                                 UINT64 presentationTs)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtpSlicedFrame pSlicedFrame = NULL;
+    UINT32 packetCount = (UINT16)(endIndex - startIndex + 1), sliceCount = 0, filledSize = 0, i;
+
+    CHK(pTransceiver->depayPayloadSlicesFn != NULL, STATUS_NOT_IMPLEMENTED);
+    CHK_STATUS(
+        jitter_buffer_fillFrameSlices(pTransceiver->pJitterBuffer, pTransceiver->depayPayloadSlicesFn, NULL, &sliceCount, startIndex, endIndex));
+
+    pSlicedFrame = (PRtpSlicedFrame) MEMCALLOC(1, SIZEOF(RtpSlicedFrame) + packetCount * SIZEOF(PRtpPacket) + sliceCount * SIZEOF(RtcFrameSlice));
+    CHK(pSlicedFrame != NULL, STATUS_PEER_CONN_NOT_ENOUGH_MEMORY);
+    pSlicedFrame->pPackets = (PRtpPacket*) (pSlicedFrame + 1);
+    pSlicedFrame->frame.pSlices = (PRtcFrameSlice) (pSlicedFrame->pPackets + packetCount);
+    pSlicedFrame->frame.sliceCount = sliceCount;
+
+    CHK_STATUS(jitter_buffer_fillFrameSlices(pTransceiver->pJitterBuffer, pTransceiver->depayPayloadSlicesFn, pSlicedFrame->frame.pSlices,
+                                             &pSlicedFrame->frame.sliceCount, startIndex, endIndex));
+    for (i = 0; i < pSlicedFrame->frame.sliceCount; i++) {
+        filledSize += pSlicedFrame->frame.pSlices[i].size;
+    }
+    CHK(frameSize == filledSize, STATUS_INVALID_ARG_LEN);
+
+    // the jitter buffer skips the detached packets when it drops the frame
+    pSlicedFrame->packetCount = packetCount;
+    CHK_STATUS(jitter_buffer_detachPackets(pTransceiver->pJitterBuffer, pSlicedFrame->pPackets, startIndex, endIndex));
+
+    pSlicedFrame->frame.index = index;
+    pSlicedFrame->frame.decodingTs = presentationTs;
+    pSlicedFrame->frame.presentationTs = presentationTs;
+    pSlicedFrame->frame.size = frameSize;
+    pTransceiver->onSlicedFrame(pTransceiver->onSlicedFrameCustomData, &pSlicedFrame->frame);
+    pSlicedFrame = NULL;
+
+CleanUp:
+    if (pSlicedFrame != NULL) {
+        rtp_transceiver_releaseSlicedFrame(&pSlicedFrame->frame);
+    }
+
+    return retStatus;
+}
+
 STATUS pc_onFrameReady(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 frameSize)
 {
     PC_ENTER();
@@ -389,29 +549,43 @@ STATUS pc_onFrameReady(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UI
     PKvsRtpTransceiver pTransceiver = (PKvsRtpTransceiver) customData;
     PRtpPacket pPacket = NULL;
     Frame frame;
-    UINT64 hashValue;
     UINT32 filledSize = 0, index;
+    UINT64 targetDelay = 0, presentationTs, extraDelay = 0;
 
     CHK(pTransceiver != NULL, STATUS_PEER_CONN_NULL_ARG);
 
     // TODO: handle multi-packet frames
-    retStatus = hash_table_get(pTransceiver->pJitterBuffer->pPkgBufferHashTable, startIndex, &hashValue);
-    pPacket = (PRtpPacket) hashValue;
-    if (retStatus == STATUS_SUCCESS || retStatus == STATUS_HASH_KEY_NOT_PRESENT) {
-        retStatus = STATUS_SUCCESS;
-    } else {
-        CHK(FALSE, retStatus);
-    }
+    CHK_STATUS(jitter_buffer_getPacket(pTransceiver->pJitterBuffer, startIndex, &pPacket));
     CHK(pPacket != NULL, STATUS_PEER_CONN_NULL_ARG);
-    MUTEX_LOCK(pTransceiver->statsLock);
+    CHK_STATUS(jitter_buffer_getTargetDelay(pTransceiver->pJitterBuffer, &targetDelay));
+    rtp_transceiver_lockStats(pTransceiver);
     // https://www.w3.org/TR/webrtc-stats/#dom-rtcinboundrtpstreamstats-jitterbufferdelay
     pTransceiver->inboundStats.jitterBufferDelay += (DOUBLE)(GETTIME() - pPacket->receivedTime) / HUNDREDS_OF_NANOS_IN_A_SECOND;
+    // https://www.w3.org/TR/webrtc-stats/#dom-rtcinboundrtpstreamstats-jitterbuffertargetdelay
+    pTransceiver->inboundStats.jitterBufferTargetDelay += (DOUBLE) targetDelay / HUNDREDS_OF_NANOS_IN_A_SECOND;
     index = pTransceiver->inboundStats.jitterBufferEmittedCount;
     pTransceiver->inboundStats.jitterBufferEmittedCount++;
     if (MEDIA_STREAM_TRACK_KIND_VIDEO == pTransceiver->transceiver.receiver.track.kind) {
         pTransceiver->inboundStats.framesReceived++;
     }
-    MUTEX_UNLOCK(pTransceiver->statsLock);
+    rtp_transceiver_unlockStats(pTransceiver);
+
+    if (pTransceiver->pNackGenerator != NULL) {
+        CHK_STATUS(nack_generator_cancelUpTo(pTransceiver->pNackGenerator, endIndex));
+    }
+
+    presentationTs = pPacket->header.timestamp * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    if (pTransceiver->playoutSyncStream != PLAYOUT_SYNC_STREAM_NONE) {
+        CHK_STATUS(playout_sync_onFrame(pTransceiver->pKvsPeerConnection->pPlayoutSync, pTransceiver->playoutSyncStream, pPacket->header.timestamp,
+                                        GETTIME(), &presentationTs, &extraDelay));
+        CHK_STATUS(jitter_buffer_setExtraDelay(pTransceiver->pJitterBuffer, extraDelay));
+    }
+
+    if (pTransceiver->onSlicedFrame != NULL) {
+        // nothing is copied, the application reads the frame from the packets
+        CHK_STATUS(pc_emitSlicedFrame(pTransceiver, startIndex, endIndex, frameSize, index, presentationTs));
+        CHK(FALSE, retStatus);
+    }
 
     if (frameSize > pTransceiver->peerFrameBufferSize) {
         MEMFREE(pTransceiver->peerFrameBuffer);
@@ -424,8 +598,8 @@ STATUS pc_onFrameReady(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UI
     CHK(frameSize == filledSize, STATUS_INVALID_ARG_LEN);
 
     frame.version = FRAME_CURRENT_VERSION;
-    frame.decodingTs = pPacket->header.timestamp * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
-    frame.presentationTs = frame.decodingTs;
+    frame.decodingTs = presentationTs;
+    frame.presentationTs = presentationTs;
     frame.frameData = pTransceiver->peerFrameBuffer;
     frame.size = frameSize;
     frame.duration = 0;
@@ -444,32 +618,41 @@ CleanUp:
 STATUS pc_onFrameDrop(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 timestamp)
 {
     PC_ENTER();
-    UNUSED_PARAM(endIndex);
     STATUS retStatus = STATUS_SUCCESS;
-    UINT64 hashValue = 0;
     PRtpPacket pPacket = NULL;
     PKvsRtpTransceiver pTransceiver = (PKvsRtpTransceiver) customData;
+    UINT16 index = startIndex;
 
     DLOGW("Frame with timestamp %u is dropped!", timestamp);
     CHK(pTransceiver != NULL, STATUS_PEER_CONN_NULL_ARG);
 
-    retStatus = hash_table_get(pTransceiver->pJitterBuffer->pPkgBufferHashTable, startIndex, &hashValue);
-    pPacket = (PRtpPacket) hashValue;
-    if (retStatus == STATUS_SUCCESS || retStatus == STATUS_HASH_KEY_NOT_PRESENT) {
-        retStatus = STATUS_SUCCESS;
-    } else {
-        CHK(FALSE, retStatus);
+    // the jitter buffer gave up on the frame, its missing packets are not needed anymore
+    if (pTransceiver->pNackGenerator != NULL) {
+        CHK_STATUS(nack_generator_cancelUpTo(pTransceiver->pNackGenerator, endIndex));
     }
 
-    // TODO: handle multi-packet frames
-    CHK(pPacket != NULL, STATUS_PEER_CONN_NULL_ARG);
-    MUTEX_LOCK(pTransceiver->statsLock);
-    // https://www.w3.org/TR/webrtc-stats/#dom-rtcinboundrtpstreamstats-jitterbufferdelay
-    pTransceiver->inboundStats.jitterBufferDelay += (DOUBLE)(GETTIME() - pPacket->receivedTime) / HUNDREDS_OF_NANOS_IN_A_SECOND;
-    pTransceiver->inboundStats.jitterBufferEmittedCount++;
+    // the frames following the dropped one cannot be decoded until the next key frame, also when none of its packets arrived
+    if (MEDIA_STREAM_TRACK_KIND_VIDEO == pTransceiver->transceiver.receiver.track.kind &&
+        STATUS_FAILED(rtcp_sendKeyFrameRequest(pTransceiver, GETTIME()))) {
+        DLOGW("Failed to request a key frame for ssrc %u", pTransceiver->jitterBufferSsrc);
+    }
+
+    // the delay is measured from the first packet of the frame which did arrive, the leading ones are often the lost ones
+    CHK_STATUS(jitter_buffer_getPacket(pTransceiver->pJitterBuffer, index, &pPacket));
+    while (pPacket == NULL && index != endIndex) {
+        index++;
+        CHK_STATUS(jitter_buffer_getPacket(pTransceiver->pJitterBuffer, index, &pPacket));
+    }
+
+    rtp_transceiver_lockStats(pTransceiver);
+    if (pPacket != NULL) {
+        // https://www.w3.org/TR/webrtc-stats/#dom-rtcinboundrtpstreamstats-jitterbufferdelay
+        pTransceiver->inboundStats.jitterBufferDelay += (DOUBLE)(GETTIME() - pPacket->receivedTime) / HUNDREDS_OF_NANOS_IN_A_SECOND;
+        pTransceiver->inboundStats.jitterBufferEmittedCount++;
+    }
     pTransceiver->inboundStats.received.framesDropped++;
     pTransceiver->inboundStats.received.fullFramesLost++;
-    MUTEX_UNLOCK(pTransceiver->statsLock);
+    rtp_transceiver_unlockStats(pTransceiver);
 
 CleanUp:
     PC_LEAVE();
@@ -745,10 +928,7 @@ STATUS pc_rtcpReportsCallback(UINT32 timerId, UINT64 currentTime, UINT64 customD
 {
     UNUSED_PARAM(timerId);
     STATUS retStatus = STATUS_SUCCESS;
-    BOOL ready = FALSE;
-    UINT64 ntpTime, rtpTime, delay;
-    UINT32 packetCount, octetCount, packetLen, allocSize, ssrc;
-    PBYTE rawPacket = NULL;
+    UINT64 delay;
     PKvsPeerConnection pKvsPeerConnection = NULL;
 
     PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) customData;
@@ -756,46 +936,13 @@ STATUS pc_rtcpReportsCallback(UINT32 timerId, UINT64 currentTime, UINT64 customD
         STATUS_PEER_CONN_NULL_ARG);
     pKvsPeerConnection = pKvsRtpTransceiver->pKvsPeerConnection;
 
-    ssrc = pKvsRtpTransceiver->sender.ssrc;
-    DLOGS("pc_rtcpReportsCallback %" PRIu64 " ssrc: %u rtxssrc: %u", currentTime, ssrc, pKvsRtpTransceiver->sender.rtxSsrc);
-
-    // check if ice agent is connected, reschedule in 200msec if not
-    ready = pKvsPeerConnection->pSrtpSession != NULL &&
-        (currentTime - pKvsRtpTransceiver->sender.firstFrameWallClockTime >= 2500 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
-    if (!ready) {
-        DLOGV("sender report no frames sent %u", ssrc);
-    } else {
-        // create rtcp sender report packet
-        // https://tools.ietf.org/html/rfc3550#section-6.4.1
-        ntpTime = rtcp_packet_convertTimestampToNTP(currentTime);
-        rtpTime = pKvsRtpTransceiver->sender.rtpTimeOffset +
-            CONVERT_TIMESTAMP_TO_RTP(pKvsRtpTransceiver->pJitterBuffer->clockRate, currentTime - pKvsRtpTransceiver->sender.firstFrameWallClockTime);
-        MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
-        packetCount = pKvsRtpTransceiver->outboundStats.sent.packetsSent;
-        octetCount = pKvsRtpTransceiver->outboundStats.sent.bytesSent;
-        MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
-        DLOGV("sender report %u %" PRIu64 " %" PRIu64 " : %u packets %u bytes", ssrc, ntpTime, rtpTime, packetCount, octetCount);
-        packetLen = RTCP_PACKET_HEADER_LEN + 24;
-
-        // srtp_protect_rtcp() in srtp_session_encryptRtcpPacket() assumes memory availability to write 10 bytes of authentication tag and
-        // SRTP_MAX_TRAILER_LEN + 4 following the actual rtcp Packet payload
-        allocSize = packetLen + SRTP_AUTH_TAG_OVERHEAD + SRTP_MAX_TRAILER_LEN + 4;
-        CHK(NULL != (rawPacket = (PBYTE) MEMALLOC(allocSize)), STATUS_PEER_CONN_NOT_ENOUGH_MEMORY);
-        rawPacket[0] = RTCP_PACKET_VERSION_VAL << 6;
-        rawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_SENDER_REPORT;
-        putUnalignedInt16BigEndian(rawPacket + RTCP_PACKET_LEN_OFFSET,
-                                   (packetLen / RTCP_PACKET_LEN_WORD_SIZE) - 1); // The length of this RTCP packet in 32-bit words minus one
-        putUnalignedInt32BigEndian(rawPacket + 4, ssrc);
-        putUnalignedInt64BigEndian(rawPacket + 8, ntpTime);
-        putUnalignedInt32BigEndian(rawPacket + 16, rtpTime);
-        putUnalignedInt32BigEndian(rawPacket + 20, packetCount);
-        putUnalignedInt32BigEndian(rawPacket + 24, octetCount);
-        CHK_STATUS(srtp_session_encryptRtcpPacket(pKvsPeerConnection->pSrtpSession, rawPacket, (PINT32) &packetLen));
-        CHK_STATUS(ice_agent_send(pKvsPeerConnection->pIceAgent, rawPacket, packetLen));
-    }
+    DLOGS("pc_rtcpReportsCallback %" PRIu64 " ssrc: %u rtxssrc: %u", currentTime, pKvsRtpTransceiver->sender.ssrc,
+          pKvsRtpTransceiver->sender.rtxSsrc);
+    // a report which could not be sent does not stop the next ones
+    CHK_LOG_ERR(rtcp_sendReports(pKvsRtpTransceiver, currentTime));
 
     delay = 100 + (RAND() % 200);
-    DLOGS("next sender report %u in %" PRIu64 " msec", ssrc, delay);
+    DLOGS("next rtcp report %u in %" PRIu64 " msec", pKvsRtpTransceiver->sender.ssrc, delay);
     // reschedule timer with 200msec +- 100ms
     CHK_STATUS(timer_queue_addTimer(pKvsPeerConnection->timerQueueHandle, delay * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
                                     TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, pc_rtcpReportsCallback, (UINT64) pKvsRtpTransceiver,
@@ -803,7 +950,34 @@ STATUS pc_rtcpReportsCallback(UINT32 timerId, UINT64 currentTime, UINT64 customD
 
 CleanUp:
     CHK_LOG_ERR(retStatus);
-    SAFE_MEMFREE(rawPacket);
+    return retStatus;
+}
+
+/**
+ * @brief release the frames the jitter buffer of the transceiver holds for the target delay once they are due, without
+ *        waiting for the next packet.
+ *
+ * @param[in] timerId
+ * @param[in] currentTime
+ * @param[in] customData the transceiver.
+ *
+ * @return STATUS status of execution.
+ */
+STATUS pc_jitterBufferReleaseCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(timerId);
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) customData;
+
+    CHK(pKvsRtpTransceiver != NULL && pKvsRtpTransceiver->pJitterBuffer != NULL, STATUS_PEER_CONN_NULL_ARG);
+
+    MUTEX_LOCK(pKvsRtpTransceiver->jitterBufferLock);
+    retStatus = jitter_buffer_releaseDueFrames(pKvsRtpTransceiver->pJitterBuffer, currentTime);
+    MUTEX_UNLOCK(pKvsRtpTransceiver->jitterBufferLock);
+
+CleanUp:
+    // a failed release is retried on the next period
+    CHK_LOG_ERR(retStatus);
     return retStatus;
 }
 #endif
@@ -816,6 +990,7 @@ STATUS pc_create(PRtcConfiguration pConfiguration, PRtcPeerConnection* ppPeerCon
     IceAgentCallbacks iceAgentCallbacks;
     DtlsSessionCallbacks dtlsSessionCallbacks;
     PConnectionListener pConnectionListener = NULL;
+    INT32 listenerCpu = THREAD_ANY_CPU;
 
     CHK(pConfiguration != NULL && ppPeerConnection != NULL, STATUS_PEER_CONN_NULL_ARG);
 
@@ -825,7 +1000,21 @@ STATUS pc_create(PRtcConfiguration pConfiguration, PRtcPeerConnection* ppPeerCon
     pKvsPeerConnection = (PKvsPeerConnection) MEMCALLOC(1, SIZEOF(KvsPeerConnection));
     CHK(pKvsPeerConnection != NULL, STATUS_PEER_CONN_NOT_ENOUGH_MEMORY);
 
-    CHK_STATUS(timer_queue_createEx(&pKvsPeerConnection->timerQueueHandle, PEER_TIMER_NAME, PEER_TIMER_SIZE));
+    if (pConfiguration->kvsRtcConfiguration.pRuntime != NULL) {
+        retStatus = rtc_runtime_attach(pConfiguration->kvsRtcConfiguration.pRuntime, &pKvsPeerConnection->timerQueueHandle, &listenerCpu);
+    } else if (IS_VALID_TIMER_QUEUE_HANDLE(gPeerTimerQueueHandle)) {
+        retStatus = timer_queue_attachWithReserve(gPeerTimerQueueHandle, PEER_TIMER_COUNT_PER_PEER, &pKvsPeerConnection->timerQueueHandle);
+    }
+    // the shared timer thread does not grow, a peer connection which does not fit any more runs its timers on its own
+    if (retStatus == STATUS_MAX_TIMER_COUNT_REACHED) {
+        DLOGW("The shared timer thread is full, the peer connection creates its own");
+        retStatus = STATUS_SUCCESS;
+    }
+    CHK_STATUS(retStatus);
+    if (!IS_VALID_TIMER_QUEUE_HANDLE(pKvsPeerConnection->timerQueueHandle)) {
+        CHK_STATUS(
+            timer_queue_createWithCapacity(&pKvsPeerConnection->timerQueueHandle, PEER_TIMER_NAME, PEER_TIMER_SIZE, PEER_TIMER_COUNT_PER_PEER));
+    }
 
     pKvsPeerConnection->peerConnection.version = PEER_CONNECTION_CURRENT_VERSION;
     CHK_STATUS(json_generateSafeString(pKvsPeerConnection->localIceUfrag, LOCAL_ICE_UFRAG_LEN));
@@ -844,6 +1033,7 @@ STATUS pc_create(PRtcConfiguration pConfiguration, PRtcPeerConnection* ppPeerCon
     CHK_STATUS(hash_table_createWithParams(RTX_HASH_TABLE_BUCKET_COUNT, RTX_HASH_TABLE_BUCKET_LENGTH, &pKvsPeerConnection->pRtxTable));
     CHK_STATUS(double_list_create(&(pKvsPeerConnection->pTransceivers)));
 #ifdef ENABLE_STREAMING
+    CHK_STATUS(ssrc_map_create(SSRC_MAP_DEFAULT_CAPACITY, &pKvsPeerConnection->pSsrcMap));
     pKvsPeerConnection->pSrtpSessionLock = MUTEX_CREATE(TRUE);
 #endif
     pKvsPeerConnection->peerConnectionObjLock = MUTEX_CREATE(FALSE);
@@ -851,6 +1041,20 @@ STATUS pc_create(PRtcConfiguration pConfiguration, PRtcPeerConnection* ppPeerCon
     pKvsPeerConnection->MTU = pConfiguration->kvsRtcConfiguration.maximumTransmissionUnit == 0
         ? DEFAULT_MTU_SIZE
         : pConfiguration->kvsRtcConfiguration.maximumTransmissionUnit;
+    pKvsPeerConnection->adaptiveJitterBuffer = pConfiguration->kvsRtcConfiguration.enableAdaptiveJitterBuffer;
+#ifdef ENABLE_STREAMING
+    pKvsPeerConnection->srtpDecryptWorkerCount = MIN(pConfiguration->kvsRtcConfiguration.srtpDecryptWorkerCount, SRTP_PIPELINE_MAX_WORKERS);
+    pKvsPeerConnection->maxHistoryBytes = pConfiguration->kvsRtcConfiguration.maxRetransmissionHistoryBytes == 0
+        ? DEFAULT_RTP_HISTORY_MAX_PEER_BYTES
+        : pConfiguration->kvsRtcConfiguration.maxRetransmissionHistoryBytes;
+    pKvsPeerConnection->rtcpBuilderLock = MUTEX_CREATE(FALSE);
+    CHK_STATUS(rtcp_builder_create(pKvsPeerConnection->MTU > RTCP_SRTCP_OVERHEAD ? pKvsPeerConnection->MTU - RTCP_SRTCP_OVERHEAD
+                                                                                 : pKvsPeerConnection->MTU,
+                                   RTCP_SRTCP_TAIL_LEN, &pKvsPeerConnection->pRtcpBuilder));
+    if (pConfiguration->kvsRtcConfiguration.enablePlayoutSync) {
+        CHK_STATUS(playout_sync_create(&pKvsPeerConnection->pPlayoutSync));
+    }
+#endif
     pKvsPeerConnection->sctpIsEnabled = FALSE;
 
     iceAgentCallbacks.customData = (UINT64) pKvsPeerConnection;
@@ -858,6 +1062,8 @@ STATUS pc_create(PRtcConfiguration pConfiguration, PRtcPeerConnection* ppPeerCon
     iceAgentCallbacks.onIceAgentStateChange = pc_onIceAgentStateChange;
     iceAgentCallbacks.newLocalCandidateFn = pc_onNewIceLocalCandidate;
     CHK_STATUS(connection_listener_create(&pConnectionListener));
+    // the listener thread starts with the gathering, it runs next to the worker of the peer connection
+    pConnectionListener->receiveDataCpu = listenerCpu;
     // IceAgent will own the lifecycle of pConnectionListener;
     CHK_STATUS(ice_agent_create(pKvsPeerConnection->localIceUfrag, pKvsPeerConnection->localIcePwd, &iceAgentCallbacks, pConfiguration,
                                 pKvsPeerConnection->timerQueueHandle, pConnectionListener, &pKvsPeerConnection->pIceAgent));
@@ -905,6 +1111,9 @@ STATUS pc_free(PRtcPeerConnection* ppPeerConnection)
     if (IS_VALID_TIMER_QUEUE_HANDLE(pKvsPeerConnection->timerQueueHandle)) {
         timer_queue_shutdown(pKvsPeerConnection->timerQueueHandle);
     }
+    if (IS_VALID_TIMER_QUEUE_HANDLE(pKvsPeerConnection->frameReleaseTimerQueueHandle)) {
+        timer_queue_shutdown(pKvsPeerConnection->frameReleaseTimerQueueHandle);
+    }
 /* Free structs that have their own thread. SCTP has threads created by SCTP library. IceAgent has the
  * connectionListener thread. Free SCTP first so it wont try to send anything through ICE. */
 #ifdef ENABLE_DATA_CHANNEL
@@ -913,6 +1122,8 @@ STATUS pc_free(PRtcPeerConnection* ppPeerConnection)
     CHK_LOG_ERR(ice_agent_free(&pKvsPeerConnection->pIceAgent));
 
 #ifdef ENABLE_STREAMING
+    // the decrypt workers hand the packets to the transceivers
+    CHK_LOG_ERR(srtp_pipeline_free(&pKvsPeerConnection->pSrtpPipeline));
     // free transceivers
     CHK_LOG_ERR(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
     while (pCurNode != NULL) {
@@ -937,12 +1148,19 @@ STATUS pc_free(PRtcPeerConnection* ppPeerConnection)
 
 #ifdef ENABLE_STREAMING
     CHK_LOG_ERR(double_list_free(pKvsPeerConnection->pTransceivers));
+    CHK_LOG_ERR(ssrc_map_free(&pKvsPeerConnection->pSsrcMap));
     CHK_LOG_ERR(hash_table_free(pKvsPeerConnection->pCodecTable));
     CHK_LOG_ERR(hash_table_free(pKvsPeerConnection->pRtxTable));
+    CHK_LOG_ERR(playout_sync_free(&pKvsPeerConnection->pPlayoutSync));
     if (IS_VALID_MUTEX_VALUE(pKvsPeerConnection->pSrtpSessionLock)) {
         MUTEX_FREE(pKvsPeerConnection->pSrtpSessionLock);
         pKvsPeerConnection->pSrtpSessionLock = INVALID_MUTEX_VALUE;
     }
+    CHK_LOG_ERR(rtcp_builder_free(&pKvsPeerConnection->pRtcpBuilder));
+    if (IS_VALID_MUTEX_VALUE(pKvsPeerConnection->rtcpBuilderLock)) {
+        MUTEX_FREE(pKvsPeerConnection->rtcpBuilderLock);
+        pKvsPeerConnection->rtcpBuilderLock = INVALID_MUTEX_VALUE;
+    }
 #endif
 
     if (IS_VALID_MUTEX_VALUE(pKvsPeerConnection->peerConnectionObjLock)) {
@@ -952,6 +1170,9 @@ STATUS pc_free(PRtcPeerConnection* ppPeerConnection)
     if (IS_VALID_TIMER_QUEUE_HANDLE(pKvsPeerConnection->timerQueueHandle)) {
         timer_queue_free(&pKvsPeerConnection->timerQueueHandle);
     }
+    if (IS_VALID_TIMER_QUEUE_HANDLE(pKvsPeerConnection->frameReleaseTimerQueueHandle)) {
+        timer_queue_free(&pKvsPeerConnection->frameReleaseTimerQueueHandle);
+    }
 
     SAFE_MEMFREE(pKvsPeerConnection);
     *ppPeerConnection = NULL;
@@ -1105,6 +1326,10 @@ STATUS pc_setRemoteDescription(PRtcPeerConnection pPeerConnection, PRtcSessionDe
     STATUS retStatus = STATUS_SUCCESS;
     PCHAR remoteIceUfrag = NULL, remoteIcePwd = NULL;
     UINT32 i, j;
+#ifdef ENABLE_STREAMING
+    PDoubleListNode pCurNode = NULL;
+    UINT64 item;
+#endif
 
     CHK(pPeerConnection != NULL, STATUS_PEER_CONN_NULL_ARG);
     PKvsPeerConnection pKvsPeerConnection = (PKvsPeerConnection) pPeerConnection;
@@ -1184,8 +1409,19 @@ STATUS pc_setRemoteDescription(PRtcPeerConnection pPeerConnection, PRtcSessionDe
     if (!pKvsPeerConnection->isOffer) {
         CHK_STATUS(sdp_setPayloadTypesFromOffer(pKvsPeerConnection->pCodecTable, pKvsPeerConnection->pRtxTable, pSessionDescription));
     }
-    CHK_STATUS(sdp_setTransceiverPayloadTypes(pKvsPeerConnection->pCodecTable, pKvsPeerConnection->pRtxTable, pKvsPeerConnection->pTransceivers));
+    CHK_STATUS(sdp_setTransceiverPayloadTypes(pKvsPeerConnection->pCodecTable, pKvsPeerConnection->pRtxTable, pKvsPeerConnection->pTransceivers,
+                                              pKvsPeerConnection->maxHistoryBytes));
     CHK_STATUS(sdp_setReceiversSsrc(pSessionDescription, pKvsPeerConnection->pTransceivers));
+    if (pKvsPeerConnection->isOffer) {
+        CHK_STATUS(sdp_setSimulcastParameters(pSessionDescription, pKvsPeerConnection->pTransceivers));
+    }
+    // the remote ssrcs are known now
+    CHK_STATUS(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
+    while (pCurNode != NULL) {
+        CHK_STATUS(double_list_getNodeData(pCurNode, &item));
+        CHK_STATUS(rtp_transceiver_mapSsrcs((PKvsRtpTransceiver) item));
+        pCurNode = pCurNode->pNext;
+    }
 #endif
 #ifdef KVSWEBRTC_HAVE_GETENV
     if (NULL != GETENV(DEBUG_LOG_SDP)) {
@@ -1287,8 +1523,10 @@ STATUS pc_addTransceiver(PRtcPeerConnection pPeerConnection, PRtcMediaStreamTrac
     PKvsPeerConnection pKvsPeerConnection = (PKvsPeerConnection) pPeerConnection;
     PJitterBuffer pJitterBuffer = NULL;
     DepayRtpPayloadFunc depayFunc;
-    UINT32 clockRate = 0;
-    UINT32 ssrc = (UINT32) RAND(), rtxSsrc = (UINT32) RAND();
+    DepayRtpPayloadSlicesFunc depaySlicesFunc;
+    UINT32 clockRate = 0, syncStream;
+    BOOL syncStreamClaimed = FALSE;
+    UINT32 ssrc, rtxSsrc;
     RTC_RTP_TRANSCEIVER_DIRECTION direction = RTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV;
 
     if (pRtcRtpTransceiverInit != NULL) {
@@ -1300,22 +1538,26 @@ STATUS pc_addTransceiver(PRtcPeerConnection pPeerConnection, PRtcMediaStreamTrac
     switch (pRtcMediaStreamTrack->codec) {
         case RTC_CODEC_OPUS:
             depayFunc = depayOpusFromRtpPayload;
+            depaySlicesFunc = depayOpusSlicesFromRtpPayload;
             clockRate = OPUS_CLOCKRATE;
             break;
 
         case RTC_CODEC_MULAW:
         case RTC_CODEC_ALAW:
             depayFunc = depayG711FromRtpPayload;
+            depaySlicesFunc = depayG711SlicesFromRtpPayload;
             clockRate = PCM_CLOCKRATE;
             break;
 
         case RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE:
             depayFunc = depayH264FromRtpPayload;
+            depaySlicesFunc = depayH264SlicesFromRtpPayload;
             clockRate = VIDEO_CLOCKRATE;
             break;
 
         case RTC_CODEC_VP8:
             depayFunc = depayVP8FromRtpPayload;
+            depaySlicesFunc = depayVP8SlicesFromRtpPayload;
             clockRate = VIDEO_CLOCKRATE;
             break;
 
@@ -1323,22 +1565,54 @@ STATUS pc_addTransceiver(PRtcPeerConnection pPeerConnection, PRtcMediaStreamTrac
             CHK(FALSE, STATUS_NOT_IMPLEMENTED);
     }
 
-    // TODO: Add ssrc duplicate detection here not only relying on RAND()
+    ssrc = rtp_generateSsrc(pKvsPeerConnection, NULL, 0);
+    rtxSsrc = rtp_generateSsrc(pKvsPeerConnection, &ssrc, 1);
     CHK_STATUS(rtp_createTransceiver(direction, pKvsPeerConnection, ssrc, rtxSsrc, pRtcMediaStreamTrack, NULL, pRtcMediaStreamTrack->codec,
                                      &pKvsRtpTransceiver));
     CHK_STATUS(jitter_buffer_create(pc_onFrameReady, pc_onFrameDrop, depayFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY, clockRate,
                                     (UINT64) pKvsRtpTransceiver, &pJitterBuffer));
+    CHK_STATUS(jitter_buffer_setAdaptiveDelay(pJitterBuffer, pKvsPeerConnection->adaptiveJitterBuffer));
     CHK_STATUS(rtp_transceiver_setJitterBuffer(pKvsRtpTransceiver, pJitterBuffer));
+    pKvsRtpTransceiver->depayPayloadSlicesFn = depaySlicesFunc;
+
+    if (pKvsPeerConnection->pPlayoutSync != NULL && direction != RTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY) {
+        syncStream = pRtcMediaStreamTrack->kind == MEDIA_STREAM_TRACK_KIND_VIDEO ? PLAYOUT_SYNC_STREAM_VIDEO : PLAYOUT_SYNC_STREAM_AUDIO;
+        CHK_STATUS(playout_sync_claimStream(pKvsPeerConnection->pPlayoutSync, syncStream, &syncStreamClaimed));
+        if (syncStreamClaimed) {
+            pKvsRtpTransceiver->playoutSyncStream = syncStream;
+        }
+    }
 
     // after pKvsRtpTransceiver is successfully created, jitterBuffer will be freed by pKvsRtpTransceiver.
     pJitterBuffer = NULL;
 
+    // lost video packets are requested again with generic NACK, which every video codec offers through rtcp-fb
+    if (pRtcMediaStreamTrack->kind == MEDIA_STREAM_TRACK_KIND_VIDEO && direction != RTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY) {
+        CHK_STATUS(nack_generator_create(NACK_GENERATOR_DEFAULT_MAX_RETRIES, &pKvsRtpTransceiver->pNackGenerator));
+    }
+
     CHK_STATUS(double_list_insertItemHead(pKvsPeerConnection->pTransceivers, (UINT64) pKvsRtpTransceiver));
+    CHK_STATUS(rtp_transceiver_mapSsrcs(pKvsRtpTransceiver));
     *ppRtcRtpTransceiver = (PRtcRtpTransceiver) pKvsRtpTransceiver;
 
     CHK_STATUS(timer_queue_addTimer(pKvsPeerConnection->timerQueueHandle, RTCP_FIRST_REPORT_DELAY, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD,
                                     pc_rtcpReportsCallback, (UINT64) pKvsRtpTransceiver, &pKvsRtpTransceiver->rtcpReportsTimerId));
 
+    // held frames are released on time also when the stream pauses
+    if (direction != RTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY &&
+        (pKvsPeerConnection->adaptiveJitterBuffer || pKvsRtpTransceiver->playoutSyncStream != PLAYOUT_SYNC_STREAM_NONE)) {
+        // without the timer held frames still go out with the next packet
+        if (!IS_VALID_TIMER_QUEUE_HANDLE(pKvsPeerConnection->frameReleaseTimerQueueHandle)) {
+            CHK_LOG_ERR(timer_queue_createWithCapacity(&pKvsPeerConnection->frameReleaseTimerQueueHandle, FRAME_RELEASE_THREAD_NAME,
+                                                       FRAME_RELEASE_THREAD_SIZE, DEFAULT_TIMER_QUEUE_TIMER_COUNT));
+        }
+        if (IS_VALID_TIMER_QUEUE_HANDLE(pKvsPeerConnection->frameReleaseTimerQueueHandle)) {
+            CHK_LOG_ERR(timer_queue_addTimer(pKvsPeerConnection->frameReleaseTimerQueueHandle, JITTER_BUFFER_RELEASE_CHECK_PERIOD,
+                                             JITTER_BUFFER_RELEASE_CHECK_PERIOD, pc_jitterBufferReleaseCallback, (UINT64) pKvsRtpTransceiver,
+                                             &pKvsRtpTransceiver->jitterBufferTimerId));
+        }
+    }
+
     pKvsRtpTransceiver = NULL;
 
 CleanUp:
@@ -1475,6 +1749,8 @@ STATUS pc_initWebRtc(VOID)
     CHK_STATUS(sctp_session_init());
 #endif
 
+    CHK_STATUS(timer_queue_createWithCapacity(&gPeerTimerQueueHandle, PEER_TIMER_NAME, PEER_TIMER_SIZE, PEER_TIMER_COUNT));
+
     ATOMIC_STORE_BOOL(&gKvsWebRtcInitialized, TRUE);
 
 CleanUp:
@@ -1497,6 +1773,9 @@ STATUS pc_deinitWebRtc(VOID)
     srtp_shutdown();
 #endif
 
+    // the thread stops once the peer connections still attached are freed
+    timer_queue_free(&gPeerTimerQueueHandle);
+
     ATOMIC_STORE_BOOL(&gKvsWebRtcInitialized, FALSE);
 
 CleanUp:
@@ -31,7 +31,12 @@ extern "C" {
 #include "ice_agent.h"
 #include "network.h"
 #include "srtp_session.h"
+#include "srtp_pipeline.h"
 #include "sctp_session.h"
+#include "PlayoutSync.h"
+#include "SsrcMap.h"
+#include "RtcpBuilder.h"
+#include "Runtime.h"
 
 /******************************************************************************
  * DEFINITIONS
@@ -79,12 +84,18 @@ typedef struct __KvsPeerConnection {
 #ifdef ENABLE_STREAMING
     MUTEX pSrtpSessionLock; //!< the lock for srtp session.
     PSrtpSession pSrtpSession;
+    UINT32 srtpDecryptWorkerCount; //!< the workers of the decrypt pipeline, none when 0.
+    PSrtpPipeline pSrtpPipeline;   //!< decrypts the rtp packets off the listener thread, NULL unless srtpDecryptWorkerCount is set.
+    UINT32 maxHistoryBytes;        //!< the bytes of the packet histories of all the senders together.
+    MUTEX rtcpBuilderLock;         //!< the lock for the rtcp builder.
+    PRtcpBuilder pRtcpBuilder;     //!< the compound rtcp packet which is filled and sent by the reports and the feedback requests.
 #endif
 #ifdef ENABLE_DATA_CHANNEL
     PSctpSession pSctpSession;
 #endif
     SessionDescription remoteSessionDescription; //!< the session desciption of the remote peer.
     PDoubleList pTransceivers;                   //!< the transceivers.
+    PSsrcMap pSsrcMap;                           //!< the transceiver of every ssrc sent or received by the transceivers.
     BOOL sctpIsEnabled;                          //!< enable the data channel or not. indicate that support sctp or not.
 
     CHAR localIceUfrag[LOCAL_ICE_UFRAG_LEN + 1];
@@ -102,6 +113,9 @@ typedef struct __KvsPeerConnection {
     BOOL isOffer; //!< the one creates the offer.
 
     TIMER_QUEUE_HANDLE timerQueueHandle;
+    // releases the frames held by the jitter buffers, apart from timerQueueHandle which may be shared with other peer
+    // connections, so a slow frame callback only holds up this one. Created with the first transceiver holding frames.
+    TIMER_QUEUE_HANDLE frameReleaseTimerQueueHandle;
 
     // Codecs that we support and their payloadTypes
     // When offering, we generate values starting from 96
@@ -127,6 +141,9 @@ typedef struct __KvsPeerConnection {
     RTC_PEER_CONNECTION_STATE connectionState;
 
     UINT16 MTU;
+    BOOL adaptiveJitterBuffer;
+    // lip sync of the first received audio and video transceivers, NULL unless enablePlayoutSync is set
+    PPlayoutSync pPlayoutSync;
 
     NullableBool canTrickleIce; //!< indicate the behavior of ice, trickle ice or non-trickle ice.
                                 ///!< https://tools.ietf.org/html/rfc8838
@@ -167,6 +184,10 @@ VOID pc_onSctpSessionDataChannelOpen(UINT64, UINT32, PBYTE, UINT32);
  * @return STATUS status of execution
  */
 STATUS pc_sendPacketToRtpReceiver(PKvsPeerConnection pKvsPeerConnection, PBYTE pBuffer, UINT32 bufferLen);
+/**
+ * @brief the SrtpPipelineDeliverFunc of the decrypt pipeline, which hands the packets on to their rtp receiver.
+ */
+STATUS pc_onDecryptedRtpPacket(UINT64, PBYTE, UINT32, UINT64, STATUS);
 STATUS pc_changeState(PKvsPeerConnection, RTC_PEER_CONNECTION_STATE);
 
 STATUS json_generateSafeString(PCHAR, UINT32);
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "PlayoutSync"
+
+#include "PlayoutSync.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS playout_sync_create(PPlayoutSync* ppPlayoutSync)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PPlayoutSync pPlayoutSync = NULL;
+
+    CHK(ppPlayoutSync != NULL, STATUS_NULL_ARG);
+
+    pPlayoutSync = (PPlayoutSync) MEMCALLOC(1, SIZEOF(PlayoutSync));
+    CHK(pPlayoutSync != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pPlayoutSync->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pPlayoutSync->lock), STATUS_INVALID_OPERATION);
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        playout_sync_free(&pPlayoutSync);
+    }
+    if (ppPlayoutSync != NULL) {
+        *ppPlayoutSync = pPlayoutSync;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS playout_sync_free(PPlayoutSync* ppPlayoutSync)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(ppPlayoutSync != NULL, STATUS_NULL_ARG);
+    CHK(*ppPlayoutSync != NULL, retStatus);
+
+    if (IS_VALID_MUTEX_VALUE((*ppPlayoutSync)->lock)) {
+        MUTEX_FREE((*ppPlayoutSync)->lock);
+    }
+    SAFE_MEMFREE(*ppPlayoutSync);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+STATUS playout_sync_claimStream(PPlayoutSync pPlayoutSync, UINT32 stream, PBOOL pClaimed)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pPlayoutSync != NULL && pClaimed != NULL, STATUS_NULL_ARG);
+    CHK(stream < PLAYOUT_SYNC_STREAM_COUNT, STATUS_INVALID_ARG);
+
+    MUTEX_LOCK(pPlayoutSync->lock);
+    *pClaimed = !pPlayoutSync->streams[stream].claimed;
+    pPlayoutSync->streams[stream].claimed = TRUE;
+    MUTEX_UNLOCK(pPlayoutSync->lock);
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS playout_sync_onSenderReport(PPlayoutSync pPlayoutSync, UINT32 stream, UINT64 senderTime, UINT32 rtpTime, UINT32 clockRate)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PPlayoutSyncStream pStream = NULL;
+
+    CHK(pPlayoutSync != NULL, STATUS_NULL_ARG);
+    CHK(stream < PLAYOUT_SYNC_STREAM_COUNT && clockRate != 0, STATUS_INVALID_ARG);
+
+    MUTEX_LOCK(pPlayoutSync->lock);
+    pStream = &pPlayoutSync->streams[stream];
+    pStream->mapped = TRUE;
+    pStream->clockRate = clockRate;
+    pStream->senderReportTime = senderTime;
+    pStream->senderReportRtpTime = rtpTime;
+    MUTEX_UNLOCK(pPlayoutSync->lock);
+
+CleanUp:
+    return retStatus;
+}
+
+/**
+ * @brief the hold of a stream which is released delay sooner after capture than the other one.
+ */
+static VOID playout_sync_updateExtraDelay(PPlayoutSyncStream pStream, INT64 delay)
+{
+    UINT64 extraDelay = (UINT64) MIN(MAX(delay, 0), PLAYOUT_SYNC_MAX_DELAY);
+
+    if (extraDelay > pStream->extraDelay + PLAYOUT_SYNC_TOLERANCE || extraDelay + PLAYOUT_SYNC_TOLERANCE < pStream->extraDelay) {
+        pStream->extraDelay = extraDelay;
+    }
+}
+
+STATUS playout_sync_onFrame(PPlayoutSync pPlayoutSync, UINT32 stream, UINT32 rtpTime, UINT64 now, PUINT64 pPresentationTs, PUINT64 pExtraDelay)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PPlayoutSyncStream pStream = NULL, pOtherStream = NULL;
+    UINT64 captureTime;
+    INT64 delay;
+    BOOL locked = FALSE;
+
+    CHK(pPlayoutSync != NULL && pPresentationTs != NULL && pExtraDelay != NULL, STATUS_NULL_ARG);
+    CHK(stream < PLAYOUT_SYNC_STREAM_COUNT, STATUS_INVALID_ARG);
+
+    MUTEX_LOCK(pPlayoutSync->lock);
+    locked = TRUE;
+    pStream = &pPlayoutSync->streams[stream];
+    pOtherStream = &pPlayoutSync->streams[PLAYOUT_SYNC_STREAM_COUNT - 1 - stream];
+    *pExtraDelay = pStream->appliedDelay;
+    CHK(pStream->mapped, retStatus);
+
+    // frames before the SR are a negative distance away from it
+    captureTime = pStream->senderReportTime +
+        (UINT64)((INT64)(INT32)(rtpTime - pStream->senderReportRtpTime) * HUNDREDS_OF_NANOS_IN_A_SECOND / (INT64) pStream->clockRate);
+    *pPresentationTs = captureTime;
+
+    // the delay the stream would have without the hold it was released with
+    delay = (INT64)(now - captureTime) - (INT64) pStream->appliedDelay;
+    if (!pStream->delayValid) {
+        pStream->delayValid = TRUE;
+        pStream->delay = delay;
+    } else {
+        pStream->delay += (delay - pStream->delay) / (1 << PLAYOUT_SYNC_SMOOTHING_SHIFT);
+    }
+
+    // the stream which is ready sooner waits for the other one, the later one is not held
+    if (pOtherStream->delayValid) {
+        playout_sync_updateExtraDelay(pStream, pOtherStream->delay - pStream->delay);
+        playout_sync_updateExtraDelay(pOtherStream, pStream->delay - pOtherStream->delay);
+    }
+    pStream->appliedDelay = pStream->extraDelay;
+    *pExtraDelay = pStream->appliedDelay;
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pPlayoutSync->lock);
+    }
+    return retStatus;
+}
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_PLAYOUT_SYNC__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_PLAYOUT_SYNC__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+#define PLAYOUT_SYNC_STREAM_AUDIO 0
+#define PLAYOUT_SYNC_STREAM_VIDEO 1
+#define PLAYOUT_SYNC_STREAM_COUNT 2
+// a transceiver which does not take part in the synchronization
+#define PLAYOUT_SYNC_STREAM_NONE PLAYOUT_SYNC_STREAM_COUNT
+// the longest a stream is held to wait for the other one, below the latency of the jitter buffer
+#define PLAYOUT_SYNC_MAX_DELAY (1000 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+// the hold only moves once the streams drift further apart than this, so that it does not follow the network jitter
+#define PLAYOUT_SYNC_TOLERANCE (20 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+// the delay of a stream moves by 1 / 2^PLAYOUT_SYNC_SMOOTHING_SHIFT of the difference with every frame
+#define PLAYOUT_SYNC_SMOOTHING_SHIFT 4
+
+typedef struct {
+    // a transceiver feeds the stream
+    BOOL claimed;
+    BOOL mapped;
+    UINT32 clockRate;
+    // wall clock of the remote sender at senderReportRtpTime, 100ns precision, from the last SR
+    UINT64 senderReportTime;
+    UINT32 senderReportRtpTime;
+    BOOL delayValid;
+    // smoothed release time minus capture time of the frames without the hold, 100ns precision. Includes the offset
+    // between the clocks of both peers, which is the same for every stream and cancels out.
+    INT64 delay;
+    // the hold the stream should apply, and the one its frames were released with, 100ns precision
+    UINT64 extraDelay;
+    UINT64 appliedDelay;
+} PlayoutSyncStream, *PPlayoutSyncStream;
+
+/**
+ * Lip sync of one audio and one video stream, https://tools.ietf.org/html/rfc3550#section-6.4.1. The SR of each stream maps
+ * its rtp timestamps to the wall clock of the sender, which is shared by both streams. The stream whose frames are released
+ * sooner after capture is held by the difference, and every frame gets its capture time on that wall clock as presentation
+ * timestamp.
+ */
+typedef struct __PlayoutSync {
+    MUTEX lock;
+    PlayoutSyncStream streams[PLAYOUT_SYNC_STREAM_COUNT];
+} PlayoutSync, *PPlayoutSync;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS playout_sync_create(PPlayoutSync*);
+STATUS playout_sync_free(PPlayoutSync*);
+/**
+ * @brief take a stream for a transceiver, only the first transceiver of each kind is synchronized.
+ *
+ * @param[in] pPlayoutSync the playout sync.
+ * @param[in] stream PLAYOUT_SYNC_STREAM_AUDIO or PLAYOUT_SYNC_STREAM_VIDEO.
+ * @param[out] pClaimed TRUE if the stream was free and now belongs to the caller.
+ *
+ * @return STATUS status of execution
+ */
+STATUS playout_sync_claimStream(PPlayoutSync, UINT32, PBOOL);
+/**
+ * @brief update the mapping of a stream from its rtp timestamps to the wall clock of the sender.
+ *
+ * @param[in] pPlayoutSync the playout sync.
+ * @param[in] stream PLAYOUT_SYNC_STREAM_AUDIO or PLAYOUT_SYNC_STREAM_VIDEO.
+ * @param[in] senderTime the NTP timestamp of the SR converted to 100ns.
+ * @param[in] rtpTime the rtp timestamp of the SR.
+ * @param[in] clockRate the clock rate of the rtp timestamps.
+ *
+ * @return STATUS status of execution
+ */
+STATUS playout_sync_onSenderReport(PPlayoutSync, UINT32, UINT64, UINT32, UINT32);
+/**
+ * @brief account a frame released by the jitter buffer of a stream and get its synchronized presentation timestamp.
+ *
+ * @param[in] pPlayoutSync the playout sync.
+ * @param[in] stream PLAYOUT_SYNC_STREAM_AUDIO or PLAYOUT_SYNC_STREAM_VIDEO.
+ * @param[in] rtpTime the rtp timestamp of the frame.
+ * @param[in] now the current time in 100ns.
+ * @param[in, out] pPresentationTs the capture time of the frame on the wall clock of the sender in 100ns, left as it is
+ *                 until the stream received a SR.
+ * @param[out] pExtraDelay the time the jitter buffer of the stream holds the next frames for in 100ns.
+ *
+ * @return STATUS status of execution
+ */
+STATUS playout_sync_onFrame(PPlayoutSync, UINT32, UINT32, UINT64, PUINT64, PUINT64);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_PLAYOUT_SYNC__ */
@@ -27,16 +27,18 @@
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
-STATUS retransmitter_create(UINT32 seqNumListLen, UINT32 validIndexListLen, PRetransmitter* ppRetransmitter)
+STATUS retransmitter_create(UINT32 seqNumListLen, UINT32 packetBufferSize, PRetransmitter* ppRetransmitter)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PRetransmitter pRetransmitter = MEMALLOC(SIZEOF(Retransmitter) + SIZEOF(UINT16) * seqNumListLen + SIZEOF(UINT64) * validIndexListLen);
+    PRetransmitter pRetransmitter =
+        MEMCALLOC(1, SIZEOF(Retransmitter) + SIZEOF(UINT16) * seqNumListLen + RTX_OSN_LENGTH + packetBufferSize + SRTP_AUTH_TAG_OVERHEAD);
     CHK(pRetransmitter != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRetransmitter->budgetPercent = RETRANSMITTER_DEFAULT_BUDGET_PERCENT;
     pRetransmitter->sequenceNumberList = (PUINT16)(pRetransmitter + 1);
     pRetransmitter->seqNumListLen = seqNumListLen;
-    pRetransmitter->validIndexList = (PUINT64)(pRetransmitter->sequenceNumberList + seqNumListLen);
-    pRetransmitter->validIndexListLen = validIndexListLen;
+    pRetransmitter->packetBuffer = (PBYTE)(pRetransmitter->sequenceNumberList + seqNumListLen) + RTX_OSN_LENGTH;
+    pRetransmitter->packetBufferSize = packetBufferSize;
 
 CleanUp:
     if (STATUS_FAILED(retStatus) && pRetransmitter != NULL) {
@@ -65,20 +67,99 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * @brief find the retransmission state of a ssrc. A new ssrc takes an unused slot, or the one of the stream NACKed the
+ *        longest time ago, which has gone stale after a change of the encodings.
+ *
+ * @return the stream.
+ */
+static PRetransmitStream retransmitter_getStream(PRetransmitter pRetransmitter, UINT32 ssrc, UINT64 currentTime)
+{
+    PRetransmitStream pStream = NULL;
+    UINT32 i;
+
+    for (i = 0; i < RETRANSMITTER_MAX_STREAMS; i++) {
+        if (pRetransmitter->streams[i].inUse && pRetransmitter->streams[i].ssrc == ssrc) {
+            pRetransmitter->streams[i].lastNackTime = currentTime;
+            return &pRetransmitter->streams[i];
+        }
+        if (pStream == NULL || (pStream->inUse && (!pRetransmitter->streams[i].inUse ||
+                                                   pRetransmitter->streams[i].lastNackTime < pStream->lastNackTime))) {
+            pStream = &pRetransmitter->streams[i];
+        }
+    }
+
+    if (pStream->inUse) {
+        DLOGD("Retransmission state of ssrc %lu is taken over by ssrc %lu", pStream->ssrc, ssrc);
+    }
+    MEMSET(pStream, 0x00, SIZEOF(RetransmitStream));
+    pStream->inUse = TRUE;
+    pStream->ssrc = ssrc;
+    pStream->budgetBytes = RETRANSMITTER_MAX_BUDGET_BYTES;
+    pStream->lastNackTime = currentTime;
+
+    return pStream;
+}
+
+/**
+ * @brief add the share of the media bytes sent since the last refill to the budget of the stream.
+ */
+static VOID retransmitter_refillBudget(PRetransmitter pRetransmitter, PRetransmitStream pStream, UINT64 mediaBytes)
+{
+    if (mediaBytes > pStream->lastMediaBytes) {
+        pStream->budgetBytes += (mediaBytes - pStream->lastMediaBytes) * pRetransmitter->budgetPercent / 100;
+        pStream->budgetBytes = MIN(pStream->budgetBytes, RETRANSMITTER_MAX_BUDGET_BYTES);
+    }
+    pStream->lastMediaBytes = mediaBytes;
+}
+
+/**
+ * @brief whether the packet was resent within the suppression window.
+ */
+static BOOL retransmitter_isRecentlyResent(PRetransmitStream pStream, UINT16 sequenceNumber, UINT64 currentTime, UINT64 suppressionWindow)
+{
+    UINT32 slot = sequenceNumber % RETRANSMITTER_RESENT_HISTORY_SIZE;
+
+    if (pStream->resentTimeList[slot] != 0 && pStream->resentSeqNumList[slot] == sequenceNumber &&
+        currentTime < pStream->resentTimeList[slot] + suppressionWindow) {
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static VOID retransmitter_markResent(PRetransmitStream pStream, UINT16 sequenceNumber, UINT64 currentTime)
+{
+    UINT32 slot = sequenceNumber % RETRANSMITTER_RESENT_HISTORY_SIZE;
+
+    pStream->resentSeqNumList[slot] = sequenceNumber;
+    pStream->resentTimeList[slot] = currentTime;
+}
+
 STATUS retransmitter_resendPacketOnNack(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsPeerConnection)
 {
     ENTERS();
 
     STATUS retStatus = STATUS_SUCCESS;
     UINT32 senderSsrc = 0, receiverSsrc = 0;
-    UINT32 filledLen = 0, validIndexListLen = 0;
+    UINT32 filledLen = 0, index, packetLength, rtxPacketLength;
     PKvsRtpTransceiver pSenderTranceiver = NULL;
-    UINT64 item, index;
     STATUS tmpStatus = STATUS_SUCCESS;
-    PRtpPacket pRtpPacket = NULL, pRtxRtpPacket = NULL;
+    RtpPacket rtpPacket;
+    PRtpPacket pRtpPacket = &rtpPacket;
+    PBYTE pRtxPacket = NULL;
     PRetransmitter pRetransmitter = NULL;
+    PRtcRtpEncoding pEncoding = NULL;
+    PRtpHistory pPacketBuffer = NULL;
+    PRtcOutboundRtpStreamStats pOutboundStats = NULL;
+    PRtcRemoteInboundRtpStreamStats pRemoteInboundStats = NULL;
+    PUINT16 pRtxSequenceNumber = NULL;
+    UINT32 rtxSsrc = 0, mediaSsrc;
+    PRetransmitStream pStream = NULL;
+    UINT64 currentTime, suppressionWindow = RETRANSMITTER_DEFAULT_SUPPRESSION_WINDOW, mediaBytes;
     // stats
     UINT32 retransmittedPacketsSent = 0, retransmittedBytesSent = 0, nackCount = 0;
+    UINT32 retransmissionsSuppressed = 0, retransmissionsRateLimited = 0, nackHistoryMisses = 0, retransmissionsFailed = 0;
 
     CHK(pKvsPeerConnection != NULL && pRtcpPacket != NULL, STATUS_NULL_ARG);
     CHK_STATUS(rtcp_packet_getNackList(pRtcpPacket->payload, pRtcpPacket->payloadLength, &senderSsrc, &receiverSsrc, NULL, &filledLen));
@@ -90,6 +171,25 @@ STATUS retransmitter_resendPacketOnNack(PRtcpPacket pRtcpPacket, PKvsPeerConnect
     }
     CHK_STATUS(tmpStatus);
 
+    // the nack may target the primary encoding or one of the simulcast encodings of the sender, the state of the stream
+    // is kept under the ssrc the nack was resolved to rather than whichever ssrc the remote put in it
+    if (STATUS_FAILED(rtp_transceiver_findEncodingBySsrc(pSenderTranceiver, receiverSsrc, &pEncoding)) || pEncoding == NULL) {
+        mediaSsrc = pSenderTranceiver->sender.ssrc;
+        pPacketBuffer = pSenderTranceiver->sender.packetBuffer;
+        pOutboundStats = &pSenderTranceiver->outboundStats;
+        pRemoteInboundStats = &pSenderTranceiver->remoteInboundStats;
+        pRtxSequenceNumber = &pSenderTranceiver->sender.rtxSequenceNumber;
+        rtxSsrc = pSenderTranceiver->sender.rtxSsrc;
+    } else {
+        mediaSsrc = pEncoding->ssrc;
+        pPacketBuffer = pEncoding->packetBuffer;
+        pOutboundStats = &pEncoding->outboundStats;
+        pRemoteInboundStats = &pEncoding->remoteInboundStats;
+        pRtxSequenceNumber = &pEncoding->rtxSequenceNumber;
+        rtxSsrc = pEncoding->rtxSsrc;
+    }
+    CHK_ERR(pPacketBuffer != NULL, STATUS_INVALID_OPERATION, "No packet history for ssrc %lu", mediaSsrc);
+
     pRetransmitter = pSenderTranceiver->sender.retransmitter;
     // TODO it is not very clear from the spec whether nackCount is number of packets received or number of rtp packets lost reported in nack packets
     nackCount++;
@@ -100,64 +200,90 @@ STATUS retransmitter_resendPacketOnNack(PRtcpPacket pRtcpPacket, PKvsPeerConnect
     filledLen = pRetransmitter->seqNumListLen;
     CHK_STATUS(rtcp_packet_getNackList(pRtcpPacket->payload, pRtcpPacket->payloadLength, &senderSsrc, &receiverSsrc,
                                        pRetransmitter->sequenceNumberList, &filledLen));
-    validIndexListLen = pRetransmitter->validIndexListLen;
-    CHK_STATUS(rtp_rolling_buffer_getValidSeqIndexList(pSenderTranceiver->sender.packetBuffer, pRetransmitter->sequenceNumberList, filledLen,
-                                                       pRetransmitter->validIndexList, &validIndexListLen));
-    for (index = 0; index < validIndexListLen; index++) {
-        retStatus = rolling_buffer_extractData(pSenderTranceiver->sender.packetBuffer->pRollingBuffer, pRetransmitter->validIndexList[index], &item);
-        pRtpPacket = (PRtpPacket) item;
-        CHK(retStatus == STATUS_SUCCESS, retStatus);
-
-        if (pRtpPacket != NULL) {
+    currentTime = GETTIME();
+    pStream = retransmitter_getStream(pRetransmitter, mediaSsrc, currentTime);
+
+    rtp_transceiver_lockStatsForRead(pSenderTranceiver);
+    mediaBytes = pOutboundStats->sent.bytesSent + pOutboundStats->headerBytesSent;
+    // each simulcast encoding takes its own path, its round trip time comes from its own report blocks
+    if (pRemoteInboundStats->roundTripTime > 0) {
+        suppressionWindow = pRemoteInboundStats->roundTripTime * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    }
+    rtp_transceiver_unlockStatsForRead(pSenderTranceiver);
+    retransmitter_refillBudget(pRetransmitter, pStream, mediaBytes);
+
+    for (index = 0; index < filledLen; index++) {
+        // the history is read without a lock, the sender keeps putting packets meanwhile and may have dropped this one
+        packetLength = pRetransmitter->packetBufferSize + SRTP_AUTH_TAG_OVERHEAD;
+        tmpStatus =
+            rtp_history_get(pPacketBuffer, pRetransmitter->sequenceNumberList[index], currentTime, pRetransmitter->packetBuffer, &packetLength);
+        if (tmpStatus == STATUS_NOT_FOUND) {
+            // evicted, or dropped for being older than a few round trips
+            nackHistoryMisses++;
+            DLOGS("Retransmit seq %u not in history", pRetransmitter->sequenceNumberList[index]);
+            continue;
+        } else if (STATUS_FAILED(tmpStatus)) {
+            retransmissionsFailed++;
+            DLOGW("Failed to read seq %u back from the history of ssrc %u with 0x%08x", pRetransmitter->sequenceNumberList[index], mediaSsrc,
+                  tmpStatus);
+            continue;
+        }
+        CHK_STATUS(rtp_packet_setPacketFromBytes(pRetransmitter->packetBuffer, packetLength, pRtpPacket));
+        pRtpPacket->pRawPacket = pRetransmitter->packetBuffer;
+        pRtpPacket->rawPacketLength = packetLength;
+
+        if (retransmitter_isRecentlyResent(pStream, pRtpPacket->header.sequenceNumber, currentTime, suppressionWindow)) {
+            // the previous retransmission may still be in flight, a repeated nack does not mean it was lost
+            retransmissionsSuppressed++;
+        } else if (pStream->budgetBytes < pRtpPacket->rawPacketLength) {
+            retransmissionsRateLimited++;
+        } else {
             if (pSenderTranceiver->sender.payloadType == pSenderTranceiver->sender.rtxPayloadType) {
-                retStatus = ice_agent_send(pKvsPeerConnection->pIceAgent, pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength);
+                tmpStatus = ice_agent_send(pKvsPeerConnection->pIceAgent, pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength);
+            } else if (packetLength > pRetransmitter->packetBufferSize) {
+                // the authentication tag of a packet filling the whole buffer has no room left behind it
+                tmpStatus = STATUS_BUFFER_TOO_SMALL;
             } else {
-                CHK_STATUS(rtp_packet_constructRetransmitPacketFromBytes(
-                    pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength, pSenderTranceiver->sender.rtxSequenceNumber,
-                    pSenderTranceiver->sender.rtxPayloadType, pSenderTranceiver->sender.rtxSsrc, &pRtxRtpPacket));
-                pSenderTranceiver->sender.rtxSequenceNumber++;
-                retStatus = rtp_writePacket(pKvsPeerConnection, pRtxRtpPacket);
+                // the history keeps the packet unencrypted, the rtx packet is patched into the scratch buffer and encrypted once
+                CHK_STATUS(rtp_packet_constructRetransmitPacketInPlace(pRtpPacket, *pRtxSequenceNumber, pSenderTranceiver->sender.rtxPayloadType,
+                                                                       rtxSsrc, &pRtxPacket, &rtxPacketLength));
+                (*pRtxSequenceNumber)++;
+                // https://tools.ietf.org/html/rfc8852#section-3.2 rtx packets carry the rid of the repaired stream as rrid
+                if (pSenderTranceiver->sender.simulcastNegotiated && pSenderTranceiver->sender.rridExtensionId != 0) {
+                    rtp_packet_rewriteOneByteExtensionId(pRtxPacket, rtxPacketLength, pSenderTranceiver->sender.ridExtensionId,
+                                                         pSenderTranceiver->sender.rridExtensionId);
+                }
+                tmpStatus = rtp_writeRawPacketInPlace(pKvsPeerConnection, pRtxPacket, rtxPacketLength);
             }
             // resendPacket
-            if (STATUS_SUCCEEDED(retStatus)) {
+            if (STATUS_SUCCEEDED(tmpStatus)) {
                 retransmittedPacketsSent++;
                 retransmittedBytesSent += pRtpPacket->rawPacketLength - RTP_HEADER_LEN(pRtpPacket);
+                pStream->budgetBytes -= pRtpPacket->rawPacketLength;
+                retransmitter_markResent(pStream, pRtpPacket->header.sequenceNumber, currentTime);
                 DLOGV("Resent packet ssrc %lu seq %lu succeeded", pRtpPacket->header.ssrc, pRtpPacket->header.sequenceNumber);
             } else {
-                DLOGV("Resent packet ssrc %lu seq %lu failed 0x%08x", pRtpPacket->header.ssrc, pRtpPacket->header.sequenceNumber, retStatus);
+                retransmissionsFailed++;
+                // a packet which could not be resent does not keep the others from going out
+                DLOGW("Resent packet ssrc %lu seq %lu failed 0x%08x", pRtpPacket->header.ssrc, pRtpPacket->header.sequenceNumber, tmpStatus);
             }
-            // putBackPacketToRollingBuffer
-            retStatus =
-                rolling_buffer_insertData(pSenderTranceiver->sender.packetBuffer->pRollingBuffer, pRetransmitter->sequenceNumberList[index], item);
-            CHK(retStatus == STATUS_SUCCESS || retStatus == STATUS_ROLLING_BUFFER_NOT_IN_RANGE, retStatus);
-
-            // free the packet if it is not in the valid range any more
-            if (retStatus == STATUS_ROLLING_BUFFER_NOT_IN_RANGE) {
-                DLOGS("Retransmit STATUS_ROLLING_BUFFER_NOT_IN_RANGE free %lu by self", pRtpPacket->header.sequenceNumber);
-                rtp_packet_free(&pRtpPacket);
-                retStatus = STATUS_SUCCESS;
-            } else {
-                DLOGS("Retransmit add back to rolling %lu", pRtpPacket->header.sequenceNumber);
-            }
-
-            rtp_packet_free(&pRtxRtpPacket);
-            pRtpPacket = NULL;
         }
     }
 CleanUp:
 
-    MUTEX_LOCK(pSenderTranceiver->statsLock);
-    pSenderTranceiver->outboundStats.nackCount += nackCount;
-    pSenderTranceiver->outboundStats.retransmittedPacketsSent += retransmittedPacketsSent;
-    pSenderTranceiver->outboundStats.retransmittedBytesSent += retransmittedBytesSent;
-    MUTEX_UNLOCK(pSenderTranceiver->statsLock);
+    if (pOutboundStats != NULL) {
+        rtp_transceiver_lockStats(pSenderTranceiver);
+        pOutboundStats->nackCount += nackCount;
+        pOutboundStats->retransmittedPacketsSent += retransmittedPacketsSent;
+        pOutboundStats->retransmittedBytesSent += retransmittedBytesSent;
+        pOutboundStats->retransmissionsSuppressed += retransmissionsSuppressed;
+        pOutboundStats->retransmissionsRateLimited += retransmissionsRateLimited;
+        pOutboundStats->nackHistoryMisses += nackHistoryMisses;
+        pOutboundStats->retransmissionsFailed += retransmissionsFailed;
+        rtp_transceiver_unlockStats(pSenderTranceiver);
+    }
 
     CHK_LOG_ERR(retStatus);
-    if (pRtpPacket != NULL) {
-        // free the packet as it is not put back into rolling buffer
-        rtp_packet_free(&pRtpPacket);
-        pRtpPacket = NULL;
-    }
 
     LEAVES();
     return retStatus;
@@ -30,11 +30,38 @@ extern "C" {
 /******************************************************************************
  * DEFINITIONS
  ******************************************************************************/
+// retransmissions of one ssrc may use up to this percentage of the media bytes sent on it
+#define RETRANSMITTER_DEFAULT_BUDGET_PERCENT 25
+// depth of the token bucket, also the budget available before any media is accounted
+#define RETRANSMITTER_MAX_BUDGET_BYTES (64 * 1024)
+// a packet is not resent again while a previous retransmission of it may still be in flight
+#define RETRANSMITTER_DEFAULT_SUPPRESSION_WINDOW (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+// recently resent sequence numbers are tracked per ssrc in a table indexed by the low bits of the sequence number
+#define RETRANSMITTER_RESENT_HISTORY_SIZE 128
+#define RETRANSMITTER_MAX_STREAMS         MAX_RTP_SEND_ENCODINGS
+
+typedef struct {
+    BOOL inUse;
+    // the media ssrc of the primary or simulcast encoding the NACKs were resolved to
+    UINT32 ssrc;
+    // the slot of the stream NACKed the longest time ago is taken over by a new ssrc
+    UINT64 lastNackTime;
+    // token bucket in bytes, refilled from the media bytes sent since the last refill
+    UINT64 budgetBytes;
+    UINT64 lastMediaBytes;
+    UINT16 resentSeqNumList[RETRANSMITTER_RESENT_HISTORY_SIZE];
+    UINT64 resentTimeList[RETRANSMITTER_RESENT_HISTORY_SIZE];
+} RetransmitStream, *PRetransmitStream;
+
 typedef struct __Retransmitter {
     PUINT16 sequenceNumberList;
     UINT32 seqNumListLen;
-    UINT32 validIndexListLen;
-    PUINT64 validIndexList;
+    // a packet read back from the history, with RTX_OSN_LENGTH bytes of headroom in front for the rtx header and
+    // SRTP_AUTH_TAG_OVERHEAD bytes behind packetBufferSize for the encryption in place
+    PBYTE packetBuffer;
+    UINT32 packetBufferSize;
+    UINT32 budgetPercent;
+    RetransmitStream streams[RETRANSMITTER_MAX_STREAMS];
 } Retransmitter, *PRetransmitter;
 
 /******************************************************************************
@@ -42,6 +69,16 @@ typedef struct __Retransmitter {
  ******************************************************************************/
 STATUS retransmitter_create(UINT32, UINT32, PRetransmitter*);
 STATUS retransmitter_free(PRetransmitter*);
+/**
+ * @brief resend the packets requested by a generic NACK from the history of the sender.
+ *        Packets resent within the last round trip time are skipped, and the retransmissions of each ssrc are
+ *        limited to budgetPercent of its media bytes.
+ *
+ * @param[in] pRtcpPacket the NACK.
+ * @param[in] pKvsPeerConnection the peer connection of the sender.
+ *
+ * @return STATUS status of execution
+ */
 STATUS retransmitter_resendPacketOnNack(PRtcpPacket, PKvsPeerConnection);
 
 #ifdef __cplusplus
@@ -39,12 +39,10 @@ static STATUS rtcp_onFIRPacket(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsP
     CHK(pKvsPeerConnection != NULL && pRtcpPacket != NULL, STATUS_RTCP_NULL_ARG);
     mediaSSRC = getUnalignedInt32BigEndian((pRtcpPacket->payload + (SIZEOF(UINT32))));
     if (STATUS_SUCCEEDED(rtp_transceiver_findBySsrc(pKvsPeerConnection, &pTransceiver, mediaSSRC))) {
-        MUTEX_LOCK(pTransceiver->statsLock);
+        rtp_transceiver_lockStats(pTransceiver);
         pTransceiver->outboundStats.firCount++;
-        MUTEX_UNLOCK(pTransceiver->statsLock);
-        if (pTransceiver->onPictureLoss != NULL) {
-            pTransceiver->onPictureLoss(pTransceiver->onPictureLossCustomData);
-        }
+        rtp_transceiver_unlockStats(pTransceiver);
+        rtp_transceiver_requestKeyFrame(pTransceiver);
     } else {
         DLOGW("Received FIR for non existing ssrc: %u", mediaSSRC);
     }
@@ -64,9 +62,9 @@ static STATUS rtcp_onSLIPacket(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsP
     CHK(pKvsPeerConnection != NULL && pRtcpPacket != NULL, STATUS_RTCP_NULL_ARG);
     mediaSSRC = getUnalignedInt32BigEndian((pRtcpPacket->payload + (SIZEOF(UINT32))));
     if (STATUS_SUCCEEDED(rtp_transceiver_findBySsrc(pKvsPeerConnection, &pTransceiver, mediaSSRC))) {
-        MUTEX_LOCK(pTransceiver->statsLock);
+        rtp_transceiver_lockStats(pTransceiver);
         pTransceiver->outboundStats.sliCount++;
-        MUTEX_UNLOCK(pTransceiver->statsLock);
+        rtp_transceiver_unlockStats(pTransceiver);
     } else {
         DLOGW("Received FIR for non existing ssrc: %u", mediaSSRC);
     }
@@ -76,7 +74,106 @@ CleanUp:
     return retStatus;
 }
 /**
- * @brief TODO better sender report handling https://tools.ietf.org/html/rfc3550#section-6.4.1
+ * @brief account one report block of SR or RR to the outbound stream it reports on, which is either the primary or a
+ *        simulcast encoding of a sender.
+ *
+ * @param[in] pKvsPeerConnection the context of peer connection.
+ * @param[in] pReportBlock the report block.
+ * @param[in] currentTimeNTP the arrival of the report in NTP time.
+ *
+ * @return STATUS status of execution
+ */
+static STATUS rtcp_onReportBlock(PKvsPeerConnection pKvsPeerConnection, PRtcpReportBlock pReportBlock, UINT64 currentTimeNTP)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRtpTransceiver pTransceiver = NULL;
+    PRtcRtpEncoding pEncoding = NULL;
+    PRtcRemoteInboundRtpStreamStats pRemoteInboundStats;
+    PRtpHistory pPacketBuffer;
+    UINT32 rttPropDelay, rttPropDelayMsec = 0, clockRate;
+    UINT64 rttPropDelay64;
+
+    if (STATUS_FAILED(rtp_transceiver_findBySsrc(pKvsPeerConnection, &pTransceiver, pReportBlock->ssrc)) ||
+        STATUS_FAILED(rtp_transceiver_findEncodingBySsrc(pTransceiver, pReportBlock->ssrc, &pEncoding))) {
+        DLOGW("Received report block for non existing ssrc: %u", pReportBlock->ssrc);
+        CHK(FALSE, retStatus); // not really an error ?
+    }
+
+    DLOGS("report block %u loss: %u %d seq: %u jit: %u lsr: %u dlsr: %u", pReportBlock->ssrc, pReportBlock->fractionLost, pReportBlock->cumulativeLost,
+          pReportBlock->extendedHighestSequenceNumber, pReportBlock->jitter, pReportBlock->lastSenderReport, pReportBlock->delaySinceLastSenderReport);
+    if (pReportBlock->lastSenderReport != 0) {
+        // https://tools.ietf.org/html/rfc3550#section-6.4.1
+        //      Source SSRC_n can compute the round-trip propagation delay to
+        //      SSRC_r by recording the time A when this reception report block is
+        //      received.  It calculates the total round-trip time A-LSR using the
+        //      last SR timestamp (LSR) field, and then subtracting this field to
+        //      leave the round-trip propagation delay as (A - LSR - DLSR).
+        rttPropDelay = MID_NTP(currentTimeNTP) - pReportBlock->lastSenderReport - pReportBlock->delaySinceLastSenderReport;
+        rttPropDelay64 = rttPropDelay;
+        rttPropDelayMsec = (UINT32) KVS_CONVERT_TIMESCALE(rttPropDelay64, DLSR_TIMESCALE, 1000);
+        DLOGS("report block %u rttPropDelay %u msec", pReportBlock->ssrc, rttPropDelayMsec);
+    }
+    clockRate = pTransceiver->pJitterBuffer != NULL ? pTransceiver->pJitterBuffer->clockRate : 0;
+
+    rtp_transceiver_lockStats(pTransceiver);
+    pRemoteInboundStats = pEncoding != NULL ? &pEncoding->remoteInboundStats : &pTransceiver->remoteInboundStats;
+    pRemoteInboundStats->ssrc = pReportBlock->ssrc;
+    pRemoteInboundStats->reportsReceived++;
+    pRemoteInboundStats->fractionLost = pReportBlock->fractionLost / 256.0;
+    pRemoteInboundStats->packetsLost = pReportBlock->cumulativeLost;
+    if (clockRate != 0) {
+        pRemoteInboundStats->jitter = (DOUBLE) pReportBlock->jitter / clockRate;
+    }
+    if (pReportBlock->lastSenderReport != 0) {
+        pRemoteInboundStats->roundTripTimeMeasurements++;
+        pRemoteInboundStats->totalRoundTripTime += rttPropDelayMsec;
+        pRemoteInboundStats->roundTripTime = rttPropDelayMsec;
+    }
+    rtp_transceiver_unlockStats(pTransceiver);
+
+    // the history of the stream keeps its packets for a few round trips
+    pPacketBuffer = pEncoding != NULL ? pEncoding->packetBuffer : pTransceiver->sender.packetBuffer;
+    if (pReportBlock->lastSenderReport != 0 && pPacketBuffer != NULL) {
+        rtp_history_setMaxAge(pPacketBuffer,
+                              (UINT32) MIN(MAX((UINT64) rttPropDelayMsec * RTP_HISTORY_RTT_MULTIPLIER, RTP_HISTORY_MIN_MAX_AGE_MSEC),
+                                           RTP_HISTORY_DEFAULT_MAX_AGE_MSEC));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * @brief account every report block of SR or RR.
+ *
+ * @param[in] pKvsPeerConnection the context of peer connection.
+ * @param[in] pRtcpPacket the report.
+ * @param[in] offset the offset of the first report block in the payload.
+ *
+ * @return STATUS status of execution
+ */
+static STATUS rtcp_onReportBlocks(PKvsPeerConnection pKvsPeerConnection, PRtcpPacket pRtcpPacket, UINT32 offset)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    RtcpReportBlock reportBlock;
+    UINT64 currentTimeNTP = rtcp_packet_convertTimestampToNTP(GETTIME());
+    UINT32 i;
+
+    // the blocks may be followed by profile-specific extensions, a truncated block is ignored
+    for (i = 0; i < pRtcpPacket->header.receptionReportCount && offset + RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN <= pRtcpPacket->payloadLength;
+         i++, offset += RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN) {
+        CHK_STATUS(rtcp_packet_getReportBlock(pRtcpPacket->payload + offset, RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN, &reportBlock));
+        CHK_STATUS(rtcp_onReportBlock(pKvsPeerConnection, &reportBlock, currentTimeNTP));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * @brief https://tools.ietf.org/html/rfc3550#section-6.4.1
  *        0                   1                   2                   3
  *        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
  *        +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
@@ -127,8 +224,7 @@ static STATUS rtcp_onSRPacket(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsPe
 
     CHK(pKvsPeerConnection != NULL && pRtcpPacket != NULL, STATUS_RTCP_NULL_ARG);
 
-    if (pRtcpPacket->payloadLength != RTCP_PACKET_SENDER_REPORT_MINLEN) {
-        // TODO: handle sender report containing receiver report blocks
+    if (pRtcpPacket->payloadLength < RTCP_PACKET_SENDER_REPORT_MINLEN) {
         DLOGW("unhandled packet type RTCP_PACKET_SENDER_REPORT size %d", pRtcpPacket->payloadLength);
         return STATUS_SUCCESS;
     }
@@ -140,68 +236,49 @@ static STATUS rtcp_onSRPacket(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsPe
         UINT32 packetCnt = getUnalignedInt32BigEndian(pRtcpPacket->payload + 16);
         UINT32 octetCnt = getUnalignedInt32BigEndian(pRtcpPacket->payload + 20);
         DLOGV("RTCP_PACKET_TYPE_SENDER_REPORT %d %" PRIu64 " rtpTs: %u %u pkts %u bytes", senderSSRC, ntpTime, rtpTs, packetCnt, octetCnt);
+        if (pTransceiver->jitterBufferSsrc == senderSSRC) {
+            // echoed as LSR in our reports so that the remote sender can compute the round trip time
+            rtp_transceiver_lockStats(pTransceiver);
+            pTransceiver->receptionStats.lastSenderReport = (UINT32)((ntpTime >> 16U) & 0xffffffffULL);
+            pTransceiver->receptionStats.lastSenderReportTime = GETTIME();
+            pTransceiver->receptionStats.lastSenderReportNtpTime = ntpTime;
+            pTransceiver->receptionStats.lastSenderReportRtpTime = rtpTs;
+            rtp_transceiver_unlockStats(pTransceiver);
+            if (pTransceiver->playoutSyncStream != PLAYOUT_SYNC_STREAM_NONE) {
+                CHK_STATUS(playout_sync_onSenderReport(pKvsPeerConnection->pPlayoutSync, pTransceiver->playoutSyncStream,
+                                                       rtcp_packet_convertNTPToTimestamp(ntpTime), rtpTs, pTransceiver->pJitterBuffer->clockRate));
+            }
+        }
     } else {
         DLOGV("Received sender report for non existing ssrc: %u", senderSSRC);
     }
 
+    CHK_STATUS(rtcp_onReportBlocks(pKvsPeerConnection, pRtcpPacket, RTCP_PACKET_SENDER_REPORT_MINLEN));
+
 CleanUp:
 
     return retStatus;
 }
 
+/**
+ * @brief https://tools.ietf.org/html/rfc3550#section-6.4.2, the SSRC of the packet sender followed by report blocks.
+ *
+ * @param[in] pRtcpPacket the buffer of rtcp packet.
+ * @param[in] pKvsPeerConnection the context of peer connection.
+ *
+ * @return STATUS status of execution
+ */
 static STATUS rtcp_onRRPacket(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsPeerConnection)
 {
     STATUS retStatus = STATUS_SUCCESS;
-    PKvsRtpTransceiver pTransceiver = NULL;
-    DOUBLE fractionLost;
-    UINT32 rttPropDelayMsec = 0, rttPropDelay, delaySinceLastSR, lastSR, interarrivalJitter, extHiSeqNumReceived, cumulativeLost, senderSSRC, ssrc1;
-    UINT64 currentTimeNTP = rtcp_packet_convertTimestampToNTP(GETTIME());
 
     CHK(pKvsPeerConnection != NULL && pRtcpPacket != NULL, STATUS_RTCP_NULL_ARG);
-    // https://tools.ietf.org/html/rfc3550#section-6.4.2
-    if (pRtcpPacket->payloadLength != RTCP_PACKET_RECEIVER_REPORT_MINLEN) {
-        // TODO: handle multiple receiver report blocks
+    if (pRtcpPacket->payloadLength < SIZEOF(UINT32)) {
         DLOGS("unhandled packet type RTCP_PACKET_TYPE_RECEIVER_REPORT size %d", pRtcpPacket->payloadLength);
         return STATUS_SUCCESS;
     }
 
-    senderSSRC = getUnalignedInt32BigEndian(pRtcpPacket->payload);
-    ssrc1 = getUnalignedInt32BigEndian(pRtcpPacket->payload + 4);
-
-    if (STATUS_FAILED(rtp_transceiver_findBySsrc(pKvsPeerConnection, &pTransceiver, ssrc1))) {
-        DLOGW("Received receiver report for non existing ssrc: %u", ssrc1);
-        return STATUS_SUCCESS; // not really an error ?
-    }
-    fractionLost = pRtcpPacket->payload[8] / 255.0;
-    cumulativeLost = ((UINT32) getUnalignedInt32BigEndian(pRtcpPacket->payload + 8)) & 0x00ffffffu;
-    extHiSeqNumReceived = getUnalignedInt32BigEndian(pRtcpPacket->payload + 12);
-    interarrivalJitter = getUnalignedInt32BigEndian(pRtcpPacket->payload + 16);
-    lastSR = getUnalignedInt32BigEndian(pRtcpPacket->payload + 20);
-    delaySinceLastSR = getUnalignedInt32BigEndian(pRtcpPacket->payload + 24);
-
-    DLOGS("RTCP_PACKET_TYPE_RECEIVER_REPORT %u %u loss: %u %u seq: %u jit: %u lsr: %u dlsr: %u", senderSSRC, ssrc1, fractionLost, cumulativeLost,
-          extHiSeqNumReceived, interarrivalJitter, lastSR, delaySinceLastSR);
-    if (lastSR != 0) {
-        // https://tools.ietf.org/html/rfc3550#section-6.4.1
-        //      Source SSRC_n can compute the round-trip propagation delay to
-        //      SSRC_r by recording the time A when this reception report block is
-        //      received.  It calculates the total round-trip time A-LSR using the
-        //      last SR timestamp (LSR) field, and then subtracting this field to
-        //      leave the round-trip propagation delay as (A - LSR - DLSR).
-        rttPropDelay = MID_NTP(currentTimeNTP) - lastSR - delaySinceLastSR;
-        rttPropDelayMsec = KVS_CONVERT_TIMESCALE(rttPropDelay, DLSR_TIMESCALE, 1000);
-        DLOGS("RTCP_PACKET_TYPE_RECEIVER_REPORT rttPropDelay %u msec", rttPropDelayMsec);
-    }
-
-    MUTEX_LOCK(pTransceiver->statsLock);
-    pTransceiver->remoteInboundStats.reportsReceived++;
-    if (fractionLost > -1.0) {
-        pTransceiver->remoteInboundStats.fractionLost = fractionLost;
-    }
-    pTransceiver->remoteInboundStats.roundTripTimeMeasurements++;
-    pTransceiver->remoteInboundStats.totalRoundTripTime += rttPropDelayMsec;
-    pTransceiver->remoteInboundStats.roundTripTime = rttPropDelayMsec;
-    MUTEX_UNLOCK(pTransceiver->statsLock);
+    CHK_STATUS(rtcp_onReportBlocks(pKvsPeerConnection, pRtcpPacket, SIZEOF(UINT32)));
 
 CleanUp:
 
@@ -307,15 +384,218 @@ STATUS rtcp_onPLIPacket(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsPeerConn
     CHK_STATUS_ERR(rtp_transceiver_findBySsrc(pKvsPeerConnection, &pTransceiver, mediaSSRC), STATUS_RTCP_INPUT_SSRC_INVALID,
                    "Received PLI for non existing ssrc: %u", mediaSSRC);
 
-    MUTEX_LOCK(pTransceiver->statsLock);
+    rtp_transceiver_lockStats(pTransceiver);
     pTransceiver->outboundStats.pliCount++;
-    MUTEX_UNLOCK(pTransceiver->statsLock);
+    rtp_transceiver_unlockStats(pTransceiver);
+
+    rtp_transceiver_requestKeyFrame(pTransceiver);
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * @brief encrypt the compound packet of the builder and send it, the caller holds rtcpBuilderLock. The builder is empty
+ *        afterwards, a packet which could not be sent is dropped.
+ */
+static STATUS rtcp_sendCompoundPacket(PKvsPeerConnection pKvsPeerConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtcpBuilder pRtcpBuilder = pKvsPeerConnection->pRtcpBuilder;
+    INT32 packetLen = (INT32) pRtcpBuilder->length;
+
+    CHK(packetLen > 0, retStatus);
+    CHK_STATUS(srtp_session_encryptRtcpPacket(pKvsPeerConnection->pSrtpSession, pRtcpBuilder->pBuffer, &packetLen));
+    CHK_STATUS(ice_agent_send(pKvsPeerConnection->pIceAgent, pRtcpBuilder->pBuffer, (UINT32) packetLen));
+
+CleanUp:
+    rtcp_builder_reset(pRtcpBuilder);
+
+    return retStatus;
+}
+
+STATUS rtcp_sendReports(PKvsRtpTransceiver pTransceiver, UINT64 now)
+{
+    STATUS retStatus = STATUS_SUCCESS, blockStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection;
+    BOOL sending, receiving, locked = FALSE;
+    UINT64 ntpTime;
+    UINT32 rtpTime, packetCount, octetCount, ssrc, i, encodingCount, reportCount;
+    BYTE reportBlock[RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN];
+
+    CHK(pTransceiver != NULL && pTransceiver->pJitterBuffer != NULL && pTransceiver->pKvsPeerConnection != NULL, STATUS_RTCP_NULL_ARG);
+    pKvsPeerConnection = pTransceiver->pKvsPeerConnection;
+    ssrc = pTransceiver->sender.ssrc;
+
+    // not connected yet
+    CHK(pKvsPeerConnection->pSrtpSession != NULL, retStatus);
+    sending = pTransceiver->sender.firstFrameWallClockTime != 0 &&
+        (now - pTransceiver->sender.firstFrameWallClockTime >= 2500 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+
+    // the report block of the inbound stream goes into the sender report, or a receiver report if nothing is sent
+    rtp_transceiver_lockStats(pTransceiver);
+    receiving = pTransceiver->receptionStats.started;
+    if (receiving) {
+        blockStatus = rtcp_packet_setReportBlock(&pTransceiver->receptionStats, pTransceiver->jitterBufferSsrc,
+                                                 (UINT32) pTransceiver->pJitterBuffer->jitter, now, reportBlock);
+    }
+    rtp_transceiver_unlockStats(pTransceiver);
+    CHK_STATUS(blockStatus);
+    if (!sending && !receiving) {
+        DLOGV("no rtcp report for %u", ssrc);
+        CHK(FALSE, retStatus);
+    }
+
+    MUTEX_LOCK(pKvsPeerConnection->rtcpBuilderLock);
+    locked = TRUE;
+
+    if (!sending) {
+        // https://tools.ietf.org/html/rfc3550#section-6.4.2
+        DLOGV("receiver report %u for %u", ssrc, pTransceiver->jitterBufferSsrc);
+        CHK_STATUS(rtcp_builder_addReceiverReport(pKvsPeerConnection->pRtcpBuilder, ssrc, reportBlock, 1));
+    } else {
+        // https://tools.ietf.org/html/rfc3550#section-6.4.1
+        ntpTime = rtcp_packet_convertTimestampToNTP(now);
+        rtpTime = (UINT32)(pTransceiver->sender.rtpTimeOffset +
+                           CONVERT_TIMESTAMP_TO_RTP(pTransceiver->pJitterBuffer->clockRate, now - pTransceiver->sender.firstFrameWallClockTime));
+
+        // one sender report for the primary encoding and one for every other simulcast encoding the remote accepted
+        encodingCount = pTransceiver->sender.simulcastNegotiated ? MAX(pTransceiver->sender.encodingCount, 1) : 1;
+        for (i = 0; i < encodingCount; i++) {
+            if (i != 0 && !pTransceiver->sender.encodings[i].accepted) {
+                continue;
+            }
+            rtp_transceiver_lockStatsForRead(pTransceiver);
+            if (i == 0) {
+                ssrc = pTransceiver->sender.ssrc;
+                packetCount = pTransceiver->outboundStats.sent.packetsSent;
+                octetCount = pTransceiver->outboundStats.sent.bytesSent;
+            } else {
+                ssrc = pTransceiver->sender.encodings[i].ssrc;
+                packetCount = pTransceiver->sender.encodings[i].outboundStats.sent.packetsSent;
+                octetCount = pTransceiver->sender.encodings[i].outboundStats.sent.bytesSent;
+            }
+            rtp_transceiver_unlockStatsForRead(pTransceiver);
+            DLOGV("sender report %u %" PRIu64 " %u : %u packets %u bytes", ssrc, ntpTime, rtpTime, packetCount, octetCount);
+
+            // the inbound stream is reported once, by the sender report of the primary encoding
+            reportCount = (i == 0 && receiving) ? 1 : 0;
+            CHK_STATUS(rtcp_builder_addSenderReport(pKvsPeerConnection->pRtcpBuilder, ssrc, ntpTime, rtpTime, packetCount, octetCount,
+                                                    reportCount > 0 ? reportBlock : NULL, reportCount));
+        }
+    }
+    // https://tools.ietf.org/html/rfc3550#section-6.1 every compound packet carries the CNAME
+    CHK_STATUS(rtcp_builder_addSdesCname(pKvsPeerConnection->pRtcpBuilder, pTransceiver->sender.ssrc, pKvsPeerConnection->localCNAME));
+    CHK_STATUS(rtcp_sendCompoundPacket(pKvsPeerConnection));
+
+CleanUp:
+    if (locked) {
+        if (STATUS_FAILED(retStatus)) {
+            rtcp_builder_reset(pKvsPeerConnection->pRtcpBuilder);
+        }
+        MUTEX_UNLOCK(pKvsPeerConnection->rtcpBuilderLock);
+    }
+
+    return retStatus;
+}
 
-    if (pTransceiver->onPictureLoss != NULL) {
-        pTransceiver->onPictureLoss(pTransceiver->onPictureLossCustomData);
+STATUS rtcp_sendNackRequests(PKvsRtpTransceiver pTransceiver, UINT64 now)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection;
+    UINT16 sequenceNumberList[NACK_GENERATOR_MAX_PENDING];
+    UINT32 sequenceNumberListLen = ARRAY_SIZE(sequenceNumberList);
+    UINT64 retryInterval;
+    BOOL locked = FALSE;
+
+    CHK(pTransceiver != NULL, STATUS_RTCP_NULL_ARG);
+    CHK(pTransceiver->pNackGenerator != NULL && pTransceiver->pNackGenerator->requestCount > 0, retStatus);
+    pKvsPeerConnection = pTransceiver->pKvsPeerConnection;
+
+    rtp_transceiver_lockStatsForRead(pTransceiver);
+    retryInterval = pTransceiver->remoteInboundStats.roundTripTime * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    rtp_transceiver_unlockStatsForRead(pTransceiver);
+    if (retryInterval == 0) {
+        retryInterval = NACK_GENERATOR_DEFAULT_RTT;
     }
 
+    CHK_STATUS(nack_generator_getNackList(pTransceiver->pNackGenerator, now, retryInterval, sequenceNumberList, &sequenceNumberListLen));
+    CHK(sequenceNumberListLen > 0, retStatus);
+
+    // feedback is sent right away, https://tools.ietf.org/html/rfc5506 allows it without a report in front
+    MUTEX_LOCK(pKvsPeerConnection->rtcpBuilderLock);
+    locked = TRUE;
+    CHK_STATUS(rtcp_builder_addNack(pKvsPeerConnection->pRtcpBuilder, pTransceiver->sender.ssrc, pTransceiver->jitterBufferSsrc, sequenceNumberList,
+                                    sequenceNumberListLen));
+    CHK_STATUS(rtcp_sendCompoundPacket(pKvsPeerConnection));
+
+    rtp_transceiver_lockStats(pTransceiver);
+    pTransceiver->inboundStats.nackCount++;
+    rtp_transceiver_unlockStats(pTransceiver);
+
 CleanUp:
+    if (locked) {
+        if (STATUS_FAILED(retStatus)) {
+            rtcp_builder_reset(pKvsPeerConnection->pRtcpBuilder);
+        }
+        MUTEX_UNLOCK(pKvsPeerConnection->rtcpBuilderLock);
+    }
+
+    return retStatus;
+}
+
+STATUS rtcp_sendKeyFrameRequest(PKvsRtpTransceiver pTransceiver, UINT64 now)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection;
+    PRtpKeyFrameRequestState pState;
+    UINT64 minInterval;
+    BOOL locked = FALSE;
+
+    CHK(pTransceiver != NULL, STATUS_RTCP_NULL_ARG);
+    CHK(pTransceiver->jitterBufferSsrc != 0, retStatus);
+    pKvsPeerConnection = pTransceiver->pKvsPeerConnection;
+    pState = &pTransceiver->keyFrameRequestState;
+    // not connected yet, or the jitter buffer is flushed while the peer connection is torn down
+    CHK(pKvsPeerConnection->pSrtpSession != NULL && pKvsPeerConnection->pIceAgent != NULL, retStatus);
+
+    rtp_transceiver_lockStatsForRead(pTransceiver);
+    minInterval = pTransceiver->remoteInboundStats.roundTripTime * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    rtp_transceiver_unlockStatsForRead(pTransceiver);
+    minInterval = MAX(minInterval, RTCP_KEY_FRAME_REQUEST_MIN_INTERVAL);
+    // the key frame of the previous request may still be on its way
+    CHK(pState->lastRequestTime == 0 || now - pState->lastRequestTime >= minInterval, retStatus);
+
+    MUTEX_LOCK(pKvsPeerConnection->rtcpBuilderLock);
+    locked = TRUE;
+    if (pState->useFir) {
+        CHK_STATUS(rtcp_builder_addFir(pKvsPeerConnection->pRtcpBuilder, pTransceiver->sender.ssrc, pTransceiver->jitterBufferSsrc,
+                                       (UINT8)(pState->firSequenceNumber + 1)));
+    } else {
+        CHK_STATUS(rtcp_builder_addPli(pKvsPeerConnection->pRtcpBuilder, pTransceiver->sender.ssrc, pTransceiver->jitterBufferSsrc));
+    }
+    CHK_STATUS(rtcp_sendCompoundPacket(pKvsPeerConnection));
+    MUTEX_UNLOCK(pKvsPeerConnection->rtcpBuilderLock);
+    locked = FALSE;
+    pState->lastRequestTime = now;
+    if (pState->useFir) {
+        pState->firSequenceNumber++;
+    }
+
+    rtp_transceiver_lockStats(pTransceiver);
+    if (pState->useFir) {
+        pTransceiver->inboundStats.firCount++;
+    } else {
+        pTransceiver->inboundStats.pliCount++;
+    }
+    rtp_transceiver_unlockStats(pTransceiver);
+
+CleanUp:
+    if (locked) {
+        rtcp_builder_reset(pKvsPeerConnection->pRtcpBuilder);
+        MUTEX_UNLOCK(pKvsPeerConnection->rtcpBuilderLock);
+    }
 
     return retStatus;
 }
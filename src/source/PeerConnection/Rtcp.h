@@ -29,12 +29,51 @@ extern "C" {
 /******************************************************************************
  * DEFINITIONS
  ******************************************************************************/
+// key frames are requested again once per round trip time, but not faster than this
+#define RTCP_KEY_FRAME_REQUEST_MIN_INTERVAL (300 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+// https://tools.ietf.org/html/rfc3711#section-3.4 the E flag and SRTCP index, and the authentication tag
+#define RTCP_SRTCP_OVERHEAD (4 + SRTP_AUTH_TAG_OVERHEAD)
+// srtp_protect_rtcp() in srtp_session_encryptRtcpPacket() assumes memory availability to write 10 bytes of authentication tag and
+// SRTP_MAX_TRAILER_LEN + 4 following the actual rtcp Packet payload
+#define RTCP_SRTCP_TAIL_LEN (SRTP_AUTH_TAG_OVERHEAD + SRTP_MAX_TRAILER_LEN + 4)
+
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
 STATUS rtcp_onInboundPacket(PKvsPeerConnection pKvsPeerConnection, PBYTE pBuff, UINT32 buffLen);
 STATUS rtcp_onInboundRembPacket(PRtcpPacket, PKvsPeerConnection);
 STATUS rtcp_onPLIPacket(PRtcpPacket, PKvsPeerConnection);
+/**
+ * @brief send a generic NACK for the missing packets of the receiver of a transceiver which are due for a request.
+ *        Requests are repeated once per round trip time measured by the receiver reports of the remote peer.
+ *
+ * @param[in] pTransceiver the transceiver of the receiver.
+ * @param[in] now the current time in 100ns.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_sendNackRequests(PKvsRtpTransceiver, UINT64);
+/**
+ * @brief ask the remote sender of the receiver of a transceiver for a key frame with a PLI, or a FIR when that
+ *        is all the remote sender offered. Requests within a round trip time of the previous one are skipped.
+ *
+ * @param[in] pTransceiver the transceiver of the receiver.
+ * @param[in] now the current time in 100ns.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_sendKeyFrameRequest(PKvsRtpTransceiver, UINT64);
+/**
+ * @brief send the periodic reports of a transceiver as one compound packet, https://tools.ietf.org/html/rfc3550#section-6.1.
+ *        It holds a SR for every sent encoding or a RR when nothing is sent, the report block of the received stream
+ *        and the CNAME. Nothing is sent before the connection is established.
+ *
+ * @param[in] pTransceiver the transceiver.
+ * @param[in] now the current time in 100ns.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_sendReports(PKvsRtpTransceiver, UINT64);
 
 #ifdef __cplusplus
 }
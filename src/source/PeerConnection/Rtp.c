@@ -31,6 +31,8 @@
  * DEFINITIONS
  ******************************************************************************/
 typedef STATUS (*RtpPayloadFunc)(UINT32, PBYTE, UINT32, PBYTE, PUINT32, PUINT32, PUINT32);
+
+#define IS_RID_CHAR(c) (((c) >= '0' && (c) <= '9') || ((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z'))
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
@@ -51,12 +53,18 @@ STATUS rtp_createTransceiver(RTC_RTP_TRANSCEIVER_DIRECTION direction, PKvsPeerCo
     CHK(pKvsRtpTransceiver->peerFrameBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
     pKvsRtpTransceiver->pKvsPeerConnection = pKvsPeerConnection;
     pKvsRtpTransceiver->statsLock = MUTEX_CREATE(FALSE);
+    pKvsRtpTransceiver->jitterBufferLock = MUTEX_CREATE(FALSE);
+    pKvsRtpTransceiver->jitterBufferTimerId = MAX_UINT32;
     pKvsRtpTransceiver->sender.ssrc = ssrc;
     pKvsRtpTransceiver->sender.rtxSsrc = rtxSsrc;
     pKvsRtpTransceiver->sender.track = *pRtcMediaStreamTrack;
     pKvsRtpTransceiver->sender.packetBuffer = NULL;
     pKvsRtpTransceiver->sender.retransmitter = NULL;
+    pKvsRtpTransceiver->sender.midExtensionId = DEFAULT_MID_EXTENSION_ID;
+    pKvsRtpTransceiver->sender.ridExtensionId = DEFAULT_RID_EXTENSION_ID;
+    pKvsRtpTransceiver->sender.rridExtensionId = DEFAULT_RRID_EXTENSION_ID;
     pKvsRtpTransceiver->pJitterBuffer = pJitterBuffer;
+    pKvsRtpTransceiver->playoutSyncStream = PLAYOUT_SYNC_STREAM_NONE;
     pKvsRtpTransceiver->transceiver.receiver.track.codec = rtcCodec;
     pKvsRtpTransceiver->transceiver.receiver.track.kind = pRtcMediaStreamTrack->kind;
     pKvsRtpTransceiver->transceiver.direction = direction;
@@ -89,25 +97,45 @@ STATUS rtp_transceiver_free(PKvsRtpTransceiver* ppKvsRtpTransceiver)
 {
     STATUS retStatus = STATUS_SUCCESS;
     PKvsRtpTransceiver pKvsRtpTransceiver = NULL;
+    UINT32 i;
 
     CHK(ppKvsRtpTransceiver != NULL, STATUS_RTP_NULL_ARG);
     pKvsRtpTransceiver = *ppKvsRtpTransceiver;
     // free is idempotent
     CHK(pKvsRtpTransceiver != NULL, retStatus);
 
+    // inbound packets of the ssrcs must not find the transceiver any more
+    if (pKvsRtpTransceiver->mappedSsrcCount != 0) {
+        CHK_LOG_ERR(rtp_transceiver_unmapSsrcs(pKvsRtpTransceiver));
+    }
+
     if (pKvsRtpTransceiver->pJitterBuffer != NULL) {
         jitter_buffer_free(&pKvsRtpTransceiver->pJitterBuffer);
     }
 
+    if (pKvsRtpTransceiver->pNackGenerator != NULL) {
+        nack_generator_free(&pKvsRtpTransceiver->pNackGenerator);
+    }
+
     if (pKvsRtpTransceiver->sender.packetBuffer != NULL) {
-        rtp_rolling_buffer_free(&pKvsRtpTransceiver->sender.packetBuffer);
+        rtp_history_free(&pKvsRtpTransceiver->sender.packetBuffer);
     }
 
     if (pKvsRtpTransceiver->sender.retransmitter != NULL) {
         retransmitter_free(&pKvsRtpTransceiver->sender.retransmitter);
     }
+
+    for (i = 0; i < pKvsRtpTransceiver->sender.encodingCount; i++) {
+        if (pKvsRtpTransceiver->sender.encodings[i].packetBuffer != NULL) {
+            rtp_history_free(&pKvsRtpTransceiver->sender.encodings[i].packetBuffer);
+        }
+    }
     MUTEX_FREE(pKvsRtpTransceiver->statsLock);
     pKvsRtpTransceiver->statsLock = INVALID_MUTEX_VALUE;
+    if (IS_VALID_MUTEX_VALUE(pKvsRtpTransceiver->jitterBufferLock)) {
+        MUTEX_FREE(pKvsRtpTransceiver->jitterBufferLock);
+        pKvsRtpTransceiver->jitterBufferLock = INVALID_MUTEX_VALUE;
+    }
 
     SAFE_MEMFREE(pKvsRtpTransceiver->peerFrameBuffer);
     SAFE_MEMFREE(pKvsRtpTransceiver->sender.payloadArray.payloadBuffer);
@@ -151,6 +179,43 @@ CleanUp:
     return retStatus;
 }
 
+STATUS rtp_transceiver_onSlicedFrame(PRtcRtpTransceiver pRtcRtpTransceiver, UINT64 customData, RtcOnSlicedFrame rtcOnSlicedFrame)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+
+    CHK(pKvsRtpTransceiver != NULL && rtcOnSlicedFrame != NULL, STATUS_RTP_NULL_ARG);
+
+    pKvsRtpTransceiver->onSlicedFrame = rtcOnSlicedFrame;
+    pKvsRtpTransceiver->onSlicedFrameCustomData = customData;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtp_transceiver_releaseSlicedFrame(PRtcSlicedFrame pRtcSlicedFrame)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtpSlicedFrame pRtpSlicedFrame = (PRtpSlicedFrame) pRtcSlicedFrame;
+    UINT32 i;
+
+    CHK(pRtpSlicedFrame != NULL, STATUS_RTP_NULL_ARG);
+
+    for (i = 0; i < pRtpSlicedFrame->packetCount; i++) {
+        rtp_packet_free(&pRtpSlicedFrame->pPackets[i]);
+    }
+    MEMFREE(pRtpSlicedFrame);
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
 STATUS rtp_transceiver_onBandwidthEstimation(PRtcRtpTransceiver pRtcRtpTransceiver, UINT64 customData,
                                              RtcOnBandwidthEstimation rtcOnBandwidthEstimation)
 {
@@ -186,12 +251,43 @@ CleanUp:
     return retStatus;
 }
 
+STATUS rtp_transceiver_setMediaSource(PRtcRtpTransceiver pRtcRtpTransceiver, PRtcMediaSource pRtcMediaSource)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+
+    CHK(pKvsRtpTransceiver != NULL, STATUS_RTP_NULL_ARG);
+
+    pKvsRtpTransceiver->pMediaSource = (PKvsMediaSource) pRtcMediaSource;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_transceiver_requestKeyFrame(PKvsRtpTransceiver pKvsRtpTransceiver)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pKvsRtpTransceiver != NULL, STATUS_RTP_NULL_ARG);
+
+    if (pKvsRtpTransceiver->pMediaSource != NULL) {
+        CHK_STATUS(media_source_requestKeyFrame(pKvsRtpTransceiver->pMediaSource));
+    } else if (pKvsRtpTransceiver->onPictureLoss != NULL) {
+        pKvsRtpTransceiver->onPictureLoss(pKvsRtpTransceiver->onPictureLossCustomData);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
 STATUS rtp_transceiver_updateEncoderStats(PRtcRtpTransceiver pRtcRtpTransceiver, PRtcEncoderStats encoderStats)
 {
     STATUS retStatus = STATUS_SUCCESS;
     PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
     CHK(pKvsRtpTransceiver != NULL && encoderStats != NULL, STATUS_RTP_NULL_ARG);
-    MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
+    rtp_transceiver_lockStats(pKvsRtpTransceiver);
     pKvsRtpTransceiver->outboundStats.totalEncodeTime += encoderStats->encodeTimeMsec;
     pKvsRtpTransceiver->outboundStats.targetBitrate = encoderStats->targetBitrate;
     if (encoderStats->width < pKvsRtpTransceiver->outboundStats.frameWidth || encoderStats->height < pKvsRtpTransceiver->outboundStats.frameHeight) {
@@ -205,29 +301,192 @@ STATUS rtp_transceiver_updateEncoderStats(PRtcRtpTransceiver pRtcRtpTransceiver,
     if (encoderStats->encoderImplementation[0] != '\0')
         STRNCPY(pKvsRtpTransceiver->outboundStats.encoderImplementation, encoderStats->encoderImplementation, MAX_STATS_STRING_LENGTH);
 
-    MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+    rtp_transceiver_unlockStats(pKvsRtpTransceiver);
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    return retStatus;
+}
+
+UINT32 rtp_generateSsrc(PKvsPeerConnection pKvsPeerConnection, PUINT32 pPickedSsrcs, UINT32 pickedSsrcCount)
+{
+    UINT64 item;
+    UINT32 ssrc = 0, i;
+    BOOL taken = TRUE;
+
+    // https://tools.ietf.org/html/rfc3550#section-8.1 a collision of random ssrcs is unlikely but not impossible
+    while (taken) {
+        ssrc = (UINT32) RAND();
+        taken = ssrc == 0 ||
+            (pKvsPeerConnection != NULL && pKvsPeerConnection->pSsrcMap != NULL &&
+             STATUS_SUCCEEDED(ssrc_map_get(pKvsPeerConnection->pSsrcMap, ssrc, &item)));
+        for (i = 0; i < pickedSsrcCount && !taken; i++) {
+            taken = ssrc == pPickedSsrcs[i];
+        }
+    }
+
+    return ssrc;
+}
+
+STATUS rtp_transceiver_setSendEncodings(PRtcRtpTransceiver pRtcRtpTransceiver, PRtcRtpEncodingParameters pEncodings, UINT32 encodingCount)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+    PRtcRtpSender pRtcRtpSender = NULL;
+    PRtcRtpEncoding pEncoding = NULL;
+    UINT32 i, j, ridLen, pickedSsrcCount = 0;
+    UINT32 pickedSsrcs[2 * MAX_RTP_SEND_ENCODINGS];
+
+    CHK(pKvsRtpTransceiver != NULL && pEncodings != NULL, STATUS_RTP_NULL_ARG);
+    pRtcRtpSender = &pKvsRtpTransceiver->sender;
+    CHK(encodingCount > 0 && encodingCount <= MAX_RTP_SEND_ENCODINGS, STATUS_RTP_INVALID_ENCODING);
+    CHK(pRtcRtpSender->track.kind == MEDIA_STREAM_TRACK_KIND_VIDEO, STATUS_RTP_INVALID_ENCODING);
+    // encodings can not be changed once the rolling buffers were created by the negotiation
+    CHK(pRtcRtpSender->encodingCount == 0 && pRtcRtpSender->packetBuffer == NULL, STATUS_INVALID_OPERATION);
+
+    // https://tools.ietf.org/html/rfc8851#section-10 rid-id is alphanumeric
+    for (i = 0; i < encodingCount; i++) {
+        ridLen = (UINT32) STRNLEN(pEncodings[i].rid, MAX_RTP_RID_LEN + 1);
+        CHK(ridLen > 0 && ridLen <= MAX_RTP_RID_LEN, STATUS_RTP_INVALID_ENCODING);
+        for (j = 0; j < ridLen; j++) {
+            CHK(IS_RID_CHAR(pEncodings[i].rid[j]), STATUS_RTP_INVALID_ENCODING);
+        }
+        for (j = 0; j < i; j++) {
+            CHK(STRCMP(pEncodings[i].rid, pEncodings[j].rid) != 0, STATUS_RTP_INVALID_ENCODING);
+        }
+    }
+
+    rtp_transceiver_lockStats(pKvsRtpTransceiver);
+    for (i = 0; i < encodingCount; i++) {
+        pEncoding = &pRtcRtpSender->encodings[i];
+        MEMSET(pEncoding, 0x00, SIZEOF(RtcRtpEncoding));
+        STRNCPY(pEncoding->rid, pEncodings[i].rid, MAX_RTP_RID_LEN);
+        if (i == 0) {
+            // the primary encoding keeps the ssrc and stats of the transceiver
+            pEncoding->ssrc = pRtcRtpSender->ssrc;
+            pEncoding->rtxSsrc = pRtcRtpSender->rtxSsrc;
+            STRNCPY(pKvsRtpTransceiver->outboundStats.rid, pEncoding->rid, MAX_STATS_STRING_LENGTH);
+            pickedSsrcs[pickedSsrcCount++] = pEncoding->ssrc;
+            pickedSsrcs[pickedSsrcCount++] = pEncoding->rtxSsrc;
+            continue;
+        }
+
+        // the ssrcs of the earlier encodings are only mapped once all of them are picked
+        pEncoding->ssrc = rtp_generateSsrc(pKvsRtpTransceiver->pKvsPeerConnection, pickedSsrcs, pickedSsrcCount);
+        pickedSsrcs[pickedSsrcCount++] = pEncoding->ssrc;
+        pEncoding->rtxSsrc = rtp_generateSsrc(pKvsRtpTransceiver->pKvsPeerConnection, pickedSsrcs, pickedSsrcCount);
+        pickedSsrcs[pickedSsrcCount++] = pEncoding->rtxSsrc;
+        pEncoding->outboundStats.sent.rtpStream.ssrc = pEncoding->ssrc;
+        STRNCPY(pEncoding->outboundStats.sent.rtpStream.kind, "video", MAX_STATS_STRING_LENGTH);
+        STRNCPY(pEncoding->outboundStats.trackId, pRtcRtpSender->track.trackId, MAX_STATS_STRING_LENGTH);
+        STRNCPY(pEncoding->outboundStats.rid, pEncoding->rid, MAX_STATS_STRING_LENGTH);
+    }
+    pRtcRtpSender->encodingCount = encodingCount;
+    rtp_transceiver_unlockStats(pKvsRtpTransceiver);
+
+    CHK_STATUS(rtp_transceiver_mapSsrcs(pKvsRtpTransceiver));
 
 CleanUp:
+
     CHK_LOG_ERR(retStatus);
 
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtp_transceiver_getSendEncodingStats(PRtcRtpTransceiver pRtcRtpTransceiver, UINT32 encodingIndex,
+                                            PRtcOutboundRtpStreamStats pRtcOutboundRtpStreamStats)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+
+    CHK(pKvsRtpTransceiver != NULL && pRtcOutboundRtpStreamStats != NULL, STATUS_RTP_NULL_ARG);
+    CHK(encodingIndex == 0 || encodingIndex < pKvsRtpTransceiver->sender.encodingCount, STATUS_RTP_INVALID_ENCODING);
+
+    if (encodingIndex == 0) {
+        rtp_transceiver_readStats(pKvsRtpTransceiver, &pKvsRtpTransceiver->outboundStats, pRtcOutboundRtpStreamStats,
+                                  SIZEOF(RtcOutboundRtpStreamStats));
+    } else {
+        rtp_transceiver_readStats(pKvsRtpTransceiver, &pKvsRtpTransceiver->sender.encodings[encodingIndex].outboundStats, pRtcOutboundRtpStreamStats,
+                                  SIZEOF(RtcOutboundRtpStreamStats));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_transceiver_getSendEncodingRemoteInboundStats(PRtcRtpTransceiver pRtcRtpTransceiver, UINT32 encodingIndex,
+                                                         PRtcRemoteInboundRtpStreamStats pRtcRemoteInboundRtpStreamStats)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+
+    CHK(pKvsRtpTransceiver != NULL && pRtcRemoteInboundRtpStreamStats != NULL, STATUS_RTP_NULL_ARG);
+    CHK(encodingIndex == 0 || encodingIndex < pKvsRtpTransceiver->sender.encodingCount, STATUS_RTP_INVALID_ENCODING);
+
+    if (encodingIndex == 0) {
+        rtp_transceiver_readStats(pKvsRtpTransceiver, &pKvsRtpTransceiver->remoteInboundStats, pRtcRemoteInboundRtpStreamStats,
+                                  SIZEOF(RtcRemoteInboundRtpStreamStats));
+    } else {
+        rtp_transceiver_readStats(pKvsRtpTransceiver, &pKvsRtpTransceiver->sender.encodings[encodingIndex].remoteInboundStats,
+                                  pRtcRemoteInboundRtpStreamStats, SIZEOF(RtcRemoteInboundRtpStreamStats));
+    }
+
+CleanUp:
+
     return retStatus;
 }
 
+/**
+ * @brief whether frames after this one may be predicted from it. Key frames always are, and delta frames are
+ *        assumed to be unless the codec marks them otherwise.
+ */
+static BOOL rtp_isReferenceFrame(RTC_CODEC codec, PFrame pFrame)
+{
+    BOOL isReference = TRUE;
+
+    if (codec == RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE && 0 == (pFrame->flags & FRAME_FLAG_KEY_FRAME)) {
+        isH264ReferenceFrame(pFrame->frameData, pFrame->size, &isReference);
+    }
+
+    return isReference;
+}
+
 STATUS rtp_writeFrame(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame)
+{
+    return rtp_writeSimulcastFrame(pRtcRtpTransceiver, 0, pFrame);
+}
+
+STATUS rtp_writeSimulcastFrame(PRtcRtpTransceiver pRtcRtpTransceiver, UINT32 encodingIndex, PFrame pFrame)
 {
     STATUS retStatus = STATUS_SUCCESS;
     PKvsPeerConnection pKvsPeerConnection = NULL;
     PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
     PRtcRtpSender pRtcRtpSender = NULL;
+    PRtcRtpEncoding pEncoding = NULL;
     BOOL locked = FALSE, bufferAfterEncrypt = FALSE;
     PRtpPacket pPacketList = NULL, pRtpPacket = NULL;
-    UINT32 i = 0, packetLen = 0, headerLen = 0, allocSize;
+    UINT32 i = 0, packetLen = 0, headerLen = 0, allocSize, mtu;
     PBYTE rawPacket = NULL;
     PPayloadArray pPayloadArray = NULL;
     RtpPayloadFunc rtpPayloadFunc = NULL;
     UINT64 randomRtpTimeoffset = 0; // TODO: spec requires random rtp time offset
     UINT64 rtpTimestamp = 0;
     UINT64 now = GETTIME();
+    // per encoding state, the primary encoding lives in the sender and transceiver
+    UINT32 ssrc;
+    PUINT16 pSequenceNumber;
+    PRtpHistory pPacketBuffer;
+    PUINT64 pLastKnownFrameCount, pLastKnownFrameCountTime;
+    PRtcOutboundRtpStreamStats pOutboundStats = NULL;
+    PRtpFrameDropState pDropState;
+    BOOL dropFrame = FALSE, frameBroken = FALSE, requestKeyFrame = FALSE;
+    // #stack MID and RID one-byte header extension elements
+    BYTE extensionPayload[MAX_SIMULCAST_EXTENSION_LEN];
+    UINT32 extensionLength = 0;
     // stats updates
     DOUBLE fps = 0.0;
     UINT32 frames = 0, keyframes = 0, bytesSent = 0, packetsSent = 0, headerBytesSent = 0, framesSent = 0;
@@ -241,22 +500,74 @@ STATUS rtp_writeFrame(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame)
     pRtcRtpSender = &(pKvsRtpTransceiver->sender);
     pKvsPeerConnection = pKvsRtpTransceiver->pKvsPeerConnection;
     pPayloadArray = &(pRtcRtpSender->payloadArray);
+    CHK(encodingIndex == 0 || encodingIndex < pRtcRtpSender->encodingCount, STATUS_RTP_INVALID_ENCODING);
+    // Discard the other encodings when the remote can not demux them by rid, and the encodings the remote did not accept
+    CHK(pRtcRtpSender->simulcastNegotiated ? pRtcRtpSender->encodings[encodingIndex].accepted : encodingIndex == 0, retStatus);
+
+    if (encodingIndex == 0) {
+        ssrc = pRtcRtpSender->ssrc;
+        pSequenceNumber = &pRtcRtpSender->sequenceNumber;
+        pPacketBuffer = pRtcRtpSender->packetBuffer;
+        pLastKnownFrameCount = &pRtcRtpSender->lastKnownFrameCount;
+        pLastKnownFrameCountTime = &pRtcRtpSender->lastKnownFrameCountTime;
+        pOutboundStats = &pKvsRtpTransceiver->outboundStats;
+        pDropState = &pRtcRtpSender->dropState;
+    } else {
+        pEncoding = &pRtcRtpSender->encodings[encodingIndex];
+        ssrc = pEncoding->ssrc;
+        pSequenceNumber = &pEncoding->sequenceNumber;
+        pPacketBuffer = pEncoding->packetBuffer;
+        pLastKnownFrameCount = &pEncoding->lastKnownFrameCount;
+        pLastKnownFrameCountTime = &pEncoding->lastKnownFrameCountTime;
+        pOutboundStats = &pEncoding->outboundStats;
+        pDropState = &pEncoding->dropState;
+    }
 
     if (MEDIA_STREAM_TRACK_KIND_VIDEO == pRtcRtpSender->track.kind) {
         frames++;
         if (0 != (pFrame->flags & FRAME_FLAG_KEY_FRAME)) {
             keyframes++;
         }
-        if (pRtcRtpSender->lastKnownFrameCountTime == 0) {
-            pRtcRtpSender->lastKnownFrameCountTime = now;
-            pRtcRtpSender->lastKnownFrameCount = pKvsRtpTransceiver->outboundStats.framesEncoded + frames;
-        } else if (now - pRtcRtpSender->lastKnownFrameCountTime > HUNDREDS_OF_NANOS_IN_A_SECOND) {
-            tmpFrames = (pKvsRtpTransceiver->outboundStats.framesEncoded + frames) - pRtcRtpSender->lastKnownFrameCount;
-            tmpTime = now - pRtcRtpSender->lastKnownFrameCountTime;
+        if (*pLastKnownFrameCountTime == 0) {
+            *pLastKnownFrameCountTime = now;
+            *pLastKnownFrameCount = pOutboundStats->framesEncoded + frames;
+        } else if (now - *pLastKnownFrameCountTime > HUNDREDS_OF_NANOS_IN_A_SECOND) {
+            tmpFrames = (pOutboundStats->framesEncoded + frames) - *pLastKnownFrameCount;
+            tmpTime = now - *pLastKnownFrameCountTime;
             fps = (DOUBLE)(tmpFrames * HUNDREDS_OF_NANOS_IN_A_SECOND) / (DOUBLE) tmpTime;
         }
     }
 
+    // Under congestion drop whole delta frames rather than random packets of key frames and audio
+    if (MEDIA_STREAM_TRACK_KIND_VIDEO == pRtcRtpSender->track.kind && 0 == (pFrame->flags & FRAME_FLAG_KEY_FRAME)) {
+        if (pDropState->waitingForKeyFrame) {
+            dropFrame = TRUE;
+        } else if (pDropState->lastSendFailureTime != 0 && now < pDropState->lastSendFailureTime + RTP_SEND_CONGESTION_HOLD_TIME) {
+            dropFrame = TRUE;
+            if (rtp_isReferenceFrame(pRtcRtpSender->track.codec, pFrame)) {
+                pDropState->waitingForKeyFrame = TRUE;
+                requestKeyFrame = TRUE;
+            }
+        }
+        if (dropFrame) {
+            DLOGV("Dropping delta frame of ssrc %lu, waiting for key frame %d", ssrc, pDropState->waitingForKeyFrame);
+            framesDiscardedOnSend = 1;
+        }
+        CHK(!dropFrame, retStatus);
+    }
+
+    // https://tools.ietf.org/html/rfc8852#section-3 every packet of a negotiated simulcast encoding carries the mid and rid
+    if (pRtcRtpSender->simulcastNegotiated) {
+        if (pRtcRtpSender->mid[0] != '\0' && pRtcRtpSender->midExtensionId != 0) {
+            CHK_STATUS(rtp_packet_appendOneByteExtension(extensionPayload, SIZEOF(extensionPayload), &extensionLength, pRtcRtpSender->midExtensionId,
+                                                         (PBYTE) pRtcRtpSender->mid, (UINT32) STRLEN(pRtcRtpSender->mid)));
+        }
+        CHK_STATUS(rtp_packet_appendOneByteExtension(extensionPayload, SIZEOF(extensionPayload), &extensionLength, pRtcRtpSender->ridExtensionId,
+                                                     (PBYTE) pRtcRtpSender->encodings[encodingIndex].rid,
+                                                     (UINT32) STRLEN(pRtcRtpSender->encodings[encodingIndex].rid)));
+        extensionLength = ROUND_UP(extensionLength, SIZEOF(UINT32));
+    }
+
     MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
     locked = TRUE;
     CHK(pKvsPeerConnection->pSrtpSession != NULL, STATUS_SRTP_NOT_READY_YET); // Discard packets till SRTP is ready
@@ -288,7 +599,13 @@ STATUS rtp_writeFrame(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame)
 
     rtpTimestamp += randomRtpTimeoffset;
 
-    CHK_STATUS(rtpPayloadFunc(pKvsPeerConnection->MTU, (PBYTE) pFrame->frameData, pFrame->size, NULL, &(pPayloadArray->payloadLength), NULL,
+    // Leave room for the header extension so the packets still fit the MTU
+    mtu = pKvsPeerConnection->MTU;
+    if (extensionLength > 0) {
+        mtu -= SIZEOF(UINT32) + extensionLength;
+    }
+
+    CHK_STATUS(rtpPayloadFunc(mtu, (PBYTE) pFrame->frameData, pFrame->size, NULL, &(pPayloadArray->payloadLength), NULL,
                               &(pPayloadArray->payloadSubLenSize)));
     if (pPayloadArray->payloadLength > pPayloadArray->maxPayloadLength) {
         SAFE_MEMFREE(pPayloadArray->payloadBuffer);
@@ -300,17 +617,23 @@ STATUS rtp_writeFrame(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame)
         pPayloadArray->payloadSubLength = (PUINT32) MEMALLOC(pPayloadArray->payloadSubLenSize * SIZEOF(UINT32));
         pPayloadArray->maxPayloadSubLenSize = pPayloadArray->payloadSubLenSize;
     }
-    CHK_STATUS(rtpPayloadFunc(pKvsPeerConnection->MTU, (PBYTE) pFrame->frameData, pFrame->size, pPayloadArray->payloadBuffer,
-                              &(pPayloadArray->payloadLength), pPayloadArray->payloadSubLength, &(pPayloadArray->payloadSubLenSize)));
+    CHK_STATUS(rtpPayloadFunc(mtu, (PBYTE) pFrame->frameData, pFrame->size, pPayloadArray->payloadBuffer, &(pPayloadArray->payloadLength),
+                              pPayloadArray->payloadSubLength, &(pPayloadArray->payloadSubLenSize)));
     pPacketList = (PRtpPacket) MEMALLOC(pPayloadArray->payloadSubLenSize * SIZEOF(RtpPacket));
 
-    CHK_STATUS(rtp_packet_constructPackets(pPayloadArray, pRtcRtpSender->payloadType, pRtcRtpSender->sequenceNumber, rtpTimestamp,
-                                           pRtcRtpSender->ssrc, pPacketList, pPayloadArray->payloadSubLenSize));
-    pRtcRtpSender->sequenceNumber = GET_UINT16_SEQ_NUM(pRtcRtpSender->sequenceNumber + pPayloadArray->payloadSubLenSize);
+    CHK_STATUS(rtp_packet_constructPackets(pPayloadArray, pRtcRtpSender->payloadType, *pSequenceNumber, rtpTimestamp, ssrc, pPacketList,
+                                           pPayloadArray->payloadSubLenSize));
+    *pSequenceNumber = GET_UINT16_SEQ_NUM(*pSequenceNumber + pPayloadArray->payloadSubLenSize);
 
     bufferAfterEncrypt = (pRtcRtpSender->payloadType == pRtcRtpSender->rtxPayloadType);
     for (i = 0; i < pPayloadArray->payloadSubLenSize; i++) {
         pRtpPacket = pPacketList + i;
+        if (extensionLength > 0) {
+            pRtpPacket->header.extension = TRUE;
+            pRtpPacket->header.extensionProfile = RTP_ONE_BYTE_EXTENSION_PROFILE;
+            pRtpPacket->header.extensionPayload = extensionPayload;
+            pRtpPacket->header.extensionLength = extensionLength;
+        }
 
         // Get the required size first
         CHK_STATUS(rtp_packet_createBytesFromPacket(pRtpPacket, NULL, &packetLen));
@@ -321,9 +644,7 @@ STATUS rtp_writeFrame(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame)
         CHK_STATUS(rtp_packet_createBytesFromPacket(pRtpPacket, rawPacket, &packetLen));
 
         if (!bufferAfterEncrypt) {
-            pRtpPacket->pRawPacket = rawPacket;
-            pRtpPacket->rawPacketLength = packetLen;
-            CHK_STATUS(rtp_rolling_buffer_addRtpPacket(pRtcRtpSender->packetBuffer, pRtpPacket));
+            CHK_STATUS(rtp_history_put(pPacketBuffer, rawPacket, packetLen, now));
         }
 
         CHK_STATUS(srtp_session_encryptRtpPacket(pKvsPeerConnection->pSrtpSession, rawPacket, (PINT32) &packetLen));
@@ -334,13 +655,23 @@ STATUS rtp_writeFrame(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame)
             // TODO is frame considered discarded when at least one of its packets is discarded or all of its packets discarded?
             framesDiscardedOnSend = 1;
             SAFE_MEMFREE(rawPacket);
+            if (MEDIA_STREAM_TRACK_KIND_VIDEO == pRtcRtpSender->track.kind) {
+                pDropState->lastSendFailureTime = now;
+                // Without retransmission the packet is lost for good and the rest of the frame is of no use to the receiver
+                if (bufferAfterEncrypt) {
+                    frameBroken = TRUE;
+                    for (i++; i < pPayloadArray->payloadSubLenSize; i++) {
+                        packetsDiscardedOnSend++;
+                        bytesDiscardedOnSend += pPayloadArray->payloadSubLength[i];
+                    }
+                    break;
+                }
+            }
             continue;
         }
         CHK_STATUS(sendStatus);
         if (bufferAfterEncrypt) {
-            pRtpPacket->pRawPacket = rawPacket;
-            pRtpPacket->rawPacketLength = packetLen;
-            CHK_STATUS(rtp_rolling_buffer_addRtpPacket(pRtcRtpSender->packetBuffer, pRtpPacket));
+            CHK_STATUS(rtp_history_put(pPacketBuffer, rawPacket, packetLen, now));
         }
 
         // https://tools.ietf.org/html/rfc3550#section-6.4.1
@@ -356,6 +687,12 @@ STATUS rtp_writeFrame(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame)
 
     if (MEDIA_STREAM_TRACK_KIND_VIDEO == pRtcRtpSender->track.kind) {
         framesSent++;
+        if (frameBroken && rtp_isReferenceFrame(pRtcRtpSender->track.codec, pFrame)) {
+            pDropState->waitingForKeyFrame = TRUE;
+            requestKeyFrame = TRUE;
+        } else if (!frameBroken && 0 != (pFrame->flags & FRAME_FLAG_KEY_FRAME)) {
+            pDropState->waitingForKeyFrame = FALSE;
+        }
     }
 
     if (pRtcRtpSender->firstFrameWallClockTime == 0) {
@@ -367,35 +704,36 @@ CleanUp:
     if (locked) {
         MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
     }
-    MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
-    pKvsRtpTransceiver->outboundStats.totalEncodedBytesTarget += pFrame->size;
-    pKvsRtpTransceiver->outboundStats.framesEncoded += frames;
-    pKvsRtpTransceiver->outboundStats.keyFramesEncoded += keyframes;
-    if (fps > 0.0) {
-        pKvsRtpTransceiver->outboundStats.framesPerSecond = fps;
-    }
-    pRtcRtpSender->lastKnownFrameCountTime = now;
-    pRtcRtpSender->lastKnownFrameCount = pKvsRtpTransceiver->outboundStats.framesEncoded;
-    pKvsRtpTransceiver->outboundStats.sent.bytesSent += bytesSent;
-    pKvsRtpTransceiver->outboundStats.sent.packetsSent += packetsSent;
-    if (lastPacketSentTimestamp > 0) {
-        pKvsRtpTransceiver->outboundStats.lastPacketSentTimestamp = lastPacketSentTimestamp;
-    }
-    pKvsRtpTransceiver->outboundStats.headerBytesSent += headerBytesSent;
-    pKvsRtpTransceiver->outboundStats.framesSent += framesSent;
-    if (pKvsRtpTransceiver->outboundStats.framesPerSecond > 0.0) {
-        if (pFrame->size >=
-            pKvsRtpTransceiver->outboundStats.targetBitrate / pKvsRtpTransceiver->outboundStats.framesPerSecond * HUGE_FRAME_MULTIPLIER) {
-            pKvsRtpTransceiver->outboundStats.hugeFramesSent++;
+    if (pOutboundStats != NULL) {
+        rtp_transceiver_lockStats(pKvsRtpTransceiver);
+        pOutboundStats->totalEncodedBytesTarget += pFrame->size;
+        pOutboundStats->framesEncoded += frames;
+        pOutboundStats->keyFramesEncoded += keyframes;
+        if (fps > 0.0) {
+            pOutboundStats->framesPerSecond = fps;
         }
-    }
-    // ice_agent_send tries to send packet immediately, explicitly settings totalPacketSendDelay to 0
-    pKvsRtpTransceiver->outboundStats.totalPacketSendDelay = 0;
+        *pLastKnownFrameCountTime = now;
+        *pLastKnownFrameCount = pOutboundStats->framesEncoded;
+        pOutboundStats->sent.bytesSent += bytesSent;
+        pOutboundStats->sent.packetsSent += packetsSent;
+        if (lastPacketSentTimestamp > 0) {
+            pOutboundStats->lastPacketSentTimestamp = lastPacketSentTimestamp;
+        }
+        pOutboundStats->headerBytesSent += headerBytesSent;
+        pOutboundStats->framesSent += framesSent;
+        if (pOutboundStats->framesPerSecond > 0.0) {
+            if (pFrame->size >= pOutboundStats->targetBitrate / pOutboundStats->framesPerSecond * HUGE_FRAME_MULTIPLIER) {
+                pOutboundStats->hugeFramesSent++;
+            }
+        }
+        // ice_agent_send tries to send packet immediately, explicitly settings totalPacketSendDelay to 0
+        pOutboundStats->totalPacketSendDelay = 0;
 
-    pKvsRtpTransceiver->outboundStats.framesDiscardedOnSend += framesDiscardedOnSend;
-    pKvsRtpTransceiver->outboundStats.packetsDiscardedOnSend += packetsDiscardedOnSend;
-    pKvsRtpTransceiver->outboundStats.bytesDiscardedOnSend += bytesDiscardedOnSend;
-    MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+        pOutboundStats->framesDiscardedOnSend += framesDiscardedOnSend;
+        pOutboundStats->packetsDiscardedOnSend += packetsDiscardedOnSend;
+        pOutboundStats->bytesDiscardedOnSend += bytesDiscardedOnSend;
+        rtp_transceiver_unlockStats(pKvsRtpTransceiver);
+    }
 
     SAFE_MEMFREE(rawPacket);
     SAFE_MEMFREE(pPacketList);
@@ -403,6 +741,13 @@ CleanUp:
         CHK_LOG_ERR(retStatus);
     }
 
+    // The reference chain is broken, ask the application for a new key frame the same way a PLI from the receiver does
+    if (requestKeyFrame) {
+        rtp_transceiver_requestKeyFrame(pKvsRtpTransceiver);
+    } else if (framesSent > 0 && pKvsRtpTransceiver->pMediaSource != NULL) {
+        media_source_onFrameSent(pKvsRtpTransceiver->pMediaSource, 0 != (pFrame->flags & FRAME_FLAG_KEY_FRAME));
+    }
+
     return retStatus;
 }
 
@@ -433,6 +778,28 @@ CleanUp:
     return retStatus;
 }
 
+STATUS rtp_writeRawPacketInPlace(PKvsPeerConnection pKvsPeerConnection, PBYTE pRawPacket, UINT32 packetLength)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    INT32 rawLen = (INT32) packetLength;
+
+    CHK(pKvsPeerConnection != NULL && pRawPacket != NULL, STATUS_RTP_NULL_ARG);
+
+    MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
+    locked = TRUE;
+    CHK(pKvsPeerConnection->pSrtpSession != NULL, STATUS_SUCCESS); // Discard packets till SRTP is ready
+    CHK_STATUS(srtp_session_encryptRtpPacket(pKvsPeerConnection->pSrtpSession, pRawPacket, &rawLen));
+    CHK_STATUS(ice_agent_send(pKvsPeerConnection->pIceAgent, pRawPacket, rawLen));
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+    }
+
+    return retStatus;
+}
+
 STATUS rtp_findTransceiverByssrc(PKvsPeerConnection pKvsPeerConnection, UINT32 ssrc)
 {
     PKvsRtpTransceiver p = NULL;
@@ -442,26 +809,149 @@ STATUS rtp_findTransceiverByssrc(PKvsPeerConnection pKvsPeerConnection, UINT32 s
 STATUS rtp_transceiver_findBySsrc(PKvsPeerConnection pKvsPeerConnection, PKvsRtpTransceiver* ppTransceiver, UINT32 ssrc)
 {
     STATUS retStatus = STATUS_SUCCESS;
-    PDoubleListNode pCurNode = NULL;
     UINT64 item = 0;
     PKvsRtpTransceiver pTransceiver = NULL;
+    PRtcRtpEncoding pEncoding = NULL;
     CHK(pKvsPeerConnection != NULL && ppTransceiver != NULL, STATUS_RTP_NULL_ARG);
 
-    CHK_STATUS(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
-    while (pCurNode != NULL) {
-        CHK_STATUS(double_list_getNodeData(pCurNode, &item));
-        pTransceiver = (PKvsRtpTransceiver) item;
-        if (pTransceiver->sender.ssrc == ssrc || pTransceiver->sender.rtxSsrc == ssrc || pTransceiver->jitterBufferSsrc == ssrc) {
-            break;
-        }
-        pTransceiver = NULL;
-        pCurNode = pCurNode->pNext;
-    }
-    CHK(pTransceiver != NULL, STATUS_NOT_FOUND);
+    CHK_STATUS(ssrc_map_get(pKvsPeerConnection->pSsrcMap, ssrc, &item));
+    pTransceiver = (PKvsRtpTransceiver) item;
+    // the rtx ssrc of the remote sender is mapped for the receive path only
+    CHK(pTransceiver->jitterBufferSsrc == ssrc || STATUS_SUCCEEDED(rtp_transceiver_findEncodingBySsrc(pTransceiver, ssrc, &pEncoding)),
+        STATUS_NOT_FOUND);
     *ppTransceiver = pTransceiver;
 
 CleanUp:
     CHK_LOG_ERR(retStatus);
     return retStatus;
 }
+
+STATUS rtp_transceiver_findEncodingBySsrc(PKvsRtpTransceiver pKvsRtpTransceiver, UINT32 ssrc, PRtcRtpEncoding* ppEncoding)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtcRtpEncoding pEncoding = NULL;
+    UINT32 i;
+    BOOL found = FALSE;
+
+    CHK(pKvsRtpTransceiver != NULL && ppEncoding != NULL, STATUS_RTP_NULL_ARG);
+
+    if (pKvsRtpTransceiver->sender.ssrc == ssrc || pKvsRtpTransceiver->sender.rtxSsrc == ssrc) {
+        found = TRUE;
+    }
+    // encoding 0 is the primary encoding of the sender
+    for (i = 1; i < pKvsRtpTransceiver->sender.encodingCount && !found; i++) {
+        if (pKvsRtpTransceiver->sender.encodings[i].ssrc == ssrc || pKvsRtpTransceiver->sender.encodings[i].rtxSsrc == ssrc) {
+            pEncoding = &pKvsRtpTransceiver->sender.encodings[i];
+            found = TRUE;
+        }
+    }
+    CHK(found, STATUS_NOT_FOUND);
+    *ppEncoding = pEncoding;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_transceiver_mapSsrcs(PKvsRtpTransceiver pKvsRtpTransceiver)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PSsrcMap pSsrcMap = NULL;
+    UINT32 ssrcs[RTP_TRANSCEIVER_MAX_MAPPED_SSRCS];
+    UINT32 i, ssrcCount = 0;
+
+    CHK(pKvsRtpTransceiver != NULL && pKvsRtpTransceiver->pKvsPeerConnection != NULL, STATUS_RTP_NULL_ARG);
+    pSsrcMap = pKvsRtpTransceiver->pKvsPeerConnection->pSsrcMap;
+
+    ssrcs[ssrcCount++] = pKvsRtpTransceiver->sender.ssrc;
+    ssrcs[ssrcCount++] = pKvsRtpTransceiver->sender.rtxSsrc;
+    ssrcs[ssrcCount++] = pKvsRtpTransceiver->jitterBufferSsrc;
+    ssrcs[ssrcCount++] = pKvsRtpTransceiver->jitterBufferRtxSsrc;
+    for (i = 1; i < pKvsRtpTransceiver->sender.encodingCount; i++) {
+        ssrcs[ssrcCount++] = pKvsRtpTransceiver->sender.encodings[i].ssrc;
+        ssrcs[ssrcCount++] = pKvsRtpTransceiver->sender.encodings[i].rtxSsrc;
+    }
+
+    // the ssrcs which are gone would otherwise keep leading to the transceiver
+    CHK_STATUS(rtp_transceiver_unmapSsrcs(pKvsRtpTransceiver));
+
+    // 0 is an ssrc which was not negotiated yet
+    for (i = 0; i < ssrcCount; i++) {
+        if (ssrcs[i] != 0) {
+            CHK_STATUS(ssrc_map_put(pSsrcMap, ssrcs[i], (UINT64) pKvsRtpTransceiver));
+            pKvsRtpTransceiver->mappedSsrcs[pKvsRtpTransceiver->mappedSsrcCount++] = ssrcs[i];
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_transceiver_unmapSsrcs(PKvsRtpTransceiver pKvsRtpTransceiver)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PSsrcMap pSsrcMap = NULL;
+    UINT32 i;
+
+    CHK(pKvsRtpTransceiver != NULL && pKvsRtpTransceiver->pKvsPeerConnection != NULL, STATUS_RTP_NULL_ARG);
+    pSsrcMap = pKvsRtpTransceiver->pKvsPeerConnection->pSsrcMap;
+
+    for (i = 0; i < pKvsRtpTransceiver->mappedSsrcCount; i++) {
+        // not found when another transceiver took the ssrc over, or the transceiver maps the same ssrc twice
+        retStatus = ssrc_map_removeValue(pSsrcMap, pKvsRtpTransceiver->mappedSsrcs[i], (UINT64) pKvsRtpTransceiver);
+        CHK(STATUS_SUCCEEDED(retStatus) || retStatus == STATUS_NOT_FOUND, retStatus);
+    }
+    retStatus = STATUS_SUCCESS;
+    pKvsRtpTransceiver->mappedSsrcCount = 0;
+
+CleanUp:
+
+    return retStatus;
+}
+
+VOID rtp_transceiver_lockStats(PKvsRtpTransceiver pKvsRtpTransceiver)
+{
+    MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
+    ATOMIC_INCREMENT(&pKvsRtpTransceiver->statsVersion);
+}
+
+VOID rtp_transceiver_unlockStats(PKvsRtpTransceiver pKvsRtpTransceiver)
+{
+    ATOMIC_INCREMENT(&pKvsRtpTransceiver->statsVersion);
+    MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+}
+
+VOID rtp_transceiver_lockStatsForRead(PKvsRtpTransceiver pKvsRtpTransceiver)
+{
+    MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
+}
+
+VOID rtp_transceiver_unlockStatsForRead(PKvsRtpTransceiver pKvsRtpTransceiver)
+{
+    MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+}
+
+VOID rtp_transceiver_readStats(PKvsRtpTransceiver pKvsRtpTransceiver, PVOID pStats, PVOID pCopy, UINT32 size)
+{
+    SIZE_T version;
+    UINT32 i;
+    BOOL copied = FALSE;
+
+    for (i = 0; i < RTP_STATS_MAX_LOCK_FREE_READS && !copied; i++) {
+        version = ATOMIC_LOAD(&pKvsRtpTransceiver->statsVersion);
+        if ((version & 1) == 0) {
+            MEMCPY(pCopy, pStats, size);
+            // the fence keeps the copy ahead of the check, the copy is dropped when a writer came by meanwhile
+            ATOMIC_FENCE_ACQUIRE();
+            copied = ATOMIC_LOAD(&pKvsRtpTransceiver->statsVersion) == version;
+        }
+    }
+
+    if (!copied) {
+        MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
+        MEMCPY(pCopy, pStats, size);
+        MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+    }
+}
 #endif
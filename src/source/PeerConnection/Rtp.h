@@ -24,10 +24,12 @@ extern "C" {
  * HEADERS
  ******************************************************************************/
 #include "RtpPacket.h"
-#include "RtpRollingBuffer.h"
+#include "RtpHistory.h"
 #include "JitterBuffer.h"
 #include "PeerConnection.h"
 #include "Retransmitter.h"
+#include "MediaSource.h"
+#include "NackGenerator.h"
 
 /******************************************************************************
  * DEFINITIONS
@@ -37,15 +39,97 @@ extern "C" {
 #define DEFAULT_MTU_SIZE                           1200
 #define DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS 3
 #define HIGHEST_EXPECTED_BIT_RATE                  (10 * 1024 * 1024)
+#define HIGHEST_EXPECTED_AUDIO_BIT_RATE            (512 * 1024)
+#define HIGHEST_EXPECTED_AUDIO_PACKET_RATE         100 // audio frames of 10ms
 #define DEFAULT_SEQ_NUM_BUFFER_SIZE                1000
-#define DEFAULT_VALID_INDEX_BUFFER_SIZE            1000
+#define DEFAULT_RETRANSMIT_PACKET_BUFFER_SIZE      1500 // the largest ethernet payload
 #define DEFAULT_PEER_FRAME_BUFFER_SIZE             (5 * 1024)
 #define SRTP_AUTH_TAG_OVERHEAD                     10
 
+// The packet history keeps the packets for a few round trips, so a NACK and a repeated one after a lost retransmission both
+// find the packet, within the limits below. The bytes of all the histories of a peer connection are capped.
+#define RTP_HISTORY_RTT_MULTIPLIER       4
+#define RTP_HISTORY_MIN_MAX_AGE_MSEC     250
+#define RTP_HISTORY_DEFAULT_MAX_AGE_MSEC (DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS * 1000)
+#ifdef KVS_PLAT_ESP_FREERTOS
+#define DEFAULT_RTP_HISTORY_MAX_PEER_BYTES (512 * 1024)
+#else
+#define DEFAULT_RTP_HISTORY_MAX_PEER_BYTES (8 * 1024 * 1024)
+#endif
+
+// The stats are read without the statsLock, a reader which keeps racing the writers takes the lock after that many copies so
+// that it cannot spin forever behind a preempted writer of a lower priority.
+#define RTP_STATS_MAX_LOCK_FREE_READS 16
+
+// the media and rtx ssrc of both directions and of every send encoding after the first
+#define RTP_TRANSCEIVER_MAX_MAPPED_SSRCS (4 + 2 * MAX_RTP_SEND_ENCODINGS)
+
 // https://www.w3.org/TR/webrtc-stats/#dom-rtcoutboundrtpstreamstats-huge
 // Huge frames, by definition, are frames that have an encoded size at least 2.5 times the average size of the frames.
 #define HUGE_FRAME_MULTIPLIER 2.5
 
+// https://tools.ietf.org/html/rfc8852#section-3
+#define RTP_HEADER_EXTENSION_MID_URI  "urn:ietf:params:rtp-hdrext:sdes:mid"
+#define RTP_HEADER_EXTENSION_RID_URI  "urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id"
+#define RTP_HEADER_EXTENSION_RRID_URI "urn:ietf:params:rtp-hdrext:sdes:repaired-rtp-stream-id"
+
+// extension ids offered by us, the answerer latches the ids from the offer
+#define DEFAULT_MID_EXTENSION_ID  1
+#define DEFAULT_RID_EXTENSION_ID  2
+#define DEFAULT_RRID_EXTENSION_ID 3
+
+#define MAX_RTP_MID_LEN 16
+// MID and RID elements with their one-byte headers, padded to 32-bit words
+#define MAX_SIMULCAST_EXTENSION_LEN ROUND_UP(2 * (RTP_ONE_BYTE_EXTENSION_HEADER_LEN + RTP_ONE_BYTE_EXTENSION_MAX_LEN), 4)
+
+// after a packet of an encoding could not be sent, its delta frames are dropped whole for this long
+#define RTP_SEND_CONGESTION_HOLD_TIME (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+/**
+ * Frame drop policy of a video encoding. Under congestion whole delta frames are dropped so that
+ * key frames and audio get through, and once a reference frame is lost the following delta frames
+ * are dropped until the next key frame.
+ */
+typedef struct {
+    UINT64 lastSendFailureTime; // 100ns precision
+    BOOL waitingForKeyFrame;
+} RtpFrameDropState, *PRtpFrameDropState;
+
+/**
+ * Key frame requests of the receiver. A frame the jitter buffer gave up on leaves the decoder without its
+ * reference, so the remote sender is asked for a key frame, at most once per round trip time.
+ */
+typedef struct {
+    BOOL useFir;             // the remote sender offered ccm fir but not nack pli
+    UINT8 firSequenceNumber; // https://tools.ietf.org/html/rfc5104#section-4.3.1.1
+    UINT64 lastRequestTime;  // 100ns precision
+} RtpKeyFrameRequestState, *PRtpKeyFrameRequestState;
+
+/**
+ * One simulcast layer of a sender. Encoding 0 is sent with the primary ssrc, sequence number,
+ * packet history and outbound stats of the sender/transceiver, so only its rid is kept here.
+ */
+typedef struct {
+    CHAR rid[MAX_RTP_RID_LEN + 1];
+    UINT32 ssrc;
+    UINT32 rtxSsrc;
+    UINT16 sequenceNumber;
+    UINT16 rtxSequenceNumber;
+    PRtpHistory packetBuffer;
+
+    // used for fps calculation
+    UINT64 lastKnownFrameCount;
+    UINT64 lastKnownFrameCountTime; // 100ns precision
+
+    RtpFrameDropState dropState;
+    // the remote listed the rid in the recv list of its a=simulcast, only accepted encodings are sent once simulcast is negotiated
+    BOOL accepted;
+
+    // protected by the statsLock of the transceiver
+    RtcOutboundRtpStreamStats outboundStats;
+    RtcRemoteInboundRtpStreamStats remoteInboundStats;
+} RtcRtpEncoding, *PRtcRtpEncoding;
+
 typedef struct {
     UINT8 payloadType;
     UINT8 rtxPayloadType;
@@ -56,7 +140,7 @@ typedef struct {
     PayloadArray payloadArray;
 
     RtcMediaStreamTrack track;
-    PRtpRollingBuffer packetBuffer;
+    PRtpHistory packetBuffer;
     PRetransmitter retransmitter;
 
     UINT64 rtpTimeOffset;
@@ -66,8 +150,28 @@ typedef struct {
     UINT64 lastKnownFrameCount;
     UINT64 lastKnownFrameCountTime; // 100ns precision
 
+    RtpFrameDropState dropState;
+
+    // simulcast, encodingCount is 0 when a single encoding is sent without rid
+    UINT32 encodingCount;
+    RtcRtpEncoding encodings[MAX_RTP_SEND_ENCODINGS];
+    BOOL simulcastNegotiated;
+    CHAR mid[MAX_RTP_MID_LEN + 1];
+    UINT8 midExtensionId;
+    UINT8 ridExtensionId;
+    UINT8 rridExtensionId;
 } RtcRtpSender, *PRtcRtpSender;
 
+/**
+ * A frame handed out through onSlicedFrame, its slices point into the packets which are freed when the application
+ * releases the frame. Allocated as one block: this struct, the packets, then the slices.
+ */
+typedef struct {
+    RtcSlicedFrame frame;
+    UINT32 packetCount;
+    PRtpPacket* pPackets;
+} RtpSlicedFrame, *PRtpSlicedFrame;
+
 typedef struct {
     RtcRtpTransceiver transceiver;
     RtcRtpSender sender;
@@ -75,25 +179,51 @@ typedef struct {
     PKvsPeerConnection pKvsPeerConnection;
 
     UINT32 jitterBufferSsrc;
+    // retransmissions of jitterBufferSsrc, https://tools.ietf.org/html/rfc4588, 0 when the remote peer does not send rtx
+    UINT32 jitterBufferRtxSsrc;
     PJitterBuffer pJitterBuffer;
+    // requests the packets missing from jitterBufferSsrc, NULL when the receiver does not use NACK
+    PNackGenerator pNackGenerator;
+    RtpKeyFrameRequestState keyFrameRequestState;
+    // the stream of pKvsPeerConnection->pPlayoutSync fed by the transceiver, PLAYOUT_SYNC_STREAM_NONE when it is not synchronized
+    UINT32 playoutSyncStream;
 
     UINT64 onFrameCustomData;
     RtcOnFrame onFrame;
+    // frames go out as slices of the jitter buffer packets instead of through onFrame when it is set
+    UINT64 onSlicedFrameCustomData;
+    RtcOnSlicedFrame onSlicedFrame;
+    DepayRtpPayloadSlicesFunc depayPayloadSlicesFn;
 
     UINT64 onBandwidthEstimationCustomData;
     RtcOnBandwidthEstimation onBandwidthEstimation;
     UINT64 onPictureLossCustomData;
     RtcOnPictureLoss onPictureLoss;
+    // key frame requests go to the media source instead of onPictureLoss when it is set
+    PKvsMediaSource pMediaSource;
 
     PBYTE peerFrameBuffer;
     UINT32 peerFrameBufferSize;
 
+    // the ssrcs rtp_transceiver_mapSsrcs put into the ssrc map of the peer connection, taken out again on the next map and on free
+    UINT32 mappedSsrcs[RTP_TRANSCEIVER_MAX_MAPPED_SSRCS];
+    UINT32 mappedSsrcCount;
+
     UINT32 rtcpReportsTimerId;
+    // releases the frames held by the jitter buffer when no packet follows them, MAX_UINT32 when frames are not held
+    UINT32 jitterBufferTimerId;
+    // serializes the receiving thread and jitterBufferTimerId on the jitter buffer and the nack generator
+    MUTEX jitterBufferLock;
 
+    // serializes the writers of the stats below and of the stats of the encodings
     MUTEX statsLock;
+    // odd while a writer changes the stats, a reader keeps what it copied only if the version did not move meanwhile
+    volatile SIZE_T statsVersion;
     RtcOutboundRtpStreamStats outboundStats;
     RtcRemoteInboundRtpStreamStats remoteInboundStats;
     RtcInboundRtpStreamStats inboundStats;
+    // report block of jitterBufferSsrc in our SR and RR
+    RtcpReceptionStats receptionStats;
 } KvsRtpTransceiver, *PKvsRtpTransceiver;
 /******************************************************************************
  * FUNCTIONS
@@ -107,9 +237,93 @@ STATUS rtp_transceiver_setJitterBuffer(PKvsRtpTransceiver, PJitterBuffer);
 #define CONVERT_TIMESTAMP_TO_RTP(clockRate, pts) (pts * clockRate / HUNDREDS_OF_NANOS_IN_A_SECOND)
 
 STATUS rtp_writePacket(PKvsPeerConnection pKvsPeerConnection, PRtpPacket pRtpPacket);
+/**
+ * @brief encrypt a serialized packet in place and send it, without the copy of rtp_writePacket.
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ * @param[in] pRawPacket the packet, followed by SRTP_AUTH_TAG_OVERHEAD bytes of room for the authentication tag.
+ * @param[in] packetLength the length of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_writeRawPacketInPlace(PKvsPeerConnection, PBYTE, UINT32);
 
+/**
+ * @brief pick a random ssrc for a local stream which is not 0, is not mapped in the ssrc map of the peer connection and
+ *        is none of the ssrcs picked so far but not mapped yet.
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ * @param[in] pPickedSsrcs the ssrcs picked before, NULL if there are none.
+ * @param[in] pickedSsrcCount the number of pPickedSsrcs.
+ *
+ * @return UINT32 the ssrc.
+ */
+UINT32 rtp_generateSsrc(PKvsPeerConnection, PUINT32, UINT32);
 STATUS rtp_findTransceiverByssrc(PKvsPeerConnection pKvsPeerConnection, UINT32 ssrc);
 STATUS rtp_transceiver_findBySsrc(PKvsPeerConnection pKvsPeerConnection, PKvsRtpTransceiver* ppTransceiver, UINT32 ssrc);
+/**
+ * @brief the receiver of the transceiver needs a key frame, either through the media source of the transceiver
+ *        or the onPictureLoss callback.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_transceiver_requestKeyFrame(PKvsRtpTransceiver);
+/**
+ * @brief find the simulcast encoding of a transceiver which sends on the media or rtx ssrc.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ * @param[in] ssrc the media or rtx ssrc.
+ * @param[out] ppEncoding the encoding, NULL if the ssrc belongs to the primary encoding.
+ *
+ * @return STATUS_NOT_FOUND if the ssrc is not sent by this transceiver
+ */
+STATUS rtp_transceiver_findEncodingBySsrc(PKvsRtpTransceiver pKvsRtpTransceiver, UINT32 ssrc, PRtcRtpEncoding* ppEncoding);
+/**
+ * @brief map every ssrc the transceiver sends or receives on to it, so that inbound packets find it without a walk of the
+ *        transceivers. Called again whenever the negotiation or the encodings change ssrcs, the ssrcs of the previous
+ *        call are unmapped first.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_transceiver_mapSsrcs(PKvsRtpTransceiver pKvsRtpTransceiver);
+/**
+ * @brief take the ssrcs of the last rtp_transceiver_mapSsrcs out of the ssrc map, unless they were mapped to another
+ *        transceiver since.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_transceiver_unmapSsrcs(PKvsRtpTransceiver pKvsRtpTransceiver);
+/**
+ * @brief start changing the stats of a transceiver or of its encodings, the readers copying them meanwhile try again.
+ *        Every lockStats is paired with an unlockStats, the stats are never changed outside of the pair.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ */
+VOID rtp_transceiver_lockStats(PKvsRtpTransceiver pKvsRtpTransceiver);
+VOID rtp_transceiver_unlockStats(PKvsRtpTransceiver pKvsRtpTransceiver);
+/**
+ * @brief start reading a few stats of a transceiver or of its encodings. The writers wait, the version is left alone
+ *        so the readers copying the stats without the lock do not try again.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ */
+VOID rtp_transceiver_lockStatsForRead(PKvsRtpTransceiver pKvsRtpTransceiver);
+VOID rtp_transceiver_unlockStatsForRead(PKvsRtpTransceiver pKvsRtpTransceiver);
+/**
+ * @brief copy stats of a transceiver or of its encodings without blocking the writers.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ * @param[in] pStats the stats, a field of the transceiver or of one of its encodings.
+ * @param[out] pCopy the copy.
+ * @param[in] size the size of the stats.
+ */
+VOID rtp_transceiver_readStats(PKvsRtpTransceiver pKvsRtpTransceiver, PVOID pStats, PVOID pCopy, UINT32 size);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#define LOG_CLASS "Runtime"
+
+#include "Runtime.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS rtc_runtime_create(PRtcRuntimeConfiguration pRtcRuntimeConfiguration, PRtcRuntime* ppRtcRuntime)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRuntime pKvsRuntime = NULL;
+    UINT32 i, stackSize, maxTimerCount;
+
+    CHK(pRtcRuntimeConfiguration != NULL && ppRtcRuntime != NULL, STATUS_NULL_ARG);
+    CHK(pRtcRuntimeConfiguration->workerCount > 0 && pRtcRuntimeConfiguration->workerCount <= MAX_RTC_RUNTIME_WORKER_COUNT, STATUS_INVALID_ARG);
+    for (i = 0; pRtcRuntimeConfiguration->pinWorkers && i < pRtcRuntimeConfiguration->workerCount; i++) {
+        CHK(pRtcRuntimeConfiguration->workerCpus[i] <= (UINT32) MAX_INT32, STATUS_INVALID_ARG);
+    }
+
+    stackSize = pRtcRuntimeConfiguration->workerStackSize == 0 ? PEER_TIMER_SIZE : pRtcRuntimeConfiguration->workerStackSize;
+    maxTimerCount = pRtcRuntimeConfiguration->maxTimerCountPerWorker == 0 ? PEER_TIMER_COUNT : pRtcRuntimeConfiguration->maxTimerCountPerWorker;
+
+    pKvsRuntime = (PKvsRuntime) MEMCALLOC(1, SIZEOF(KvsRuntime));
+    CHK(pKvsRuntime != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    for (i = 0; i < MAX_RTC_RUNTIME_WORKER_COUNT; i++) {
+        pKvsRuntime->workers[i] = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    }
+
+    for (i = 0; i < pRtcRuntimeConfiguration->workerCount; i++) {
+        pKvsRuntime->workerCpus[i] = pRtcRuntimeConfiguration->pinWorkers ? (INT32) pRtcRuntimeConfiguration->workerCpus[i] : THREAD_ANY_CPU;
+        CHK_STATUS(timer_queue_createOnCpu(&pKvsRuntime->workers[i], RTC_RUNTIME_THREAD_NAME, stackSize, maxTimerCount, pKvsRuntime->workerCpus[i]));
+        pKvsRuntime->workerCount++;
+    }
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        rtc_runtime_free((PRtcRuntime*) &pKvsRuntime);
+    }
+    if (ppRtcRuntime != NULL) {
+        *ppRtcRuntime = (PRtcRuntime) pKvsRuntime;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtc_runtime_free(PRtcRuntime* ppRtcRuntime)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRuntime pKvsRuntime = NULL;
+    UINT32 i;
+
+    CHK(ppRtcRuntime != NULL, STATUS_NULL_ARG);
+    pKvsRuntime = (PKvsRuntime) *ppRtcRuntime;
+    CHK(pKvsRuntime != NULL, retStatus);
+
+    // a worker which peer connections are still attached to stops with the last of them
+    for (i = 0; i < pKvsRuntime->workerCount; i++) {
+        timer_queue_free(&pKvsRuntime->workers[i]);
+    }
+    SAFE_MEMFREE(*ppRtcRuntime);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtc_runtime_attach(PRtcRuntime pRtcRuntime, PTIMER_QUEUE_HANDLE pTimerQueueHandle, PINT32 pCpu)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRuntime pKvsRuntime = (PKvsRuntime) pRtcRuntime;
+    UINT32 index;
+
+    CHK(pKvsRuntime != NULL && pTimerQueueHandle != NULL && pCpu != NULL, STATUS_NULL_ARG);
+
+    index = (UINT32)(ATOMIC_INCREMENT(&pKvsRuntime->nextWorker) % pKvsRuntime->workerCount);
+    CHK_STATUS(timer_queue_attachWithReserve(pKvsRuntime->workers[index], PEER_TIMER_COUNT_PER_PEER, pTimerQueueHandle));
+    *pCpu = pKvsRuntime->workerCpus[index];
+
+CleanUp:
+    return retStatus;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_RUNTIME__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_RUNTIME__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/webrtc_client.h"
+#include "kvs/platform_utils.h"
+#include "timer_queue.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+typedef struct {
+    RtcRuntime runtime;
+
+    UINT32 workerCount;
+    // the worker the next peer connection is given
+    volatile SIZE_T nextWorker;
+    // the peer connections attach their timer queues to these
+    TIMER_QUEUE_HANDLE workers[MAX_RTC_RUNTIME_WORKER_COUNT];
+    // THREAD_ANY_CPU when the workers are not pinned
+    INT32 workerCpus[MAX_RTC_RUNTIME_WORKER_COUNT];
+} KvsRuntime, *PKvsRuntime;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief give a peer connection the next worker of the runtime, its timers run on that worker.
+ *
+ * @param[in] pRtcRuntime the runtime.
+ * @param[out] pTimerQueueHandle the timer queue of the peer connection, attached to the worker.
+ * @param[out] pCpu the cpu of the worker, THREAD_ANY_CPU when it is not pinned.
+ *
+ * @return STATUS_MAX_TIMER_COUNT_REACHED when the worker cannot set PEER_TIMER_COUNT_PER_PEER more timers aside.
+ */
+STATUS rtc_runtime_attach(PRtcRuntime, PTIMER_QUEUE_HANDLE, PINT32);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_RUNTIME__ */
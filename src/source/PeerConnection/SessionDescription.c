@@ -263,13 +263,52 @@ CleanUp:
     return retStatus;
 }
 
-STATUS sdp_setTransceiverPayloadTypes(PHashTable codecTable, PHashTable rtxTable, PDoubleList pTransceivers)
+/**
+ * @brief the bytes of DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS of a kind of media at its highest expected bit rate.
+ */
+static UINT64 sdp_getPacketHistoryBytes(MEDIA_STREAM_TRACK_KIND kind)
+{
+    return (UINT64) DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS *
+        (kind == MEDIA_STREAM_TRACK_KIND_AUDIO ? HIGHEST_EXPECTED_AUDIO_BIT_RATE : HIGHEST_EXPECTED_BIT_RATE) / 8;
+}
+
+/**
+ * @brief create the packet history of a sender. The histories of the peer connection take totalBytes together, they are
+ *        scaled down alike when that is more than maxPeerBytes.
+ */
+static STATUS sdp_createPacketHistory(MEDIA_STREAM_TRACK_KIND kind, UINT64 totalBytes, UINT32 maxPeerBytes, PRtpHistory* ppRtpHistory)
+{
+    UINT64 slabSize = sdp_getPacketHistoryBytes(kind);
+    UINT32 entryCount = kind == MEDIA_STREAM_TRACK_KIND_AUDIO
+        ? DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS * HIGHEST_EXPECTED_AUDIO_PACKET_RATE
+        : DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS * HIGHEST_EXPECTED_BIT_RATE / 8 / DEFAULT_MTU_SIZE;
+
+    if (totalBytes > maxPeerBytes) {
+        slabSize = MAX(slabSize * maxPeerBytes / totalBytes, DEFAULT_RETRANSMIT_PACKET_BUFFER_SIZE);
+    }
+
+    return rtp_history_create(entryCount, (UINT32) slabSize, RTP_HISTORY_DEFAULT_MAX_AGE_MSEC, ppRtpHistory);
+}
+
+STATUS sdp_setTransceiverPayloadTypes(PHashTable codecTable, PHashTable rtxTable, PDoubleList pTransceivers, UINT32 maxHistoryBytes)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PDoubleListNode pCurNode = NULL;
     PKvsRtpTransceiver pKvsRtpTransceiver;
-    UINT64 data;
+    UINT64 data, totalHistoryBytes = 0;
+    UINT32 i;
+
+    // every encoding of a sender gets a packet history
+    CHK_STATUS(double_list_getHeadNode(pTransceivers, &pCurNode));
+    while (pCurNode != NULL) {
+        CHK_STATUS(double_list_getNodeData(pCurNode, &data));
+        pCurNode = pCurNode->pNext;
+        pKvsRtpTransceiver = (PKvsRtpTransceiver) data;
+        if (pKvsRtpTransceiver != NULL) {
+            totalHistoryBytes += sdp_getPacketHistoryBytes(pKvsRtpTransceiver->sender.track.kind) * MAX(pKvsRtpTransceiver->sender.encodingCount, 1);
+        }
+    }
 
     // Loop over Transceivers and set the payloadType (which what we got from the other side)
     // If a codec we want to send wasn't supported by the other return an error
@@ -292,9 +331,17 @@ STATUS sdp_setTransceiverPayloadTypes(PHashTable codecTable, PHashTable rtxTable
             }
         }
 
-        CHK_STATUS(rtp_rolling_buffer_create(DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS * HIGHEST_EXPECTED_BIT_RATE / 8 / DEFAULT_MTU_SIZE,
-                                             &pKvsRtpTransceiver->sender.packetBuffer));
-        CHK_STATUS(retransmitter_create(DEFAULT_SEQ_NUM_BUFFER_SIZE, DEFAULT_VALID_INDEX_BUFFER_SIZE, &pKvsRtpTransceiver->sender.retransmitter));
+        CHK_STATUS(sdp_createPacketHistory(pKvsRtpTransceiver->sender.track.kind, totalHistoryBytes, maxHistoryBytes,
+                                           &pKvsRtpTransceiver->sender.packetBuffer));
+        CHK_STATUS(
+            retransmitter_create(DEFAULT_SEQ_NUM_BUFFER_SIZE, DEFAULT_RETRANSMIT_PACKET_BUFFER_SIZE, &pKvsRtpTransceiver->sender.retransmitter));
+        // encoding 0 shares the packet history of the sender
+        for (i = 1; i < pKvsRtpTransceiver->sender.encodingCount; i++) {
+            if (pKvsRtpTransceiver->sender.encodings[i].packetBuffer == NULL) {
+                CHK_STATUS(sdp_createPacketHistory(pKvsRtpTransceiver->sender.track.kind, totalHistoryBytes, maxHistoryBytes,
+                                                   &pKvsRtpTransceiver->sender.encodings[i].packetBuffer));
+            }
+        }
     }
 
 CleanUp:
@@ -327,6 +374,230 @@ PCHAR sdp_fmtpForPayloadType(UINT64 payloadType, PSessionDescription pSessionDes
 }
 
 // Populate a single media section from a PKvsRtpTransceiver
+// https://tools.ietf.org/html/rfc8853#section-5.1
+// a=extmap:1 urn:ietf:params:rtp-hdrext:sdes:mid
+// a=extmap:2 urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id
+// a=extmap:3 urn:ietf:params:rtp-hdrext:sdes:repaired-rtp-stream-id
+// a=rid:h send
+// a=rid:l send
+// a=simulcast:send h;l
+STATUS sdp_populateSimulcastAttributes(PKvsRtpTransceiver pKvsRtpTransceiver, PSdpMediaDescription pSdpMediaDescription, PUINT32 pAttributeCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtcRtpSender pRtcRtpSender = NULL;
+    UINT32 i, listed, attributeCount, sizeRemaining;
+    PCHAR curr = NULL;
+    BOOL isOffer;
+
+    CHK(pKvsRtpTransceiver != NULL && pSdpMediaDescription != NULL && pAttributeCount != NULL, STATUS_NULL_ARG);
+    pRtcRtpSender = &pKvsRtpTransceiver->sender;
+    attributeCount = *pAttributeCount;
+    CHK(attributeCount + 4 + pRtcRtpSender->encodingCount <= MAX_SDP_ATTRIBUTES_COUNT, STATUS_BUFFER_TOO_SMALL);
+
+    if (pRtcRtpSender->midExtensionId != 0) {
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "extmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u " RTP_HEADER_EXTENSION_MID_URI,
+                 pRtcRtpSender->midExtensionId);
+        attributeCount++;
+    }
+
+    STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "extmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+    SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u " RTP_HEADER_EXTENSION_RID_URI,
+             pRtcRtpSender->ridExtensionId);
+    attributeCount++;
+
+    if (pRtcRtpSender->rridExtensionId != 0) {
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "extmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH,
+                 "%u " RTP_HEADER_EXTENSION_RRID_URI, pRtcRtpSender->rridExtensionId);
+        attributeCount++;
+    }
+
+    // an offer lists every encoding, an answer only those the offer accepted
+    isOffer = pKvsRtpTransceiver->pKvsPeerConnection == NULL || pKvsRtpTransceiver->pKvsPeerConnection->isOffer;
+    for (i = 0; i < pRtcRtpSender->encodingCount; i++) {
+        if (!isOffer && !pRtcRtpSender->encodings[i].accepted) {
+            continue;
+        }
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rid", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%s send",
+                 pRtcRtpSender->encodings[i].rid);
+        attributeCount++;
+    }
+
+    STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "simulcast", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+    curr = pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue;
+    curr += SNPRINTF(curr, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "send ");
+    for (i = 0, listed = 0; i < pRtcRtpSender->encodingCount; i++) {
+        if (!isOffer && !pRtcRtpSender->encodings[i].accepted) {
+            continue;
+        }
+        sizeRemaining = MAX_SDP_ATTRIBUTE_VALUE_LENGTH - (curr - pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue);
+        curr += SNPRINTF(curr, sizeRemaining, listed++ == 0 ? "%s" : ";%s", pRtcRtpSender->encodings[i].rid);
+    }
+    attributeCount++;
+
+    *pAttributeCount = attributeCount;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * @brief mark the encodings whose rid is in the recv list of a remote a=simulcast, the list our sender may send.
+ *        https://tools.ietf.org/html/rfc8853#section-5.1 a=simulcast:send 1;2,3 recv 4;~5
+ *        Streams are separated by ';', their alternatives by ',' and a paused rid starts with '~', it is not sent.
+ *
+ * @return UINT32 number of encodings the remote accepted so far
+ */
+static UINT32 sdp_acceptSimulcastRids(PRtcRtpSender pRtcRtpSender, PCHAR pSimulcast)
+{
+    PCHAR curr = pSimulcast, end, ridEnd;
+    UINT32 i, length, acceptedCount = 0;
+    BOOL expectDirection = TRUE, recv = FALSE;
+
+    while (*curr != '\0') {
+        while (*curr == ' ') {
+            curr++;
+        }
+        for (end = curr; *end != '\0' && *end != ' '; end++) {
+        }
+        length = (UINT32)(end - curr);
+        if (length == 0) {
+            break;
+        }
+
+        if (expectDirection) {
+            recv = length == 4 && STRNCMP(curr, "recv", 4) == 0;
+        } else if (recv) {
+            // drafts before rfc8853 prefixed the list with rid=
+            if (length > 4 && STRNCMP(curr, "rid=", 4) == 0) {
+                curr += 4;
+            }
+            while (curr < end) {
+                for (ridEnd = curr; ridEnd < end && *ridEnd != ';' && *ridEnd != ','; ridEnd++) {
+                }
+                length = (UINT32)(ridEnd - curr);
+                if (length > 0 && *curr != '~') {
+                    for (i = 0; i < pRtcRtpSender->encodingCount; i++) {
+                        if (!pRtcRtpSender->encodings[i].accepted && STRLEN(pRtcRtpSender->encodings[i].rid) == length &&
+                            STRNCMP(pRtcRtpSender->encodings[i].rid, curr, length) == 0) {
+                            pRtcRtpSender->encodings[i].accepted = TRUE;
+                            acceptedCount++;
+                        }
+                    }
+                }
+                curr = ridEnd < end ? ridEnd + 1 : end;
+            }
+        }
+        expectDirection = !expectDirection;
+        curr = end;
+    }
+
+    return acceptedCount;
+}
+
+STATUS sdp_latchSimulcastParameters(PKvsRtpTransceiver pKvsRtpTransceiver, PSdpMediaDescription pRemoteMediaDescription)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtcRtpSender pRtcRtpSender = NULL;
+    PCHAR attributeValue, end, uri;
+    UINT32 i, extensionId, acceptedCount = 0;
+    UINT8 midExtensionId = 0, ridExtensionId = 0, rridExtensionId = 0;
+
+    CHK(pKvsRtpTransceiver != NULL && pRemoteMediaDescription != NULL, STATUS_NULL_ARG);
+    pRtcRtpSender = &pKvsRtpTransceiver->sender;
+    for (i = 0; i < pRtcRtpSender->encodingCount; i++) {
+        pRtcRtpSender->encodings[i].accepted = FALSE;
+    }
+
+    for (i = 0; i < pRemoteMediaDescription->mediaAttributesCount; i++) {
+        attributeValue = pRemoteMediaDescription->sdpAttributes[i].attributeValue;
+        if (STRCMP(pRemoteMediaDescription->sdpAttributes[i].attributeName, "simulcast") == 0) {
+            acceptedCount += sdp_acceptSimulcastRids(pRtcRtpSender, attributeValue);
+        } else if (STRCMP(pRemoteMediaDescription->sdpAttributes[i].attributeName, "extmap") == 0) {
+            // a=extmap:<value>["/"<direction>] <URI> <extensionattributes>
+            if ((uri = STRCHR(attributeValue, ' ')) == NULL) {
+                continue;
+            }
+            if ((end = STRCHR(attributeValue, '/')) == NULL || end > uri) {
+                end = uri;
+            }
+            if (STATUS_FAILED(STRTOUI32(attributeValue, end, 10, &extensionId)) || extensionId < RTP_ONE_BYTE_EXTENSION_MIN_ID ||
+                extensionId > RTP_ONE_BYTE_EXTENSION_MAX_ID) {
+                continue;
+            }
+            uri++;
+            if (STRNCMP(uri, RTP_HEADER_EXTENSION_MID_URI, ARRAY_SIZE(RTP_HEADER_EXTENSION_MID_URI) - 1) == 0) {
+                midExtensionId = (UINT8) extensionId;
+            } else if (STRNCMP(uri, RTP_HEADER_EXTENSION_RID_URI, ARRAY_SIZE(RTP_HEADER_EXTENSION_RID_URI) - 1) == 0) {
+                ridExtensionId = (UINT8) extensionId;
+            } else if (STRNCMP(uri, RTP_HEADER_EXTENSION_RRID_URI, ARRAY_SIZE(RTP_HEADER_EXTENSION_RRID_URI) - 1) == 0) {
+                rridExtensionId = (UINT8) extensionId;
+            }
+        }
+    }
+
+    // the remote can only tell the encodings apart if it receives at least one of them and accepted the rid header extension
+    pRtcRtpSender->simulcastNegotiated = acceptedCount > 0 && ridExtensionId != 0;
+    if (pRtcRtpSender->simulcastNegotiated) {
+        pRtcRtpSender->midExtensionId = midExtensionId;
+        pRtcRtpSender->ridExtensionId = ridExtensionId;
+        pRtcRtpSender->rridExtensionId = rridExtensionId;
+    }
+    DLOGD("Simulcast %s for mid %s: %u of %u encodings, mid ext %u rid ext %u rrid ext %u",
+          pRtcRtpSender->simulcastNegotiated ? "negotiated" : "rejected", pRtcRtpSender->mid, acceptedCount, pRtcRtpSender->encodingCount,
+          midExtensionId, ridExtensionId, rridExtensionId);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS sdp_setSimulcastParameters(PSessionDescription pRemoteSessionDescription, PDoubleList pTransceivers)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PSdpMediaDescription pMediaDescription = NULL;
+    PDoubleListNode pCurNode = NULL;
+    PKvsRtpTransceiver pKvsRtpTransceiver;
+    UINT64 data;
+    UINT32 currentMedia, currentAttribute;
+    BOOL found;
+
+    CHK(pRemoteSessionDescription != NULL && pTransceivers != NULL, STATUS_NULL_ARG);
+
+    // the answer is matched to our offer by the mid we offered for each transceiver
+    CHK_STATUS(double_list_getHeadNode(pTransceivers, &pCurNode));
+    while (pCurNode != NULL) {
+        CHK_STATUS(double_list_getNodeData(pCurNode, &data));
+        pCurNode = pCurNode->pNext;
+        pKvsRtpTransceiver = (PKvsRtpTransceiver) data;
+        if (pKvsRtpTransceiver == NULL || pKvsRtpTransceiver->sender.encodingCount == 0 || pKvsRtpTransceiver->sender.mid[0] == '\0') {
+            continue;
+        }
+
+        found = FALSE;
+        for (currentMedia = 0; currentMedia < pRemoteSessionDescription->mediaCount && !found; currentMedia++) {
+            pMediaDescription = &(pRemoteSessionDescription->mediaDescriptions[currentMedia]);
+            for (currentAttribute = 0; currentAttribute < pMediaDescription->mediaAttributesCount && !found; currentAttribute++) {
+                found = STRCMP(pMediaDescription->sdpAttributes[currentAttribute].attributeName, "mid") == 0 &&
+                    STRCMP(pMediaDescription->sdpAttributes[currentAttribute].attributeValue, pKvsRtpTransceiver->sender.mid) == 0;
+            }
+        }
+
+        if (found) {
+            CHK_STATUS(sdp_latchSimulcastParameters(pKvsRtpTransceiver, pMediaDescription));
+        } else {
+            pKvsRtpTransceiver->sender.simulcastNegotiated = FALSE;
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
 STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKvsRtpTransceiver pKvsRtpTransceiver,
                                       PSdpMediaDescription pSdpMediaDescription, PSessionDescription pRemoteSessionDescription,
                                       PCHAR pCertificateFingerprint, UINT32 mediaSectionId, PCHAR pDtlsRole)
@@ -460,6 +731,8 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
     STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "mid", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
     SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%d", mediaSectionId);
     attributeCount++;
+    // the mid is also sent in the MID header extension of simulcast encodings
+    SNPRINTF(pKvsRtpTransceiver->sender.mid, ARRAY_SIZE(pKvsRtpTransceiver->sender.mid), "%d", mediaSectionId);
     // setup the direction of offer.
     if (pKvsPeerConnection->isOffer) {
         switch (pKvsRtpTransceiver->transceiver.direction) {
@@ -580,6 +853,23 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
     SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%" PRId64 " nack", payloadType);
     attributeCount++;
 
+    if (pRtcMediaStreamTrack->kind == MEDIA_STREAM_TRACK_KIND_VIDEO) {
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtcp-fb", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%" PRId64 " nack pli",
+                 payloadType);
+        attributeCount++;
+    }
+
+    // simulcast is offered whenever encodings are configured, the answer only keeps it when the offer had it
+    if (pKvsRtpTransceiver->sender.encodingCount > 0) {
+        if (!pKvsPeerConnection->isOffer) {
+            CHK_STATUS(sdp_latchSimulcastParameters(pKvsRtpTransceiver, &pRemoteSessionDescription->mediaDescriptions[mediaSectionId]));
+        }
+        if (pKvsPeerConnection->isOffer || pKvsRtpTransceiver->sender.simulcastNegotiated) {
+            CHK_STATUS(sdp_populateSimulcastAttributes(pKvsRtpTransceiver, pSdpMediaDescription, &attributeCount));
+        }
+    }
+
     pSdpMediaDescription->mediaAttributesCount = attributeCount;
 
 CleanUp:
@@ -950,17 +1240,37 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * @brief whether a media section offers an rtcp feedback type for any of its payload types, e.g. "nack pli" for
+ *        a=rtcp-fb:96 nack pli
+ */
+static BOOL sdp_hasRtcpFeedback(PSdpMediaDescription pMediaDescription, PCHAR pFeedback)
+{
+    UINT32 currentAttribute;
+    PCHAR pValue;
+
+    for (currentAttribute = 0; currentAttribute < pMediaDescription->mediaAttributesCount; currentAttribute++) {
+        pValue = pMediaDescription->sdpAttributes[currentAttribute].attributeValue;
+        if (STRCMP(pMediaDescription->sdpAttributes[currentAttribute].attributeName, "rtcp-fb") == 0 && (pValue = STRCHR(pValue, ' ')) != NULL &&
+            STRCMP(pValue + 1, pFeedback) == 0) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 STATUS sdp_setReceiversSsrc(PSessionDescription pRemoteSessionDescription, PDoubleList pTransceivers)
 {
     STATUS retStatus = STATUS_SUCCESS;
     PSdpMediaDescription pMediaDescription = NULL;
     BOOL foundSsrc, isVideoMediaSection, isAudioMediaSection, isAudioCodec, isVideoCodec;
-    UINT32 currentAttribute, currentMedia, ssrc;
+    UINT32 currentAttribute, currentMedia, ssrc, rtxSsrc, groupSsrc;
     UINT64 data;
     PDoubleListNode pCurNode = NULL;
     PKvsRtpTransceiver pKvsRtpTransceiver;
     RTC_CODEC codec;
-    PCHAR end = NULL;
+    PCHAR end = NULL, pValue;
 
     for (currentMedia = 0; currentMedia < pRemoteSessionDescription->mediaCount; currentMedia++) {
         pMediaDescription = &(pRemoteSessionDescription->mediaDescriptions[currentMedia]);
@@ -969,6 +1279,7 @@ STATUS sdp_setReceiversSsrc(PSessionDescription pRemoteSessionDescription, PDoub
         isAudioMediaSection = (STRNCMP(pMediaDescription->mediaName, MEDIA_SECTION_AUDIO_VALUE, ARRAY_SIZE(MEDIA_SECTION_AUDIO_VALUE) - 1) == 0);
         foundSsrc = FALSE;
         ssrc = 0;
+        rtxSsrc = 0;
 
         if (isVideoMediaSection || isAudioMediaSection) {
             for (currentAttribute = 0; currentAttribute < pMediaDescription->mediaAttributesCount && !foundSsrc; currentAttribute++) {
@@ -981,6 +1292,16 @@ STATUS sdp_setReceiversSsrc(PSessionDescription pRemoteSessionDescription, PDoub
                 }
             }
 
+            // a=ssrc-group:FID <media ssrc> <rtx ssrc>
+            for (currentAttribute = 0; currentAttribute < pMediaDescription->mediaAttributesCount && foundSsrc && rtxSsrc == 0; currentAttribute++) {
+                pValue = pMediaDescription->sdpAttributes[currentAttribute].attributeValue;
+                if (STRCMP(pMediaDescription->sdpAttributes[currentAttribute].attributeName, "ssrc-group") == 0 &&
+                    STRNCMP(pValue, "FID ", 4) == 0 && (end = STRCHR(pValue + 4, ' ')) != NULL &&
+                    STATUS_SUCCEEDED(STRTOUI32(pValue + 4, end, 10, &groupSsrc)) && groupSsrc == ssrc) {
+                    CHK_STATUS(STRTOUI32(end + 1, NULL, 10, &rtxSsrc));
+                }
+            }
+
             if (foundSsrc) {
                 CHK_STATUS(double_list_getHeadNode(pTransceivers, &pCurNode));
                 while (pCurNode != NULL) {
@@ -994,6 +1315,10 @@ STATUS sdp_setReceiversSsrc(PSessionDescription pRemoteSessionDescription, PDoub
                         ((isVideoCodec && isVideoMediaSection) || (isAudioCodec && isAudioMediaSection))) {
                         // Finish iteration, we assigned the ssrc move on to next media section
                         pKvsRtpTransceiver->jitterBufferSsrc = ssrc;
+                        pKvsRtpTransceiver->jitterBufferRtxSsrc = rtxSsrc;
+                        // PLI is understood by every sender we know of, FIR only when nothing else is offered
+                        pKvsRtpTransceiver->keyFrameRequestState.useFir =
+                            !sdp_hasRtcpFeedback(pMediaDescription, "nack pli") && sdp_hasRtcpFeedback(pMediaDescription, "ccm fir");
                         pKvsRtpTransceiver->inboundStats.received.rtpStream.ssrc = ssrc;
                         STRNCPY(pKvsRtpTransceiver->inboundStats.received.rtpStream.kind,
                                 pKvsRtpTransceiver->transceiver.receiver.track.kind == MEDIA_STREAM_TRACK_KIND_VIDEO ? "video" : "audio",
@@ -14,6 +14,7 @@ extern "C" {
 #include "double_linked_list.h"
 #include "Sdp.h"
 #include "PeerConnection.h"
+#include "Rtp.h"
 
 #define SESSION_DESCRIPTION_INIT_LINE_ENDING            "\\r\\n"
 #define SESSION_DESCRIPTION_INIT_LINE_ENDING_WITHOUT_CR "\\n"
@@ -76,10 +77,50 @@ extern "C" {
 STATUS sdp_setPayloadTypesFromOffer(PHashTable, PHashTable, PSessionDescription);
 STATUS sdp_setPayloadTypesForOffer(PHashTable);
 
-STATUS sdp_setTransceiverPayloadTypes(PHashTable, PHashTable, PDoubleList);
+/**
+ * @brief set the payload types of the senders and create their packet histories and retransmitters.
+ *
+ * @param[in] codecTable the codec table of transimission.
+ * @param[in] rtxTable the codec table of retransmission.
+ * @param[in] pTransceivers the transceivers.
+ * @param[in] maxHistoryBytes the most bytes the packet histories of the transceivers take together.
+ *
+ * @return STATUS status of execution
+ */
+STATUS sdp_setTransceiverPayloadTypes(PHashTable, PHashTable, PDoubleList, UINT32);
 STATUS sdp_populateSessionDescription(PKvsPeerConnection, PSessionDescription, PSessionDescription);
 STATUS sdp_reorderTransceiverByRemoteDescription(PKvsPeerConnection, PSessionDescription);
 STATUS sdp_setReceiversSsrc(PSessionDescription, PDoubleList);
+/**
+ * @brief add the extmap, rid and simulcast attributes of the send encodings to a media section.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver with send encodings.
+ * @param[in] pSdpMediaDescription the local media section.
+ * @param[in, out] pAttributeCount the number of attributes in the media section.
+ *
+ * @return STATUS status of execution
+ */
+STATUS sdp_populateSimulcastAttributes(PKvsRtpTransceiver, PSdpMediaDescription, PUINT32);
+/**
+ * @brief latch whether the remote media section accepted simulcast, the encodings whose rid it receives and the
+ *        header extension ids it uses. Simulcast is only negotiated when the recv list of its a=simulcast names at
+ *        least one of our rids, the other encodings are not sent.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver with send encodings.
+ * @param[in] pRemoteMediaDescription the remote media section of the transceiver.
+ *
+ * @return STATUS status of execution
+ */
+STATUS sdp_latchSimulcastParameters(PKvsRtpTransceiver, PSdpMediaDescription);
+/**
+ * @brief latch the simulcast parameters of an answer, matching the media sections by the offered mid.
+ *
+ * @param[in] pRemoteSessionDescription the sdp of the answer.
+ * @param[in] pTransceivers the transceivers of the peer connection.
+ *
+ * @return STATUS status of execution
+ */
+STATUS sdp_setSimulcastParameters(PSessionDescription, PDoubleList);
 PCHAR sdp_fmtpForPayloadType(UINT64, PSessionDescription);
 
 #ifdef __cplusplus
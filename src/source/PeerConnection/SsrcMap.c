@@ -0,0 +1,222 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "SsrcMap"
+
+#include "SsrcMap.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+/**
+ * @brief the first slot of the probe sequence of the ssrc. A remote peer picks its ssrcs, so they are mixed before the
+ *        low bits are taken.
+ */
+#define SSRC_MAP_HASH(ssrc)                (((UINT32)(ssrc)) * 2654435761U)
+#define SSRC_MAP_HOME_SLOT(ssrc, capacity) ((SSRC_MAP_HASH(ssrc) ^ (SSRC_MAP_HASH(ssrc) >> 16)) & ((capacity) - 1))
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS ssrc_map_create(UINT32 capacity, PSsrcMap* ppSsrcMap)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PSsrcMap pSsrcMap = NULL;
+    UINT32 roundedCapacity = 1;
+
+    CHK(ppSsrcMap != NULL, STATUS_NULL_ARG);
+    CHK(capacity > 0 && capacity <= MAX_UINT32 / 2, STATUS_INVALID_ARG);
+
+    while (roundedCapacity < capacity) {
+        roundedCapacity <<= 1;
+    }
+
+    pSsrcMap = (PSsrcMap) MEMCALLOC(1, SIZEOF(SsrcMap));
+    CHK(pSsrcMap != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pSsrcMap->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pSsrcMap->lock), STATUS_INVALID_OPERATION);
+    pSsrcMap->entries = (PSsrcMapEntry) MEMCALLOC(roundedCapacity, SIZEOF(SsrcMapEntry));
+    CHK(pSsrcMap->entries != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pSsrcMap->capacity = roundedCapacity;
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        ssrc_map_free(&pSsrcMap);
+    }
+    if (ppSsrcMap != NULL) {
+        *ppSsrcMap = pSsrcMap;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS ssrc_map_free(PSsrcMap* ppSsrcMap)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(ppSsrcMap != NULL, STATUS_NULL_ARG);
+    CHK(*ppSsrcMap != NULL, retStatus);
+
+    if (IS_VALID_MUTEX_VALUE((*ppSsrcMap)->lock)) {
+        MUTEX_FREE((*ppSsrcMap)->lock);
+    }
+    SAFE_MEMFREE((*ppSsrcMap)->entries);
+    SAFE_MEMFREE(*ppSsrcMap);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * @brief the slot of the ssrc, or the free slot which ends its probe sequence. The table always has a free slot.
+ */
+static UINT32 ssrc_map_findSlot(PSsrcMapEntry entries, UINT32 capacity, UINT32 ssrc)
+{
+    UINT32 slot = SSRC_MAP_HOME_SLOT(ssrc, capacity);
+
+    while (entries[slot].used && entries[slot].ssrc != ssrc) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return slot;
+}
+
+static STATUS ssrc_map_grow(PSsrcMap pSsrcMap)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PSsrcMapEntry entries = NULL;
+    UINT32 i, capacity = pSsrcMap->capacity << 1;
+
+    CHK(capacity > pSsrcMap->capacity, STATUS_NOT_ENOUGH_MEMORY);
+    entries = (PSsrcMapEntry) MEMCALLOC(capacity, SIZEOF(SsrcMapEntry));
+    CHK(entries != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    for (i = 0; i < pSsrcMap->capacity; i++) {
+        if (pSsrcMap->entries[i].used) {
+            entries[ssrc_map_findSlot(entries, capacity, pSsrcMap->entries[i].ssrc)] = pSsrcMap->entries[i];
+        }
+    }
+    SAFE_MEMFREE(pSsrcMap->entries);
+    pSsrcMap->entries = entries;
+    pSsrcMap->capacity = capacity;
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS ssrc_map_put(PSsrcMap pSsrcMap, UINT32 ssrc, UINT64 value)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PSsrcMapEntry pEntry = NULL;
+    BOOL locked = FALSE;
+
+    CHK(pSsrcMap != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pSsrcMap->lock);
+    locked = TRUE;
+
+    pEntry = &pSsrcMap->entries[ssrc_map_findSlot(pSsrcMap->entries, pSsrcMap->capacity, ssrc)];
+    if (!pEntry->used) {
+        if ((pSsrcMap->count + 1) > (pSsrcMap->capacity >> SSRC_MAP_MAX_LOAD_SHIFT)) {
+            CHK_STATUS(ssrc_map_grow(pSsrcMap));
+            pEntry = &pSsrcMap->entries[ssrc_map_findSlot(pSsrcMap->entries, pSsrcMap->capacity, ssrc)];
+        }
+        pEntry->used = TRUE;
+        pEntry->ssrc = ssrc;
+        pSsrcMap->count++;
+    }
+    pEntry->value = value;
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pSsrcMap->lock);
+    }
+    return retStatus;
+}
+
+STATUS ssrc_map_get(PSsrcMap pSsrcMap, UINT32 ssrc, PUINT64 pValue)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PSsrcMapEntry pEntry = NULL;
+    BOOL locked = FALSE;
+
+    CHK(pSsrcMap != NULL && pValue != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pSsrcMap->lock);
+    locked = TRUE;
+
+    pEntry = &pSsrcMap->entries[ssrc_map_findSlot(pSsrcMap->entries, pSsrcMap->capacity, ssrc)];
+    CHK(pEntry->used, STATUS_NOT_FOUND);
+    *pValue = pEntry->value;
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pSsrcMap->lock);
+    }
+    return retStatus;
+}
+
+/**
+ * @brief remove the entry of the ssrc if it is mapped to the value, or whatever it is mapped to when anyValue is set.
+ */
+static STATUS ssrc_map_removeEntry(PSsrcMap pSsrcMap, UINT32 ssrc, BOOL anyValue, UINT64 value)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 freeSlot, slot, homeSlot, mask;
+    BOOL locked = FALSE;
+
+    CHK(pSsrcMap != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pSsrcMap->lock);
+    locked = TRUE;
+
+    mask = pSsrcMap->capacity - 1;
+    freeSlot = ssrc_map_findSlot(pSsrcMap->entries, pSsrcMap->capacity, ssrc);
+    CHK(pSsrcMap->entries[freeSlot].used && (anyValue || pSsrcMap->entries[freeSlot].value == value), STATUS_NOT_FOUND);
+    pSsrcMap->entries[freeSlot].used = FALSE;
+    pSsrcMap->count--;
+
+    // an entry after the freed slot moves into it unless its probe sequence starts between the two slots
+    for (slot = (freeSlot + 1) & mask; pSsrcMap->entries[slot].used; slot = (slot + 1) & mask) {
+        homeSlot = SSRC_MAP_HOME_SLOT(pSsrcMap->entries[slot].ssrc, pSsrcMap->capacity);
+        if (((slot - homeSlot) & mask) >= ((slot - freeSlot) & mask)) {
+            pSsrcMap->entries[freeSlot] = pSsrcMap->entries[slot];
+            pSsrcMap->entries[slot].used = FALSE;
+            freeSlot = slot;
+        }
+    }
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pSsrcMap->lock);
+    }
+    return retStatus;
+}
+
+STATUS ssrc_map_remove(PSsrcMap pSsrcMap, UINT32 ssrc)
+{
+    return ssrc_map_removeEntry(pSsrcMap, ssrc, TRUE, 0);
+}
+
+STATUS ssrc_map_removeValue(PSsrcMap pSsrcMap, UINT32 ssrc, UINT64 value)
+{
+    return ssrc_map_removeEntry(pSsrcMap, ssrc, FALSE, value);
+}
+#endif
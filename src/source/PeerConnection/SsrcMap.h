@@ -0,0 +1,105 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_SSRC_MAP__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_SSRC_MAP__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+// a media and a rtx ssrc in each direction of a couple of transceivers
+#define SSRC_MAP_DEFAULT_CAPACITY 16
+// the table doubles once more than 1 / 2 of its slots are used, so that probe sequences stay short
+#define SSRC_MAP_MAX_LOAD_SHIFT 1
+
+typedef struct {
+    BOOL used;
+    UINT32 ssrc;
+    UINT64 value;
+} SsrcMapEntry, *PSsrcMapEntry;
+
+/**
+ * Open addressing map from ssrc to a 64 bit value with linear probing. Removal shifts the following entries of the probe
+ * sequence back, so that no tombstones are left behind and a lookup stops at the first free slot.
+ */
+typedef struct __SsrcMap {
+    MUTEX lock;
+    // power of 2
+    UINT32 capacity;
+    UINT32 count;
+    PSsrcMapEntry entries;
+} SsrcMap, *PSsrcMap;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief create the map.
+ *
+ * @param[in] capacity the initial number of slots, rounded up to a power of 2.
+ * @param[out] ppSsrcMap the created map.
+ *
+ * @return STATUS status of execution
+ */
+STATUS ssrc_map_create(UINT32, PSsrcMap*);
+STATUS ssrc_map_free(PSsrcMap*);
+/**
+ * @brief map the ssrc to the value, replacing the value it had.
+ *
+ * @param[in] pSsrcMap the map.
+ * @param[in] ssrc the ssrc.
+ * @param[in] value the value.
+ *
+ * @return STATUS status of execution
+ */
+STATUS ssrc_map_put(PSsrcMap, UINT32, UINT64);
+/**
+ * @brief get the value of the ssrc.
+ *
+ * @param[in] pSsrcMap the map.
+ * @param[in] ssrc the ssrc.
+ * @param[out] pValue the value.
+ *
+ * @return STATUS_NOT_FOUND when the ssrc is not mapped.
+ */
+STATUS ssrc_map_get(PSsrcMap, UINT32, PUINT64);
+STATUS ssrc_map_remove(PSsrcMap, UINT32);
+/**
+ * @brief remove the ssrc only while it is mapped to the value, so that an owner does not take away an ssrc which was
+ *        mapped to another owner since.
+ *
+ * @param[in] pSsrcMap the map.
+ * @param[in] ssrc the ssrc.
+ * @param[in] value the value the ssrc is expected to be mapped to.
+ *
+ * @return STATUS_NOT_FOUND when the ssrc is not mapped to the value.
+ */
+STATUS ssrc_map_removeValue(PSsrcMap, UINT32, UINT64);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_SSRC_MAP__ */
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#define LOG_CLASS "RtcpBuilder"
+
+#include "RtcpBuilder.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS rtcp_builder_create(UINT32 maxPacketLength, UINT32 tailLength, PRtcpBuilder* ppRtcpBuilder)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtcpBuilder pRtcpBuilder = NULL;
+
+    CHK(ppRtcpBuilder != NULL, STATUS_RTCP_NULL_ARG);
+    CHK(maxPacketLength >= RTCP_PACKET_HEADER_LEN, STATUS_INVALID_ARG);
+
+    pRtcpBuilder = (PRtcpBuilder) MEMCALLOC(1, SIZEOF(RtcpBuilder));
+    CHK(pRtcpBuilder != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRtcpBuilder->pBuffer = (PBYTE) MEMALLOC(maxPacketLength + tailLength);
+    CHK(pRtcpBuilder->pBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRtcpBuilder->maxPacketLength = maxPacketLength;
+    pRtcpBuilder->tailLength = tailLength;
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        rtcp_builder_free(&pRtcpBuilder);
+    }
+    if (ppRtcpBuilder != NULL) {
+        *ppRtcpBuilder = pRtcpBuilder;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtcp_builder_free(PRtcpBuilder* ppRtcpBuilder)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(ppRtcpBuilder != NULL, STATUS_RTCP_NULL_ARG);
+    CHK(*ppRtcpBuilder != NULL, retStatus);
+
+    SAFE_MEMFREE((*ppRtcpBuilder)->pBuffer);
+    SAFE_MEMFREE(*ppRtcpBuilder);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtcp_builder_reset(PRtcpBuilder pRtcpBuilder)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pRtcpBuilder != NULL, STATUS_RTCP_NULL_ARG);
+    pRtcpBuilder->length = 0;
+    pRtcpBuilder->reportLength = 0;
+
+CleanUp:
+    return retStatus;
+}
+
+/**
+ * @brief make room for an item of itemLength bytes. Reports go behind the reports already added, which moves the feedback
+ *        messages back, everything else goes to the end.
+ */
+static STATUS rtcp_builder_reserve(PRtcpBuilder pRtcpBuilder, UINT32 itemLength, BOOL isReport, PBYTE* ppItem)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 offset;
+
+    CHK(pRtcpBuilder->length + itemLength <= pRtcpBuilder->maxPacketLength, STATUS_BUFFER_TOO_SMALL);
+
+    if (isReport) {
+        offset = pRtcpBuilder->reportLength;
+        MEMMOVE(pRtcpBuilder->pBuffer + offset + itemLength, pRtcpBuilder->pBuffer + offset, pRtcpBuilder->length - offset);
+        pRtcpBuilder->reportLength += itemLength;
+    } else {
+        offset = pRtcpBuilder->length;
+    }
+    pRtcpBuilder->length += itemLength;
+    *ppItem = pRtcpBuilder->pBuffer + offset;
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtcp_builder_addSenderReport(PRtcpBuilder pRtcpBuilder, UINT32 ssrc, UINT64 ntpTime, UINT32 rtpTime, UINT32 packetCount, UINT32 octetCount,
+                                    PBYTE pReportBlocks, UINT32 reportCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 itemLength = 0;
+    PBYTE pItem = NULL;
+
+    CHK(pRtcpBuilder != NULL, STATUS_RTCP_NULL_ARG);
+    CHK_STATUS(rtcp_packet_createSenderReportBytes(ssrc, ntpTime, rtpTime, packetCount, octetCount, pReportBlocks, reportCount, NULL, &itemLength));
+    CHK_STATUS(rtcp_builder_reserve(pRtcpBuilder, itemLength, TRUE, &pItem));
+    CHK_STATUS(rtcp_packet_createSenderReportBytes(ssrc, ntpTime, rtpTime, packetCount, octetCount, pReportBlocks, reportCount, pItem, &itemLength));
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtcp_builder_addReceiverReport(PRtcpBuilder pRtcpBuilder, UINT32 ssrc, PBYTE pReportBlocks, UINT32 reportCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 itemLength = 0;
+    PBYTE pItem = NULL;
+
+    CHK(pRtcpBuilder != NULL, STATUS_RTCP_NULL_ARG);
+    CHK_STATUS(rtcp_packet_createReceiverReportBytes(ssrc, pReportBlocks, reportCount, NULL, &itemLength));
+    CHK_STATUS(rtcp_builder_reserve(pRtcpBuilder, itemLength, TRUE, &pItem));
+    CHK_STATUS(rtcp_packet_createReceiverReportBytes(ssrc, pReportBlocks, reportCount, pItem, &itemLength));
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtcp_builder_addSdesCname(PRtcpBuilder pRtcpBuilder, UINT32 ssrc, PCHAR cname)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 itemLength = 0;
+    PBYTE pItem = NULL;
+
+    CHK(pRtcpBuilder != NULL, STATUS_RTCP_NULL_ARG);
+    CHK_STATUS(rtcp_packet_createSdesCnameBytes(ssrc, cname, NULL, &itemLength));
+    CHK_STATUS(rtcp_builder_reserve(pRtcpBuilder, itemLength, TRUE, &pItem));
+    CHK_STATUS(rtcp_packet_createSdesCnameBytes(ssrc, cname, pItem, &itemLength));
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtcp_builder_addNack(PRtcpBuilder pRtcpBuilder, UINT32 senderSsrc, UINT32 mediaSsrc, PUINT16 pSequenceNumberList, UINT32 sequenceNumberListLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 itemLength = 0;
+    PBYTE pItem = NULL;
+
+    CHK(pRtcpBuilder != NULL, STATUS_RTCP_NULL_ARG);
+    CHK_STATUS(rtcp_packet_createNackBytes(senderSsrc, mediaSsrc, pSequenceNumberList, sequenceNumberListLen, NULL, &itemLength));
+    CHK_STATUS(rtcp_builder_reserve(pRtcpBuilder, itemLength, FALSE, &pItem));
+    CHK_STATUS(rtcp_packet_createNackBytes(senderSsrc, mediaSsrc, pSequenceNumberList, sequenceNumberListLen, pItem, &itemLength));
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtcp_builder_addPli(PRtcpBuilder pRtcpBuilder, UINT32 senderSsrc, UINT32 mediaSsrc)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 itemLength = 0;
+    PBYTE pItem = NULL;
+
+    CHK(pRtcpBuilder != NULL, STATUS_RTCP_NULL_ARG);
+    CHK_STATUS(rtcp_packet_createPliBytes(senderSsrc, mediaSsrc, NULL, &itemLength));
+    CHK_STATUS(rtcp_builder_reserve(pRtcpBuilder, itemLength, FALSE, &pItem));
+    CHK_STATUS(rtcp_packet_createPliBytes(senderSsrc, mediaSsrc, pItem, &itemLength));
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtcp_builder_addFir(PRtcpBuilder pRtcpBuilder, UINT32 senderSsrc, UINT32 mediaSsrc, UINT8 sequenceNumber)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 itemLength = 0;
+    PBYTE pItem = NULL;
+
+    CHK(pRtcpBuilder != NULL, STATUS_RTCP_NULL_ARG);
+    CHK_STATUS(rtcp_packet_createFirBytes(senderSsrc, mediaSsrc, sequenceNumber, NULL, &itemLength));
+    CHK_STATUS(rtcp_builder_reserve(pRtcpBuilder, itemLength, FALSE, &pItem));
+    CHK_STATUS(rtcp_packet_createFirBytes(senderSsrc, mediaSsrc, sequenceNumber, pItem, &itemLength));
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtcp_builder_addRemb(PRtcpBuilder pRtcpBuilder, UINT32 senderSsrc, UINT64 bitrate, PUINT32 pSsrcList, UINT32 ssrcListLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 itemLength = 0;
+    PBYTE pItem = NULL;
+
+    CHK(pRtcpBuilder != NULL, STATUS_RTCP_NULL_ARG);
+    CHK_STATUS(rtcp_packet_createRembBytes(senderSsrc, bitrate, pSsrcList, ssrcListLen, NULL, &itemLength));
+    CHK_STATUS(rtcp_builder_reserve(pRtcpBuilder, itemLength, FALSE, &pItem));
+    CHK_STATUS(rtcp_packet_createRembBytes(senderSsrc, bitrate, pSsrcList, ssrcListLen, pItem, &itemLength));
+
+CleanUp:
+    return retStatus;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_RTCP_RTCPBUILDER_H
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_RTCP_RTCPBUILDER_H
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "RtcpPacket.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+/**
+ * A compound RTCP packet, https://tools.ietf.org/html/rfc3550#section-6.1, which is filled item by item and sent at once.
+ * Reports and source descriptions stay in front of the feedback messages whatever order they were added in. An item which
+ * does not fit into maxPacketLength any more is rejected with STATUS_BUFFER_TOO_SMALL, the packet is sent and started again
+ * by the owner. The buffer is reused from one packet to the next.
+ */
+typedef struct {
+    PBYTE pBuffer;
+    // the bound of the compound packet, the buffer has tailLength spare bytes after it for the srtp trailer
+    UINT32 maxPacketLength;
+    UINT32 tailLength;
+    UINT32 length;
+    // SR, RR and SDES take the first reportLength bytes
+    UINT32 reportLength;
+} RtcpBuilder, *PRtcpBuilder;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief create a builder.
+ *
+ * @param[in] maxPacketLength the largest compound packet.
+ * @param[in] tailLength the spare bytes after the packet, written by the encryption in place.
+ * @param[out] ppRtcpBuilder the builder.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_builder_create(UINT32, UINT32, PRtcpBuilder*);
+STATUS rtcp_builder_free(PRtcpBuilder*);
+/**
+ * @brief drop the items, after the packet was sent or could not be.
+ */
+STATUS rtcp_builder_reset(PRtcpBuilder);
+/**
+ * @brief add a sender report, the arguments are the ones of rtcp_packet_createSenderReportBytes.
+ */
+STATUS rtcp_builder_addSenderReport(PRtcpBuilder, UINT32, UINT64, UINT32, UINT32, UINT32, PBYTE, UINT32);
+/**
+ * @brief add a receiver report, the arguments are the ones of rtcp_packet_createReceiverReportBytes.
+ */
+STATUS rtcp_builder_addReceiverReport(PRtcpBuilder, UINT32, PBYTE, UINT32);
+/**
+ * @brief add the CNAME of an ssrc, the arguments are the ones of rtcp_packet_createSdesCnameBytes.
+ */
+STATUS rtcp_builder_addSdesCname(PRtcpBuilder, UINT32, PCHAR);
+/**
+ * @brief add a generic NACK, the arguments are the ones of rtcp_packet_createNackBytes.
+ */
+STATUS rtcp_builder_addNack(PRtcpBuilder, UINT32, UINT32, PUINT16, UINT32);
+/**
+ * @brief add a picture loss indication, the arguments are the ones of rtcp_packet_createPliBytes.
+ */
+STATUS rtcp_builder_addPli(PRtcpBuilder, UINT32, UINT32);
+/**
+ * @brief add a full intra request, the arguments are the ones of rtcp_packet_createFirBytes.
+ */
+STATUS rtcp_builder_addFir(PRtcpBuilder, UINT32, UINT32, UINT8);
+/**
+ * @brief add a receiver estimated maximum bitrate, the arguments are the ones of rtcp_packet_createRembBytes.
+ */
+STATUS rtcp_builder_addRemb(PRtcpBuilder, UINT32, UINT64, PUINT32, UINT32);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //__KINESIS_VIDEO_WEBRTC_CLIENT_RTCP_RTCPBUILDER_H
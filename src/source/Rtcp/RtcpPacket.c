@@ -106,6 +106,394 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * https://tools.ietf.org/html/rfc4585#section-6.2.1
+ * Every FCI entry carries one packet id (PID) and a bitmask of the 16 following lost packets (BLP), so the sequence
+ * numbers are packed into as few entries as possible when the list is sorted.
+ */
+STATUS rtcp_packet_createNackBytes(UINT32 senderSsrc, UINT32 mediaSsrc, PUINT16 pSequenceNumberList, UINT32 sequenceNumberListLen, PBYTE pRawPacket,
+                                   PUINT32 pPacketLength)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i, packetLength = 0, offset;
+    UINT16 pid, blp, distance;
+
+    CHK(pSequenceNumberList != NULL && pPacketLength != NULL, STATUS_RTCP_NULL_ARG);
+    CHK(sequenceNumberListLen > 0, STATUS_RTCP_INPUT_NACK_LIST_INVALID);
+
+    packetLength = RTCP_PACKET_HEADER_LEN + RTCP_NACK_LIST_LEN + 4;
+    pid = pSequenceNumberList[0];
+    for (i = 1; i < sequenceNumberListLen; i++) {
+        distance = (UINT16)(pSequenceNumberList[i] - pid);
+        if (distance == 0 || distance > 16) {
+            pid = pSequenceNumberList[i];
+            packetLength += 4;
+        }
+    }
+
+    // Check if we are trying to calculate the required size only
+    CHK(pRawPacket != NULL, retStatus);
+    CHK(*pPacketLength >= packetLength, STATUS_BUFFER_TOO_SMALL);
+
+    pRawPacket[0] = (RTCP_PACKET_VERSION_VAL << VERSION_SHIFT) | RTCP_FEEDBACK_MESSAGE_TYPE_NACK;
+    pRawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_GENERIC_RTP_FEEDBACK;
+    putUnalignedInt16BigEndian(pRawPacket + RTCP_PACKET_LEN_OFFSET, (packetLength / RTCP_PACKET_LEN_WORD_SIZE) - 1);
+    putUnalignedInt32BigEndian(pRawPacket + 4, senderSsrc);
+    putUnalignedInt32BigEndian(pRawPacket + 8, mediaSsrc);
+
+    offset = RTCP_PACKET_HEADER_LEN + RTCP_NACK_LIST_LEN;
+    pid = pSequenceNumberList[0];
+    blp = 0;
+    for (i = 1; i < sequenceNumberListLen; i++) {
+        distance = (UINT16)(pSequenceNumberList[i] - pid);
+        if (distance == 0 || distance > 16) {
+            putUnalignedInt16BigEndian(pRawPacket + offset, pid);
+            putUnalignedInt16BigEndian(pRawPacket + offset + 2, blp);
+            offset += 4;
+            pid = pSequenceNumberList[i];
+            blp = 0;
+        } else {
+            blp |= 1 << (distance - 1);
+        }
+    }
+    putUnalignedInt16BigEndian(pRawPacket + offset, pid);
+    putUnalignedInt16BigEndian(pRawPacket + offset + 2, blp);
+
+CleanUp:
+    if (pPacketLength != NULL) {
+        *pPacketLength = packetLength;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtcp_packet_createPliBytes(UINT32 senderSsrc, UINT32 mediaSsrc, PBYTE pRawPacket, PUINT32 pPacketLength)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 packetLength = RTCP_PACKET_HEADER_LEN + RTCP_NACK_LIST_LEN;
+
+    CHK(pPacketLength != NULL, STATUS_RTCP_NULL_ARG);
+
+    // Check if we are trying to calculate the required size only
+    CHK(pRawPacket != NULL, retStatus);
+    CHK(*pPacketLength >= packetLength, STATUS_BUFFER_TOO_SMALL);
+
+    pRawPacket[0] = (RTCP_PACKET_VERSION_VAL << VERSION_SHIFT) | RTCP_PSFB_PLI;
+    pRawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_PAYLOAD_SPECIFIC_FEEDBACK;
+    putUnalignedInt16BigEndian(pRawPacket + RTCP_PACKET_LEN_OFFSET, (packetLength / RTCP_PACKET_LEN_WORD_SIZE) - 1);
+    putUnalignedInt32BigEndian(pRawPacket + 4, senderSsrc);
+    putUnalignedInt32BigEndian(pRawPacket + 8, mediaSsrc);
+
+CleanUp:
+    if (pPacketLength != NULL) {
+        *pPacketLength = packetLength;
+    }
+
+    return retStatus;
+}
+
+STATUS rtcp_packet_createFirBytes(UINT32 senderSsrc, UINT32 mediaSsrc, UINT8 sequenceNumber, PBYTE pRawPacket, PUINT32 pPacketLength)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 packetLength = RTCP_PACKET_HEADER_LEN + RTCP_NACK_LIST_LEN + RTCP_FIR_ENTRY_LEN;
+
+    CHK(pPacketLength != NULL, STATUS_RTCP_NULL_ARG);
+
+    // Check if we are trying to calculate the required size only
+    CHK(pRawPacket != NULL, retStatus);
+    CHK(*pPacketLength >= packetLength, STATUS_BUFFER_TOO_SMALL);
+
+    pRawPacket[0] = (RTCP_PACKET_VERSION_VAL << VERSION_SHIFT) | RTCP_PSFB_FIR;
+    pRawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_PAYLOAD_SPECIFIC_FEEDBACK;
+    putUnalignedInt16BigEndian(pRawPacket + RTCP_PACKET_LEN_OFFSET, (packetLength / RTCP_PACKET_LEN_WORD_SIZE) - 1);
+    putUnalignedInt32BigEndian(pRawPacket + 4, senderSsrc);
+    // the media source field is unused, the ssrc is carried in the FCI entry
+    putUnalignedInt32BigEndian(pRawPacket + 8, 0);
+    putUnalignedInt32BigEndian(pRawPacket + 12, mediaSsrc);
+    putUnalignedInt32BigEndian(pRawPacket + 16, (UINT32) sequenceNumber << 24);
+
+CleanUp:
+    if (pPacketLength != NULL) {
+        *pPacketLength = packetLength;
+    }
+
+    return retStatus;
+}
+
+STATUS rtcp_packet_createSenderReportBytes(UINT32 ssrc, UINT64 ntpTime, UINT32 rtpTime, UINT32 packetCount, UINT32 octetCount, PBYTE pReportBlocks,
+                                           UINT32 reportCount, PBYTE pRawPacket, PUINT32 pPacketLength)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 packetLength = RTCP_PACKET_HEADER_LEN + RTCP_PACKET_SENDER_REPORT_MINLEN + reportCount * RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN;
+
+    CHK(pPacketLength != NULL && (pReportBlocks != NULL || reportCount == 0), STATUS_RTCP_NULL_ARG);
+    CHK(reportCount <= RTCP_PACKET_RRC_BITMASK, STATUS_INVALID_ARG);
+
+    // Check if we are trying to calculate the required size only
+    CHK(pRawPacket != NULL, retStatus);
+    CHK(*pPacketLength >= packetLength, STATUS_BUFFER_TOO_SMALL);
+
+    pRawPacket[0] = (RTCP_PACKET_VERSION_VAL << VERSION_SHIFT) | reportCount;
+    pRawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_SENDER_REPORT;
+    putUnalignedInt16BigEndian(pRawPacket + RTCP_PACKET_LEN_OFFSET, (packetLength / RTCP_PACKET_LEN_WORD_SIZE) - 1);
+    putUnalignedInt32BigEndian(pRawPacket + 4, ssrc);
+    putUnalignedInt64BigEndian(pRawPacket + 8, ntpTime);
+    putUnalignedInt32BigEndian(pRawPacket + 16, rtpTime);
+    putUnalignedInt32BigEndian(pRawPacket + 20, packetCount);
+    putUnalignedInt32BigEndian(pRawPacket + 24, octetCount);
+    if (reportCount > 0) {
+        MEMCPY(pRawPacket + RTCP_PACKET_HEADER_LEN + RTCP_PACKET_SENDER_REPORT_MINLEN, pReportBlocks,
+               reportCount * RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN);
+    }
+
+CleanUp:
+    if (pPacketLength != NULL) {
+        *pPacketLength = packetLength;
+    }
+
+    return retStatus;
+}
+
+STATUS rtcp_packet_createReceiverReportBytes(UINT32 ssrc, PBYTE pReportBlocks, UINT32 reportCount, PBYTE pRawPacket, PUINT32 pPacketLength)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 packetLength = RTCP_PACKET_HEADER_LEN + 4 + reportCount * RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN;
+
+    CHK(pPacketLength != NULL && (pReportBlocks != NULL || reportCount == 0), STATUS_RTCP_NULL_ARG);
+    CHK(reportCount <= RTCP_PACKET_RRC_BITMASK, STATUS_INVALID_ARG);
+
+    // Check if we are trying to calculate the required size only
+    CHK(pRawPacket != NULL, retStatus);
+    CHK(*pPacketLength >= packetLength, STATUS_BUFFER_TOO_SMALL);
+
+    pRawPacket[0] = (RTCP_PACKET_VERSION_VAL << VERSION_SHIFT) | reportCount;
+    pRawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_RECEIVER_REPORT;
+    putUnalignedInt16BigEndian(pRawPacket + RTCP_PACKET_LEN_OFFSET, (packetLength / RTCP_PACKET_LEN_WORD_SIZE) - 1);
+    putUnalignedInt32BigEndian(pRawPacket + 4, ssrc);
+    if (reportCount > 0) {
+        MEMCPY(pRawPacket + RTCP_PACKET_HEADER_LEN + 4, pReportBlocks, reportCount * RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN);
+    }
+
+CleanUp:
+    if (pPacketLength != NULL) {
+        *pPacketLength = packetLength;
+    }
+
+    return retStatus;
+}
+
+/**
+ * https://tools.ietf.org/html/rfc3550#section-6.5
+ * One chunk of the ssrc and its CNAME item. The item list ends with a null octet, and further null octets pad the chunk
+ * to a 32 bit boundary.
+ */
+STATUS rtcp_packet_createSdesCnameBytes(UINT32 ssrc, PCHAR cname, PBYTE pRawPacket, PUINT32 pPacketLength)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 packetLength = 0, cnameLength = 0, chunkLength;
+
+    CHK(cname != NULL && pPacketLength != NULL, STATUS_RTCP_NULL_ARG);
+    cnameLength = (UINT32) STRNLEN(cname, RTCP_SDES_MAX_ITEM_LEN + 1);
+    CHK(cnameLength <= RTCP_SDES_MAX_ITEM_LEN, STATUS_INVALID_ARG);
+
+    chunkLength = (4 + 2 + cnameLength + RTCP_PACKET_LEN_WORD_SIZE) & ~(RTCP_PACKET_LEN_WORD_SIZE - 1);
+    packetLength = RTCP_PACKET_HEADER_LEN + chunkLength;
+
+    // Check if we are trying to calculate the required size only
+    CHK(pRawPacket != NULL, retStatus);
+    CHK(*pPacketLength >= packetLength, STATUS_BUFFER_TOO_SMALL);
+
+    MEMSET(pRawPacket, 0x00, packetLength);
+    pRawPacket[0] = (RTCP_PACKET_VERSION_VAL << VERSION_SHIFT) | 1;
+    pRawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_SOURCE_DESCRIPTION;
+    putUnalignedInt16BigEndian(pRawPacket + RTCP_PACKET_LEN_OFFSET, (packetLength / RTCP_PACKET_LEN_WORD_SIZE) - 1);
+    putUnalignedInt32BigEndian(pRawPacket + 4, ssrc);
+    pRawPacket[8] = RTCP_SDES_ITEM_CNAME;
+    pRawPacket[9] = (BYTE) cnameLength;
+    MEMCPY(pRawPacket + 10, cname, cnameLength);
+
+CleanUp:
+    if (pPacketLength != NULL) {
+        *pPacketLength = packetLength;
+    }
+
+    return retStatus;
+}
+
+/**
+ * https://tools.ietf.org/html/draft-alvestrand-rmcat-remb-03#section-2.2
+ * The bitrate is carried as an 18 bit mantissa and a 6 bit exponent, the FCI starts with the "REMB" identifier.
+ */
+STATUS rtcp_packet_createRembBytes(UINT32 senderSsrc, UINT64 bitrate, PUINT32 pSsrcList, UINT32 ssrcListLen, PBYTE pRawPacket, PUINT32 pPacketLength)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    const BYTE rembUniqueIdentifier[] = {0x52, 0x45, 0x4d, 0x42};
+    UINT32 packetLength = RTCP_PACKET_HEADER_LEN + RTCP_PACKET_REMB_MIN_SIZE + ssrcListLen * SIZEOF(UINT32), i;
+    UINT64 mantissa = bitrate;
+    UINT8 exponent = 0;
+
+    CHK(pPacketLength != NULL && (pSsrcList != NULL || ssrcListLen == 0), STATUS_RTCP_NULL_ARG);
+    CHK(ssrcListLen <= MAX_UINT8, STATUS_INVALID_ARG);
+
+    // Check if we are trying to calculate the required size only
+    CHK(pRawPacket != NULL, retStatus);
+    CHK(*pPacketLength >= packetLength, STATUS_BUFFER_TOO_SMALL);
+
+    while (mantissa > RTCP_PACKET_REMB_MANTISSA_BITMASK) {
+        mantissa >>= 1;
+        exponent++;
+    }
+
+    pRawPacket[0] = (RTCP_PACKET_VERSION_VAL << VERSION_SHIFT) | RTCP_FEEDBACK_MESSAGE_TYPE_APPLICATION_LAYER_FEEDBACK;
+    pRawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_PAYLOAD_SPECIFIC_FEEDBACK;
+    putUnalignedInt16BigEndian(pRawPacket + RTCP_PACKET_LEN_OFFSET, (packetLength / RTCP_PACKET_LEN_WORD_SIZE) - 1);
+    putUnalignedInt32BigEndian(pRawPacket + 4, senderSsrc);
+    // the media source is unused, the ssrcs follow the bitrate
+    putUnalignedInt32BigEndian(pRawPacket + 8, 0);
+    MEMCPY(pRawPacket + RTCP_PACKET_HEADER_LEN + RTCP_PACKET_REMB_IDENTIFIER_OFFSET, rembUniqueIdentifier, SIZEOF(rembUniqueIdentifier));
+    putUnalignedInt32BigEndian(pRawPacket + 16, (ssrcListLen << 24) | ((UINT32) exponent << 18) | (UINT32) mantissa);
+    for (i = 0; i < ssrcListLen; i++) {
+        putUnalignedInt32BigEndian(pRawPacket + 20 + i * SIZEOF(UINT32), pSsrcList[i]);
+    }
+
+CleanUp:
+    if (pPacketLength != NULL) {
+        *pPacketLength = packetLength;
+    }
+
+    return retStatus;
+}
+
+static VOID rtcp_packet_initReceptionStats(PRtcpReceptionStats pReceptionStats, UINT16 sequenceNumber)
+{
+    pReceptionStats->started = TRUE;
+    pReceptionStats->baseSequenceNumber = sequenceNumber;
+    pReceptionStats->maxSequenceNumber = sequenceNumber;
+    pReceptionStats->badSequenceNumber = RTCP_RECEPTION_SEQ_MOD + 1;
+    pReceptionStats->cycles = 0;
+    pReceptionStats->received = 0;
+    pReceptionStats->receivedPrior = 0;
+    pReceptionStats->expectedPrior = 0;
+}
+
+STATUS rtcp_packet_updateReceptionStats(PRtcpReceptionStats pReceptionStats, UINT16 sequenceNumber)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT16 delta;
+
+    CHK(pReceptionStats != NULL, STATUS_RTCP_NULL_ARG);
+
+    if (!pReceptionStats->started) {
+        rtcp_packet_initReceptionStats(pReceptionStats, sequenceNumber);
+    } else {
+        delta = (UINT16)(sequenceNumber - pReceptionStats->maxSequenceNumber);
+        if (delta < RTCP_RECEPTION_MAX_DROPOUT) {
+            // in order, with permissible gap
+            if (sequenceNumber < pReceptionStats->maxSequenceNumber) {
+                // sequence number wrapped, count another 64K cycle
+                pReceptionStats->cycles += RTCP_RECEPTION_SEQ_MOD;
+            }
+            pReceptionStats->maxSequenceNumber = sequenceNumber;
+        } else if (delta <= RTCP_RECEPTION_SEQ_MOD - RTCP_RECEPTION_MAX_MISORDER) {
+            // the sequence number made a very large jump
+            if (sequenceNumber == pReceptionStats->badSequenceNumber) {
+                // two sequential packets, assume that the other side restarted without telling us so just re-sync
+                rtcp_packet_initReceptionStats(pReceptionStats, sequenceNumber);
+            } else {
+                pReceptionStats->badSequenceNumber = (sequenceNumber + 1) & (RTCP_RECEPTION_SEQ_MOD - 1);
+                CHK(FALSE, retStatus);
+            }
+        }
+        // otherwise a duplicate or reordered packet
+    }
+    pReceptionStats->received++;
+
+CleanUp:
+    return retStatus;
+}
+
+/**
+ *        0                   1                   2                   3
+ *        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ *        +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ * report |                 SSRC_1 (SSRC of first source)                 |
+ * block  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *   1    | fraction lost |       cumulative number of packets lost       |
+ *        +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *        |           extended highest sequence number received           |
+ *        +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *        |                      interarrival jitter                      |
+ *        +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *        |                         last SR (LSR)                         |
+ *        +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *        |                   delay since last SR (DLSR)                  |
+ *        +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ */
+STATUS rtcp_packet_setReportBlock(PRtcpReceptionStats pReceptionStats, UINT32 ssrc, UINT32 jitter, UINT64 now, PBYTE pBuffer)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 extendedMax, expected, expectedInterval, receivedInterval, delaySinceLastSR = 0;
+    INT32 lost, lostInterval;
+    UINT64 elapsed;
+    UINT8 fraction = 0;
+
+    CHK(pReceptionStats != NULL && pBuffer != NULL, STATUS_RTCP_NULL_ARG);
+
+    extendedMax = pReceptionStats->cycles + pReceptionStats->maxSequenceNumber;
+    expected = extendedMax - pReceptionStats->baseSequenceNumber + 1;
+    lost = (INT32)(expected - pReceptionStats->received);
+    // the cumulative number of packets lost is a signed 24 bit value
+    lost = MIN(MAX(lost, -0x800000), 0x7FFFFF);
+
+    expectedInterval = expected - pReceptionStats->expectedPrior;
+    pReceptionStats->expectedPrior = expected;
+    receivedInterval = pReceptionStats->received - pReceptionStats->receivedPrior;
+    pReceptionStats->receivedPrior = pReceptionStats->received;
+    lostInterval = (INT32)(expectedInterval - receivedInterval);
+    if (expectedInterval != 0 && lostInterval > 0) {
+        fraction = (UINT8)(((UINT32) lostInterval << 8) / expectedInterval);
+    }
+
+    if (pReceptionStats->lastSenderReportTime != 0 && now > pReceptionStats->lastSenderReportTime) {
+        elapsed = now - pReceptionStats->lastSenderReportTime;
+        delaySinceLastSR = (UINT32) KVS_CONVERT_TIMESCALE(elapsed, HUNDREDS_OF_NANOS_IN_A_SECOND, DLSR_TIMESCALE);
+    }
+
+    putUnalignedInt32BigEndian(pBuffer, ssrc);
+    putUnalignedInt32BigEndian(pBuffer + 4, ((UINT32) fraction << 24) | ((UINT32) lost & 0x00FFFFFF));
+    putUnalignedInt32BigEndian(pBuffer + 8, extendedMax);
+    putUnalignedInt32BigEndian(pBuffer + 12, jitter);
+    putUnalignedInt32BigEndian(pBuffer + 16, pReceptionStats->lastSenderReport);
+    putUnalignedInt32BigEndian(pBuffer + 20, delaySinceLastSR);
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtcp_packet_getReportBlock(PBYTE pBuffer, UINT32 bufferLen, PRtcpReportBlock pReportBlock)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 lost;
+
+    CHK(pBuffer != NULL && pReportBlock != NULL, STATUS_RTCP_NULL_ARG);
+    CHK(bufferLen >= RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN, STATUS_RTCP_INPUT_PACKET_TOO_SMALL);
+
+    pReportBlock->ssrc = (UINT32) getUnalignedInt32BigEndian(pBuffer);
+    pReportBlock->fractionLost = pBuffer[4];
+    lost = (UINT32) getUnalignedInt32BigEndian(pBuffer + 4) & 0x00FFFFFF;
+    // sign extend the 24 bit value
+    pReportBlock->cumulativeLost = (lost & 0x00800000) ? (INT32)(lost | 0xFF000000) : (INT32) lost;
+    pReportBlock->extendedHighestSequenceNumber = (UINT32) getUnalignedInt32BigEndian(pBuffer + 8);
+    pReportBlock->jitter = (UINT32) getUnalignedInt32BigEndian(pBuffer + 12);
+    pReportBlock->lastSenderReport = (UINT32) getUnalignedInt32BigEndian(pBuffer + 16);
+    pReportBlock->delaySinceLastSenderReport = (UINT32) getUnalignedInt32BigEndian(pBuffer + 20);
+
+CleanUp:
+    return retStatus;
+}
+
 // Assert that Application Layer Feedback payload is REMB
 STATUS rtcp_packet_isRemb(PBYTE pPayload, UINT32 payloadLen)
 {
@@ -179,3 +567,12 @@ UINT64 rtcp_packet_convertTimestampToNTP(UINT64 time100ns)
     UINT64 ntp_frac = KVS_CONVERT_TIMESCALE(_100ns, HUNDREDS_OF_NANOS_IN_A_SECOND, NTP_TIMESCALE);
     return (ntp_sec << 32U | ntp_frac);
 }
+
+UINT64 rtcp_packet_convertNTPToTimestamp(UINT64 ntpTime)
+{
+    UINT64 sec = (ntpTime >> 32U) - NTP_OFFSET;
+    UINT64 ntp_frac = ntpTime & 0xffffffffULL;
+
+    // rounded, a time converted to ntp and back stays the same
+    return sec * HUNDREDS_OF_NANOS_IN_A_SECOND + (ntp_frac * HUNDREDS_OF_NANOS_IN_A_SECOND + NTP_TIMESCALE / 2) / NTP_TIMESCALE;
+}
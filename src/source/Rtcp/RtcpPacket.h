@@ -36,6 +36,11 @@ extern "C" {
 
 #define RTCP_PACKET_HEADER_LEN 4
 #define RTCP_NACK_LIST_LEN     8
+// FCI entry of a FIR, the ssrc of the media sender, the command sequence number and 3 reserved bytes
+#define RTCP_FIR_ENTRY_LEN 8
+// https://tools.ietf.org/html/rfc3550#section-6.5.1
+#define RTCP_SDES_ITEM_CNAME   1
+#define RTCP_SDES_MAX_ITEM_LEN 255
 
 #define RTCP_PACKET_VERSION_VAL 2
 
@@ -65,6 +70,11 @@ extern "C" {
 // is set to 5 seconds.
 #define RTCP_FIRST_REPORT_DELAY (3 * HUNDREDS_OF_NANOS_IN_A_SECOND)
 
+// https://tools.ietf.org/html/rfc3550#appendix-A.1
+#define RTCP_RECEPTION_MAX_DROPOUT  3000
+#define RTCP_RECEPTION_MAX_MISORDER 100
+#define RTCP_RECEPTION_SEQ_MOD      (1 << 16)
+
 typedef enum {
     RTCP_PACKET_TYPE_FIR = 192,                  // https://tools.ietf.org/html/rfc2032#section-5.2.1
     RTCP_PACKET_TYPE_SENDER_REPORT = 200,        //!< SR: Sender Report RTCP Packet, https://datatracker.ietf.org/doc/html/rfc3550#section-6.4.1
@@ -86,6 +96,7 @@ typedef enum {
     RTCP_PSFB_PLI = 1,                                          //!< Picture Loss Indication, https://tools.ietf.org/html/rfc4585#section-6.3
     RTCP_PSFB_SLI = 2,                                          //!< Slice Loss Indication, https://tools.ietf.org/html/rfc4585#section-6.3.2
     RTCP_PSFB_RPSI = 3,                                         //!< Reference Picture Selection Indication
+    RTCP_PSFB_FIR = 4,                                          //!< Full Intra Request, https://tools.ietf.org/html/rfc5104#section-4.3.1
     RTCP_FEEDBACK_MESSAGE_TYPE_APPLICATION_LAYER_FEEDBACK = 15, //!< Application Layer Feedback, AFB.
 } RTCP_FEEDBACK_MESSAGE_TYPE;
 
@@ -113,11 +124,163 @@ typedef struct {
     UINT32 payloadLength;
 } RtcpPacket, *PRtcpPacket;
 
+/**
+ * Reception statistics of one inbound ssrc for the report blocks of SR and RR, https://tools.ietf.org/html/rfc3550#appendix-A.1
+ */
+typedef struct {
+    BOOL started;
+    UINT16 maxSequenceNumber;    // highest sequence number seen
+    UINT32 cycles;               // shifted count of sequence number cycles
+    UINT32 baseSequenceNumber;   // first sequence number
+    UINT32 badSequenceNumber;    // last 'bad' sequence number + 1
+    UINT32 received;             // packets received
+    UINT32 expectedPrior;        // packets expected at the last report
+    UINT32 receivedPrior;        // packets received at the last report
+    UINT32 lastSenderReport;     // LSR, the middle 32 bits of the NTP timestamp of the last SR of the ssrc
+    UINT64 lastSenderReportTime; // arrival of the last SR in 100ns, 0 if none arrived yet
+    // wallclock of the remote sender at lastSenderReportRtpTime, mapping the rtp timestamps of the ssrc to NTP time
+    UINT64 lastSenderReportNtpTime;
+    UINT32 lastSenderReportRtpTime;
+} RtcpReceptionStats, *PRtcpReceptionStats;
+
+/**
+ * One report block of SR or RR, https://tools.ietf.org/html/rfc3550#section-6.4.1
+ */
+typedef struct {
+    UINT32 ssrc;
+    UINT8 fractionLost; // fixed point, the lost fraction multiplied by 256
+    INT32 cumulativeLost;
+    UINT32 extendedHighestSequenceNumber;
+    UINT32 jitter; // timestamp units
+    UINT32 lastSenderReport;
+    UINT32 delaySinceLastSenderReport; // 1/65536 seconds
+} RtcpReportBlock, *PRtcpReportBlock;
+
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
 STATUS rtcp_packet_setFromBytes(PBYTE, UINT32, PRtcpPacket);
 STATUS rtcp_packet_getNackList(PBYTE, UINT32, PUINT32, PUINT32, PUINT16, PUINT32);
+/**
+ * @brief serialize a generic NACK, https://tools.ietf.org/html/rfc4585#section-6.2.1
+ *
+ * @param[in] senderSsrc the ssrc of the packet sender.
+ * @param[in] mediaSsrc the ssrc of the media source the packets are missing from.
+ * @param[in] pSequenceNumberList the missing sequence numbers, sorted oldest first for the most compact packet.
+ * @param[in] sequenceNumberListLen the number of missing sequence numbers.
+ * @param[out] pRawPacket the packet buffer, NULL to calculate the required size only.
+ * @param[in, out] pPacketLength the size of the buffer, the length of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_packet_createNackBytes(UINT32, UINT32, PUINT16, UINT32, PBYTE, PUINT32);
+/**
+ * @brief serialize a picture loss indication, https://tools.ietf.org/html/rfc4585#section-6.3.1
+ *
+ * @param[in] senderSsrc the ssrc of the packet sender.
+ * @param[in] mediaSsrc the ssrc of the media source which lost its reference.
+ * @param[out] pRawPacket the packet buffer, NULL to calculate the required size only.
+ * @param[in, out] pPacketLength the size of the buffer, the length of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_packet_createPliBytes(UINT32, UINT32, PBYTE, PUINT32);
+/**
+ * @brief serialize a full intra request, https://tools.ietf.org/html/rfc5104#section-4.3.1
+ *
+ * @param[in] senderSsrc the ssrc of the packet sender.
+ * @param[in] mediaSsrc the ssrc of the media sender which is asked for a key frame.
+ * @param[in] sequenceNumber the command sequence number, incremented for every new request and kept for repetitions.
+ * @param[out] pRawPacket the packet buffer, NULL to calculate the required size only.
+ * @param[in, out] pPacketLength the size of the buffer, the length of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_packet_createFirBytes(UINT32, UINT32, UINT8, PBYTE, PUINT32);
+/**
+ * @brief serialize a sender report, https://tools.ietf.org/html/rfc3550#section-6.4.1
+ *
+ * @param[in] ssrc the ssrc of the sender.
+ * @param[in] ntpTime the wallclock of the report in NTP format.
+ * @param[in] rtpTime the rtp timestamp of the same instant.
+ * @param[in] packetCount the packets sent by the ssrc.
+ * @param[in] octetCount the payload bytes sent by the ssrc.
+ * @param[in] pReportBlocks reportCount blocks of RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN bytes, NULL if there are none.
+ * @param[in] reportCount the number of report blocks.
+ * @param[out] pRawPacket the packet buffer, NULL to calculate the required size only.
+ * @param[in, out] pPacketLength the size of the buffer, the length of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_packet_createSenderReportBytes(UINT32, UINT64, UINT32, UINT32, UINT32, PBYTE, UINT32, PBYTE, PUINT32);
+/**
+ * @brief serialize a receiver report, https://tools.ietf.org/html/rfc3550#section-6.4.2
+ *
+ * @param[in] ssrc the ssrc of the packet sender.
+ * @param[in] pReportBlocks reportCount blocks of RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN bytes, NULL if there are none.
+ * @param[in] reportCount the number of report blocks.
+ * @param[out] pRawPacket the packet buffer, NULL to calculate the required size only.
+ * @param[in, out] pPacketLength the size of the buffer, the length of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_packet_createReceiverReportBytes(UINT32, PBYTE, UINT32, PBYTE, PUINT32);
+/**
+ * @brief serialize a source description with the CNAME of one ssrc, https://tools.ietf.org/html/rfc3550#section-6.5
+ *
+ * @param[in] ssrc the ssrc the CNAME belongs to.
+ * @param[in] cname the NULL terminated CNAME, at most RTCP_SDES_MAX_ITEM_LEN characters.
+ * @param[out] pRawPacket the packet buffer, NULL to calculate the required size only.
+ * @param[in, out] pPacketLength the size of the buffer, the length of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_packet_createSdesCnameBytes(UINT32, PCHAR, PBYTE, PUINT32);
+/**
+ * @brief serialize a receiver estimated maximum bitrate, https://tools.ietf.org/html/draft-alvestrand-rmcat-remb-03#section-2.2
+ *
+ * @param[in] senderSsrc the ssrc of the packet sender.
+ * @param[in] bitrate the estimated maximum bitrate in bits per second, rounded down to 18 significant bits.
+ * @param[in] pSsrcList the ssrcs the estimate applies to.
+ * @param[in] ssrcListLen the number of ssrcs, at most 255.
+ * @param[out] pRawPacket the packet buffer, NULL to calculate the required size only.
+ * @param[in, out] pPacketLength the size of the buffer, the length of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_packet_createRembBytes(UINT32, UINT64, PUINT32, UINT32, PBYTE, PUINT32);
+/**
+ * @brief account an inbound rtp packet, update_seq() of https://tools.ietf.org/html/rfc3550#appendix-A.1
+ *
+ * @param[in] pReceptionStats the statistics of the ssrc of the packet.
+ * @param[in] sequenceNumber the sequence number of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_packet_updateReceptionStats(PRtcpReceptionStats, UINT16);
+/**
+ * @brief write a report block of SR and RR and start the next reporting interval,
+ *        https://tools.ietf.org/html/rfc3550#appendix-A.3
+ *
+ * @param[in] pReceptionStats the statistics of the reported ssrc.
+ * @param[in] ssrc the reported ssrc.
+ * @param[in] jitter the interarrival jitter in timestamp units.
+ * @param[in] now the current time in 100ns, for the delay since the last SR.
+ * @param[out] pBuffer RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN bytes for the block.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_packet_setReportBlock(PRtcpReceptionStats, UINT32, UINT32, UINT64, PBYTE);
+/**
+ * @brief parse one report block of SR or RR.
+ *
+ * @param[in] pBuffer the report block.
+ * @param[in] bufferLen the length of the buffer, at least RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN.
+ * @param[out] pReportBlock the report block.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_packet_getReportBlock(PBYTE, UINT32, PRtcpReportBlock);
 STATUS rtcp_packet_getRembValue(PBYTE, UINT32, PDOUBLE, PUINT32, PUINT8);
 STATUS rtcp_packet_isRemb(PBYTE, UINT32);
 
@@ -126,6 +289,8 @@ STATUS rtcp_packet_isRemb(PBYTE, UINT32);
 
 // converts 100ns precision time to ntp time
 UINT64 rtcp_packet_convertTimestampToNTP(UINT64 time100ns);
+// converts ntp time to 100ns precision time, the inverse of rtcp_packet_convertTimestampToNTP
+UINT64 rtcp_packet_convertNTPToTimestamp(UINT64 ntpTime);
 
 #define DLSR_TIMESCALE 65536
 
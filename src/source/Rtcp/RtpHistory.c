@@ -0,0 +1,238 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#define LOG_CLASS "RtpHistory"
+
+#include "RtpHistory.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+// the entries cover at most half of the sequence number space, so newer and older stay well defined
+#define RTP_HISTORY_MAX_ENTRY_COUNT 0x8000
+// the expired packets dropped by a put, more than one so the history catches up after a change of maxAgeMsec
+#define RTP_HISTORY_MAX_EXPIRED_PER_PUT 4
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS rtp_history_create(UINT32 entryCount, UINT32 slabSize, UINT32 maxAgeMsec, PRtpHistory* ppRtpHistory)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtpHistory pRtpHistory = NULL;
+    UINT32 roundedCount = 1;
+
+    CHK(ppRtpHistory != NULL, STATUS_NULL_ARG);
+    CHK(entryCount > 0 && entryCount <= RTP_HISTORY_MAX_ENTRY_COUNT && slabSize >= MIN_HEADER_LENGTH, STATUS_INVALID_ARG);
+
+    while (roundedCount < entryCount) {
+        roundedCount <<= 1;
+    }
+
+    pRtpHistory = (PRtpHistory) MEMCALLOC(1, SIZEOF(RtpHistory));
+    CHK(pRtpHistory != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRtpHistory->pSlab = (PBYTE) MEMALLOC(slabSize);
+    CHK(pRtpHistory->pSlab != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRtpHistory->entries = (PRtpHistoryEntry) MEMCALLOC(roundedCount, SIZEOF(RtpHistoryEntry));
+    CHK(pRtpHistory->entries != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRtpHistory->slabSize = slabSize;
+    pRtpHistory->entryCount = roundedCount;
+    pRtpHistory->maxAgeMsec = maxAgeMsec;
+    pRtpHistory->empty = TRUE;
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        rtp_history_free(&pRtpHistory);
+    }
+    if (ppRtpHistory != NULL) {
+        *ppRtpHistory = pRtpHistory;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtp_history_free(PRtpHistory* ppRtpHistory)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(ppRtpHistory != NULL, STATUS_NULL_ARG);
+    CHK(*ppRtpHistory != NULL, retStatus);
+
+    SAFE_MEMFREE((*ppRtpHistory)->entries);
+    SAFE_MEMFREE((*ppRtpHistory)->pSlab);
+    SAFE_MEMFREE(*ppRtpHistory);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtp_history_setMaxAge(PRtpHistory pRtpHistory, UINT32 maxAgeMsec)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pRtpHistory != NULL, STATUS_NULL_ARG);
+    ATOMIC_STORE(&pRtpHistory->maxAgeMsec, (SIZE_T) maxAgeMsec);
+
+CleanUp:
+    return retStatus;
+}
+
+/**
+ * @brief drop the oldest sequence number, the entry is emptied when it holds that packet.
+ */
+static VOID rtp_history_dropOldest(PRtpHistory pRtpHistory)
+{
+    PRtpHistoryEntry pEntry = &pRtpHistory->entries[pRtpHistory->oldestSequenceNumber & (pRtpHistory->entryCount - 1)];
+
+    if (pEntry->length != 0 && pEntry->sequenceNumber == pRtpHistory->oldestSequenceNumber) {
+        ATOMIC_INCREMENT(&pEntry->version);
+        pEntry->length = 0;
+        ATOMIC_INCREMENT(&pEntry->version);
+    }
+
+    if (pRtpHistory->oldestSequenceNumber == pRtpHistory->newestSequenceNumber) {
+        pRtpHistory->empty = TRUE;
+        pRtpHistory->writeOffset = 0;
+    } else {
+        pRtpHistory->oldestSequenceNumber++;
+    }
+}
+
+/**
+ * @brief the entry of the oldest packet kept, skipping the sequence numbers which were never put.
+ */
+static PRtpHistoryEntry rtp_history_getOldest(PRtpHistory pRtpHistory)
+{
+    PRtpHistoryEntry pEntry;
+
+    while (!pRtpHistory->empty) {
+        pEntry = &pRtpHistory->entries[pRtpHistory->oldestSequenceNumber & (pRtpHistory->entryCount - 1)];
+        if (pEntry->length != 0 && pEntry->sequenceNumber == pRtpHistory->oldestSequenceNumber) {
+            return pEntry;
+        }
+        rtp_history_dropOldest(pRtpHistory);
+    }
+
+    return NULL;
+}
+
+STATUS rtp_history_put(PRtpHistory pRtpHistory, PBYTE pPacket, UINT32 packetLength, UINT64 currentTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtpHistoryEntry pEntry;
+    UINT16 sequenceNumber, delta;
+    UINT32 offset, advance, i;
+    UINT64 maxAge;
+
+    CHK(pRtpHistory != NULL && pPacket != NULL, STATUS_NULL_ARG);
+    CHK(packetLength >= MIN_HEADER_LENGTH && packetLength <= pRtpHistory->slabSize, STATUS_INVALID_ARG);
+    sequenceNumber = (UINT16) getInt16(*(PUINT16)(pPacket + SEQ_NUMBER_OFFSET));
+
+    if (!pRtpHistory->empty) {
+        delta = (UINT16)(sequenceNumber - pRtpHistory->newestSequenceNumber);
+        // the sender started over or jumped past everything kept
+        if (delta == 0 || delta >= pRtpHistory->entryCount) {
+            while (!pRtpHistory->empty) {
+                rtp_history_dropOldest(pRtpHistory);
+            }
+        }
+    }
+
+    // the entries of the sequence numbers one entryCount back are reused
+    while (!pRtpHistory->empty && (UINT16)(sequenceNumber - pRtpHistory->oldestSequenceNumber) >= pRtpHistory->entryCount) {
+        rtp_history_dropOldest(pRtpHistory);
+    }
+
+    maxAge = ATOMIC_LOAD(&pRtpHistory->maxAgeMsec) * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    for (i = 0; i < RTP_HISTORY_MAX_EXPIRED_PER_PUT; i++) {
+        pEntry = rtp_history_getOldest(pRtpHistory);
+        if (pEntry == NULL || pEntry->putTime + maxAge >= currentTime) {
+            break;
+        }
+        rtp_history_dropOldest(pRtpHistory);
+    }
+
+    // the packet goes behind the newest one, or to the start of the slab when it does not fit before the end
+    offset = pRtpHistory->writeOffset;
+    advance = packetLength;
+    if (offset + packetLength > pRtpHistory->slabSize) {
+        advance += pRtpHistory->slabSize - offset;
+        offset = 0;
+    }
+
+    // the packets are laid out in the order they were put, the ones in the way are the oldest
+    while (NULL != (pEntry = rtp_history_getOldest(pRtpHistory)) &&
+           (pEntry->offset + pRtpHistory->slabSize - pRtpHistory->writeOffset) % pRtpHistory->slabSize < advance) {
+        rtp_history_dropOldest(pRtpHistory);
+    }
+    if (pRtpHistory->empty) {
+        offset = 0;
+    }
+
+    pEntry = &pRtpHistory->entries[sequenceNumber & (pRtpHistory->entryCount - 1)];
+    ATOMIC_INCREMENT(&pEntry->version);
+    MEMCPY(pRtpHistory->pSlab + offset, pPacket, packetLength);
+    pEntry->offset = offset;
+    pEntry->length = packetLength;
+    pEntry->sequenceNumber = sequenceNumber;
+    pEntry->putTime = currentTime;
+    ATOMIC_INCREMENT(&pEntry->version);
+
+    pRtpHistory->writeOffset = offset + packetLength;
+    pRtpHistory->newestSequenceNumber = sequenceNumber;
+    if (pRtpHistory->empty) {
+        pRtpHistory->oldestSequenceNumber = sequenceNumber;
+        pRtpHistory->empty = FALSE;
+    }
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtp_history_get(PRtpHistory pRtpHistory, UINT16 sequenceNumber, UINT64 currentTime, PBYTE pBuffer, PUINT32 pLength)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtpHistoryEntry pEntry;
+    SIZE_T version;
+    UINT32 offset, length;
+
+    CHK(pRtpHistory != NULL && pBuffer != NULL && pLength != NULL, STATUS_NULL_ARG);
+
+    pEntry = &pRtpHistory->entries[sequenceNumber & (pRtpHistory->entryCount - 1)];
+    version = ATOMIC_LOAD(&pEntry->version);
+    CHK((version & 1) == 0, STATUS_NOT_FOUND);
+    offset = pEntry->offset;
+    length = pEntry->length;
+    // the fields may be torn, they are only trusted once the version is checked again
+    CHK(length != 0 && pEntry->sequenceNumber == sequenceNumber && offset <= pRtpHistory->slabSize && length <= pRtpHistory->slabSize - offset,
+        STATUS_NOT_FOUND);
+    // expired, the writer drops it on one of the next puts
+    CHK(pEntry->putTime + ATOMIC_LOAD(&pRtpHistory->maxAgeMsec) * HUNDREDS_OF_NANOS_IN_A_MILLISECOND >= currentTime, STATUS_NOT_FOUND);
+    CHK(length <= *pLength, STATUS_BUFFER_TOO_SMALL);
+
+    MEMCPY(pBuffer, pRtpHistory->pSlab + offset, length);
+    // the fence keeps the copy ahead of the check, the copy is dropped when the writer reused the entry or its bytes
+    ATOMIC_FENCE_ACQUIRE();
+    CHK(ATOMIC_LOAD(&pEntry->version) == version, STATUS_NOT_FOUND);
+    *pLength = length;
+
+CleanUp:
+    return retStatus;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_RTCP_RTP_HISTORY_H
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_RTCP_RTP_HISTORY_H
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "RtpPacket.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+typedef struct {
+    // odd while the writer changes the entry, a reader keeps what it copied only if the version did not move meanwhile
+    volatile SIZE_T version;
+    UINT32 offset;
+    // 0 when the entry is empty
+    UINT32 length;
+    UINT16 sequenceNumber;
+    UINT64 putTime;
+} RtpHistoryEntry, *PRtpHistoryEntry;
+
+/**
+ * The packets sent on an ssrc, kept for retransmission. The bytes are copied into one slab which is used as a ring, a packet
+ * never wraps around the end of the slab. The entry of a packet is found by the low bits of its sequence number. A packet
+ * is kept for maxAgeMsec at most, the older ones are dropped a few at a time when packets are put.
+ *
+ * One thread puts the packets and any number of threads get them without a lock: the writer makes the version of an entry
+ * odd before it reuses the entry or the slab bytes under it, and a reader drops its copy when the version moved.
+ */
+typedef struct {
+    PBYTE pSlab;
+    UINT32 slabSize;
+    // power of 2
+    UINT32 entryCount;
+    PRtpHistoryEntry entries;
+    // changed by any thread, the round trip time is measured on the rtcp path
+    volatile SIZE_T maxAgeMsec;
+    // only used by the writer
+    UINT32 writeOffset;
+    UINT16 oldestSequenceNumber;
+    UINT16 newestSequenceNumber;
+    BOOL empty;
+} RtpHistory, *PRtpHistory;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief create a history.
+ *
+ * @param[in] entryCount the most packets kept, rounded up to a power of 2.
+ * @param[in] slabSize the most bytes kept.
+ * @param[in] maxAgeMsec the longest a packet is kept.
+ * @param[out] ppRtpHistory the history.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_history_create(UINT32, UINT32, UINT32, PRtpHistory*);
+STATUS rtp_history_free(PRtpHistory*);
+/**
+ * @brief change how long the packets are kept, the packets older than that are not returned any more.
+ */
+STATUS rtp_history_setMaxAge(PRtpHistory, UINT32);
+/**
+ * @brief copy a packet into the history, dropping the oldest packets to make room. A sequence number which is not newer than
+ *        the newest one kept starts the history again. Only one thread puts packets.
+ *
+ * @param[in] pRtpHistory the history.
+ * @param[in] pPacket the rtp packet.
+ * @param[in] packetLength the length of the packet.
+ * @param[in] currentTime the time the packet is sent at.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_history_put(PRtpHistory, PBYTE, UINT32, UINT64);
+/**
+ * @brief copy a packet out of the history, concurrently with the writer.
+ *
+ * @param[in] pRtpHistory the history.
+ * @param[in] sequenceNumber the sequence number of the packet.
+ * @param[in] currentTime the current time, which the age of the packet is checked against.
+ * @param[out] pBuffer the buffer for the packet.
+ * @param[in, out] pLength the size of the buffer on the way in, the length of the packet on the way out.
+ *
+ * @return STATUS_NOT_FOUND when the packet is not kept any more, STATUS_BUFFER_TOO_SMALL when it does not fit into the buffer.
+ */
+STATUS rtp_history_get(PRtpHistory, UINT16, UINT64, PBYTE, PUINT32);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //__KINESIS_VIDEO_WEBRTC_CLIENT_RTCP_RTP_HISTORY_H
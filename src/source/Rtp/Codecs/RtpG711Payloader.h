@@ -12,6 +12,7 @@ extern "C" {
 
 STATUS createPayloadForG711(UINT32, PBYTE, UINT32, PBYTE, PUINT32, PUINT32, PUINT32);
 STATUS depayG711FromRtpPayload(PBYTE, UINT32, PBYTE, PUINT32, PBOOL);
+STATUS depayG711SlicesFromRtpPayload(PBYTE, UINT32, PRtcFrameSlice, PUINT32);
 
 #ifdef __cplusplus
 }
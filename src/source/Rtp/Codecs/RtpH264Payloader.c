@@ -133,6 +133,42 @@ CleanUp:
     return retStatus;
 }
 
+STATUS isH264ReferenceFrame(PBYTE nalus, UINT32 nalusLength, PBOOL pIsReference)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE curPtrInNalus = nalus;
+    UINT32 remainNalusLength = nalusLength;
+    UINT32 nextNaluLength = 0, startIndex = 0;
+    UINT8 naluType;
+    BOOL isReference = FALSE;
+
+    CHK(nalus != NULL && pIsReference != NULL, STATUS_NULL_ARG);
+
+    // https://tools.ietf.org/html/rfc6184#section-1.3 nal_ref_idc 0 means the slice is not used for inter picture prediction
+    while (remainNalusLength != 0 && !isReference) {
+        CHK_STATUS(getNextNaluLength(curPtrInNalus, remainNalusLength, &startIndex, &nextNaluLength));
+        curPtrInNalus += startIndex;
+        remainNalusLength -= startIndex;
+        if (nextNaluLength > 0) {
+            naluType = *curPtrInNalus & NAL_TYPE_MASK;
+            if (naluType >= NAL_TYPE_SLICE && naluType <= NAL_TYPE_IDR_SLICE) {
+                isReference = ((*curPtrInNalus >> NAL_REF_IDC_SHIFT) & NAL_REF_IDC_MASK) != 0;
+            }
+        }
+        remainNalusLength -= nextNaluLength;
+        curPtrInNalus += nextNaluLength;
+    }
+
+CleanUp:
+
+    if (pIsReference != NULL) {
+        // assume the worst when the frame can not be parsed
+        *pIsReference = STATUS_FAILED(retStatus) ? TRUE : isReference;
+    }
+
+    return retStatus;
+}
+
 STATUS createPayloadFromNalu(UINT32 mtu, PBYTE nalu, UINT32 naluLength, PPayloadArray pPayloadArray, PUINT32 filledLength, PUINT32 filledSubLenSize)
 {
     ENTERS();
@@ -377,3 +413,82 @@ CleanUp:
     LEAVES();
     return retStatus;
 }
+
+STATUS depayH264SlicesFromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PRtcFrameSlice pSlices, PUINT32 pSliceCount)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 sliceCount = 0, headerSize = 0;
+    UINT8 indicator = 0;
+    BOOL sizeCalculationOnly = (pSlices == NULL);
+    BOOL isStartingPacket = FALSE;
+    PBYTE pCurPtr = pRawPacket;
+    // the start codes of every frame point here, the application only reads the slices
+    static BYTE start4ByteCode[] = {0x00, 0x00, 0x00, 0x01};
+    UINT16 subNaluSize = 0;
+
+    CHK(pRawPacket != NULL && pSliceCount != NULL, STATUS_NULL_ARG);
+    CHK(packetLength > 0, retStatus);
+
+    indicator = *pRawPacket & NAL_TYPE_MASK;
+    switch (indicator) {
+        case FU_A_INDICATOR:
+        case FU_B_INDICATOR:
+            headerSize = (indicator == FU_A_INDICATOR) ? FU_A_HEADER_SIZE : FU_B_HEADER_SIZE;
+            CHK(packetLength > headerSize, STATUS_INVALID_ARG_LEN);
+            isStartingPacket = (pRawPacket[1] & (1 << 7)) != 0;
+            sliceCount = isStartingPacket ? 2 : 1;
+            CHK(!sizeCalculationOnly, retStatus);
+            CHK(sliceCount <= *pSliceCount, STATUS_BUFFER_TOO_SMALL);
+            if (isStartingPacket) {
+                // the nal header is rebuilt in the last byte of the fu header, right in front of the fragment
+                pRawPacket[headerSize - 1] = (pRawPacket[0] & 0x60) | (pRawPacket[1] & 0x1f);
+                pSlices[0].pData = start4ByteCode;
+                pSlices[0].size = SIZEOF(start4ByteCode);
+                pSlices[1].pData = pRawPacket + headerSize - 1;
+                pSlices[1].size = packetLength - headerSize + 1;
+            } else {
+                pSlices[0].pData = pRawPacket + headerSize;
+                pSlices[0].size = packetLength - headerSize;
+            }
+            break;
+        case STAP_A_INDICATOR:
+        case STAP_B_INDICATOR:
+            pCurPtr += (indicator == STAP_A_INDICATOR) ? STAP_A_HEADER_SIZE : STAP_B_HEADER_SIZE;
+            while (pCurPtr + SIZEOF(UINT16) <= pRawPacket + packetLength) {
+                subNaluSize = getUnalignedInt16BigEndian(pCurPtr);
+                pCurPtr += SIZEOF(UINT16);
+                if (subNaluSize == 0) {
+                    break;
+                }
+                CHK(pCurPtr + subNaluSize <= pRawPacket + packetLength, STATUS_INVALID_ARG_LEN);
+                if (!sizeCalculationOnly) {
+                    CHK(sliceCount + 2 <= *pSliceCount, STATUS_BUFFER_TOO_SMALL);
+                    pSlices[sliceCount].pData = start4ByteCode;
+                    pSlices[sliceCount].size = SIZEOF(start4ByteCode);
+                    pSlices[sliceCount + 1].pData = pCurPtr;
+                    pSlices[sliceCount + 1].size = subNaluSize;
+                }
+                sliceCount += 2;
+                pCurPtr += subNaluSize;
+            }
+            break;
+        default:
+            // Single NALU https://tools.ietf.org/html/rfc6184#section-5.6
+            sliceCount = 2;
+            CHK(!sizeCalculationOnly, retStatus);
+            CHK(sliceCount <= *pSliceCount, STATUS_BUFFER_TOO_SMALL);
+            pSlices[0].pData = start4ByteCode;
+            pSlices[0].size = SIZEOF(start4ByteCode);
+            pSlices[1].pData = pRawPacket;
+            pSlices[1].size = packetLength;
+    }
+
+CleanUp:
+    if (pSliceCount != NULL) {
+        *pSliceCount = STATUS_SUCCEEDED(retStatus) ? sliceCount : 0;
+    }
+
+    LEAVES();
+    return retStatus;
+}
@@ -22,6 +22,10 @@ extern "C" {
 #define STAP_A_INDICATOR     24
 #define STAP_B_INDICATOR     25
 #define NAL_TYPE_MASK        31
+#define NAL_REF_IDC_SHIFT    5
+#define NAL_REF_IDC_MASK     3
+#define NAL_TYPE_SLICE       1
+#define NAL_TYPE_IDR_SLICE   5
 
 /*
  *   0                   1                   2                   3
@@ -41,6 +45,28 @@ STATUS createPayloadForH264(UINT32, PBYTE, UINT32, PBYTE, PUINT32, PUINT32, PUIN
 STATUS getNextNaluLength(PBYTE, UINT32, PUINT32, PUINT32);
 STATUS createPayloadFromNalu(UINT32, PBYTE, UINT32, PPayloadArray, PUINT32, PUINT32);
 STATUS depayH264FromRtpPayload(PBYTE, UINT32, PBYTE, PUINT32, PBOOL);
+/**
+ * @brief describe the annex-b nalus of a packet as slices, the start codes point to a static buffer. The first fragment of
+ *        a FU-A/FU-B nalu gets its nal header rebuilt in place over the fu header.
+ *
+ * @param[in] pRawPacket the rtp payload.
+ * @param[in] packetLength the length of the rtp payload.
+ * @param[out] pSlices the slices, NULL to only count them.
+ * @param[in, out] pSliceCount the capacity of the slices, the number of slices of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS depayH264SlicesFromRtpPayload(PBYTE, UINT32, PRtcFrameSlice, PUINT32);
+/**
+ * @brief whether other frames may reference this annex-b frame, i.e. one of its slices has a non zero nal_ref_idc.
+ *
+ * @param[in] nalus the annex-b frame.
+ * @param[in] nalusLength the length of the frame.
+ * @param[out] pIsReference TRUE if dropping the frame breaks the reference chain.
+ *
+ * @return STATUS status of execution
+ */
+STATUS isH264ReferenceFrame(PBYTE, UINT32, PBOOL);
 
 #ifdef __cplusplus
 }
@@ -74,3 +74,27 @@ CleanUp:
     LEAVES();
     return retStatus;
 }
+
+STATUS depayOpusSlicesFromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PRtcFrameSlice pSlices, PUINT32 pSliceCount)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 sliceCount = 0;
+
+    CHK(pRawPacket != NULL && pSliceCount != NULL, STATUS_NULL_ARG);
+    CHK(packetLength > 0, retStatus);
+
+    sliceCount = 1;
+    CHK(pSlices != NULL, retStatus);
+    CHK(sliceCount <= *pSliceCount, STATUS_BUFFER_TOO_SMALL);
+    pSlices[0].pData = pRawPacket;
+    pSlices[0].size = packetLength;
+
+CleanUp:
+    if (pSliceCount != NULL) {
+        *pSliceCount = STATUS_SUCCEEDED(retStatus) ? sliceCount : 0;
+    }
+
+    LEAVES();
+    return retStatus;
+}
@@ -53,21 +53,18 @@ CleanUp:
     return retStatus;
 }
 
-STATUS depayVP8FromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PBYTE pVp8Data, PUINT32 pVp8Length, PBOOL pIsStart)
+/**
+ * @brief the length of the payload descriptor in front of the VP8 data, https://tools.ietf.org/html/rfc7741#section-4.2
+ */
+static UINT32 depayVP8PayloadDescriptorLength(PBYTE pRawPacket)
 {
-    ENTERS();
-    STATUS retStatus = STATUS_SUCCESS;
-    UINT32 vp8Length = packetLength, payloadDescriptorLength = 0;
-    BOOL sizeCalculationOnly = (pVp8Data == NULL);
+    UINT32 payloadDescriptorLength = 0;
     BOOL haveExtendedControlBits = FALSE;
     BOOL havePictureID = FALSE;
     BOOL haveTL0PICIDX = FALSE;
     BOOL haveTID = FALSE;
     BOOL haveKEYIDX = FALSE;
 
-    CHK(pRawPacket != NULL && pVp8Length != NULL, STATUS_NULL_ARG);
-    CHK(packetLength > 0, retStatus);
-
     haveExtendedControlBits = (pRawPacket[payloadDescriptorLength] & 0x80) >> 7;
     payloadDescriptorLength++;
 
@@ -95,6 +92,20 @@ STATUS depayVP8FromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PBYTE pVp8D
         payloadDescriptorLength++;
     }
 
+    return payloadDescriptorLength;
+}
+
+STATUS depayVP8FromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PBYTE pVp8Data, PUINT32 pVp8Length, PBOOL pIsStart)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 vp8Length = packetLength, payloadDescriptorLength = 0;
+    BOOL sizeCalculationOnly = (pVp8Data == NULL);
+
+    CHK(pRawPacket != NULL && pVp8Length != NULL, STATUS_NULL_ARG);
+    CHK(packetLength > 0, retStatus);
+
+    payloadDescriptorLength = depayVP8PayloadDescriptorLength(pRawPacket);
     vp8Length -= payloadDescriptorLength;
     CHK(!sizeCalculationOnly, retStatus);
 
@@ -117,3 +128,29 @@ CleanUp:
     LEAVES();
     return retStatus;
 }
+
+STATUS depayVP8SlicesFromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PRtcFrameSlice pSlices, PUINT32 pSliceCount)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 sliceCount = 0, payloadDescriptorLength = 0;
+
+    CHK(pRawPacket != NULL && pSliceCount != NULL, STATUS_NULL_ARG);
+    CHK(packetLength > 0, retStatus);
+
+    payloadDescriptorLength = depayVP8PayloadDescriptorLength(pRawPacket);
+    CHK(payloadDescriptorLength < packetLength, retStatus);
+    sliceCount = 1;
+    CHK(pSlices != NULL, retStatus);
+    CHK(sliceCount <= *pSliceCount, STATUS_BUFFER_TOO_SMALL);
+    pSlices[0].pData = pRawPacket + payloadDescriptorLength;
+    pSlices[0].size = packetLength - payloadDescriptorLength;
+
+CleanUp:
+    if (pSliceCount != NULL) {
+        *pSliceCount = STATUS_SUCCEEDED(retStatus) ? sliceCount : 0;
+    }
+
+    LEAVES();
+    return retStatus;
+}
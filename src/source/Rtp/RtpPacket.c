@@ -156,6 +156,34 @@ CleanUp:
     return retStatus;
 }
 
+STATUS rtp_packet_constructRetransmitPacketInPlace(PRtpPacket pRtpPacket, UINT16 sequenceNum, UINT8 payloadType, UINT32 ssrc, PBYTE* ppRtxPacket,
+                                                   PUINT32 pRtxPacketLength)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pRtxPacket = NULL;
+    UINT32 headerLength;
+
+    CHK(pRtpPacket != NULL && pRtpPacket->pRawPacket != NULL && ppRtxPacket != NULL && pRtxPacketLength != NULL, STATUS_RTP_NULL_ARG);
+
+    // only the header moves, the payload stays where it is
+    headerLength = RTP_HEADER_LEN(pRtpPacket);
+    pRtxPacket = pRtpPacket->pRawPacket - RTX_OSN_LENGTH;
+    MEMMOVE(pRtxPacket, pRtpPacket->pRawPacket, headerLength);
+    putUnalignedInt16BigEndian((PINT16)(pRtxPacket + headerLength), pRtpPacket->header.sequenceNumber);
+
+    // the padding bytes are carried as payload, the same as rtp_packet_constructRetransmitPacketFromBytes
+    pRtxPacket[0] &= ~(PADDING_MASK << PADDING_SHIFT);
+    pRtxPacket[1] = (pRtxPacket[1] & (MARKER_MASK << MARKER_SHIFT)) | (payloadType & PAYLOAD_TYPE_MASK);
+    putUnalignedInt16BigEndian((PINT16)(pRtxPacket + SEQ_NUMBER_OFFSET), sequenceNum);
+    putUnalignedInt32BigEndian((PINT32)(pRtxPacket + SSRC_OFFSET), ssrc);
+
+    *ppRtxPacket = pRtxPacket;
+    *pRtxPacketLength = headerLength + RTX_OSN_LENGTH + pRtpPacket->payloadLength;
+
+CleanUp:
+    return retStatus;
+}
+
 STATUS rtp_packet_setPacketFromBytes(PBYTE rawPacket, UINT32 packetLength, PRtpPacket pRtpPacket)
 {
     ENTERS();
@@ -347,3 +375,95 @@ CleanUp:
     LEAVES();
     return retStatus;
 }
+
+STATUS rtp_packet_appendOneByteExtension(PBYTE pBuffer, UINT32 bufferLen, PUINT32 pFilledLen, UINT8 id, PBYTE pData, UINT32 dataLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 offset, paddedLen;
+
+    CHK(pBuffer != NULL && pFilledLen != NULL && pData != NULL, STATUS_RTP_NULL_ARG);
+    CHK(id >= RTP_ONE_BYTE_EXTENSION_MIN_ID && id <= RTP_ONE_BYTE_EXTENSION_MAX_ID, STATUS_INVALID_ARG);
+    CHK(dataLen > 0 && dataLen <= RTP_ONE_BYTE_EXTENSION_MAX_LEN, STATUS_RTP_INVALID_EXTENSION_LEN);
+
+    /*
+     *  0
+     *  0 1 2 3 4 5 6 7
+     * +-+-+-+-+-+-+-+-+
+     * |  ID   |  len  |   len is the number of data bytes minus one
+     * +-+-+-+-+-+-+-+-+
+     */
+    offset = *pFilledLen;
+    paddedLen = ROUND_UP(offset + RTP_ONE_BYTE_EXTENSION_HEADER_LEN + dataLen, SIZEOF(UINT32));
+    CHK(paddedLen <= bufferLen, STATUS_RTP_BUFFER_TOO_SMALL);
+
+    pBuffer[offset] = (UINT8)((id << RTP_ONE_BYTE_EXTENSION_ID_SHIFT) | (dataLen - 1));
+    MEMCPY(pBuffer + offset + RTP_ONE_BYTE_EXTENSION_HEADER_LEN, pData, dataLen);
+    offset += RTP_ONE_BYTE_EXTENSION_HEADER_LEN + dataLen;
+    // zero bytes are padding, the block length is the filled length rounded up to 32-bit words
+    MEMSET(pBuffer + offset, 0, paddedLen - offset);
+    *pFilledLen = offset;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_packet_getOneByteExtension(PRtpPacket pRtpPacket, UINT8 id, PBYTE* ppData, PUINT32 pDataLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pCurPtr, pEnd;
+    UINT8 curId;
+    UINT32 curLen;
+
+    CHK(pRtpPacket != NULL && ppData != NULL && pDataLen != NULL, STATUS_RTP_NULL_ARG);
+    CHK(pRtpPacket->header.extension && pRtpPacket->header.extensionProfile == RTP_ONE_BYTE_EXTENSION_PROFILE &&
+            pRtpPacket->header.extensionPayload != NULL,
+        STATUS_RTP_EXTENSION_NOT_FOUND);
+
+    pCurPtr = pRtpPacket->header.extensionPayload;
+    pEnd = pCurPtr + pRtpPacket->header.extensionLength;
+    while (pCurPtr < pEnd) {
+        // zero bytes are padding between elements
+        if (*pCurPtr == 0) {
+            pCurPtr++;
+            continue;
+        }
+        curId = *pCurPtr >> RTP_ONE_BYTE_EXTENSION_ID_SHIFT;
+        curLen = (*pCurPtr & RTP_ONE_BYTE_EXTENSION_LEN_MASK) + 1;
+        // the reserved id terminates the processing of the block
+        CHK(curId != RTP_ONE_BYTE_EXTENSION_RESERVED_ID, STATUS_RTP_EXTENSION_NOT_FOUND);
+        CHK(pCurPtr + RTP_ONE_BYTE_EXTENSION_HEADER_LEN + curLen <= pEnd, STATUS_RTP_INVALID_EXTENSION_LEN);
+        if (curId == id) {
+            *ppData = pCurPtr + RTP_ONE_BYTE_EXTENSION_HEADER_LEN;
+            *pDataLen = curLen;
+            CHK(FALSE, STATUS_SUCCESS);
+        }
+        pCurPtr += RTP_ONE_BYTE_EXTENSION_HEADER_LEN + curLen;
+    }
+
+    CHK(FALSE, STATUS_RTP_EXTENSION_NOT_FOUND);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_packet_rewriteOneByteExtensionId(PBYTE rawPacket, UINT32 packetLength, UINT8 fromId, UINT8 toId)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    RtpPacket rtpPacket;
+    PBYTE pData = NULL;
+    UINT32 dataLen = 0;
+
+    CHK(rawPacket != NULL, STATUS_RTP_NULL_ARG);
+    CHK(toId >= RTP_ONE_BYTE_EXTENSION_MIN_ID && toId <= RTP_ONE_BYTE_EXTENSION_MAX_ID, STATUS_INVALID_ARG);
+
+    CHK_STATUS(rtp_packet_setPacketFromBytes(rawPacket, packetLength, &rtpPacket));
+    CHK_STATUS(rtp_packet_getOneByteExtension(&rtpPacket, fromId, &pData, &dataLen));
+    pData -= RTP_ONE_BYTE_EXTENSION_HEADER_LEN;
+    *pData = (UINT8)((toId << RTP_ONE_BYTE_EXTENSION_ID_SHIFT) | (*pData & RTP_ONE_BYTE_EXTENSION_LEN_MASK));
+
+CleanUp:
+
+    return retStatus;
+}
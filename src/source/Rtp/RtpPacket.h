@@ -26,6 +26,7 @@ extern "C" {
 #include "kvs/error.h"
 #include "kvs/common_defs.h"
 #include "kvs/platform_utils.h"
+#include "kvs/webrtc_client.h"
 /******************************************************************************
  * DEFINITIONS
  ******************************************************************************/
@@ -53,7 +54,26 @@ extern "C" {
 
 #define GET_UINT16_SEQ_NUM(seqIndex) ((UINT16)((seqIndex) % (MAX_UINT16 + 1)))
 
+// https://tools.ietf.org/html/rfc8285#section-4.2
+#define RTP_ONE_BYTE_EXTENSION_PROFILE     0xBEDE
+#define RTP_ONE_BYTE_EXTENSION_HEADER_LEN  1
+#define RTP_ONE_BYTE_EXTENSION_ID_SHIFT    4
+#define RTP_ONE_BYTE_EXTENSION_LEN_MASK    0xF
+#define RTP_ONE_BYTE_EXTENSION_MIN_ID      1
+#define RTP_ONE_BYTE_EXTENSION_MAX_ID      14
+#define RTP_ONE_BYTE_EXTENSION_MAX_LEN     16
+#define RTP_ONE_BYTE_EXTENSION_RESERVED_ID 15
+
+// https://tools.ietf.org/html/rfc4588#section-4 the rtx payload starts with the original sequence number
+#define RTX_OSN_LENGTH SIZEOF(UINT16)
+
 typedef STATUS (*DepayRtpPayloadFunc)(PBYTE, UINT32, PBYTE, PUINT32, PBOOL);
+/**
+ * Same as DepayRtpPayloadFunc, but describes the payload as slices pointing into the packet instead of copying it. Only the
+ * count is returned when the slices are NULL, otherwise the count is the capacity of the slices on the way in. Filling may
+ * rewrite header bytes of the packet in place, so a packet is sliced once.
+ */
+typedef STATUS (*DepayRtpPayloadSlicesFunc)(PBYTE, UINT32, PRtcFrameSlice, PUINT32);
 
 /*
  *  0                   1                   2                   3
@@ -122,10 +142,59 @@ STATUS rtp_packet_free(PRtpPacket*);
  */
 STATUS rtp_packet_createFromBytes(PBYTE, UINT32, PRtpPacket*);
 STATUS rtp_packet_constructRetransmitPacketFromBytes(PBYTE, UINT32, UINT16, UINT8, UINT32, PRtpPacket*);
+/**
+ * @brief turn a serialized packet into its rtx packet without copying the payload. The packet must be preceded by
+ *        RTX_OSN_LENGTH bytes of headroom, the header is moved into them and the OSN takes its place in front of the payload.
+ *
+ * @param[in] pRtpPacket the packet parsed from its raw bytes, which are overwritten. The parsed fields stay valid.
+ * @param[in] sequenceNum the rtx sequence number.
+ * @param[in] payloadType the rtx payload type.
+ * @param[in] ssrc the rtx ssrc.
+ * @param[out] ppRtxPacket the rtx packet, RTX_OSN_LENGTH bytes before the raw bytes of pRtpPacket.
+ * @param[out] pRtxPacketLength the length of the rtx packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_packet_constructRetransmitPacketInPlace(PRtpPacket, UINT16, UINT8, UINT32, PBYTE*, PUINT32);
 STATUS rtp_packet_setPacketFromBytes(PBYTE, UINT32, PRtpPacket);
 STATUS rtp_packet_createBytesFromPacket(PRtpPacket, PBYTE, PUINT32);
 STATUS rtp_packet_setBytesFromPacket(PRtpPacket, PBYTE, UINT32);
 STATUS rtp_packet_constructPackets(PPayloadArray, UINT8, UINT16, UINT32, UINT32, PRtpPacket, UINT32);
+/**
+ * @brief append one element to a one-byte header extension block. The block is zero padded to 32-bit words.
+ *
+ * @param[in] pBuffer the extension block, excluding the 0xBEDE profile and length fields.
+ * @param[in] bufferLen the size of the extension block.
+ * @param[in, out] pFilledLen the length of the elements in the block, without padding. Round up to 32-bit words for the extension length.
+ * @param[in] id the extension id negotiated by a=extmap, 1 - 14.
+ * @param[in] pData the element data.
+ * @param[in] dataLen the element data length, 1 - 16.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_packet_appendOneByteExtension(PBYTE, UINT32, PUINT32, UINT8, PBYTE, UINT32);
+/**
+ * @brief find one element of the one-byte header extension of a packet.
+ *
+ * @param[in] pRtpPacket the rtp packet.
+ * @param[in] id the extension id negotiated by a=extmap.
+ * @param[out] ppData points into the extension payload of the packet.
+ * @param[out] pDataLen the element data length.
+ *
+ * @return STATUS_RTP_EXTENSION_NOT_FOUND if the packet does not carry the element
+ */
+STATUS rtp_packet_getOneByteExtension(PRtpPacket, UINT8, PBYTE*, PUINT32);
+/**
+ * @brief change the id of a one-byte header extension element in a serialized packet.
+ *
+ * @param[in] rawPacket the serialized rtp packet.
+ * @param[in] packetLength the length of the packet.
+ * @param[in] fromId the current extension id.
+ * @param[in] toId the new extension id.
+ *
+ * @return STATUS_RTP_EXTENSION_NOT_FOUND if the packet does not carry the element
+ */
+STATUS rtp_packet_rewriteOneByteExtensionId(PBYTE, UINT32, UINT8, UINT8);
 
 #ifdef __cplusplus
 }
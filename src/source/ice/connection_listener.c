@@ -40,6 +40,7 @@ STATUS connection_listener_create(PConnectionListener* ppConnectionListener)
 
     ATOMIC_STORE_BOOL(&pConnectionListener->terminate, FALSE);
     pConnectionListener->receiveDataRoutine = INVALID_TID_VALUE;
+    pConnectionListener->receiveDataCpu = THREAD_ANY_CPU;
     pConnectionListener->lock = MUTEX_CREATE(FALSE);
 
     // No sockets are present
@@ -230,8 +231,13 @@ STATUS connection_listener_start(PConnectionListener pConnectionListener)
     locked = TRUE;
 
     CHK(!IS_VALID_TID_VALUE(pConnectionListener->receiveDataRoutine), retStatus);
-    CHK_STATUS(THREAD_CREATE_EX(&pConnectionListener->receiveDataRoutine, CONN_LISTENER_THREAD_NAME, CONN_LISTENER_THREAD_SIZE, FALSE,
-                                connection_listener_receiveRoutine, (PVOID) pConnectionListener));
+    if (pConnectionListener->receiveDataCpu == THREAD_ANY_CPU) {
+        CHK_STATUS(THREAD_CREATE_EX(&pConnectionListener->receiveDataRoutine, CONN_LISTENER_THREAD_NAME, CONN_LISTENER_THREAD_SIZE, FALSE,
+                                    connection_listener_receiveRoutine, (PVOID) pConnectionListener));
+    } else {
+        CHK_STATUS(THREAD_CREATE_EX_AFFINITY(&pConnectionListener->receiveDataRoutine, CONN_LISTENER_THREAD_NAME, CONN_LISTENER_THREAD_SIZE, FALSE,
+                                             pConnectionListener->receiveDataCpu, connection_listener_receiveRoutine, (PVOID) pConnectionListener));
+    }
 
 CleanUp:
 
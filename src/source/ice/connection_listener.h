@@ -39,6 +39,8 @@ typedef struct {
     UINT64 socketCount;
     MUTEX lock;
     TID receiveDataRoutine;
+    // the cpu the receiving thread is pinned to, THREAD_ANY_CPU unless set before the listener is started
+    INT32 receiveDataCpu;
     PBYTE pBuffer;
     UINT64 bufferLen;
 } ConnectionListener, *PConnectionListener;
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "SrtpPipeline"
+
+#include "srtp_pipeline.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief deliver the decrypted slots at the head of the ring, with the lock held. The lock is released around the callback,
+ *        the thread which delivers keeps going for the slots decrypted meanwhile by the other workers.
+ */
+static VOID srtp_pipeline_deliver(PSrtpPipeline pSrtpPipeline)
+{
+    SrtpPipelineSlot slot;
+    PSrtpPipelineSlot pSlot;
+    UINT32 mask = pSrtpPipeline->depth - 1;
+
+    if (pSrtpPipeline->delivering) {
+        return;
+    }
+    pSrtpPipeline->delivering = TRUE;
+
+    while (!pSrtpPipeline->shutdown && pSrtpPipeline->head != pSrtpPipeline->tail && pSrtpPipeline->slots[pSrtpPipeline->head & mask].decrypted) {
+        pSlot = &pSrtpPipeline->slots[pSrtpPipeline->head & mask];
+        slot = *pSlot;
+        MEMSET(pSlot, 0x00, SIZEOF(SrtpPipelineSlot));
+        pSrtpPipeline->head++;
+        CVAR_SIGNAL(pSrtpPipeline->slotFreed);
+
+        MUTEX_UNLOCK(pSrtpPipeline->lock);
+        CHK_LOG_ERR(pSrtpPipeline->deliverFn(pSrtpPipeline->customData, slot.pPacket, slot.packetLen, slot.receivedTime, slot.decryptStatus));
+        MUTEX_LOCK(pSrtpPipeline->lock);
+    }
+
+    pSrtpPipeline->delivering = FALSE;
+}
+
+static PVOID srtp_pipeline_workerRoutine(PVOID pArgs)
+{
+    PSrtpPipelineWorker pWorker = (PSrtpPipelineWorker) pArgs;
+    PSrtpPipeline pSrtpPipeline = pWorker->pSrtpPipeline;
+    PSrtpPipelineSlot pSlot;
+    UINT32 mask = pSrtpPipeline->depth - 1;
+    INT32 packetLen;
+    STATUS decryptStatus;
+
+    MUTEX_LOCK(pSrtpPipeline->lock);
+    while (!pSrtpPipeline->shutdown) {
+        if (pWorker->pendingHead == pWorker->pendingTail) {
+            CVAR_WAIT(pWorker->notify, pSrtpPipeline->lock, INFINITE_TIME_VALUE);
+            continue;
+        }
+        // the slot is left alone by the other threads until it is marked decrypted
+        pSlot = &pSrtpPipeline->slots[pWorker->pendingIndexes[pWorker->pendingHead++ & mask] & mask];
+        packetLen = (INT32) pSlot->packetLen;
+        MUTEX_UNLOCK(pSrtpPipeline->lock);
+
+        decryptStatus = srtp_session_decryptSrtpPacketOnShard(pSrtpPipeline->pSrtpSession, pWorker->index, pSlot->pPacket, &packetLen);
+
+        MUTEX_LOCK(pSrtpPipeline->lock);
+        pSlot->decryptStatus = decryptStatus;
+        if (STATUS_SUCCEEDED(decryptStatus)) {
+            pSlot->packetLen = (UINT32) packetLen;
+        }
+        pSlot->decrypted = TRUE;
+        srtp_pipeline_deliver(pSrtpPipeline);
+    }
+    MUTEX_UNLOCK(pSrtpPipeline->lock);
+
+    return NULL;
+}
+
+STATUS srtp_pipeline_create(PSrtpSession pSrtpSession, UINT32 workerCount, UINT32 depth, SrtpPipelineDeliverFunc deliverFn, UINT64 customData,
+                            PSrtpPipeline* ppSrtpPipeline)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PSrtpPipeline pSrtpPipeline = NULL;
+    PSrtpPipelineWorker pWorker;
+    UINT32 i, roundedDepth = 1;
+
+    CHK(pSrtpSession != NULL && deliverFn != NULL && ppSrtpPipeline != NULL, STATUS_NULL_ARG);
+    CHK(workerCount > 0 && workerCount <= SRTP_PIPELINE_MAX_WORKERS && workerCount <= pSrtpSession->receiveShardCount, STATUS_INVALID_ARG);
+    CHK(depth > 0 && depth <= MAX_UINT32 / 2, STATUS_INVALID_ARG);
+
+    while (roundedDepth < depth) {
+        roundedDepth <<= 1;
+    }
+
+    CHK(NULL != (pSrtpPipeline = (PSrtpPipeline) MEMCALLOC(1, SIZEOF(SrtpPipeline))), STATUS_NOT_ENOUGH_MEMORY);
+    pSrtpPipeline->pSrtpSession = pSrtpSession;
+    pSrtpPipeline->depth = roundedDepth;
+    pSrtpPipeline->deliverFn = deliverFn;
+    pSrtpPipeline->customData = customData;
+    pSrtpPipeline->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pSrtpPipeline->lock), STATUS_INVALID_OPERATION);
+    pSrtpPipeline->slotFreed = CVAR_CREATE();
+    CHK(IS_VALID_CVAR_VALUE(pSrtpPipeline->slotFreed), STATUS_INVALID_OPERATION);
+    CHK(NULL != (pSrtpPipeline->slots = (PSrtpPipelineSlot) MEMCALLOC(roundedDepth, SIZEOF(SrtpPipelineSlot))), STATUS_NOT_ENOUGH_MEMORY);
+    CHK(NULL != (pSrtpPipeline->workers = (PSrtpPipelineWorker) MEMCALLOC(workerCount, SIZEOF(SrtpPipelineWorker))), STATUS_NOT_ENOUGH_MEMORY);
+    pSrtpPipeline->workerCount = workerCount;
+
+    for (i = 0; i < workerCount; i++) {
+        pWorker = &pSrtpPipeline->workers[i];
+        pWorker->pSrtpPipeline = pSrtpPipeline;
+        pWorker->index = i;
+        pWorker->notify = CVAR_CREATE();
+        CHK(IS_VALID_CVAR_VALUE(pWorker->notify), STATUS_INVALID_OPERATION);
+        CHK(NULL != (pWorker->pendingIndexes = (PUINT64) MEMCALLOC(roundedDepth, SIZEOF(UINT64))), STATUS_NOT_ENOUGH_MEMORY);
+    }
+
+    for (i = 0; i < workerCount; i++) {
+        pWorker = &pSrtpPipeline->workers[i];
+        CHK_STATUS(THREAD_CREATE_EX(&pWorker->threadId, SRTP_DECRYPT_THREAD_NAME, SRTP_DECRYPT_THREAD_SIZE, TRUE, srtp_pipeline_workerRoutine,
+                                    (PVOID) pWorker));
+    }
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        srtp_pipeline_free(&pSrtpPipeline);
+    }
+    if (ppSrtpPipeline != NULL) {
+        *ppSrtpPipeline = pSrtpPipeline;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS srtp_pipeline_free(PSrtpPipeline* ppSrtpPipeline)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PSrtpPipeline pSrtpPipeline;
+    UINT64 index;
+    UINT32 i;
+
+    CHK(ppSrtpPipeline != NULL, STATUS_NULL_ARG);
+    CHK(*ppSrtpPipeline != NULL, retStatus);
+    pSrtpPipeline = *ppSrtpPipeline;
+
+    if (IS_VALID_MUTEX_VALUE(pSrtpPipeline->lock)) {
+        MUTEX_LOCK(pSrtpPipeline->lock);
+        pSrtpPipeline->shutdown = TRUE;
+        for (i = 0; i < pSrtpPipeline->workerCount; i++) {
+            if (IS_VALID_CVAR_VALUE(pSrtpPipeline->workers[i].notify)) {
+                CVAR_BROADCAST(pSrtpPipeline->workers[i].notify);
+            }
+        }
+        if (IS_VALID_CVAR_VALUE(pSrtpPipeline->slotFreed)) {
+            CVAR_BROADCAST(pSrtpPipeline->slotFreed);
+        }
+        MUTEX_UNLOCK(pSrtpPipeline->lock);
+    }
+
+    for (i = 0; i < pSrtpPipeline->workerCount; i++) {
+        if (IS_VALID_TID_VALUE(pSrtpPipeline->workers[i].threadId)) {
+            THREAD_JOIN(pSrtpPipeline->workers[i].threadId, NULL);
+        }
+    }
+
+    // the packets which were not delivered
+    if (pSrtpPipeline->slots != NULL) {
+        for (index = pSrtpPipeline->head; index != pSrtpPipeline->tail; index++) {
+            SAFE_MEMFREE(pSrtpPipeline->slots[index & (pSrtpPipeline->depth - 1)].pPacket);
+        }
+    }
+
+    for (i = 0; i < pSrtpPipeline->workerCount; i++) {
+        if (IS_VALID_CVAR_VALUE(pSrtpPipeline->workers[i].notify)) {
+            CVAR_FREE(pSrtpPipeline->workers[i].notify);
+        }
+        SAFE_MEMFREE(pSrtpPipeline->workers[i].pendingIndexes);
+    }
+    SAFE_MEMFREE(pSrtpPipeline->workers);
+    SAFE_MEMFREE(pSrtpPipeline->slots);
+    if (IS_VALID_CVAR_VALUE(pSrtpPipeline->slotFreed)) {
+        CVAR_FREE(pSrtpPipeline->slotFreed);
+    }
+    if (IS_VALID_MUTEX_VALUE(pSrtpPipeline->lock)) {
+        MUTEX_FREE(pSrtpPipeline->lock);
+    }
+    SAFE_MEMFREE(*ppSrtpPipeline);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+STATUS srtp_pipeline_submit(PSrtpPipeline pSrtpPipeline, UINT16 sequenceNumber, PBYTE pPacket, UINT32 packetLen, UINT64 receivedTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PSrtpPipelineSlot pSlot;
+    PSrtpPipelineWorker pWorker;
+    UINT32 mask;
+    BOOL locked = FALSE;
+
+    CHK(pSrtpPipeline != NULL && pPacket != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pSrtpPipeline->lock);
+    locked = TRUE;
+
+    while (!pSrtpPipeline->shutdown && pSrtpPipeline->tail - pSrtpPipeline->head >= pSrtpPipeline->depth) {
+        CVAR_WAIT(pSrtpPipeline->slotFreed, pSrtpPipeline->lock, INFINITE_TIME_VALUE);
+    }
+    CHK(!pSrtpPipeline->shutdown, STATUS_INVALID_OPERATION);
+
+    mask = pSrtpPipeline->depth - 1;
+    pSlot = &pSrtpPipeline->slots[pSrtpPipeline->tail & mask];
+    pSlot->pPacket = pPacket;
+    pSlot->packetLen = packetLen;
+    pSlot->receivedTime = receivedTime;
+    pSlot->decrypted = FALSE;
+    pPacket = NULL;
+
+    pWorker = &pSrtpPipeline->workers[sequenceNumber % pSrtpPipeline->workerCount];
+    pWorker->pendingIndexes[pWorker->pendingTail++ & mask] = pSrtpPipeline->tail++;
+    CVAR_SIGNAL(pWorker->notify);
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pSrtpPipeline->lock);
+    }
+    SAFE_MEMFREE(pPacket);
+    return retStatus;
+}
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_SRTP_PIPELINE__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_SRTP_PIPELINE__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "srtp_session.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+#if defined(ENABLE_STREAMING)
+// the packets between the listener and the delivery, a 4K stream has about that many packets in flight for a frame
+#define SRTP_PIPELINE_DEFAULT_DEPTH 256
+#define SRTP_PIPELINE_MAX_WORKERS   16
+
+/**
+ * @brief takes a packet back from the pipeline, in the order the packets were submitted.
+ *
+ * @param[in] customData the custom data given to srtp_pipeline_create.
+ * @param[in] pPacket the packet, decrypted in place unless decryptStatus failed. The callee owns it and frees it with MEMFREE.
+ * @param[in] packetLen the length of the packet.
+ * @param[in] receivedTime the time given to srtp_pipeline_submit.
+ * @param[in] decryptStatus the status of the decryption.
+ */
+typedef STATUS (*SrtpPipelineDeliverFunc)(UINT64, PBYTE, UINT32, UINT64, STATUS);
+
+typedef struct {
+    PBYTE pPacket;
+    UINT32 packetLen;
+    UINT64 receivedTime;
+    STATUS decryptStatus;
+    BOOL decrypted;
+} SrtpPipelineSlot, *PSrtpPipelineSlot;
+
+struct __SrtpPipeline;
+
+typedef struct {
+    struct __SrtpPipeline* pSrtpPipeline;
+    // the worker decrypts with the receive shard of the same index
+    UINT32 index;
+    TID threadId;
+    CVAR notify;
+    // the arrival indexes of the packets given to the worker, a ring of depth entries
+    PUINT64 pendingIndexes;
+    UINT64 pendingHead;
+    UINT64 pendingTail;
+} SrtpPipelineWorker, *PSrtpPipelineWorker;
+
+/**
+ * Decrypts the srtp packets of the listener on worker threads. A packet goes to the worker given by its sequence number, so
+ * the replay window of every receive shard stays consistent and a duplicate meets the shard which saw the original. Every
+ * packet gets an arrival index and takes the slot of the index in a ring, the packets are delivered from the ring in the
+ * order of the indexes by one thread at a time, which keeps the receive path behind the delivery single threaded.
+ */
+typedef struct __SrtpPipeline {
+    PSrtpSession pSrtpSession;
+    MUTEX lock;
+    // signaled when a slot is delivered, the listener waits for it when the ring is full
+    CVAR slotFreed;
+    BOOL shutdown;
+    // a thread delivers the slots, the other workers leave their decrypted slots to it
+    BOOL delivering;
+    // power of 2
+    UINT32 depth;
+    // the arrival index of the next slot to deliver
+    UINT64 head;
+    // the arrival index of the next submitted packet
+    UINT64 tail;
+    PSrtpPipelineSlot slots;
+    UINT32 workerCount;
+    PSrtpPipelineWorker workers;
+    SrtpPipelineDeliverFunc deliverFn;
+    UINT64 customData;
+} SrtpPipeline, *PSrtpPipeline;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief create the pipeline and start its workers.
+ *
+ * @param[in] pSrtpSession the session, with a receive shard for every worker.
+ * @param[in] workerCount the number of worker threads.
+ * @param[in] depth the packets in flight, rounded up to a power of 2.
+ * @param[in] deliverFn the callback taking back the packets.
+ * @param[in] customData the custom data of the callback.
+ * @param[out] ppSrtpPipeline the created pipeline.
+ *
+ * @return STATUS status of execution
+ */
+STATUS srtp_pipeline_create(PSrtpSession, UINT32, UINT32, SrtpPipelineDeliverFunc, UINT64, PSrtpPipeline*);
+/**
+ * @brief stop the workers and drop the packets which were not delivered yet.
+ */
+STATUS srtp_pipeline_free(PSrtpPipeline*);
+/**
+ * @brief hand a packet to the pipeline, which owns it from now on, also when the call fails. Waits for a slot when the
+ *        pipeline is full.
+ *
+ * @param[in] pSrtpPipeline the pipeline.
+ * @param[in] sequenceNumber the rtp sequence number of the packet, which picks the worker.
+ * @param[in] pPacket the encrypted packet, allocated with MEMALLOC.
+ * @param[in] packetLen the length of the packet.
+ * @param[in] receivedTime the time the packet was received at.
+ *
+ * @return STATUS status of execution
+ */
+STATUS srtp_pipeline_submit(PSrtpPipeline, UINT16, PBYTE, UINT32, UINT64);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif //__KINESIS_VIDEO_WEBRTC_CLIENT_SRTP_PIPELINE__
@@ -27,6 +27,12 @@
  * FUNCTIONS
  ******************************************************************************/
 STATUS srtp_session_init(PBYTE receiveKey, PBYTE transmitKey, KVS_SRTP_PROFILE profile, PSrtpSession* ppSrtpSession)
+{
+    return srtp_session_initWithReceiveShards(receiveKey, transmitKey, profile, 0, ppSrtpSession);
+}
+
+STATUS srtp_session_initWithReceiveShards(PBYTE receiveKey, PBYTE transmitKey, KVS_SRTP_PROFILE profile, UINT32 receiveShardCount,
+                                          PSrtpSession* ppSrtpSession)
 {
     ENTERS();
     UNUSED_PARAM(profile);
@@ -35,6 +41,7 @@ STATUS srtp_session_init(PBYTE receiveKey, PBYTE transmitKey, KVS_SRTP_PROFILE p
     PSrtpSession pSrtpSession = NULL;
     srtp_policy_t transmitPolicy, receivePolicy;
     srtp_err_status_t errStatus;
+    UINT32 i;
     void (*srtp_policy_setter)(srtp_crypto_policy_t*) = NULL;
     void (*srtcp_policy_setter)(srtp_crypto_policy_t*) = NULL;
 
@@ -68,6 +75,15 @@ STATUS srtp_session_init(PBYTE receiveKey, PBYTE transmitKey, KVS_SRTP_PROFILE p
     CHK_ERR((errStatus = srtp_create(&(pSrtpSession->srtp_receive_session), &receivePolicy)) == srtp_err_status_ok,
             STATUS_SRTP_RECEIVE_SESSION_CREATION_FAILED, "Create srtp session for the receiver failed with error code %u", errStatus);
 
+    if (receiveShardCount > 0) {
+        CHK(NULL != (pSrtpSession->receiveShards = (srtp_t*) MEMCALLOC(receiveShardCount, SIZEOF(srtp_t))), STATUS_NOT_ENOUGH_MEMORY);
+        pSrtpSession->receiveShardCount = receiveShardCount;
+        for (i = 0; i < receiveShardCount; i++) {
+            CHK_ERR((errStatus = srtp_create(&(pSrtpSession->receiveShards[i]), &receivePolicy)) == srtp_err_status_ok,
+                    STATUS_SRTP_RECEIVE_SESSION_CREATION_FAILED, "Create srtp receive shard %u failed with error code %u", i, errStatus);
+        }
+    }
+
     srtp_policy_setter(&transmitPolicy.rtp);
     srtcp_policy_setter(&transmitPolicy.rtcp);
 
@@ -94,6 +110,7 @@ STATUS srtp_session_free(PSrtpSession* ppSrtpSession)
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     srtp_err_status_t errStatus;
+    UINT32 i;
 
     PSrtpSession pSrtpSession = NULL;
 
@@ -108,6 +125,12 @@ STATUS srtp_session_free(PSrtpSession* ppSrtpSession)
     if ((pSrtpSession->srtp_receive_session != NULL) && (errStatus = srtp_dealloc(pSrtpSession->srtp_receive_session)) != srtp_err_status_ok) {
         DLOGW("Dealloc of receive session failed with error code %d\n", errStatus);
     }
+    for (i = 0; i < pSrtpSession->receiveShardCount; i++) {
+        if ((pSrtpSession->receiveShards[i] != NULL) && (errStatus = srtp_dealloc(pSrtpSession->receiveShards[i])) != srtp_err_status_ok) {
+            DLOGW("Dealloc of receive shard %u failed with error code %d\n", i, errStatus);
+        }
+    }
+    SAFE_MEMFREE(pSrtpSession->receiveShards);
 
     SAFE_MEMFREE(pSrtpSession);
     *ppSrtpSession = NULL;
@@ -132,6 +155,20 @@ CleanUp:
     return retStatus;
 }
 
+STATUS srtp_session_decryptSrtpPacketOnShard(PSrtpSession pSrtpSession, UINT32 shard, PVOID encryptedMessage, PINT32 len)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    srtp_err_status_t errStatus;
+
+    CHK(pSrtpSession != NULL, STATUS_NULL_ARG);
+    CHK(shard < pSrtpSession->receiveShardCount, STATUS_INVALID_ARG);
+    CHK_ERR((errStatus = srtp_unprotect(pSrtpSession->receiveShards[shard], encryptedMessage, len)) == srtp_err_status_ok,
+            STATUS_SRTP_DECRYPT_FAILED, "Decrypting rtp packet failed with error code %u on receive shard %u", errStatus, shard);
+
+CleanUp:
+    return retStatus;
+}
+
 STATUS srtp_session_decryptSrtcpPacket(PSrtpSession pSrtpSession, PVOID encryptedMessage, PINT32 len)
 {
     ENTERS();
@@ -44,6 +44,10 @@ typedef struct __SrtpSession {
     srtp_t srtp_transmit_session;
     // holds the srtp context for receive  operations
     srtp_t srtp_receive_session;
+    // more srtp contexts for receive operations, made from the same key, one for each decrypt worker. A context is not
+    // shared between threads, and the replay window of each one sees the sequence numbers given to its worker.
+    UINT32 receiveShardCount;
+    srtp_t* receiveShards;
 } SrtpSession, *PSrtpSession;
 
 /******************************************************************************
@@ -60,8 +64,18 @@ typedef struct __SrtpSession {
  * @return STATUS status of execution.
  */
 STATUS srtp_session_init(PBYTE receiveKey, PBYTE transmitKey, KVS_SRTP_PROFILE profile, PSrtpSession* ppSrtpSession);
+/**
+ * @brief srtp_session_init with receiveShardCount more receive contexts, see srtp_session_decryptSrtpPacketOnShard.
+ */
+STATUS srtp_session_initWithReceiveShards(PBYTE receiveKey, PBYTE transmitKey, KVS_SRTP_PROFILE profile, UINT32 receiveShardCount,
+                                          PSrtpSession* ppSrtpSession);
 
 STATUS srtp_session_decryptSrtpPacket(PSrtpSession pSrtpSession, PVOID encryptedMessage, PINT32 len);
+/**
+ * @brief decrypt a rtp packet with one of the receive shards. The shards can be used by different threads at the same time,
+ *        a packet and its duplicates have to go to the same shard for the replay protection.
+ */
+STATUS srtp_session_decryptSrtpPacketOnShard(PSrtpSession pSrtpSession, UINT32 shard, PVOID encryptedMessage, PINT32 len);
 STATUS srtp_session_decryptSrtcpPacket(PSrtpSession pSrtpSession, PVOID encryptedMessage, PINT32 len);
 
 STATUS srtp_session_encryptRtpPacket(PSrtpSession pSrtpSession, PVOID message, PINT32 len);
@@ -70,6 +70,11 @@ static inline SIZE_T defaultAtomicXor(volatile SIZE_T* pAtomic, SIZE_T var)
     return __atomic_fetch_xor(pAtomic, var, __ATOMIC_SEQ_CST);
 }
 
+static inline VOID defaultAtomicFenceAcquire(VOID)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
 #ifdef __cplusplus
 }
 #endif
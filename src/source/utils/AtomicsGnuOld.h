@@ -108,6 +108,11 @@ static inline SIZE_T defaultAtomicXor(volatile SIZE_T* pAtomic, SIZE_T var)
     return __sync_fetch_and_xor(pAtomic, var);
 }
 
+static inline VOID defaultAtomicFenceAcquire(VOID)
+{
+    atomicFullBarrier();
+}
+
 #ifdef __cplusplus
 }
 #endif
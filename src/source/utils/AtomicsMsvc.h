@@ -83,6 +83,12 @@ static inline SIZE_T defaultAtomicXor(volatile SIZE_T* pAtomic, SIZE_T var)
     return INTERLOCKED_OP(Xor)(pAtomic, var);
 }
 
+static inline VOID defaultAtomicFenceAcquire(VOID)
+{
+    // x86 does not reorder loads with other loads, only the compiler has to be kept from it
+    _ReadWriteBarrier();
+}
+
 #ifdef __cplusplus
 }
 #endif
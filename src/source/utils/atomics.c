@@ -30,6 +30,7 @@ PUBLIC_API atomicSubtract globalAtomicSubtract = defaultAtomicSubtract;
 PUBLIC_API atomicAnd globalAtomicAnd = defaultAtomicAnd;
 PUBLIC_API atomicOr globalAtomicOr = defaultAtomicOr;
 PUBLIC_API atomicXor globalAtomicXor = defaultAtomicXor;
+PUBLIC_API atomicFenceAcquire globalAtomicFenceAcquire = defaultAtomicFenceAcquire;
 
 #ifdef __cplusplus
 }
@@ -38,6 +38,7 @@ typedef SIZE_T (*atomicSubtract)(volatile SIZE_T*, SIZE_T);
 typedef SIZE_T (*atomicAnd)(volatile SIZE_T*, SIZE_T);
 typedef SIZE_T (*atomicOr)(volatile SIZE_T*, SIZE_T);
 typedef SIZE_T (*atomicXor)(volatile SIZE_T*, SIZE_T);
+typedef VOID (*atomicFenceAcquire)(VOID);
 //
 // Atomics
 //
@@ -52,6 +53,7 @@ extern PUBLIC_API atomicSubtract globalAtomicSubtract;
 extern PUBLIC_API atomicAnd globalAtomicAnd;
 extern PUBLIC_API atomicOr globalAtomicOr;
 extern PUBLIC_API atomicXor globalAtomicXor;
+extern PUBLIC_API atomicFenceAcquire globalAtomicFenceAcquire;
 //
 // Basic Atomics functionality
 //
@@ -66,6 +68,7 @@ extern PUBLIC_API atomicXor globalAtomicXor;
 #define ATOMIC_AND              globalAtomicAnd
 #define ATOMIC_OR               globalAtomicOr
 #define ATOMIC_XOR              globalAtomicXor
+#define ATOMIC_FENCE_ACQUIRE    globalAtomicFenceAcquire
 //
 // Helper atomics
 //
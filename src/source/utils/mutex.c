@@ -19,6 +19,10 @@
 
 #if defined _WIN32 || defined _WIN64 || defined __CYGWIN__
 
+#ifdef ENABLE_LOCK_PROFILING
+#error "lock profiling is only supported with pthreads"
+#endif
+
 //
 // Stub Mutex library functions
 //
@@ -185,6 +189,45 @@ CleanUp:
 pthread_mutex_t globalKvsReentrantMutex = GLOBAL_MUTEX_INIT_RECURSIVE;
 pthread_mutex_t globalKvsNonReentrantMutex = GLOBAL_MUTEX_INIT;
 
+#ifdef ENABLE_LOCK_PROFILING
+#define MUTEX_PROFILE_ENTRY_FREE    0
+#define MUTEX_PROFILE_ENTRY_FILLING 1
+#define MUTEX_PROFILE_ENTRY_READY   2
+
+typedef struct {
+    volatile SIZE_T state;
+    // the site is keyed by the address of the file name, set once before the state is ready
+    PCHAR file;
+    UINT32 line;
+    volatile SIZE_T acquisitionCount;
+    volatile SIZE_T contendedCount;
+    volatile SIZE_T totalWaitTime;
+    volatile SIZE_T maxHoldTime;
+} MutexProfileEntry, *PMutexProfileEntry;
+
+#define MUTEX_PROFILE_HOLD_FREE    ((SIZE_T) 0)
+#define MUTEX_PROFILE_HOLD_REMOVED ((SIZE_T) 1)
+
+/**
+ * The hold time of a mutex allocated by defaultCreateMutex. It is kept apart from the mutex, keyed by the handle, so a
+ * mutex of another create function is never written to.
+ */
+typedef struct {
+    // the handle, MUTEX_PROFILE_HOLD_FREE for a slot never used and MUTEX_PROFILE_HOLD_REMOVED for a freed one
+    volatile SIZE_T mutex;
+    // only used by the thread which holds the mutex
+    PMutexProfileEntry pHoldEntry;
+    UINT64 holdStartTime;
+    UINT32 holdDepth;
+} MutexProfileHold, *PMutexProfileHold;
+
+static MutexProfileEntry gMutexProfileEntries[MUTEX_PROFILE_MAX_SITE_COUNT];
+static MutexProfileHold gMutexProfileHolds[MUTEX_PROFILE_MAX_MUTEX_COUNT];
+
+static VOID priv_mutex_profile_addHold(MUTEX);
+static VOID priv_mutex_profile_removeHold(MUTEX);
+#endif
+
 MUTEX defaultCreateMutex(BOOL reentrant)
 {
     pthread_mutex_t* pMutex;
@@ -204,6 +247,10 @@ MUTEX defaultCreateMutex(BOOL reentrant)
         return (MUTEX)(reentrant ? &globalKvsReentrantMutex : &globalKvsNonReentrantMutex);
     }
 
+#ifdef ENABLE_LOCK_PROFILING
+    priv_mutex_profile_addHold((MUTEX) pMutex);
+#endif
+
     return (MUTEX) pMutex;
 }
 
@@ -239,6 +286,9 @@ VOID defaultFreeMutex(MUTEX mutex)
 
     // De-allocate the memory if it's not a well-known mutex - aka if we had allocated it previously
     if (pMutex != &globalKvsReentrantMutex && pMutex != &globalKvsNonReentrantMutex) {
+#ifdef ENABLE_LOCK_PROFILING
+        priv_mutex_profile_removeHold(mutex);
+#endif
         MEMFREE(pMutex);
     }
 }
@@ -328,6 +378,273 @@ CleanUp:
     return retStatus;
 }
 
+#ifdef ENABLE_LOCK_PROFILING
+static UINT32 priv_mutex_profile_getHoldIndex(MUTEX mutex)
+{
+    return (UINT32)(((SIZE_T) mutex >> 3) % MUTEX_PROFILE_MAX_MUTEX_COUNT);
+}
+
+/**
+ * @brief start measuring the hold times of a mutex allocated by defaultCreateMutex. The mutexes past
+ *        MUTEX_PROFILE_MAX_MUTEX_COUNT are not measured.
+ */
+static VOID priv_mutex_profile_addHold(MUTEX mutex)
+{
+    PMutexProfileHold pHold;
+    SIZE_T key;
+    UINT32 i, index = priv_mutex_profile_getHoldIndex(mutex);
+
+    for (i = 0; i < MUTEX_PROFILE_MAX_MUTEX_COUNT; i++) {
+        pHold = &gMutexProfileHolds[(index + i) % MUTEX_PROFILE_MAX_MUTEX_COUNT];
+        key = ATOMIC_LOAD(&pHold->mutex);
+        if ((key == MUTEX_PROFILE_HOLD_FREE || key == MUTEX_PROFILE_HOLD_REMOVED) && ATOMIC_COMPARE_EXCHANGE(&pHold->mutex, &key, (SIZE_T) mutex)) {
+            // nobody else has the handle yet
+            pHold->pHoldEntry = NULL;
+            pHold->holdStartTime = 0;
+            pHold->holdDepth = 0;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief the hold time of a mutex allocated by defaultCreateMutex, NULL for any other mutex, the fallback ones included.
+ */
+static PMutexProfileHold priv_mutex_profile_getHold(MUTEX mutex)
+{
+    PMutexProfileHold pHold;
+    SIZE_T key;
+    UINT32 i, index = priv_mutex_profile_getHoldIndex(mutex);
+
+    for (i = 0; i < MUTEX_PROFILE_MAX_MUTEX_COUNT; i++) {
+        pHold = &gMutexProfileHolds[(index + i) % MUTEX_PROFILE_MAX_MUTEX_COUNT];
+        key = ATOMIC_LOAD(&pHold->mutex);
+        if (key == (SIZE_T) mutex) {
+            return pHold;
+        } else if (key == MUTEX_PROFILE_HOLD_FREE) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static VOID priv_mutex_profile_removeHold(MUTEX mutex)
+{
+    PMutexProfileHold pHold = priv_mutex_profile_getHold(mutex);
+
+    // the slot stays in the probe sequence of the handles added after it
+    if (pHold != NULL) {
+        ATOMIC_STORE(&pHold->mutex, MUTEX_PROFILE_HOLD_REMOVED);
+    }
+}
+
+/**
+ * @brief the entry of a lock site, added the first time the site takes a mutex. NULL when the table is full.
+ */
+static PMutexProfileEntry priv_mutex_profile_getEntry(PCHAR file, UINT32 line)
+{
+    PMutexProfileEntry pEntry;
+    SIZE_T state;
+    UINT32 i, index = (UINT32)((((SIZE_T) file >> 3) * 31 + line) % MUTEX_PROFILE_MAX_SITE_COUNT);
+
+    for (i = 0; i < MUTEX_PROFILE_MAX_SITE_COUNT; i++) {
+        pEntry = &gMutexProfileEntries[(index + i) % MUTEX_PROFILE_MAX_SITE_COUNT];
+        state = ATOMIC_LOAD(&pEntry->state);
+        if (state == MUTEX_PROFILE_ENTRY_FREE && ATOMIC_COMPARE_EXCHANGE(&pEntry->state, &state, MUTEX_PROFILE_ENTRY_FILLING)) {
+            pEntry->file = file;
+            pEntry->line = line;
+            ATOMIC_STORE(&pEntry->state, MUTEX_PROFILE_ENTRY_READY);
+            return pEntry;
+        }
+
+        // another thread is adding a site here, which may be this one
+        while (state == MUTEX_PROFILE_ENTRY_FILLING) {
+            state = ATOMIC_LOAD(&pEntry->state);
+        }
+        if (pEntry->file == file && pEntry->line == line) {
+            return pEntry;
+        }
+    }
+
+    return NULL;
+}
+
+static VOID priv_mutex_profile_updateHoldTime(PMutexProfileEntry pEntry, UINT64 holdTime)
+{
+    SIZE_T maxHoldTime = ATOMIC_LOAD(&pEntry->maxHoldTime);
+
+    while ((SIZE_T) holdTime > maxHoldTime && !ATOMIC_COMPARE_EXCHANGE(&pEntry->maxHoldTime, &maxHoldTime, (SIZE_T) holdTime)) {
+        // maxHoldTime is reloaded by the failed exchange
+    }
+}
+
+static VOID priv_mutex_profile_onAcquired(MUTEX mutex, PCHAR file, UINT32 line, BOOL contended, UINT64 waitTime)
+{
+    PMutexProfileEntry pEntry = priv_mutex_profile_getEntry(file, line);
+    PMutexProfileHold pHold = priv_mutex_profile_getHold(mutex);
+
+    if (pEntry != NULL) {
+        ATOMIC_INCREMENT(&pEntry->acquisitionCount);
+        if (contended) {
+            ATOMIC_INCREMENT(&pEntry->contendedCount);
+            ATOMIC_ADD(&pEntry->totalWaitTime, (SIZE_T) waitTime);
+        }
+    }
+
+    // a reentrant mutex is held from the outermost lock to the outermost unlock
+    if (pHold != NULL && pHold->holdDepth++ == 0) {
+        pHold->pHoldEntry = pEntry;
+        pHold->holdStartTime = GETTIME();
+    }
+}
+
+VOID mutex_profile_lock(MUTEX mutex, PCHAR file, UINT32 line)
+{
+    UINT64 startTime;
+
+    if (globalTryLockMutex(mutex)) {
+        priv_mutex_profile_onAcquired(mutex, file, line, FALSE, 0);
+    } else {
+        startTime = GETTIME();
+        globalLockMutex(mutex);
+        priv_mutex_profile_onAcquired(mutex, file, line, TRUE, GETTIME() - startTime);
+    }
+}
+
+VOID mutex_profile_unlock(MUTEX mutex)
+{
+    PMutexProfileHold pHold = priv_mutex_profile_getHold(mutex);
+
+    if (pHold != NULL && pHold->holdDepth > 0 && --pHold->holdDepth == 0 && pHold->pHoldEntry != NULL) {
+        priv_mutex_profile_updateHoldTime(pHold->pHoldEntry, GETTIME() - pHold->holdStartTime);
+    }
+
+    globalUnlockMutex(mutex);
+}
+
+BOOL mutex_profile_tryLock(MUTEX mutex, PCHAR file, UINT32 line)
+{
+    if (!globalTryLockMutex(mutex)) {
+        return FALSE;
+    }
+
+    priv_mutex_profile_onAcquired(mutex, file, line, FALSE, 0);
+    return TRUE;
+}
+
+BOOL mutex_profile_waitLock(MUTEX mutex, UINT64 timeout, PCHAR file, UINT32 line)
+{
+    UINT64 startTime;
+
+    if (globalTryLockMutex(mutex)) {
+        priv_mutex_profile_onAcquired(mutex, file, line, FALSE, 0);
+        return TRUE;
+    }
+
+    startTime = GETTIME();
+    if (!globalWaitLockMutex(mutex, timeout)) {
+        return FALSE;
+    }
+
+    priv_mutex_profile_onAcquired(mutex, file, line, TRUE, GETTIME() - startTime);
+    return TRUE;
+}
+
+STATUS mutex_profile_wait(CVAR cvar, MUTEX mutex, UINT64 timeout)
+{
+    STATUS retStatus;
+    PMutexProfileHold pHold = priv_mutex_profile_getHold(mutex);
+    PMutexProfileEntry pHoldEntry = NULL;
+    UINT32 holdDepth = 0;
+
+    // the mutex is released while waiting, the hold ends here and starts again once the wait returns
+    if (pHold != NULL) {
+        pHoldEntry = pHold->pHoldEntry;
+        holdDepth = pHold->holdDepth;
+        if (holdDepth > 0 && pHoldEntry != NULL) {
+            priv_mutex_profile_updateHoldTime(pHoldEntry, GETTIME() - pHold->holdStartTime);
+        }
+        pHold->holdDepth = 0;
+    }
+
+    retStatus = globalConditionVariableWait(cvar, mutex, timeout);
+
+    if (pHold != NULL) {
+        pHold->pHoldEntry = pHoldEntry;
+        pHold->holdDepth = holdDepth;
+        pHold->holdStartTime = GETTIME();
+    }
+
+    return retStatus;
+}
+
+STATUS mutex_profile_getSites(PMutexProfileSite pSites, PUINT32 pSiteCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PMutexProfileEntry pEntry;
+    UINT32 i, siteCount = 0;
+
+    CHK(pSiteCount != NULL, STATUS_NULL_ARG);
+
+    for (i = 0; i < MUTEX_PROFILE_MAX_SITE_COUNT; i++) {
+        pEntry = &gMutexProfileEntries[i];
+        if (ATOMIC_LOAD(&pEntry->state) != MUTEX_PROFILE_ENTRY_READY) {
+            continue;
+        }
+        if (pSites != NULL && siteCount < *pSiteCount) {
+            pSites[siteCount].file = pEntry->file;
+            pSites[siteCount].line = pEntry->line;
+            pSites[siteCount].acquisitionCount = ATOMIC_LOAD(&pEntry->acquisitionCount);
+            pSites[siteCount].contendedCount = ATOMIC_LOAD(&pEntry->contendedCount);
+            pSites[siteCount].totalWaitTime = ATOMIC_LOAD(&pEntry->totalWaitTime);
+            pSites[siteCount].maxHoldTime = ATOMIC_LOAD(&pEntry->maxHoldTime);
+        }
+        siteCount++;
+    }
+
+    CHK(pSites == NULL || siteCount <= *pSiteCount, STATUS_BUFFER_TOO_SMALL);
+
+CleanUp:
+    if (pSiteCount != NULL) {
+        *pSiteCount = siteCount;
+    }
+
+    return retStatus;
+}
+
+VOID mutex_profile_dump(VOID)
+{
+    PMutexProfileEntry pEntry;
+    UINT32 i;
+
+    for (i = 0; i < MUTEX_PROFILE_MAX_SITE_COUNT; i++) {
+        pEntry = &gMutexProfileEntries[i];
+        if (ATOMIC_LOAD(&pEntry->state) != MUTEX_PROFILE_ENTRY_READY || ATOMIC_LOAD(&pEntry->acquisitionCount) == 0) {
+            continue;
+        }
+        DLOGI("%s:%u acquired %" PRIu64 " contended %" PRIu64 " waited %" PRIu64 " us max hold %" PRIu64 " us", pEntry->file, pEntry->line,
+              (UINT64) ATOMIC_LOAD(&pEntry->acquisitionCount), (UINT64) ATOMIC_LOAD(&pEntry->contendedCount),
+              (UINT64) ATOMIC_LOAD(&pEntry->totalWaitTime) / HUNDREDS_OF_NANOS_IN_A_MICROSECOND,
+              (UINT64) ATOMIC_LOAD(&pEntry->maxHoldTime) / HUNDREDS_OF_NANOS_IN_A_MICROSECOND);
+    }
+}
+
+VOID mutex_profile_reset(VOID)
+{
+    PMutexProfileEntry pEntry;
+    UINT32 i;
+
+    for (i = 0; i < MUTEX_PROFILE_MAX_SITE_COUNT; i++) {
+        pEntry = &gMutexProfileEntries[i];
+        ATOMIC_STORE(&pEntry->acquisitionCount, 0);
+        ATOMIC_STORE(&pEntry->contendedCount, 0);
+        ATOMIC_STORE(&pEntry->totalWaitTime, 0);
+        ATOMIC_STORE(&pEntry->maxHoldTime, 0);
+    }
+}
+#endif
+
 #endif
 
 createMutex globalCreateMutex = defaultCreateMutex;
@@ -114,6 +114,75 @@ extern broadcastConditionVariable globalConditionVariableBroadcast;
 extern waitConditionVariable globalConditionVariableWait;
 extern freeConditionVariable globalConditionVariableFree;
 
+#ifdef ENABLE_LOCK_PROFILING
+// The most lock sites recorded, the sites past that are not profiled
+#ifndef MUTEX_PROFILE_MAX_SITE_COUNT
+#define MUTEX_PROFILE_MAX_SITE_COUNT 512
+#endif
+// The most mutexes of the default create function whose hold times are measured at the same time
+#ifndef MUTEX_PROFILE_MAX_MUTEX_COUNT
+#define MUTEX_PROFILE_MAX_MUTEX_COUNT 4096
+#endif
+
+/**
+ * The counters of a place in the code which takes a mutex. The times are in 100ns and wrap around where SIZE_T is 32 bits.
+ */
+typedef struct {
+    PCHAR file;
+    UINT32 line;
+    // times the mutex was taken here
+    UINT64 acquisitionCount;
+    // times it was held by another thread when it was taken here
+    UINT64 contendedCount;
+    // time spent waiting for the mutex here
+    UINT64 totalWaitTime;
+    // longest the mutex was held once it was taken here, a condition variable wait in between does not count
+    UINT64 maxHoldTime;
+} MutexProfileSite, *PMutexProfileSite;
+
+VOID mutex_profile_lock(MUTEX, PCHAR, UINT32);
+VOID mutex_profile_unlock(MUTEX);
+BOOL mutex_profile_tryLock(MUTEX, PCHAR, UINT32);
+BOOL mutex_profile_waitLock(MUTEX, UINT64, PCHAR, UINT32);
+STATUS mutex_profile_wait(CVAR, MUTEX, UINT64);
+/**
+ * @brief copy the counters of the lock sites.
+ *
+ * @param[out] pSites the counters, NULL to only get the number of sites.
+ * @param[in, out] pSiteCount the room in pSites on the way in, the number of sites on the way out.
+ *
+ * @return STATUS_BUFFER_TOO_SMALL when there are more sites than room.
+ */
+STATUS mutex_profile_getSites(PMutexProfileSite, PUINT32);
+/**
+ * @brief log the counters of the lock sites which were taken.
+ */
+VOID mutex_profile_dump(VOID);
+/**
+ * @brief zero the counters of all the lock sites.
+ */
+VOID mutex_profile_reset(VOID);
+
+//
+// Mutex functionality, every call site is profiled. The hold times are only measured for the mutexes of the default
+// create function, the other mutexes are only looked up by their handle and never written to.
+//
+#define MUTEX_CREATE         globalCreateMutex
+#define MUTEX_LOCK(m)        mutex_profile_lock((m), (PCHAR) __FILE__, __LINE__)
+#define MUTEX_UNLOCK(m)      mutex_profile_unlock((m))
+#define MUTEX_TRYLOCK(m)     mutex_profile_tryLock((m), (PCHAR) __FILE__, __LINE__)
+#define MUTEX_WAITLOCK(m, t) mutex_profile_waitLock((m), (t), (PCHAR) __FILE__, __LINE__)
+#define MUTEX_FREE           globalFreeMutex
+
+//
+// Condition variable functionality
+//
+#define CVAR_CREATE        globalConditionVariableCreate
+#define CVAR_SIGNAL        globalConditionVariableSignal
+#define CVAR_BROADCAST     globalConditionVariableBroadcast
+#define CVAR_WAIT(c, m, t) mutex_profile_wait((c), (m), (t))
+#define CVAR_FREE          globalConditionVariableFree
+#else
 //
 // Mutex functionality
 //
@@ -132,6 +201,7 @@ extern freeConditionVariable globalConditionVariableFree;
 #define CVAR_BROADCAST globalConditionVariableBroadcast
 #define CVAR_WAIT      globalConditionVariableWait
 #define CVAR_FREE      globalConditionVariableFree
+#endif
 
 //
 // Static initializers
@@ -12,6 +12,10 @@
  * express or implied. See the License for the specific language governing
  * permissions and limitations under the License.
  */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+// pthread_attr_setaffinity_np
+#define _GNU_SOURCE
+#endif
 #include "kvs/common_defs.h"
 #include "kvs/error.h"
 #include "kvs/platform_utils.h"
@@ -184,23 +188,37 @@ PUBLIC_API TID defaultGetThreadId()
     return (TID) pthread_self();
 }
 
-PUBLIC_API STATUS defaultCreateThreadEx(PTID pThreadId, PCHAR threadName, UINT32 threadSize, BOOL joinable, startRoutine start, PVOID args)
+PUBLIC_API STATUS defaultCreateThreadExAffinity(PTID pThreadId, PCHAR threadName, UINT32 threadSize, BOOL joinable, INT32 cpu, startRoutine start,
+                                                PVOID args)
 {
     STATUS retStatus = STATUS_SUCCESS;
     pthread_t threadId;
     INT32 result;
     pthread_attr_t* pAttr = NULL;
     pthread_attr_t attr;
-    pAttr = &attr;
+#if defined(__linux__) && defined(CPU_SET) && !defined(KVS_PLAT_ESP_FREERTOS)
+    cpu_set_t cpuSet;
+#endif
     CHK(pThreadId != NULL, STATUS_NULL_ARG);
-    result = pthread_attr_init(pAttr);
+    CHK(cpu >= THREAD_ANY_CPU, STATUS_THREAD_INVALID_ARG);
+    result = pthread_attr_init(&attr);
+    CHK_ERR(result == 0, STATUS_THREAD_ATTR_INIT_FAILED, "pthread_attr_init failed with %d", result);
+    pAttr = &attr;
+
+    if (cpu != THREAD_ANY_CPU) {
+#if defined(__linux__) && defined(CPU_SET) && !defined(KVS_PLAT_ESP_FREERTOS)
+        CHK(cpu < CPU_SETSIZE, STATUS_THREAD_INVALID_ARG);
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu, &cpuSet);
+        result = pthread_attr_setaffinity_np(pAttr, SIZEOF(cpu_set_t), &cpuSet);
+        CHK_ERR(result == 0, STATUS_THREAD_INVALID_ARG, "pthread_attr_setaffinity_np failed with %d", result);
+#elif !defined(KVS_PLAT_ESP_FREERTOS)
+        CHK_ERR(FALSE, STATUS_NOT_IMPLEMENTED, "pinning a thread to a cpu is not supported on this platform");
+#endif
+    }
 
 #ifdef CONSTRAINED_DEVICE
-    pthread_attr_t attr;
-    pAttr = &attr;
-    result = pthread_attr_init(pAttr);
-    CHK_ERR(result == 0, STATUS_THREAD_ATTR_INIT_FAILED, "pthread_attr_init failed with %d", result);
-    result = pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE_ON_CONSTRAINED_DEVICE);
+    result = pthread_attr_setstacksize(pAttr, THREAD_STACK_SIZE_ON_CONSTRAINED_DEVICE);
     CHK_ERR(result == 0, STATUS_THREAD_ATTR_SET_STACK_SIZE_FAILED, "pthread_attr_setstacksize failed with %d", result);
 #endif
 
@@ -210,9 +228,12 @@ PUBLIC_API STATUS defaultCreateThreadEx(PTID pThreadId, PCHAR threadName, UINT32
     UINT32 internalSize = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
 
     esp_pthread_cfg_t pthread_cfg;
+    INT32 appPinToCore;
     esp_err_t esp_err = esp_pthread_get_cfg(&pthread_cfg);
     if (esp_err != ESP_OK) {
         DLOGW("get the esp pthread cfg failed.");
+        // nothing was set on this thread yet, start from the defaults so that no garbage affinity is put back
+        pthread_cfg = esp_pthread_get_default_config();
     }
 
     if (threadSize == 0) {
@@ -227,6 +248,12 @@ PUBLIC_API STATUS defaultCreateThreadEx(PTID pThreadId, PCHAR threadName, UINT32
         pthread_cfg.thread_name = threadName;
     }
 
+    // the config sticks to the calling thread, the affinity of the application is put back once the pinned thread is created
+    appPinToCore = pthread_cfg.pin_to_core;
+    if (cpu != THREAD_ANY_CPU) {
+        pthread_cfg.pin_to_core = cpu;
+    }
+
     esp_err = esp_pthread_set_cfg(&pthread_cfg);
 
     if (esp_err != ESP_OK) {
@@ -249,6 +276,12 @@ PUBLIC_API STATUS defaultCreateThreadEx(PTID pThreadId, PCHAR threadName, UINT32
     result = pthread_create(&threadId, pAttr, start, args);
 
 #if defined(KVS_PLAT_ESP_FREERTOS)
+    if (cpu != THREAD_ANY_CPU) {
+        pthread_cfg.pin_to_core = appPinToCore;
+        if (esp_pthread_set_cfg(&pthread_cfg) != ESP_OK) {
+            DLOGW("restore the esp pthread cfg failed.");
+        }
+    }
     UINT32 curTotalSize = esp_get_free_heap_size();
     UINT32 curSpiSize = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
     UINT32 curInternalSize = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
@@ -285,6 +318,11 @@ CleanUp:
     return retStatus;
 }
 
+PUBLIC_API STATUS defaultCreateThreadEx(PTID pThreadId, PCHAR threadName, UINT32 threadSize, BOOL joinable, startRoutine start, PVOID args)
+{
+    return defaultCreateThreadExAffinity(pThreadId, threadName, threadSize, joinable, THREAD_ANY_CPU, start, args);
+}
+
 PUBLIC_API STATUS defaultCreateThread(PTID pThreadId, startRoutine start, PVOID args)
 {
     return defaultCreateThreadEx(pThreadId, NULL, 0, TRUE, start, args);
@@ -430,6 +468,7 @@ getTId globalGetThreadId = defaultGetThreadId;
 getTName globalGetThreadName = defaultGetThreadName;
 createThread globalCreateThread = defaultCreateThread;
 createThreadEx globalCreateThreadEx = defaultCreateThreadEx;
+createThreadExAffinity globalCreateThreadExAffinity = defaultCreateThreadExAffinity;
 threadSleep globalThreadSleep = defaultThreadSleep;
 threadSleepUntil globalThreadSleepUntil = defaultThreadSleepUntil;
 joinThread globalJoinThread = defaultJoinThread;
@@ -43,6 +43,9 @@ typedef TID* PTID;
 #define IS_VALID_TID_VALUE(t) ((t) != INVALID_TID_VALUE)
 #endif
 
+// the thread may run on any cpu
+#define THREAD_ANY_CPU (-1)
+
 //
 // Thread library function definitions
 //
@@ -54,6 +57,7 @@ typedef STATUS (*getTName)(TID, PCHAR, UINT32);
 typedef PVOID (*startRoutine)(PVOID);
 typedef STATUS (*createThread)(PTID, startRoutine, PVOID);
 typedef STATUS (*createThreadEx)(PTID, PCHAR, UINT32, BOOL, startRoutine, PVOID);
+typedef STATUS (*createThreadExAffinity)(PTID, PCHAR, UINT32, BOOL, INT32, startRoutine, PVOID);
 typedef STATUS (*joinThread)(TID, PVOID*);
 typedef VOID (*threadSleep)(UINT64);
 typedef VOID (*threadSleepUntil)(UINT64);
@@ -72,6 +76,7 @@ extern getTName globalGetThreadName;
 //
 extern createThread globalCreateThread;
 extern createThreadEx globalCreateThreadEx;
+extern createThreadExAffinity globalCreateThreadExAffinity;
 extern joinThread globalJoinThread;
 extern threadSleep globalThreadSleep;
 extern threadSleepUntil globalThreadSleepUntil;
@@ -88,15 +93,16 @@ extern exitThread globalExitThread;
 //
 // Thread functionality
 //
-#define THREAD_CREATE        globalCreateThread
-#define THREAD_CREATE_EX     globalCreateThreadEx
-#define THREAD_CREATE_EX_PRI globalCreateThreadExPri
-#define THREAD_JOIN          globalJoinThread
-#define THREAD_SLEEP         globalThreadSleep
-#define THREAD_SLEEP_UNTIL   globalThreadSleepUntil
-#define THREAD_CANCEL        globalCancelThread
-#define THREAD_DETACH        globalDetachThread
-#define THREAD_EXIT          globalExitThread
+#define THREAD_CREATE             globalCreateThread
+#define THREAD_CREATE_EX          globalCreateThreadEx
+#define THREAD_CREATE_EX_PRI      globalCreateThreadExPri
+#define THREAD_CREATE_EX_AFFINITY globalCreateThreadExAffinity
+#define THREAD_JOIN               globalJoinThread
+#define THREAD_SLEEP              globalThreadSleep
+#define THREAD_SLEEP_UNTIL        globalThreadSleepUntil
+#define THREAD_CANCEL             globalCancelThread
+#define THREAD_DETACH             globalDetachThread
+#define THREAD_EXIT               globalExitThread
 
 #ifdef __cplusplus
 }
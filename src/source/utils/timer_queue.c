@@ -23,16 +23,25 @@
 /******************************************************************************
  * DEFINITION
  ******************************************************************************/
+#define TIMER_QUEUE_HEAP_INVOKE_TIME(pTimerQueue, index) ((pTimerQueue)->pTimers[(pTimerQueue)->pHeap[(index)]].invokeTime)
+
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
 // Internal Functions
 STATUS priv_timer_queue_createInternal(UINT32, PTimerQueue*);
-STATUS priv_timer_queue_createInternalEx(UINT32, PTimerQueue*, PCHAR, UINT32);
+STATUS priv_timer_queue_createInternalEx(UINT32, PTimerQueue*, PCHAR, UINT32, INT32);
 STATUS priv_timer_queue_freeInternal(PTimerQueue*);
 STATUS priv_timer_queue_evaluateNextInvocation(PTimerQueue);
-
-STATUS timer_queue_createEx(PTIMER_QUEUE_HANDLE pHandle, PCHAR timerName, UINT32 threadSize)
+static VOID priv_timer_queue_rescheduleTimer(PTimerQueue, UINT32, UINT64);
+static VOID priv_timer_queue_removeTimer(PTimerQueue, UINT32);
+static BOOL priv_timer_queue_isReserved(PTimerQueue);
+static STATUS priv_timer_queue_awaitCallback(PTimerQueue, PTimerQueue, UINT32, UINT64, BOOL);
+static STATUS priv_timer_queue_cancelTimerLocked(PTimerQueue, PTimerQueue, UINT32, UINT64);
+static STATUS priv_timer_queue_cancelOwnTimersLocked(PTimerQueue, PTimerQueue);
+static STATUS priv_timer_queue_release(PTimerQueue);
+
+STATUS timer_queue_createOnCpu(PTIMER_QUEUE_HANDLE pHandle, PCHAR timerName, UINT32 threadSize, UINT32 maxTimerCount, INT32 cpu)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
@@ -40,7 +49,7 @@ STATUS timer_queue_createEx(PTIMER_QUEUE_HANDLE pHandle, PCHAR timerName, UINT32
 
     CHK(pHandle != NULL, STATUS_NULL_ARG);
 
-    CHK_STATUS(priv_timer_queue_createInternalEx(DEFAULT_TIMER_QUEUE_TIMER_COUNT, &pTimerQueue, timerName, threadSize));
+    CHK_STATUS(priv_timer_queue_createInternalEx(maxTimerCount, &pTimerQueue, timerName, threadSize, cpu));
 
     *pHandle = TO_TIMER_QUEUE_HANDLE(pTimerQueue);
 
@@ -54,23 +63,87 @@ CleanUp:
     return retStatus;
 }
 
+STATUS timer_queue_createWithCapacity(PTIMER_QUEUE_HANDLE pHandle, PCHAR timerName, UINT32 threadSize, UINT32 maxTimerCount)
+{
+    return timer_queue_createOnCpu(pHandle, timerName, threadSize, maxTimerCount, THREAD_ANY_CPU);
+}
+
+STATUS timer_queue_createEx(PTIMER_QUEUE_HANDLE pHandle, PCHAR timerName, UINT32 threadSize)
+{
+    return timer_queue_createWithCapacity(pHandle, timerName, threadSize, DEFAULT_TIMER_QUEUE_TIMER_COUNT);
+}
+
 STATUS timer_queue_create(PTIMER_QUEUE_HANDLE pHandle)
 {
     return timer_queue_createEx(pHandle, NULL, 0);
 }
 
+STATUS timer_queue_attach(TIMER_QUEUE_HANDLE sharedHandle, PTIMER_QUEUE_HANDLE pHandle)
+{
+    return timer_queue_attachWithReserve(sharedHandle, 0, pHandle);
+}
+
+STATUS timer_queue_attachWithReserve(TIMER_QUEUE_HANDLE sharedHandle, UINT32 reservedTimerCount, PTIMER_QUEUE_HANDLE pHandle)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PTimerQueue pSharedQueue = FROM_TIMER_QUEUE_HANDLE(sharedHandle), pTimerQueue = NULL;
+    BOOL locked = FALSE;
+
+    CHK(pSharedQueue != NULL && pHandle != NULL, STATUS_NULL_ARG);
+    pSharedQueue = pSharedQueue->pSharedQueue;
+    CHK(!ATOMIC_LOAD_BOOL(&pSharedQueue->shutdown), STATUS_TIMER_QUEUE_SHUTDOWN);
+
+    MUTEX_LOCK(pSharedQueue->executorLock);
+    locked = TRUE;
+    CHK(pSharedQueue->reservedTimerCount + pSharedQueue->unreservedTimerCount + reservedTimerCount <= pSharedQueue->maxTimerCount,
+        STATUS_MAX_TIMER_COUNT_REACHED);
+
+    // Only the owner fields are used, the timers, the lock and the executor are the ones of the shared queue
+    CHK(NULL != (pTimerQueue = (PTimerQueue) MEMCALLOC(1, SIZEOF(TimerQueue))), STATUS_NOT_ENOUGH_MEMORY);
+    pTimerQueue->pSharedQueue = pSharedQueue;
+    pTimerQueue->reservedTimerCount = reservedTimerCount;
+    pSharedQueue->reservedTimerCount += reservedTimerCount;
+    ATOMIC_INCREMENT(&pSharedQueue->refCount);
+
+    *pHandle = TO_TIMER_QUEUE_HANDLE(pTimerQueue);
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pSharedQueue->executorLock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
 STATUS timer_queue_free(PTIMER_QUEUE_HANDLE pHandle)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PTimerQueue pTimerQueue;
+    PTimerQueue pTimerQueue, pSharedQueue;
 
     CHK(pHandle != NULL, STATUS_NULL_ARG);
 
     // Get the client handle
     pTimerQueue = FROM_TIMER_QUEUE_HANDLE(*pHandle);
+    CHK(pTimerQueue != NULL, retStatus);
+    pSharedQueue = pTimerQueue->pSharedQueue;
+
+    if (pSharedQueue != pTimerQueue) {
+        // An attached queue goes away once its timers are cancelled and no callback of them runs
+        CHK_STATUS(timer_queue_shutdown(*pHandle));
+        MUTEX_LOCK(pSharedQueue->executorLock);
+        pSharedQueue->reservedTimerCount -= pTimerQueue->reservedTimerCount;
+        MUTEX_UNLOCK(pSharedQueue->executorLock);
+        MEMFREE(pTimerQueue);
+    } else if (ATOMIC_LOAD(&pSharedQueue->refCount) > 1) {
+        // The executor keeps running for the attached queues
+        CHK_STATUS(timer_queue_cancelAllTimers(*pHandle));
+    }
 
-    CHK_STATUS(priv_timer_queue_freeInternal(&pTimerQueue));
+    CHK_STATUS(priv_timer_queue_release(pSharedQueue));
 
     // Set the handle pointer to invalid
     *pHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
@@ -86,34 +159,46 @@ STATUS timer_queue_addTimer(TIMER_QUEUE_HANDLE handle, UINT64 start, UINT64 peri
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PTimerQueue pTimerQueue = FROM_TIMER_QUEUE_HANDLE(handle);
+    PTimerQueue pOwner = FROM_TIMER_QUEUE_HANDLE(handle), pTimerQueue = NULL;
     BOOL locked = FALSE;
-    UINT32 i, retIndex = 0;
+    UINT32 retIndex = 0;
     PTimerEntry pTimerEntry = NULL;
+    BOOL reserved;
 
-    CHK(pTimerQueue != NULL && timerCallbackFn != NULL && pIndex != NULL, STATUS_NULL_ARG);
+    CHK(pOwner != NULL && timerCallbackFn != NULL && pIndex != NULL, STATUS_NULL_ARG);
     CHK(period == TIMER_QUEUE_SINGLE_INVOCATION_PERIOD || period >= MIN_TIMER_QUEUE_PERIOD_DURATION, STATUS_INVALID_TIMER_PERIOD_VALUE);
+    pTimerQueue = pOwner->pSharedQueue;
 
     MUTEX_LOCK(pTimerQueue->executorLock);
     locked = TRUE;
 
+    // A timer added once the queue is shut down, by a callback rescheduling itself for instance, would outlive its custom data
+    CHK(!ATOMIC_LOAD_BOOL(&pOwner->shutdown), STATUS_TIMER_QUEUE_SHUTDOWN);
+    // the entries reserved for the other attached queues stay free for them
+    reserved = priv_timer_queue_isReserved(pOwner);
+    CHK_WARN(reserved || pTimerQueue->reservedTimerCount + pTimerQueue->unreservedTimerCount < pTimerQueue->maxTimerCount,
+             STATUS_MAX_TIMER_COUNT_REACHED, "reach the limit of timer");
     CHK_WARN(pTimerQueue->activeTimerCount < pTimerQueue->maxTimerCount, STATUS_MAX_TIMER_COUNT_REACHED, "reach the limit of timer");
 
-    // Get an available index
-    for (i = 0; i < pTimerQueue->maxTimerCount && pTimerEntry == NULL; i++) {
-        if (pTimerQueue->pTimers[i].timerCallbackFn == NULL) {
-            pTimerEntry = &pTimerQueue->pTimers[i];
-            retIndex = i;
-        }
-    }
-
-    // Increment the count and set the timer entries
-    pTimerQueue->activeTimerCount++;
+    // Get an available index from the top of the free stack
+    retIndex = pTimerQueue->pFreeIds[pTimerQueue->maxTimerCount - pTimerQueue->activeTimerCount - 1];
+    pTimerEntry = &pTimerQueue->pTimers[retIndex];
 
     pTimerEntry->timerCallbackFn = timerCallbackFn;
     pTimerEntry->customData = customData;
-    pTimerEntry->invokeTime = GETTIME() + start;
     pTimerEntry->period = period;
+    pTimerEntry->pOwner = pOwner;
+    pTimerEntry->generation++;
+    pOwner->ownTimerCount++;
+    if (!reserved) {
+        pTimerQueue->unreservedTimerCount++;
+    }
+
+    // Increment the count and put the timer at the bottom of the heap
+    pTimerEntry->heapIndex = pTimerQueue->activeTimerCount;
+    pTimerQueue->pHeap[pTimerQueue->activeTimerCount] = retIndex;
+    pTimerQueue->activeTimerCount++;
+    priv_timer_queue_rescheduleTimer(pTimerQueue, retIndex, GETTIME() + start);
 
     if (pTimerEntry->invokeTime < pTimerQueue->invokeTime) {
         // Need to update the scheduled invoke at this time
@@ -139,33 +224,17 @@ STATUS timer_queue_cancelTimer(TIMER_QUEUE_HANDLE handle, UINT32 timerId, UINT64
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PTimerQueue pTimerQueue = FROM_TIMER_QUEUE_HANDLE(handle);
+    PTimerQueue pOwner = FROM_TIMER_QUEUE_HANDLE(handle), pTimerQueue = NULL;
     BOOL locked = FALSE;
-    CHK(pTimerQueue != NULL, STATUS_NULL_ARG);
+    CHK(pOwner != NULL, STATUS_NULL_ARG);
+    pTimerQueue = pOwner->pSharedQueue;
     CHK(timerId < pTimerQueue->maxTimerCount, STATUS_INVALID_ARG);
 
     MUTEX_LOCK(pTimerQueue->executorLock);
     locked = TRUE;
 
-    // Check if anything needs to be done
-    CHK(pTimerQueue->activeTimerCount != 0 && pTimerQueue->pTimers[timerId].timerCallbackFn != NULL &&
-            customData == pTimerQueue->pTimers[timerId].customData,
-        retStatus);
-
-    // Setting the callback to NULL to indicate empty timer
-    pTimerQueue->pTimers[timerId].timerCallbackFn = NULL;
-
-    // Decrement the count
-    pTimerQueue->activeTimerCount--;
-
-    // Check if the next invocation needs to change
-    if (pTimerQueue->pTimers[timerId].invokeTime == pTimerQueue->invokeTime) {
-        // Re-evaluate the new invocation
-        CHK_STATUS(priv_timer_queue_evaluateNextInvocation(pTimerQueue));
-
-        // Signal the executor to wake up and re-evaluate
-        CVAR_SIGNAL(pTimerQueue->executorCvar);
-    }
+    CHK_STATUS(priv_timer_queue_cancelTimerLocked(pTimerQueue, pOwner, timerId, customData));
+    CHK_STATUS(priv_timer_queue_awaitCallback(pTimerQueue, pOwner, timerId, customData, TRUE));
 
 CleanUp:
 
@@ -181,11 +250,12 @@ STATUS timer_queue_cancelTimersByCustomData(TIMER_QUEUE_HANDLE handle, UINT64 cu
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PTimerQueue pTimerQueue = FROM_TIMER_QUEUE_HANDLE(handle);
+    PTimerQueue pOwner = FROM_TIMER_QUEUE_HANDLE(handle), pTimerQueue = NULL;
     BOOL locked = FALSE;
     UINT32 timerId;
 
-    CHK(pTimerQueue != NULL, STATUS_NULL_ARG);
+    CHK(pOwner != NULL, STATUS_NULL_ARG);
+    pTimerQueue = pOwner->pSharedQueue;
 
     MUTEX_LOCK(pTimerQueue->executorLock);
     locked = TRUE;
@@ -193,10 +263,12 @@ STATUS timer_queue_cancelTimersByCustomData(TIMER_QUEUE_HANDLE handle, UINT64 cu
     // cancel all timer with customData
     for (timerId = 0; timerId < pTimerQueue->maxTimerCount; timerId++) {
         if (pTimerQueue->pTimers[timerId].customData == customData && pTimerQueue->pTimers[timerId].timerCallbackFn != NULL) {
-            CHK_STATUS(timer_queue_cancelTimer(handle, timerId, customData));
+            CHK_STATUS(priv_timer_queue_cancelTimerLocked(pTimerQueue, pOwner, timerId, customData));
         }
     }
 
+    CHK_STATUS(priv_timer_queue_awaitCallback(pTimerQueue, pOwner, MAX_UINT32, customData, TRUE));
+
 CleanUp:
 
     if (locked) {
@@ -211,21 +283,16 @@ STATUS timer_queue_cancelAllTimers(TIMER_QUEUE_HANDLE handle)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PTimerQueue pTimerQueue = FROM_TIMER_QUEUE_HANDLE(handle);
+    PTimerQueue pOwner = FROM_TIMER_QUEUE_HANDLE(handle), pTimerQueue = NULL;
     BOOL locked = FALSE;
-    UINT32 timerId;
 
-    CHK(pTimerQueue != NULL, STATUS_NULL_ARG);
+    CHK(pOwner != NULL, STATUS_NULL_ARG);
+    pTimerQueue = pOwner->pSharedQueue;
 
     MUTEX_LOCK(pTimerQueue->executorLock);
     locked = TRUE;
 
-    // cancel all timer
-    for (timerId = 0; timerId < pTimerQueue->maxTimerCount; timerId++) {
-        if (pTimerQueue->pTimers[timerId].timerCallbackFn != NULL) {
-            CHK_STATUS(timer_queue_cancelTimer(handle, timerId, pTimerQueue->pTimers[timerId].customData));
-        }
-    }
+    CHK_STATUS(priv_timer_queue_cancelOwnTimersLocked(pTimerQueue, pOwner));
 
 CleanUp:
 
@@ -241,15 +308,16 @@ STATUS timer_queue_getTimerCount(TIMER_QUEUE_HANDLE handle, PUINT32 pTimerCount)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PTimerQueue pTimerQueue = FROM_TIMER_QUEUE_HANDLE(handle);
+    PTimerQueue pOwner = FROM_TIMER_QUEUE_HANDLE(handle), pTimerQueue = NULL;
     BOOL locked = FALSE;
 
-    CHK(pTimerQueue != NULL && pTimerCount != NULL, STATUS_NULL_ARG);
+    CHK(pOwner != NULL && pTimerCount != NULL, STATUS_NULL_ARG);
+    pTimerQueue = pOwner->pSharedQueue;
 
     MUTEX_LOCK(pTimerQueue->executorLock);
     locked = TRUE;
 
-    *pTimerCount = pTimerQueue->activeTimerCount;
+    *pTimerCount = pOwner->ownTimerCount;
 
 CleanUp:
 
@@ -265,18 +333,20 @@ STATUS timer_queue_getTimersByCustomData(TIMER_QUEUE_HANDLE handle, UINT64 custo
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PTimerQueue pTimerQueue = FROM_TIMER_QUEUE_HANDLE(handle);
+    PTimerQueue pOwner = FROM_TIMER_QUEUE_HANDLE(handle), pTimerQueue = NULL;
     BOOL locked = FALSE;
     UINT32 timerId, timerIdCount = 0, bufferSize = 0;
 
-    CHK(pTimerQueue != NULL && pTimerIdCount != NULL, STATUS_NULL_ARG);
+    CHK(pOwner != NULL && pTimerIdCount != NULL, STATUS_NULL_ARG);
+    pTimerQueue = pOwner->pSharedQueue;
 
     MUTEX_LOCK(pTimerQueue->executorLock);
     locked = TRUE;
 
     // first pass to get the timer id count
     for (timerId = 0; timerId < pTimerQueue->maxTimerCount; timerId++) {
-        if (pTimerQueue->pTimers[timerId].customData == customData && pTimerQueue->pTimers[timerId].timerCallbackFn != NULL) {
+        if (pTimerQueue->pTimers[timerId].customData == customData && pTimerQueue->pTimers[timerId].timerCallbackFn != NULL &&
+            pTimerQueue->pTimers[timerId].pOwner == pOwner) {
             timerIdCount++;
         }
     }
@@ -292,7 +362,8 @@ STATUS timer_queue_getTimersByCustomData(TIMER_QUEUE_HANDLE handle, UINT64 custo
 
     // second pass to store the timer ids
     for (timerId = 0, timerIdCount = 0; timerId < pTimerQueue->maxTimerCount; timerId++) {
-        if (pTimerQueue->pTimers[timerId].customData == customData && pTimerQueue->pTimers[timerId].timerCallbackFn != NULL) {
+        if (pTimerQueue->pTimers[timerId].customData == customData && pTimerQueue->pTimers[timerId].timerCallbackFn != NULL &&
+            pTimerQueue->pTimers[timerId].pOwner == pOwner) {
             pTimerIdsBuffer[timerIdCount] = timerId;
             timerIdCount++;
         }
@@ -312,23 +383,25 @@ STATUS timer_queue_updateTimerPeriod(TIMER_QUEUE_HANDLE handle, UINT64 customDat
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PTimerQueue pTimerQueue = FROM_TIMER_QUEUE_HANDLE(handle);
+    PTimerQueue pOwner = FROM_TIMER_QUEUE_HANDLE(handle), pTimerQueue = NULL;
     BOOL locked = FALSE;
 
-    CHK(pTimerQueue != NULL, STATUS_NULL_ARG);
+    CHK(pOwner != NULL, STATUS_NULL_ARG);
+    pTimerQueue = pOwner->pSharedQueue;
     CHK(timerId < pTimerQueue->maxTimerCount, STATUS_INVALID_ARG);
-    // Check if anything needs to be done
-    CHK(pTimerQueue->activeTimerCount != 0 && pTimerQueue->pTimers[timerId].timerCallbackFn != NULL &&
-            customData == pTimerQueue->pTimers[timerId].customData,
-        retStatus);
     CHK(period == TIMER_QUEUE_SINGLE_INVOCATION_PERIOD || period >= MIN_TIMER_QUEUE_PERIOD_DURATION, STATUS_INVALID_TIMER_PERIOD_VALUE);
 
     MUTEX_LOCK(pTimerQueue->executorLock);
     locked = TRUE;
 
+    // Check if anything needs to be done
+    CHK(pTimerQueue->activeTimerCount != 0 && pTimerQueue->pTimers[timerId].timerCallbackFn != NULL &&
+            customData == pTimerQueue->pTimers[timerId].customData && pTimerQueue->pTimers[timerId].pOwner == pOwner,
+        retStatus);
+
     pTimerQueue->pTimers[timerId].period = period;
     // take effect immediately
-    pTimerQueue->pTimers[timerId].invokeTime = GETTIME() + period;
+    priv_timer_queue_rescheduleTimer(pTimerQueue, timerId, GETTIME() + period);
     CHK_STATUS(priv_timer_queue_evaluateNextInvocation(pTimerQueue));
     CVAR_SIGNAL(pTimerQueue->executorCvar);
 
@@ -346,15 +419,33 @@ STATUS timer_queue_shutdown(TIMER_QUEUE_HANDLE handle)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PTimerQueue pTimerQueue = FROM_TIMER_QUEUE_HANDLE(handle);
+    PTimerQueue pOwner = FROM_TIMER_QUEUE_HANDLE(handle), pTimerQueue = NULL;
+    BOOL locked = FALSE;
 
-    CHK(pTimerQueue != NULL, STATUS_NULL_ARG);
+    CHK(pOwner != NULL, STATUS_NULL_ARG);
+    pTimerQueue = pOwner->pSharedQueue;
 
-    ATOMIC_STORE_BOOL(&pTimerQueue->shutdown, TRUE);
-    CVAR_SIGNAL(pTimerQueue->executorCvar);
+    MUTEX_LOCK(pTimerQueue->executorLock);
+    locked = TRUE;
+
+    ATOMIC_STORE_BOOL(&pOwner->shutdown, TRUE);
+
+    if (pOwner != pTimerQueue) {
+        // The shared executor keeps going for the other queues, the timers of this one are cancelled
+        CHK_STATUS(priv_timer_queue_cancelOwnTimersLocked(pTimerQueue, pOwner));
+    } else {
+        CVAR_SIGNAL(pTimerQueue->executorCvar);
+
+        // The executor does not start another callback once the shutdown is set, the one running is waited for
+        CHK_STATUS(priv_timer_queue_awaitCallback(pTimerQueue, NULL, MAX_UINT32, 0, FALSE));
+    }
 
 CleanUp:
 
+    if (locked) {
+        MUTEX_UNLOCK(pTimerQueue->executorLock);
+    }
+
     LEAVES();
     return retStatus;
 }
@@ -362,20 +453,22 @@ CleanUp:
 /////////////////////////////////////////////////////////////////////////////////
 // Internal operations
 /////////////////////////////////////////////////////////////////////////////////
-STATUS priv_timer_queue_createInternalEx(UINT32 maxTimers, PTimerQueue* ppTimerQueue, PCHAR timerName, UINT32 threadSize)
+STATUS priv_timer_queue_createInternalEx(UINT32 maxTimers, PTimerQueue* ppTimerQueue, PCHAR timerName, UINT32 threadSize, INT32 cpu)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PTimerQueue pTimerQueue = NULL;
-    UINT32 allocSize;
+    UINT32 allocSize, i;
     BOOL locked = FALSE;
     TID threadId;
 
     CHK(ppTimerQueue != NULL, STATUS_NULL_ARG);
     CHK(maxTimers >= MIN_TIMER_QUEUE_TIMER_COUNT, STATUS_INVALID_TIMER_COUNT_VALUE);
 
-    allocSize = SIZEOF(TimerQueue) + maxTimers * SIZEOF(TimerEntry);
+    allocSize = SIZEOF(TimerQueue) + maxTimers * (SIZEOF(TimerEntry) + 2 * SIZEOF(UINT32) + SIZEOF(TimerQueueDueTimer));
     CHK(NULL != (pTimerQueue = (PTimerQueue) MEMCALLOC(1, allocSize)), STATUS_NOT_ENOUGH_MEMORY);
+    pTimerQueue->pSharedQueue = pTimerQueue;
+    pTimerQueue->refCount = 1;
     pTimerQueue->activeTimerCount = 0;
     pTimerQueue->maxTimerCount = maxTimers;
     pTimerQueue->executorTid = INVALID_TID_VALUE;
@@ -383,6 +476,7 @@ STATUS priv_timer_queue_createInternalEx(UINT32 maxTimers, PTimerQueue* ppTimerQ
     ATOMIC_STORE_BOOL(&pTimerQueue->started, FALSE);
     ATOMIC_STORE_BOOL(&pTimerQueue->shutdown, FALSE);
     pTimerQueue->invokeTime = MAX_UINT64;
+    pTimerQueue->runningTimerId = MAX_UINT32;
 
     pTimerQueue->startLock = MUTEX_CREATE(FALSE);
     CHK(IS_VALID_MUTEX_VALUE(pTimerQueue->startLock), STATUS_INVALID_OPERATION);
@@ -399,16 +493,29 @@ STATUS priv_timer_queue_createInternalEx(UINT32 maxTimers, PTimerQueue* ppTimerQ
     CHK(IS_VALID_MUTEX_VALUE(pTimerQueue->executorLock), STATUS_INVALID_OPERATION);
     pTimerQueue->executorCvar = CVAR_CREATE();
     CHK(IS_VALID_CVAR_VALUE(pTimerQueue->executorCvar), STATUS_INVALID_OPERATION);
+    pTimerQueue->callbackCvar = CVAR_CREATE();
+    CHK(IS_VALID_CVAR_VALUE(pTimerQueue->callbackCvar), STATUS_INVALID_OPERATION);
 
-    // Set the timer entry array past the end of the main allocation
+    // Set the timer entry array, the due timers, the heap and the free stack past the end of the main allocation
     pTimerQueue->pTimers = (PTimerEntry)(pTimerQueue + 1);
+    pTimerQueue->pDueTimers = (PTimerQueueDueTimer)(pTimerQueue->pTimers + maxTimers);
+    pTimerQueue->pHeap = (PUINT32)(pTimerQueue->pDueTimers + maxTimers);
+    pTimerQueue->pFreeIds = pTimerQueue->pHeap + maxTimers;
+    // the lowest id is handed out first
+    for (i = 0; i < maxTimers; i++) {
+        pTimerQueue->pFreeIds[i] = maxTimers - 1 - i;
+    }
 
     // Block threads start
     MUTEX_LOCK(pTimerQueue->startLock);
     locked = TRUE;
 
     // Create the executor thread
-    CHK_STATUS(THREAD_CREATE_EX(&threadId, timerName, threadSize, FALSE, timer_queue_executor, (PVOID) pTimerQueue));
+    if (cpu == THREAD_ANY_CPU) {
+        CHK_STATUS(THREAD_CREATE_EX(&threadId, timerName, threadSize, FALSE, timer_queue_executor, (PVOID) pTimerQueue));
+    } else {
+        CHK_STATUS(THREAD_CREATE_EX_AFFINITY(&threadId, timerName, threadSize, FALSE, cpu, timer_queue_executor, (PVOID) pTimerQueue));
+    }
 
     pTimerQueue->executorTid = threadId;
 
@@ -438,7 +545,7 @@ CleanUp:
 
 STATUS priv_timer_queue_createInternal(UINT32 maxTimers, PTimerQueue* ppTimerQueue)
 {
-    return priv_timer_queue_createInternalEx(maxTimers, ppTimerQueue, NULL, 0);
+    return priv_timer_queue_createInternalEx(maxTimers, ppTimerQueue, NULL, 0, THREAD_ANY_CPU);
 }
 
 STATUS priv_timer_queue_freeInternal(PTimerQueue* ppTimerQueue)
@@ -453,10 +560,10 @@ STATUS priv_timer_queue_freeInternal(PTimerQueue* ppTimerQueue)
     pTimerQueue = *ppTimerQueue;
     CHK(pTimerQueue != NULL, retStatus);
 
-    // Attempt to terminate the executor loop if we have fully constructed mutexes and cvars
-    if (IS_VALID_CVAR_VALUE(pTimerQueue->executorCvar) && IS_VALID_CVAR_VALUE(pTimerQueue->exitCvar) && IS_VALID_CVAR_VALUE(pTimerQueue->startCvar) &&
-        IS_VALID_MUTEX_VALUE(pTimerQueue->exitLock) && IS_VALID_MUTEX_VALUE(pTimerQueue->startLock) &&
-        IS_VALID_MUTEX_VALUE(pTimerQueue->executorLock)) {
+    // Attempt to terminate the executor loop if it was started and we have fully constructed mutexes and cvars
+    if (IS_VALID_TID_VALUE(pTimerQueue->executorTid) && IS_VALID_CVAR_VALUE(pTimerQueue->executorCvar) &&
+        IS_VALID_CVAR_VALUE(pTimerQueue->exitCvar) && IS_VALID_CVAR_VALUE(pTimerQueue->startCvar) && IS_VALID_MUTEX_VALUE(pTimerQueue->exitLock) &&
+        IS_VALID_MUTEX_VALUE(pTimerQueue->startLock) && IS_VALID_MUTEX_VALUE(pTimerQueue->executorLock)) {
         // Terminate the executor thread
         ATOMIC_STORE_BOOL(&pTimerQueue->shutdown, TRUE);
 
@@ -514,6 +621,10 @@ STATUS priv_timer_queue_freeInternal(PTimerQueue* ppTimerQueue)
         CVAR_FREE(pTimerQueue->startCvar);
     }
 
+    if (IS_VALID_CVAR_VALUE(pTimerQueue->callbackCvar)) {
+        CVAR_FREE(pTimerQueue->callbackCvar);
+    }
+
     MEMFREE(pTimerQueue);
 
     *ppTimerQueue = NULL;
@@ -527,23 +638,185 @@ CleanUp:
 STATUS priv_timer_queue_evaluateNextInvocation(PTimerQueue pTimerQueue)
 {
     STATUS retStatus = STATUS_SUCCESS;
-    UINT64 invokeTime = MAX_UINT64;
-    UINT32 i, index;
 
     CHK(pTimerQueue != NULL, STATUS_NULL_ARG);
 
     // IMPORTANT!!! This internal function is assumed to be running under the executor lock of the timer queue
-    for (i = 0, index = 0; index < pTimerQueue->activeTimerCount && i < pTimerQueue->maxTimerCount; i++) {
-        if (pTimerQueue->pTimers[i].timerCallbackFn != NULL) {
-            index++;
+    pTimerQueue->invokeTime = pTimerQueue->activeTimerCount == 0 ? MAX_UINT64 : TIMER_QUEUE_HEAP_INVOKE_TIME(pTimerQueue, 0);
 
-            if (invokeTime > pTimerQueue->pTimers[i].invokeTime) {
-                invokeTime = pTimerQueue->pTimers[i].invokeTime;
+CleanUp:
+
+    return retStatus;
+}
+
+static VOID priv_timer_queue_swapHeapEntries(PTimerQueue pTimerQueue, UINT32 index, UINT32 otherIndex)
+{
+    UINT32 timerId = pTimerQueue->pHeap[index];
+
+    pTimerQueue->pHeap[index] = pTimerQueue->pHeap[otherIndex];
+    pTimerQueue->pHeap[otherIndex] = timerId;
+    pTimerQueue->pTimers[pTimerQueue->pHeap[index]].heapIndex = index;
+    pTimerQueue->pTimers[pTimerQueue->pHeap[otherIndex]].heapIndex = otherIndex;
+}
+
+/**
+ * @brief move the heap entry up or down to where its invoke time belongs.
+ */
+static VOID priv_timer_queue_fixHeapEntry(PTimerQueue pTimerQueue, UINT32 index)
+{
+    UINT32 child, earliest;
+
+    while (index > 0 && TIMER_QUEUE_HEAP_INVOKE_TIME(pTimerQueue, index) < TIMER_QUEUE_HEAP_INVOKE_TIME(pTimerQueue, (index - 1) / 2)) {
+        priv_timer_queue_swapHeapEntries(pTimerQueue, index, (index - 1) / 2);
+        index = (index - 1) / 2;
+    }
+
+    while (TRUE) {
+        earliest = index;
+        for (child = 2 * index + 1; child <= 2 * index + 2 && child < pTimerQueue->activeTimerCount; child++) {
+            if (TIMER_QUEUE_HEAP_INVOKE_TIME(pTimerQueue, child) < TIMER_QUEUE_HEAP_INVOKE_TIME(pTimerQueue, earliest)) {
+                earliest = child;
             }
         }
+        if (earliest == index) {
+            break;
+        }
+        priv_timer_queue_swapHeapEntries(pTimerQueue, index, earliest);
+        index = earliest;
+    }
+}
+
+/**
+ * @brief change the invoke time of an active timer. Running under the executor lock.
+ */
+static VOID priv_timer_queue_rescheduleTimer(PTimerQueue pTimerQueue, UINT32 timerId, UINT64 invokeTime)
+{
+    pTimerQueue->pTimers[timerId].invokeTime = invokeTime;
+    priv_timer_queue_fixHeapEntry(pTimerQueue, pTimerQueue->pTimers[timerId].heapIndex);
+}
+
+/**
+ * @brief whether the next timer added through the queue, or the one just removed from it, is one of the timers reserved
+ *        for it. The shared queue itself has no reserve. Running under the executor lock.
+ */
+static BOOL priv_timer_queue_isReserved(PTimerQueue pOwner)
+{
+    return pOwner != pOwner->pSharedQueue && pOwner->ownTimerCount < pOwner->reservedTimerCount;
+}
+
+/**
+ * @brief take an active timer out of the heap and push its id on the free stack. Running under the executor lock.
+ */
+static VOID priv_timer_queue_removeTimer(PTimerQueue pTimerQueue, UINT32 timerId)
+{
+    UINT32 index = pTimerQueue->pTimers[timerId].heapIndex;
+
+    pTimerQueue->pTimers[timerId].timerCallbackFn = NULL;
+    pTimerQueue->pTimers[timerId].pOwner->ownTimerCount--;
+    if (!priv_timer_queue_isReserved(pTimerQueue->pTimers[timerId].pOwner)) {
+        pTimerQueue->unreservedTimerCount--;
+    }
+    pTimerQueue->activeTimerCount--;
+
+    // the last heap entry takes the place of the removed one
+    if (index != pTimerQueue->activeTimerCount) {
+        priv_timer_queue_swapHeapEntries(pTimerQueue, index, pTimerQueue->activeTimerCount);
+        priv_timer_queue_fixHeapEntry(pTimerQueue, index);
+    }
+
+    pTimerQueue->pFreeIds[pTimerQueue->maxTimerCount - pTimerQueue->activeTimerCount - 1] = timerId;
+}
+
+/**
+ * @brief wait for the running callback to return when it belongs to the timers just cancelled, a NULL owner stands for any queue
+ *        and a timerId of MAX_UINT32 for any timer. Those timers can not be called back again. Running under the executor lock,
+ *        which has to be locked once only as the wait releases it. The executor never waits for itself.
+ */
+static STATUS priv_timer_queue_awaitCallback(PTimerQueue pTimerQueue, PTimerQueue pOwner, UINT32 timerId, UINT64 customData,
+                                             BOOL matchCustomData)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT64 callbackCount = pTimerQueue->callbackCount;
+
+    CHK(pTimerQueue->runningTimerId != MAX_UINT32 && (pOwner == NULL || pTimerQueue->pRunningOwner == pOwner) &&
+            (timerId == MAX_UINT32 || pTimerQueue->runningTimerId == timerId) &&
+            (!matchCustomData || pTimerQueue->runningCustomData == customData) && GETTID() != pTimerQueue->executorTid,
+        retStatus);
+
+    // the executor may call other timers back meanwhile, only the callback running now is waited for
+    while (pTimerQueue->callbackCount == callbackCount) {
+        CHK_STATUS(CVAR_WAIT(pTimerQueue->callbackCvar, pTimerQueue->executorLock, INFINITE_TIME_VALUE));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * @brief cancel a timer when the custom data and the queue it was added through match. Running under the executor lock.
+ */
+static STATUS priv_timer_queue_cancelTimerLocked(PTimerQueue pTimerQueue, PTimerQueue pOwner, UINT32 timerId, UINT64 customData)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    // Check if anything needs to be done
+    CHK(pTimerQueue->activeTimerCount != 0 && pTimerQueue->pTimers[timerId].timerCallbackFn != NULL &&
+            customData == pTimerQueue->pTimers[timerId].customData && pTimerQueue->pTimers[timerId].pOwner == pOwner,
+        retStatus);
+
+    // Setting the callback to NULL to indicate empty timer, the id goes back to the free stack
+    priv_timer_queue_removeTimer(pTimerQueue, timerId);
+
+    // Check if the next invocation needs to change
+    if (pTimerQueue->pTimers[timerId].invokeTime == pTimerQueue->invokeTime) {
+        // Re-evaluate the new invocation
+        CHK_STATUS(priv_timer_queue_evaluateNextInvocation(pTimerQueue));
+
+        // Signal the executor to wake up and re-evaluate
+        CVAR_SIGNAL(pTimerQueue->executorCvar);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * @brief cancel the timers added through a queue and wait for their running callback. Running under the executor lock, locked
+ *        once.
+ */
+static STATUS priv_timer_queue_cancelOwnTimersLocked(PTimerQueue pTimerQueue, PTimerQueue pOwner)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 timerId;
+
+    // cancel all timer
+    for (timerId = 0; timerId < pTimerQueue->maxTimerCount && pOwner->ownTimerCount != 0; timerId++) {
+        if (pTimerQueue->pTimers[timerId].timerCallbackFn != NULL && pTimerQueue->pTimers[timerId].pOwner == pOwner) {
+            CHK_STATUS(priv_timer_queue_cancelTimerLocked(pTimerQueue, pOwner, timerId, pTimerQueue->pTimers[timerId].customData));
+        }
     }
 
-    pTimerQueue->invokeTime = invokeTime;
+    CHK_STATUS(priv_timer_queue_awaitCallback(pTimerQueue, pOwner, MAX_UINT32, 0, FALSE));
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * @brief drop a reference to a queue running the executor, the last one frees it.
+ */
+static STATUS priv_timer_queue_release(PTimerQueue pTimerQueue)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pTimerQueue != NULL, retStatus);
+
+    if (ATOMIC_DECREMENT(&pTimerQueue->refCount) == 1) {
+        CHK_STATUS(priv_timer_queue_freeInternal(&pTimerQueue));
+    }
 
 CleanUp:
 
@@ -555,8 +828,10 @@ PVOID timer_queue_executor(PVOID pArgs)
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PTimerQueue pTimerQueue = (PTimerQueue) pArgs;
-    UINT64 curTime;
-    UINT32 i, index, removeCount;
+    PTimerEntry pTimerEntry;
+    TimerCallbackFunc timerCallbackFn;
+    UINT64 curTime, invokeTime, customData;
+    UINT32 timerId, dueCount, i;
     BOOL locked = FALSE;
 
     CHK(pTimerQueue != NULL, STATUS_NULL_ARG);
@@ -581,42 +856,57 @@ PVOID timer_queue_executor(PVOID pArgs)
 
         // Check for the shutdown
         if (!ATOMIC_LOAD_BOOL(&pTimerQueue->shutdown)) {
-            // Check the time against timers
+            // Only the timers at the top of the heap are due, they are taken off the top before any callback runs
             curTime = GETTIME();
-            removeCount = 0;
-            for (i = 0, index = 0; index < pTimerQueue->activeTimerCount && i < pTimerQueue->maxTimerCount; i++) {
-                if (pTimerQueue->pTimers[i].timerCallbackFn != NULL) {
-                    index++;
-
-                    if (curTime >= pTimerQueue->pTimers[i].invokeTime) {
-                        // Call the callback while locked. The executor lock is locked at this time upon cvar awakening
-                        retStatus = pTimerQueue->pTimers[i].timerCallbackFn(i, curTime, pTimerQueue->pTimers[i].customData);
-
-                        // Check for the terminal condition and for single invoke timers
-                        if (retStatus == STATUS_TIMER_QUEUE_STOP_SCHEDULING ||
-                            pTimerQueue->pTimers[i].period == TIMER_QUEUE_SINGLE_INVOCATION_PERIOD) {
-                            // Reset the return
-                            retStatus = STATUS_SUCCESS;
-
-                            // Reset the time entry
-                            pTimerQueue->pTimers[i].timerCallbackFn = NULL;
-
-                            // Need to remove from active count
-                            removeCount++;
-                        }
+            dueCount = 0;
+            while (pTimerQueue->activeTimerCount != 0 && curTime >= TIMER_QUEUE_HEAP_INVOKE_TIME(pTimerQueue, 0)) {
+                timerId = pTimerQueue->pHeap[0];
+                pTimerEntry = &pTimerQueue->pTimers[timerId];
+                pTimerQueue->pDueTimers[dueCount].timerId = timerId;
+                pTimerQueue->pDueTimers[dueCount].generation = pTimerEntry->generation;
+                dueCount++;
+
+                // Set the new invoke, a single invoke timer stays at the bottom of the heap until its callback returned
+                invokeTime = pTimerEntry->period == TIMER_QUEUE_SINGLE_INVOCATION_PERIOD ? MAX_UINT64 : curTime + pTimerEntry->period;
+                priv_timer_queue_rescheduleTimer(pTimerQueue, timerId, invokeTime);
+            }
 
-                        // Warn the user on error
-                        CHK_LOG_ERR(retStatus);
+            // Call the callbacks without the lock, so a slow one does not hold up the other threads using the timer queue
+            for (i = 0; i < dueCount && !ATOMIC_LOAD_BOOL(&pTimerQueue->shutdown); i++) {
+                timerId = pTimerQueue->pDueTimers[i].timerId;
+                pTimerEntry = &pTimerQueue->pTimers[timerId];
+
+                // The timer may have been cancelled by an earlier callback or another thread, and the id given to a new timer
+                if (pTimerEntry->timerCallbackFn != NULL && pTimerEntry->generation == pTimerQueue->pDueTimers[i].generation) {
+                    timerCallbackFn = pTimerEntry->timerCallbackFn;
+                    customData = pTimerEntry->customData;
+                    pTimerQueue->runningTimerId = timerId;
+                    pTimerQueue->runningCustomData = customData;
+                    pTimerQueue->pRunningOwner = pTimerEntry->pOwner;
+                    MUTEX_UNLOCK(pTimerQueue->executorLock);
+
+                    retStatus = timerCallbackFn(timerId, curTime, customData);
+
+                    MUTEX_LOCK(pTimerQueue->executorLock);
+                    pTimerQueue->runningTimerId = MAX_UINT32;
+                    pTimerQueue->callbackCount++;
+                    CVAR_BROADCAST(pTimerQueue->callbackCvar);
+
+                    // Check for the terminal condition and for single invoke timers, unless the callback cancelled its timer
+                    if (pTimerEntry->timerCallbackFn != NULL && pTimerEntry->generation == pTimerQueue->pDueTimers[i].generation &&
+                        (retStatus == STATUS_TIMER_QUEUE_STOP_SCHEDULING || pTimerEntry->period == TIMER_QUEUE_SINGLE_INVOCATION_PERIOD)) {
+                        priv_timer_queue_removeTimer(pTimerQueue, timerId);
+                    }
 
-                        // Set the new invoke
-                        pTimerQueue->pTimers[i].invokeTime = curTime + pTimerQueue->pTimers[i].period;
+                    if (retStatus == STATUS_TIMER_QUEUE_STOP_SCHEDULING) {
+                        retStatus = STATUS_SUCCESS;
                     }
+
+                    // Warn the user on error
+                    CHK_LOG_ERR(retStatus);
                 }
             }
 
-            // Decrement the active timer count
-            pTimerQueue->activeTimerCount -= removeCount;
-
             // Re-evaluate again
             CHK_STATUS(priv_timer_queue_evaluateNextInvocation(pTimerQueue));
         }
@@ -100,12 +100,42 @@ typedef struct __TimerEntry {
     UINT64 invokeTime;
     UINT64 customData;
     TimerCallbackFunc timerCallbackFn;
+    // the queue the timer was added through
+    struct __TimerQueue* pOwner;
+    // position of the timer in the heap while it is active
+    UINT32 heapIndex;
+    // bumped every time the entry is given to a new timer
+    UINT32 generation;
 } TimerEntry, *PTimerEntry;
 
+typedef struct __TimerQueueDueTimer {
+    UINT32 timerId;
+    // the generation the timer had when it was found due, a different one means the timer was cancelled meanwhile
+    UINT32 generation;
+} TimerQueueDueTimer, *PTimerQueueDueTimer;
+
 /**
- * Internal timer queue definition
+ * Internal timer queue definition. The timer id is the index of the entry, the active timers are also kept in a binary
+ * min-heap of ids ordered by invokeTime and the free ids in a stack, so adding, cancelling and rescheduling a timer are
+ * O(log n) and the executor only looks at the timers which are due.
+ *
+ * A timer queue either runs its own executor thread, or is attached to another queue and keeps its timers in that one. The
+ * timers added through an attached queue are counted, cancelled and shut down apart from the others. The entries are
+ * allocated once, maxTimerCount bounds the timers of the queue and of all the queues attached to it together. An attached
+ * queue always gets the timers reserved for it, its other timers and the ones of the shared queue itself only get the
+ * entries no queue has reserved.
  */
 typedef struct __TimerQueue {
+    // the queue which keeps the timers and runs the executor, the queue itself unless it is attached to another one
+    struct __TimerQueue* pSharedQueue;
+    // the queue itself and the queues attached to it, it is freed with the last one
+    volatile SIZE_T refCount;
+    // the timers added through this queue
+    UINT32 ownTimerCount;
+    // the timers promised to the attached queues on the shared queue, the timers promised to this queue on an attached one
+    UINT32 reservedTimerCount;
+    // on the shared queue, the active timers beyond the reserve of their queue, they share what the reserves leave of maxTimerCount
+    UINT32 unreservedTimerCount;
     volatile TID executorTid;
     volatile ATOMIC_BOOL shutdown;
     volatile ATOMIC_BOOL terminated;
@@ -119,7 +149,21 @@ typedef struct __TimerQueue {
     CVAR startCvar;
     MUTEX exitLock;
     CVAR exitCvar;
+    // broadcast every time a callback returns
+    CVAR callbackCvar;
+    // the timer whose callback runs without the executor lock, MAX_UINT32 when none runs
+    UINT32 runningTimerId;
+    UINT64 runningCustomData;
+    struct __TimerQueue* pRunningOwner;
+    // the callbacks which returned so far
+    UINT64 callbackCount;
     PTimerEntry pTimers;
+    // activeTimerCount ids, pTimers[pHeap[0]] is invoked first
+    PUINT32 pHeap;
+    // maxTimerCount - activeTimerCount ids
+    PUINT32 pFreeIds;
+    // the timers found due by the executor, called back one after the other
+    PTimerQueueDueTimer pDueTimers;
 } TimerQueue, *PTimerQueue;
 
 // Public handle to and from object converters
@@ -155,10 +199,58 @@ STATUS timer_queue_create(PTIMER_QUEUE_HANDLE pHandle);
  * @return STATUS status of execution.
  */
 STATUS timer_queue_createEx(PTIMER_QUEUE_HANDLE pHandle, PCHAR timerName, UINT32 threadSize);
+/**
+ * @brief create the timer queue with room for more timers than DEFAULT_TIMER_QUEUE_TIMER_COUNT.
+ *
+ * @param[in, out] pHandle the handle of the timer queue.
+ * @param[in] timerName the thread name of the timer queue.
+ * @param[in] threadSize the thread size of the timer queue.
+ * @param[in] maxTimerCount the most timers active at the same time.
+ *
+ * @return STATUS status of execution.
+ */
+STATUS timer_queue_createWithCapacity(PTIMER_QUEUE_HANDLE pHandle, PCHAR timerName, UINT32 threadSize, UINT32 maxTimerCount);
+/**
+ * @brief create the timer queue with its executor thread pinned to a cpu.
+ *
+ * @param[in, out] pHandle the handle of the timer queue.
+ * @param[in] timerName the thread name of the timer queue.
+ * @param[in] threadSize the thread size of the timer queue.
+ * @param[in] maxTimerCount the most timers active at the same time.
+ * @param[in] cpu the cpu the executor runs on, THREAD_ANY_CPU to let the scheduler pick.
+ *
+ * @return STATUS status of execution.
+ */
+STATUS timer_queue_createOnCpu(PTIMER_QUEUE_HANDLE pHandle, PCHAR timerName, UINT32 threadSize, UINT32 maxTimerCount, INT32 cpu);
+/**
+ * @brief create a timer queue which has no thread of its own, its timers are kept and called back by another timer queue.
+ *        Many peer connections share one executor thread this way. The shared queue is freed with the last queue attached
+ *        to it, timer_queue_shutdown and timer_queue_free on an attached queue only cancel the timers added through it.
+ *
+ * @param[in] sharedHandle the handle of the timer queue running the executor.
+ * @param[in, out] pHandle the handle of the attached timer queue.
+ *
+ * @return STATUS status of execution.
+ */
+STATUS timer_queue_attach(TIMER_QUEUE_HANDLE sharedHandle, PTIMER_QUEUE_HANDLE pHandle);
+/**
+ * @brief attach like timer_queue_attach, as long as the shared queue can still promise reservedTimerCount timers to the
+ *        attached queue on top of the ones promised to the queues already attached and the unreserved ones in use. The
+ *        shared queue does not grow, a caller which needs more timers than are left creates a queue of its own instead.
+ *        Timers beyond the reserve are only added while some entries are neither reserved nor in use.
+ *
+ * @param[in] sharedHandle the handle of the timer queue running the executor.
+ * @param[in] reservedTimerCount the timers the attached queue is going to have active at the same time.
+ * @param[in, out] pHandle the handle of the attached timer queue.
+ *
+ * @return STATUS_MAX_TIMER_COUNT_REACHED when the shared queue cannot promise the timers.
+ */
+STATUS timer_queue_attachWithReserve(TIMER_QUEUE_HANDLE sharedHandle, UINT32 reservedTimerCount, PTIMER_QUEUE_HANDLE pHandle);
 /**
  * @brief Frees the Timer queue object
  *
- * NOTE: The call is idempotent.
+ * NOTE: The call is idempotent. The executor of a queue which others are attached to stops with the last of them, the
+ * timers added through the freed queue are cancelled right away.
  *
  * @param[in, out] pHandle Timer queue handle to free
  *
@@ -187,6 +279,9 @@ STATUS timer_queue_addTimer(TIMER_QUEUE_HANDLE handle, UINT64 start, UINT64 peri
  * another timer but then user 1 cancel timeId it first received. Without checking custom data user 2's timer
  * would be deleted by user 1.
  *
+ * NOTE: The callbacks run without the timer queue lock. When the callback of the timer runs on the executor thread, the cancel
+ * returns once it is done, so the custom data can be freed right after. A callback cancelling timers does not wait for itself.
+ *
  * @param[in] TIMER_QUEUE_HANDLE Timer queue handle
  * @param[in] UINT32 Timer id to cancel
  * @param[in] UINT64 provided customData. CustomData needs to match in order to successfully cancel.
@@ -195,7 +290,7 @@ STATUS timer_queue_addTimer(TIMER_QUEUE_HANDLE handle, UINT64 start, UINT64 peri
  */
 STATUS timer_queue_cancelTimer(TIMER_QUEUE_HANDLE, UINT32, UINT64);
 /**
- * @brief Cancel all timers with customData
+ * @brief Cancel all timers with customData, waiting for their running callback like timer_queue_cancelTimer
  *
  * @param[in] TIMER_QUEUE_HANDLE Timer queue handle
  * @param[in] UINT64 provided customData.
@@ -248,7 +343,7 @@ STATUS timer_queue_getTimersByCustomData(TIMER_QUEUE_HANDLE, UINT64, PUINT32, PU
 STATUS timer_queue_updateTimerPeriod(TIMER_QUEUE_HANDLE, UINT64, UINT32, UINT64);
 /**
  * @brief stop the timer. Once stopped timer can't be restarted. There will be no more timer callback invocation after
- * timer_queue_shutdown returns.
+ * timer_queue_shutdown returns. An attached queue cancels its own timers and refuses new ones, the shared executor keeps going.
  *
  * @param[in] TIMER_QUEUE_HANDLE Timer queue handle
  *
@@ -1,4 +1,6 @@
 #include "WebRTCClientTestFixture.h"
+#include <algorithm>
+#include <vector>
 
 namespace com {
 namespace amazonaws {
@@ -9,6 +11,47 @@ namespace webrtcclient {
 class JitterBufferFunctionalityTest : public WebRtcClientTestBase {
 };
 
+#define JITTER_BUFFER_BENCHMARK_PACKET_COUNT       20000
+#define JITTER_BUFFER_LOSS_BENCHMARK_FRAME_COUNT   3000
+#define JITTER_BUFFER_LOSS_BENCHMARK_FRAME_PACKETS 10
+#define JITTER_BUFFER_LOSS_BENCHMARK_LOSS_PERCENT  5
+
+typedef struct {
+    PJitterBuffer pJitterBuffer;
+    UINT32 readyFrameCount;
+    UINT32 droppedFrameCount;
+    BYTE frame[256];
+} JitterBufferBenchmarkContext, *PJitterBufferBenchmarkContext;
+
+static STATUS benchmarkFrameReadyFunc(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 frameSize)
+{
+    PJitterBufferBenchmarkContext pContext = (PJitterBufferBenchmarkContext) customData;
+    UINT32 filledSize = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_fillFrameData(pContext->pJitterBuffer, pContext->frame, frameSize, &filledSize, startIndex, endIndex));
+    EXPECT_EQ(frameSize, filledSize);
+    pContext->readyFrameCount++;
+    return STATUS_SUCCESS;
+}
+
+static UINT32 gDepayCallCount = 0;
+
+static STATUS countingDepayRtpFunc(PBYTE payload, UINT32 payloadLength, PBYTE outBuffer, PUINT32 pBufferSize, PBOOL pIsStart)
+{
+    gDepayCallCount++;
+    return WebRtcClientTestBase::testDepayRtpFunc(payload, payloadLength, outBuffer, pBufferSize, pIsStart);
+}
+
+static STATUS benchmarkFrameDroppedFunc(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 timestamp)
+{
+    UNUSED_PARAM(startIndex);
+    UNUSED_PARAM(endIndex);
+    UNUSED_PARAM(timestamp);
+    ((PJitterBufferBenchmarkContext) customData)->droppedFrameCount++;
+    return STATUS_SUCCESS;
+}
+
 // Also works as closeBufferWithSingleContinousPacket
 TEST_F(JitterBufferFunctionalityTest, continousPacketsComeInOrder)
 {
@@ -772,6 +815,514 @@ TEST_F(JitterBufferFunctionalityTest, pushFrameArrivingLate)
     clearJitterBufferForTest();
 }
 
+TEST_F(JitterBufferFunctionalityTest, ringSlotReusedByNewerPacket)
+{
+    UINT32 i = 0;
+    PRtpPacket pRtpPacket = NULL;
+    initializeJitterBuffer(1, 1, 2);
+
+    // First frame "1" at timestamp 100 - rtp packet #0
+    mPRtpPackets[0]->payloadLength = 1;
+    mPRtpPackets[0]->payload = (PBYTE) MEMALLOC(mPRtpPackets[0]->payloadLength + 1);
+    mPRtpPackets[0]->payload[0] = 1;
+    mPRtpPackets[0]->payload[1] = 1; // First packet of a frame
+    mPRtpPackets[0]->header.timestamp = 100;
+    mPRtpPackets[0]->header.sequenceNumber = 0;
+
+    // Packet #0 is evicted by packet #ringSize landing on the same slot, its frame is dropped at close
+    mExpectedDroppedFrameTimestampArr[0] = 100;
+
+    // Second frame "2" at timestamp 200 - rtp packet #ringSize
+    mPRtpPackets[1]->payloadLength = 1;
+    mPRtpPackets[1]->payload = (PBYTE) MEMALLOC(mPRtpPackets[1]->payloadLength + 1);
+    mPRtpPackets[1]->payload[0] = 2;
+    mPRtpPackets[1]->payload[1] = 1; // First packet of a frame
+    mPRtpPackets[1]->header.timestamp = 200;
+    mPRtpPackets[1]->header.sequenceNumber = (UINT16) mJitterBuffer->ringSize;
+
+    // Expected to get frame "2" at close
+    mPExpectedFrameArr[0] = (PBYTE) MEMALLOC(1);
+    mPExpectedFrameArr[0][0] = 2;
+    mExpectedFrameSizeArr[0] = 1;
+
+    setPayloadToFree();
+
+    for (i = 0; i < 2; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(mJitterBuffer, mPRtpPackets[i], nullptr));
+        EXPECT_EQ(0, mReadyFrameIndex);
+        EXPECT_EQ(0, mDroppedFrameIndex);
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_getPacket(mJitterBuffer, 0, &pRtpPacket));
+    EXPECT_TRUE(pRtpPacket == NULL);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_getPacket(mJitterBuffer, (UINT16) mJitterBuffer->ringSize, &pRtpPacket));
+    EXPECT_TRUE(pRtpPacket == mPRtpPackets[1]);
+    EXPECT_EQ(1, mJitterBuffer->packetCount);
+    EXPECT_EQ(mJitterBuffer->ringSize, mJitterBuffer->tailSequenceNumber);
+
+    clearJitterBufferForTest();
+}
+
+TEST_F(JitterBufferFunctionalityTest, ringIsSizedFromMaxLatencyAndClockRate)
+{
+    PJitterBuffer pJitterBuffer = NULL;
+
+    // 2 s of video at the highest packet rate
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(testFrameReadyFunc, testFrameDroppedFunc, testDepayRtpFunc, 2 * HUNDREDS_OF_NANOS_IN_A_SECOND,
+                                   JITTER_BUFFER_VIDEO_CLOCK_RATE, (UINT64) this, &pJitterBuffer));
+    EXPECT_LE(2 * JITTER_BUFFER_MAX_VIDEO_PACKET_RATE, pJitterBuffer->ringSize);
+    EXPECT_EQ(0, pJitterBuffer->ringSize & pJitterBuffer->ringMask);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&pJitterBuffer));
+
+    // never more than the sequence number space
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(testFrameReadyFunc, testFrameDroppedFunc, testDepayRtpFunc, 60 * HUNDREDS_OF_NANOS_IN_A_SECOND,
+                                   JITTER_BUFFER_VIDEO_CLOCK_RATE, (UINT64) this, &pJitterBuffer));
+    EXPECT_EQ(JITTER_BUFFER_RING_MAX_SIZE, pJitterBuffer->ringSize);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&pJitterBuffer));
+
+    // audio needs far fewer slots
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(testFrameReadyFunc, testFrameDroppedFunc, testDepayRtpFunc, 2 * HUNDREDS_OF_NANOS_IN_A_SECOND, 48000,
+                                   (UINT64) this, &pJitterBuffer));
+    EXPECT_EQ(JITTER_BUFFER_RING_MIN_SIZE, pJitterBuffer->ringSize);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&pJitterBuffer));
+}
+
+TEST_F(JitterBufferFunctionalityTest, tailFollowsSequenceNumberWrap)
+{
+    UINT32 i = 0;
+    initializeJitterBuffer(0, 0, 3);
+
+    // Packets #65534 #1 #65535, the tail stays on #1 as it is the furthest from the start
+    mPRtpPackets[0]->header.sequenceNumber = 65534;
+    mPRtpPackets[1]->header.sequenceNumber = 1;
+    mPRtpPackets[2]->header.sequenceNumber = 65535;
+    for (i = 0; i < 3; i++) {
+        mPRtpPackets[i]->payloadLength = 1;
+        mPRtpPackets[i]->payload = (PBYTE) MEMALLOC(mPRtpPackets[i]->payloadLength + 1);
+        mPRtpPackets[i]->payload[0] = (BYTE) i;
+        mPRtpPackets[i]->payload[1] = 0; // Following packet of a frame, never complete
+        mPRtpPackets[i]->header.timestamp = 100;
+    }
+
+    setPayloadToFree();
+
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(mJitterBuffer, mPRtpPackets[0], nullptr));
+    EXPECT_EQ(65534, mJitterBuffer->tailSequenceNumber);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(mJitterBuffer, mPRtpPackets[1], nullptr));
+    EXPECT_EQ(1, mJitterBuffer->tailSequenceNumber);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(mJitterBuffer, mPRtpPackets[2], nullptr));
+    EXPECT_EQ(1, mJitterBuffer->tailSequenceNumber);
+    EXPECT_EQ(3, mJitterBuffer->packetCount);
+
+    // Dropping the whole range across the wrap leaves nothing behind
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_dropBufferData(mJitterBuffer, 65534, 1, 100));
+    EXPECT_EQ(0, mJitterBuffer->packetCount);
+
+    clearJitterBufferForTest();
+}
+
+// Per packet cost of a push that completes the previous frame, including depay and frame fill. Run it on the revision
+// before the ring to compare with the hash table jitter buffer.
+TEST_F(JitterBufferFunctionalityTest, benchmarkPushPopPerPacket)
+{
+    JitterBufferBenchmarkContext context;
+    PRtpPacket pRtpPacket = NULL;
+    PBYTE pPayload = NULL;
+    UINT64 startTime, elapsed;
+    UINT32 i;
+    UINT16 seqNum;
+
+    MEMSET(&context, 0x00, SIZEOF(JitterBufferBenchmarkContext));
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(benchmarkFrameReadyFunc, benchmarkFrameDroppedFunc, testDepayRtpFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY,
+                                   TEST_JITTER_BUFFER_CLOCK_RATE, (UINT64) &context, &context.pJitterBuffer));
+
+    startTime = GETTIME();
+    // Start close to the end of the sequence number space to go through the wrap
+    for (i = 0, seqNum = 65000; i < JITTER_BUFFER_BENCHMARK_PACKET_COUNT; i++, seqNum++) {
+        pPayload = (PBYTE) MEMALLOC(2);
+        pPayload[0] = (BYTE) i;
+        pPayload[1] = 1; // every packet is a single packet frame
+        EXPECT_EQ(STATUS_SUCCESS,
+                  rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, seqNum, i + 1, 0x1234ABCD, NULL, 0, 0, NULL, pPayload, 1, &pRtpPacket));
+        pRtpPacket->pRawPacket = pPayload;
+        EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(context.pJitterBuffer, pRtpPacket, nullptr));
+    }
+    elapsed = GETTIME() - startTime;
+
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&context.pJitterBuffer));
+    EXPECT_EQ(JITTER_BUFFER_BENCHMARK_PACKET_COUNT, context.readyFrameCount);
+    EXPECT_EQ(0, context.droppedFrameCount);
+
+    DLOGI("Jitter buffer push/pop per packet: %" PRIu64 " ns", elapsed * DEFAULT_TIME_UNIT_IN_NANOS / JITTER_BUFFER_BENCHMARK_PACKET_COUNT);
+}
+
+// Worst case for frame assembly: multi-packet frames under 5% random loss, where the head frame waits on its hole for the
+// whole max latency while later frames keep arriving. Every packet should only be depacketized a bounded number of times.
+TEST_F(JitterBufferFunctionalityTest, benchmarkAssemblyUnderRandomLoss)
+{
+    JitterBufferBenchmarkContext context;
+    PRtpPacket pRtpPacket = NULL;
+    PBYTE pPayload = NULL;
+    UINT64 startTime, elapsed;
+    UINT32 i, j, pushedCount = 0, lossSeed = 12345;
+    UINT16 seqNum = 60000;
+
+    MEMSET(&context, 0x00, SIZEOF(JitterBufferBenchmarkContext));
+    gDepayCallCount = 0;
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(benchmarkFrameReadyFunc, benchmarkFrameDroppedFunc, countingDepayRtpFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY,
+                                   TEST_JITTER_BUFFER_CLOCK_RATE, (UINT64) &context, &context.pJitterBuffer));
+
+    startTime = GETTIME();
+    for (i = 0; i < JITTER_BUFFER_LOSS_BENCHMARK_FRAME_COUNT; i++) {
+        for (j = 0; j < JITTER_BUFFER_LOSS_BENCHMARK_FRAME_PACKETS; j++, seqNum++) {
+            // Fixed LCG so the loss pattern does not change between runs
+            lossSeed = lossSeed * 1103515245 + 12345;
+            if ((lossSeed >> 16) % 100 < JITTER_BUFFER_LOSS_BENCHMARK_LOSS_PERCENT) {
+                continue;
+            }
+            pPayload = (PBYTE) MEMALLOC(2);
+            pPayload[0] = (BYTE) j;
+            pPayload[1] = (j == 0); // First packet of a frame
+            EXPECT_EQ(STATUS_SUCCESS,
+                      rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, seqNum, 1 + i * 33, 0x1234ABCD, NULL, 0, 0, NULL, pPayload, 1, &pRtpPacket));
+            pRtpPacket->pRawPacket = pPayload;
+            EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(context.pJitterBuffer, pRtpPacket, nullptr));
+            pushedCount++;
+        }
+    }
+    elapsed = GETTIME() - startTime;
+
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&context.pJitterBuffer));
+    EXPECT_LT(0, context.readyFrameCount);
+    EXPECT_LT(0, context.droppedFrameCount);
+    EXPECT_GE(JITTER_BUFFER_LOSS_BENCHMARK_FRAME_COUNT, context.readyFrameCount + context.droppedFrameCount);
+
+    DLOGI("Jitter buffer under %u%% loss: %u ns and %.2f depacketizations per packet, %u frames ready, %u dropped",
+          JITTER_BUFFER_LOSS_BENCHMARK_LOSS_PERCENT, (UINT32) (elapsed * DEFAULT_TIME_UNIT_IN_NANOS / pushedCount),
+          (DOUBLE) gDepayCallCount / pushedCount, context.readyFrameCount, context.droppedFrameCount);
+    // sizing while walking plus copying out, no rescans
+    EXPECT_GE(3 * pushedCount, gDepayCallCount);
+}
+
+#define JITTER_BUFFER_TRACE_CLOCK_RATE 90000
+#define JITTER_BUFFER_TRACE_FRAME_RATE 30
+#define JITTER_BUFFER_TRACE_START_TIME (1000 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+typedef struct {
+    PJitterBuffer pJitterBuffer;
+    UINT32 readyFrameCount;
+    UINT32 droppedFrameCount;
+    UINT32 earlyFrameCount;
+    UINT32 nextFrame;
+    UINT64 heldTime; // 100ns precision, from the arrival of a frame to its release
+    UINT64 now;
+    BYTE frame[256];
+} JitterBufferTraceContext, *PJitterBufferTraceContext;
+
+static STATUS traceFrameReadyFunc(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 frameSize)
+{
+    PJitterBufferTraceContext pContext = (PJitterBufferTraceContext) customData;
+    PJitterBufferDelayEstimator pEstimator = &pContext->pJitterBuffer->delayEstimator;
+    PRtpPacket pPacket = NULL;
+    UINT32 filledSize = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_getPacket(pContext->pJitterBuffer, startIndex, &pPacket));
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_fillFrameData(pContext->pJitterBuffer, pContext->frame, frameSize, &filledSize, startIndex, endIndex));
+    if (pEstimator->enabled && (INT32)(pEstimator->now - pPacket->header.timestamp - pEstimator->baseTransit) < (INT32) pEstimator->targetDelay) {
+        pContext->earlyFrameCount++;
+    }
+    pContext->heldTime += pContext->now - pPacket->receivedTime;
+    pContext->readyFrameCount++;
+    return STATUS_SUCCESS;
+}
+
+static STATUS traceFrameDroppedFunc(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 timestamp)
+{
+    UNUSED_PARAM(startIndex);
+    UNUSED_PARAM(endIndex);
+    UNUSED_PARAM(timestamp);
+    ((PJitterBufferTraceContext) customData)->droppedFrameCount++;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Replay the next single packet frames of a 30 fps stream in the order the arrival trace delays them to, the trace
+ * holds the delay of every frame in ms and repeats.
+ */
+static VOID replayArrivalTrace(PJitterBufferTraceContext pContext, const UINT32* pTraceMs, UINT32 traceLen, UINT32 frameCount)
+{
+    std::vector<std::pair<UINT64, UINT32>> arrivals;
+    PRtpPacket pRtpPacket = NULL;
+    PBYTE pPayload = NULL;
+    UINT32 i, frame;
+    UINT64 sendTime;
+
+    for (i = 0, frame = pContext->nextFrame; i < frameCount; i++, frame++) {
+        sendTime = JITTER_BUFFER_TRACE_START_TIME + (UINT64) frame * HUNDREDS_OF_NANOS_IN_A_SECOND / JITTER_BUFFER_TRACE_FRAME_RATE;
+        arrivals.push_back(std::make_pair(sendTime + pTraceMs[i % traceLen] * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, frame));
+    }
+    std::sort(arrivals.begin(), arrivals.end());
+
+    for (i = 0; i < frameCount; i++) {
+        frame = arrivals[i].second;
+        pPayload = (PBYTE) MEMALLOC(2);
+        pPayload[0] = (BYTE) frame;
+        pPayload[1] = 1; // every packet is a single packet frame
+        EXPECT_EQ(STATUS_SUCCESS,
+                  rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, (UINT16)(65000 + frame),
+                                    frame * (JITTER_BUFFER_TRACE_CLOCK_RATE / JITTER_BUFFER_TRACE_FRAME_RATE), 0x1234ABCD, NULL, 0, 0, NULL,
+                                    pPayload, 1, &pRtpPacket));
+        pRtpPacket->pRawPacket = pPayload;
+        pRtpPacket->receivedTime = arrivals[i].first;
+        pContext->now = arrivals[i].first;
+        EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(pContext->pJitterBuffer, pRtpPacket, nullptr));
+    }
+    pContext->nextFrame += frameCount;
+}
+
+TEST_F(JitterBufferFunctionalityTest, adaptiveDelayFollowsArrivalTrace)
+{
+    // 2 of every 20 frames are 60 ms late and arrive after the following frames
+    const UINT32 jitteryTrace[] = {3, 0, 12, 5, 60, 8, 1, 15, 4, 9, 0, 6, 18, 2, 60, 7, 11, 3, 0, 14};
+    const UINT32 calmTrace[] = {0, 2, 1, 3, 0, 4, 1, 2};
+    JitterBufferTraceContext context, fixedContext;
+    UINT64 targetDelay = 0;
+
+    MEMSET(&context, 0x00, SIZEOF(JitterBufferTraceContext));
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(traceFrameReadyFunc, traceFrameDroppedFunc, testDepayRtpFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY,
+                                   JITTER_BUFFER_TRACE_CLOCK_RATE, (UINT64) &context, &context.pJitterBuffer));
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_setAdaptiveDelay(context.pJitterBuffer, TRUE));
+
+    // the 95th percentile waits for the late frames
+    replayArrivalTrace(&context, jitteryTrace, ARRAY_SIZE(jitteryTrace), 1000);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_getTargetDelay(context.pJitterBuffer, &targetDelay));
+    EXPECT_LE(60 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, targetDelay);
+    EXPECT_GE(80 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, targetDelay);
+    EXPECT_EQ(0, context.earlyFrameCount);
+    EXPECT_EQ(0, context.droppedFrameCount);
+    EXPECT_LE(990, context.readyFrameCount);
+
+    // once the late frames stop and the histogram forgot them, the target comes down again
+    replayArrivalTrace(&context, calmTrace, ARRAY_SIZE(calmTrace), 3000);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_getTargetDelay(context.pJitterBuffer, &targetDelay));
+    EXPECT_GE(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, targetDelay);
+    EXPECT_EQ(0, context.earlyFrameCount);
+    EXPECT_EQ(0, context.droppedFrameCount);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&context.pJitterBuffer));
+
+    // without the adaptive mode the same frames go out as soon as they are complete
+    MEMSET(&fixedContext, 0x00, SIZEOF(JitterBufferTraceContext));
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(traceFrameReadyFunc, traceFrameDroppedFunc, testDepayRtpFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY,
+                                   JITTER_BUFFER_TRACE_CLOCK_RATE, (UINT64) &fixedContext, &fixedContext.pJitterBuffer));
+    replayArrivalTrace(&fixedContext, jitteryTrace, ARRAY_SIZE(jitteryTrace), 1000);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_getTargetDelay(fixedContext.pJitterBuffer, &targetDelay));
+    EXPECT_EQ(0, targetDelay);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&fixedContext.pJitterBuffer));
+    EXPECT_LT(fixedContext.heldTime / fixedContext.readyFrameCount, context.heldTime / context.readyFrameCount);
+}
+
+TEST_F(JitterBufferFunctionalityTest, extraDelayHoldsFramesWithoutAdaptiveMode)
+{
+    const UINT32 calmTrace[] = {0, 2, 1, 3, 0, 4, 1, 2};
+    JitterBufferTraceContext context;
+
+    MEMSET(&context, 0x00, SIZEOF(JitterBufferTraceContext));
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(traceFrameReadyFunc, traceFrameDroppedFunc, testDepayRtpFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY,
+                                   JITTER_BUFFER_TRACE_CLOCK_RATE, (UINT64) &context, &context.pJitterBuffer));
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_setExtraDelay(context.pJitterBuffer, 100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND));
+
+    // every frame waits for the extra delay on top of the fastest one, at most one frame interval longer
+    replayArrivalTrace(&context, calmTrace, ARRAY_SIZE(calmTrace), 300);
+    EXPECT_EQ(0, context.droppedFrameCount);
+    EXPECT_LE(290, context.readyFrameCount);
+    EXPECT_LE(100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, context.heldTime / context.readyFrameCount);
+    EXPECT_GE(140 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, context.heldTime / context.readyFrameCount);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&context.pJitterBuffer));
+}
+
+TEST_F(JitterBufferFunctionalityTest, heldFrameReleasedWithoutNewPackets)
+{
+    JitterBufferTraceContext context;
+    PRtpPacket pRtpPacket = NULL;
+    PBYTE pPayload = NULL;
+    UINT32 i;
+
+    MEMSET(&context, 0x00, SIZEOF(JitterBufferTraceContext));
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(traceFrameReadyFunc, traceFrameDroppedFunc, testDepayRtpFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY,
+                                   JITTER_BUFFER_TRACE_CLOCK_RATE, (UINT64) &context, &context.pJitterBuffer));
+    // nothing is held yet
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_releaseDueFrames(context.pJitterBuffer, JITTER_BUFFER_TRACE_START_TIME));
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_setExtraDelay(context.pJitterBuffer, 100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND));
+
+    // the second frame completes the first one, which is then held for the extra delay
+    for (i = 0; i < 2; i++) {
+        pPayload = (PBYTE) MEMALLOC(2);
+        pPayload[0] = (BYTE) i;
+        pPayload[1] = 1;
+        EXPECT_EQ(STATUS_SUCCESS,
+                  rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, (UINT16)(i + 1),
+                                    i * (JITTER_BUFFER_TRACE_CLOCK_RATE / JITTER_BUFFER_TRACE_FRAME_RATE), 0x1234ABCD, NULL, 0, 0, NULL, pPayload, 1,
+                                    &pRtpPacket));
+        pRtpPacket->pRawPacket = pPayload;
+        pRtpPacket->receivedTime = JITTER_BUFFER_TRACE_START_TIME + (UINT64) i * HUNDREDS_OF_NANOS_IN_A_SECOND / JITTER_BUFFER_TRACE_FRAME_RATE;
+        context.now = pRtpPacket->receivedTime;
+        EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(context.pJitterBuffer, pRtpPacket, nullptr));
+    }
+    EXPECT_EQ(0, context.readyFrameCount);
+
+    context.now = JITTER_BUFFER_TRACE_START_TIME + 90 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_releaseDueFrames(context.pJitterBuffer, context.now));
+    EXPECT_EQ(0, context.readyFrameCount);
+
+    // released on time although no packet followed
+    context.now = JITTER_BUFFER_TRACE_START_TIME + 100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_releaseDueFrames(context.pJitterBuffer, context.now));
+    EXPECT_EQ(1, context.readyFrameCount);
+    EXPECT_EQ(100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, context.heldTime);
+
+    // a check behind the last one does not move the clock back
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_releaseDueFrames(context.pJitterBuffer, JITTER_BUFFER_TRACE_START_TIME));
+    EXPECT_EQ(1, context.readyFrameCount);
+    EXPECT_EQ(0, context.droppedFrameCount);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&context.pJitterBuffer));
+}
+
+typedef struct {
+    PJitterBuffer pJitterBuffer;
+    BYTE copiedFrame[256];
+    BYTE slicedFrame[256];
+    UINT32 copiedSize;
+    UINT32 slicedSize;
+    UINT32 sliceCount;
+    PRtpPacket packets[16];
+    UINT32 packetCount;
+    UINT32 droppedFrameCount;
+} JitterBufferSliceContext, *PJitterBufferSliceContext;
+
+static STATUS sliceFrameReadyFunc(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 frameSize)
+{
+    PJitterBufferSliceContext pContext = (PJitterBufferSliceContext) customData;
+    RtcFrameSlice slices[16];
+    UINT32 i, sliceCount = 0;
+
+    // copy first, slicing rewrites the fu headers
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_fillFrameData(pContext->pJitterBuffer, pContext->copiedFrame, frameSize, &pContext->copiedSize, startIndex, endIndex));
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_fillFrameSlices(pContext->pJitterBuffer, depayH264SlicesFromRtpPayload, NULL, &sliceCount, startIndex, endIndex));
+    EXPECT_GE(ARRAY_SIZE(slices), sliceCount);
+    pContext->sliceCount = ARRAY_SIZE(slices);
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_fillFrameSlices(pContext->pJitterBuffer, depayH264SlicesFromRtpPayload, slices, &pContext->sliceCount, startIndex,
+                                            endIndex));
+    EXPECT_EQ(sliceCount, pContext->sliceCount);
+    for (i = 0; i < pContext->sliceCount; i++) {
+        MEMCPY(pContext->slicedFrame + pContext->slicedSize, slices[i].pData, slices[i].size);
+        pContext->slicedSize += slices[i].size;
+    }
+
+    pContext->packetCount = (UINT16)(endIndex - startIndex + 1);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_detachPackets(pContext->pJitterBuffer, pContext->packets, startIndex, endIndex));
+    return STATUS_SUCCESS;
+}
+
+static STATUS sliceFrameDroppedFunc(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 timestamp)
+{
+    UNUSED_PARAM(startIndex);
+    UNUSED_PARAM(endIndex);
+    UNUSED_PARAM(timestamp);
+    ((PJitterBufferSliceContext) customData)->droppedFrameCount++;
+    return STATUS_SUCCESS;
+}
+
+TEST_F(JitterBufferFunctionalityTest, framesAreSlicedWithoutCopy)
+{
+    // a short nalu sent as a single nalu packet followed by one split into fu-a fragments
+    BYTE frame[4 + 8 + 4 + 100];
+    PayloadArray payloadArray;
+    JitterBufferSliceContext context;
+    PRtpPacket pRtpPacket = NULL;
+    PBYTE pPayload = NULL;
+    UINT32 i, offset = 0;
+
+    MEMSET(frame, 0x00, SIZEOF(frame));
+    frame[3] = 1;
+    frame[4] = 0x67;
+    for (i = 5; i < 12; i++) {
+        frame[i] = (BYTE) i;
+    }
+    frame[15] = 1;
+    frame[16] = 0x65;
+    for (i = 17; i < SIZEOF(frame); i++) {
+        frame[i] = (BYTE) i;
+    }
+
+    MEMSET(&payloadArray, 0x00, SIZEOF(PayloadArray));
+    EXPECT_EQ(STATUS_SUCCESS,
+              createPayloadForH264(40, frame, SIZEOF(frame), NULL, &payloadArray.payloadLength, NULL, &payloadArray.payloadSubLenSize));
+    payloadArray.payloadBuffer = (PBYTE) MEMALLOC(payloadArray.payloadLength);
+    payloadArray.payloadSubLength = (PUINT32) MEMALLOC(payloadArray.payloadSubLenSize * SIZEOF(UINT32));
+    EXPECT_EQ(STATUS_SUCCESS,
+              createPayloadForH264(40, frame, SIZEOF(frame), payloadArray.payloadBuffer, &payloadArray.payloadLength, payloadArray.payloadSubLength,
+                                   &payloadArray.payloadSubLenSize));
+    EXPECT_LT(3, payloadArray.payloadSubLenSize);
+
+    MEMSET(&context, 0x00, SIZEOF(JitterBufferSliceContext));
+    EXPECT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(sliceFrameReadyFunc, sliceFrameDroppedFunc, depayH264FromRtpPayload, DEFAULT_JITTER_BUFFER_MAX_LATENCY,
+                                   TEST_JITTER_BUFFER_CLOCK_RATE, (UINT64) &context, &context.pJitterBuffer));
+
+    // the packet of the next frame releases the first one
+    for (i = 0; i <= payloadArray.payloadSubLenSize; i++) {
+        if (i < payloadArray.payloadSubLenSize) {
+            pPayload = (PBYTE) MEMALLOC(payloadArray.payloadSubLength[i]);
+            MEMCPY(pPayload, payloadArray.payloadBuffer + offset, payloadArray.payloadSubLength[i]);
+            EXPECT_EQ(STATUS_SUCCESS,
+                      rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, (UINT16) i, 100, 0x1234ABCD, NULL, 0, 0, NULL, pPayload,
+                                        payloadArray.payloadSubLength[i], &pRtpPacket));
+            offset += payloadArray.payloadSubLength[i];
+        } else {
+            pPayload = (PBYTE) MEMCALLOC(1, 5);
+            pPayload[0] = 0x41;
+            EXPECT_EQ(STATUS_SUCCESS,
+                      rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, (UINT16) i, 200, 0x1234ABCD, NULL, 0, 0, NULL, pPayload, 5, &pRtpPacket));
+        }
+        pRtpPacket->pRawPacket = pPayload;
+        EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(context.pJitterBuffer, pRtpPacket, nullptr));
+    }
+
+    // the sliced frame is the copied one, and only the packet of the next frame is left behind
+    EXPECT_EQ(SIZEOF(frame), context.copiedSize);
+    EXPECT_EQ(0, MEMCMP(frame, context.copiedFrame, SIZEOF(frame)));
+    EXPECT_EQ(SIZEOF(frame), context.slicedSize);
+    EXPECT_EQ(0, MEMCMP(frame, context.slicedFrame, SIZEOF(frame)));
+    EXPECT_EQ(payloadArray.payloadSubLenSize, context.packetCount);
+    EXPECT_EQ(1, context.pJitterBuffer->packetCount);
+    EXPECT_EQ(0, context.droppedFrameCount);
+    for (i = 0; i < context.packetCount; i++) {
+        EXPECT_NE(nullptr, context.packets[i]);
+        rtp_packet_free(&context.packets[i]);
+    }
+
+    // closing the buffer releases the last frame through the same callback
+    context.slicedSize = 0;
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&context.pJitterBuffer));
+    EXPECT_EQ(1, context.packetCount);
+    EXPECT_EQ(5 + 4, context.slicedSize);
+    rtp_packet_free(&context.packets[0]);
+    MEMFREE(payloadArray.payloadBuffer);
+    MEMFREE(payloadArray.payloadSubLength);
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
@@ -0,0 +1,197 @@
+#include "WebRTCClientTestFixture.h"
+
+#ifdef ENABLE_LOCK_PROFILING
+
+namespace com {
+namespace amazonaws {
+namespace kinesis {
+namespace video {
+namespace webrtcclient {
+
+#define MUTEX_PROFILE_TEST_THREAD_COUNT 4
+#define MUTEX_PROFILE_TEST_ITERATIONS   200
+#define MUTEX_PROFILE_TEST_HOLD_TIME    (50 * HUNDREDS_OF_NANOS_IN_A_MICROSECOND)
+
+class MutexProfileFunctionalityTest : public WebRtcClientTestBase {
+};
+
+typedef struct {
+    MUTEX lock;
+    UINT64 counter;
+} MutexProfileTestContext, *PMutexProfileTestContext;
+
+static PVOID contendRoutine(PVOID pArgs)
+{
+    PMutexProfileTestContext pContext = (PMutexProfileTestContext) pArgs;
+    UINT32 i;
+
+    for (i = 0; i < MUTEX_PROFILE_TEST_ITERATIONS; i++) {
+        MUTEX_LOCK(pContext->lock);
+        pContext->counter++;
+        THREAD_SLEEP(MUTEX_PROFILE_TEST_HOLD_TIME);
+        MUTEX_UNLOCK(pContext->lock);
+    }
+
+    return NULL;
+}
+
+// the counters of the only site of this file which took a mutex since the reset
+static BOOL getTestSite(PMutexProfileSite pTestSite)
+{
+    MutexProfileSite sites[MUTEX_PROFILE_MAX_SITE_COUNT];
+    UINT32 i, siteCount = ARRAY_SIZE(sites), testSiteCount = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, mutex_profile_getSites(sites, &siteCount));
+    for (i = 0; i < siteCount; i++) {
+        if (STRCMP(sites[i].file, __FILE__) == 0 && sites[i].acquisitionCount > 0) {
+            *pTestSite = sites[i];
+            testSiteCount++;
+        }
+    }
+
+    return testSiteCount == 1;
+}
+
+TEST_F(MutexProfileFunctionalityTest, countersIncrementUnderContention)
+{
+    MutexProfileTestContext context;
+    MutexProfileSite site;
+    TID threadIds[MUTEX_PROFILE_TEST_THREAD_COUNT];
+    UINT32 i, siteCount = 0;
+
+    MEMSET(&context, 0x00, SIZEOF(context));
+    context.lock = MUTEX_CREATE(FALSE);
+    ASSERT_TRUE(IS_VALID_MUTEX_VALUE(context.lock));
+    mutex_profile_reset();
+
+    for (i = 0; i < MUTEX_PROFILE_TEST_THREAD_COUNT; i++) {
+        ASSERT_EQ(STATUS_SUCCESS, THREAD_CREATE(&threadIds[i], contendRoutine, (PVOID) &context));
+    }
+    for (i = 0; i < MUTEX_PROFILE_TEST_THREAD_COUNT; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, THREAD_JOIN(threadIds[i], NULL));
+    }
+
+    ASSERT_TRUE(getTestSite(&site));
+    EXPECT_EQ(MUTEX_PROFILE_TEST_THREAD_COUNT * MUTEX_PROFILE_TEST_ITERATIONS, context.counter);
+    EXPECT_EQ(MUTEX_PROFILE_TEST_THREAD_COUNT * MUTEX_PROFILE_TEST_ITERATIONS, site.acquisitionCount);
+    EXPECT_LT(0, site.contendedCount);
+    EXPECT_GE(site.acquisitionCount, site.contendedCount);
+    EXPECT_LT(0, site.totalWaitTime);
+    EXPECT_LE(MUTEX_PROFILE_TEST_HOLD_TIME, site.maxHoldTime);
+
+    EXPECT_EQ(STATUS_NULL_ARG, mutex_profile_getSites(NULL, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, mutex_profile_getSites(NULL, &siteCount));
+    EXPECT_LT(0, siteCount);
+    siteCount = 0;
+    EXPECT_EQ(STATUS_BUFFER_TOO_SMALL, mutex_profile_getSites(&site, &siteCount));
+    mutex_profile_dump();
+
+    mutex_profile_reset();
+    EXPECT_FALSE(getTestSite(&site));
+    MUTEX_FREE(context.lock);
+}
+
+TEST_F(MutexProfileFunctionalityTest, conditionVariableWaitIsNotHeld)
+{
+    MUTEX lock = MUTEX_CREATE(TRUE);
+    CVAR cvar = CVAR_CREATE();
+    MutexProfileSite sites[MUTEX_PROFILE_MAX_SITE_COUNT];
+    UINT32 i, siteCount = ARRAY_SIZE(sites);
+    UINT64 acquisitionCount = 0;
+
+    ASSERT_TRUE(IS_VALID_MUTEX_VALUE(lock));
+    ASSERT_TRUE(IS_VALID_CVAR_VALUE(cvar));
+    mutex_profile_reset();
+
+    // the reentrant lock is held from the outer lock to the outer unlock, less the time the wait released it
+    MUTEX_LOCK(lock);
+    EXPECT_EQ(STATUS_OPERATION_TIMED_OUT, CVAR_WAIT(cvar, lock, 100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND));
+    EXPECT_TRUE(MUTEX_TRYLOCK(lock));
+    MUTEX_UNLOCK(lock);
+    MUTEX_UNLOCK(lock);
+
+    EXPECT_EQ(STATUS_SUCCESS, mutex_profile_getSites(sites, &siteCount));
+    for (i = 0; i < siteCount; i++) {
+        if (STRCMP(sites[i].file, __FILE__) == 0 && sites[i].acquisitionCount > 0) {
+            acquisitionCount += sites[i].acquisitionCount;
+            EXPECT_EQ(0, sites[i].contendedCount);
+            EXPECT_GT(50 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, sites[i].maxHoldTime);
+        }
+    }
+    EXPECT_EQ(2, acquisitionCount);
+
+    CVAR_FREE(cvar);
+    MUTEX_FREE(lock);
+}
+
+typedef struct {
+    pthread_mutex_t mutex;
+    // right behind the mutex, where hold times would land if every mutex was taken for a default one
+    UINT64 canary;
+} MutexProfileTestAppMutex, *PMutexProfileTestAppMutex;
+
+static MUTEX createAppMutex(BOOL reentrant)
+{
+    PMutexProfileTestAppMutex pAppMutex = (PMutexProfileTestAppMutex) MEMCALLOC(1, SIZEOF(MutexProfileTestAppMutex));
+    pthread_mutexattr_t mutexAttributes;
+
+    pthread_mutexattr_init(&mutexAttributes);
+    pthread_mutexattr_settype(&mutexAttributes, reentrant ? PTHREAD_MUTEX_RECURSIVE : PTHREAD_MUTEX_NORMAL);
+    pthread_mutex_init(&pAppMutex->mutex, &mutexAttributes);
+    pAppMutex->canary = 0x5a5a5a5a5a5a5a5aULL;
+
+    return (MUTEX) pAppMutex;
+}
+
+static VOID freeAppMutex(MUTEX mutex)
+{
+    pthread_mutex_destroy((pthread_mutex_t*) mutex);
+    MEMFREE((PVOID) mutex);
+}
+
+TEST_F(MutexProfileFunctionalityTest, mutexOfAnotherCreateFunctionIsNotWritten)
+{
+    createMutex savedCreateMutex = globalCreateMutex;
+    freeMutex savedFreeMutex = globalFreeMutex;
+    MUTEX lock;
+    CVAR cvar = CVAR_CREATE();
+    MutexProfileSite sites[MUTEX_PROFILE_MAX_SITE_COUNT];
+    UINT32 i, siteCount = ARRAY_SIZE(sites);
+    UINT64 acquisitionCount = 0;
+
+    globalCreateMutex = createAppMutex;
+    globalFreeMutex = freeAppMutex;
+    lock = MUTEX_CREATE(TRUE);
+    ASSERT_TRUE(IS_VALID_CVAR_VALUE(cvar));
+    mutex_profile_reset();
+
+    // the lock sites are still counted, the hold times are not measured
+    MUTEX_LOCK(lock);
+    EXPECT_TRUE(MUTEX_TRYLOCK(lock));
+    MUTEX_UNLOCK(lock);
+    EXPECT_EQ(STATUS_OPERATION_TIMED_OUT, CVAR_WAIT(cvar, lock, 10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND));
+    MUTEX_UNLOCK(lock);
+    EXPECT_EQ(0x5a5a5a5a5a5a5a5aULL, ((PMutexProfileTestAppMutex) lock)->canary);
+
+    EXPECT_EQ(STATUS_SUCCESS, mutex_profile_getSites(sites, &siteCount));
+    for (i = 0; i < siteCount; i++) {
+        if (STRCMP(sites[i].file, __FILE__) == 0 && sites[i].acquisitionCount > 0) {
+            acquisitionCount += sites[i].acquisitionCount;
+            EXPECT_EQ(0, sites[i].maxHoldTime);
+        }
+    }
+    EXPECT_EQ(2, acquisitionCount);
+
+    MUTEX_FREE(lock);
+    globalCreateMutex = savedCreateMutex;
+    globalFreeMutex = savedFreeMutex;
+    CVAR_FREE(cvar);
+}
+
+} // namespace webrtcclient
+} // namespace video
+} // namespace kinesis
+} // namespace amazonaws
+} // namespace com
+
+#endif
@@ -153,6 +153,106 @@ a=fmtp:97 profile-level-id=42e01f;level-asymmetry-allowed=1
     EXPECT_STREQ(sdp_fmtpForPayloadType(25, &sessionDescription), NULL);
 }
 
+TEST_F(PeerConnectionApiTest, runtimeSpreadsPeerConnectionsOverItsWorkers)
+{
+    RtcRuntimeConfiguration configuration;
+    PRtcRuntime pRtcRuntime = NULL;
+    TIMER_QUEUE_HANDLE handles[4];
+    INT32 cpus[4];
+    UINT32 i;
+
+    MEMSET(&configuration, 0x00, SIZEOF(configuration));
+    EXPECT_EQ(STATUS_NULL_ARG, rtc_runtime_create(NULL, &pRtcRuntime));
+    EXPECT_EQ(STATUS_INVALID_ARG, rtc_runtime_create(&configuration, &pRtcRuntime));
+    configuration.workerCount = MAX_RTC_RUNTIME_WORKER_COUNT + 1;
+    EXPECT_EQ(STATUS_INVALID_ARG, rtc_runtime_create(&configuration, &pRtcRuntime));
+    EXPECT_TRUE(pRtcRuntime == NULL);
+
+    configuration.workerCount = 2;
+    configuration.pinWorkers = TRUE;
+    ASSERT_EQ(STATUS_SUCCESS, rtc_runtime_create(&configuration, &pRtcRuntime));
+
+    // the peer connections take turns on the workers
+    for (i = 0; i < ARRAY_SIZE(handles); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtc_runtime_attach(pRtcRuntime, &handles[i], &cpus[i]));
+        EXPECT_EQ(0, cpus[i]);
+    }
+    EXPECT_NE(FROM_TIMER_QUEUE_HANDLE(handles[0])->pSharedQueue, FROM_TIMER_QUEUE_HANDLE(handles[1])->pSharedQueue);
+    EXPECT_EQ(FROM_TIMER_QUEUE_HANDLE(handles[0])->pSharedQueue, FROM_TIMER_QUEUE_HANDLE(handles[2])->pSharedQueue);
+    EXPECT_EQ(FROM_TIMER_QUEUE_HANDLE(handles[1])->pSharedQueue, FROM_TIMER_QUEUE_HANDLE(handles[3])->pSharedQueue);
+
+    // the workers outlive the runtime until the last peer connection is gone
+    EXPECT_EQ(STATUS_SUCCESS, rtc_runtime_free(&pRtcRuntime));
+    EXPECT_TRUE(pRtcRuntime == NULL);
+    for (i = 0; i < ARRAY_SIZE(handles); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handles[i]));
+    }
+}
+
+static STATUS slowFrameReleaseCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(timerId);
+    UNUSED_PARAM(currentTime);
+    UNUSED_PARAM(customData);
+    // an application taking its time with a frame
+    THREAD_SLEEP(500 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    return STATUS_TIMER_QUEUE_STOP_SCHEDULING;
+}
+
+static STATUS countPeerTimerCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(timerId);
+    UNUSED_PARAM(currentTime);
+    ATOMIC_INCREMENT((volatile SIZE_T*) customData);
+    return STATUS_SUCCESS;
+}
+
+TEST_F(PeerConnectionApiTest, heldFramesAreReleasedApartFromThePeerTimers)
+{
+    RtcConfiguration configuration;
+    PRtcPeerConnection pRtcPeerConnection = NULL;
+    PKvsPeerConnection pKvsPeerConnection;
+    RtcMediaStreamTrack track;
+    RtcRtpTransceiverInit init;
+    PRtcRtpTransceiver pTransceiver = NULL;
+    volatile SIZE_T count = 0;
+    UINT32 timerId;
+
+    MEMSET(&configuration, 0x00, SIZEOF(configuration));
+    MEMSET(&track, 0x00, SIZEOF(track));
+    configuration.kvsRtcConfiguration.enableAdaptiveJitterBuffer = TRUE;
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_VP8;
+    STRNCPY(track.streamId, "myKvsVideoStream", MAX_MEDIA_STREAM_ID_LEN);
+    STRNCPY(track.trackId, "myVideoTrack", MAX_MEDIA_STREAM_ID_LEN);
+    init.direction = RTC_RTP_TRANSCEIVER_DIRECTION_RECVONLY;
+
+    ASSERT_EQ(STATUS_SUCCESS, pc_create(&configuration, &pRtcPeerConnection));
+    pKvsPeerConnection = (PKvsPeerConnection) pRtcPeerConnection;
+    EXPECT_FALSE(IS_VALID_TIMER_QUEUE_HANDLE(pKvsPeerConnection->frameReleaseTimerQueueHandle));
+    ASSERT_EQ(STATUS_SUCCESS, pc_addSupportedCodec(pRtcPeerConnection, RTC_CODEC_VP8));
+    ASSERT_EQ(STATUS_SUCCESS, pc_addTransceiver(pRtcPeerConnection, &track, &init, &pTransceiver));
+
+    // the frames are handed out by a thread of the peer connection, not by the timer thread it may share with others
+    ASSERT_TRUE(IS_VALID_TIMER_QUEUE_HANDLE(pKvsPeerConnection->frameReleaseTimerQueueHandle));
+    EXPECT_NE(MAX_UINT32, ((PKvsRtpTransceiver) pTransceiver)->jitterBufferTimerId);
+    EXPECT_NE(FROM_TIMER_QUEUE_HANDLE(pKvsPeerConnection->frameReleaseTimerQueueHandle)->pSharedQueue,
+              FROM_TIMER_QUEUE_HANDLE(pKvsPeerConnection->timerQueueHandle)->pSharedQueue);
+
+    // a slow frame callback does not hold up the timers of the peer connections
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(pKvsPeerConnection->frameReleaseTimerQueueHandle, 0, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD,
+                                   slowFrameReleaseCallback, 0, &timerId));
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(pKvsPeerConnection->timerQueueHandle, 10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
+                                   10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, countPeerTimerCallback, (UINT64) &count, &timerId));
+    THREAD_SLEEP(200 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    EXPECT_LT(5, ATOMIC_LOAD(&count));
+
+    pc_close(pRtcPeerConnection);
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnection));
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
@@ -540,6 +540,102 @@ TEST_F(PeerConnectionFunctionalityTest, exchangeMedia)
     EXPECT_EQ(ATOMIC_LOAD(&seenVideo), 1);
 }
 
+static VOID pushVp8Packet(PKvsRtpTransceiver pTransceiver, UINT16 sequenceNumber, UINT32 timestamp, BOOL startOfFrame)
+{
+    BYTE packet[] = {0x80,
+                     0x60,
+                     (BYTE)(sequenceNumber >> 8),
+                     (BYTE) sequenceNumber,
+                     (BYTE)(timestamp >> 24),
+                     (BYTE)(timestamp >> 16),
+                     (BYTE)(timestamp >> 8),
+                     (BYTE) timestamp,
+                     0x00,
+                     0x00,
+                     0x10,
+                     0x00,
+                     // vp8 payload descriptor, S bit at the start of a frame
+                     (BYTE)(startOfFrame ? 0x10 : 0x00),
+                     0x42};
+    PBYTE pBytes = (PBYTE) MEMALLOC(SIZEOF(packet));
+    PRtpPacket pRtpPacket = NULL;
+
+    MEMCPY(pBytes, packet, SIZEOF(packet));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_createFromBytes(pBytes, SIZEOF(packet), &pRtpPacket));
+    pRtpPacket->receivedTime = GETTIME();
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(pTransceiver->pJitterBuffer, pRtpPacket, NULL));
+}
+
+// A frame dropped by the jitter buffer asks the remote sender for a key frame, also when its first packet never arrived
+TEST_F(PeerConnectionFunctionalityTest, droppedFrameRequestsKeyFrame)
+{
+    const UINT32 maxLatency = (UINT32)(DEFAULT_JITTER_BUFFER_MAX_LATENCY * VIDEO_CLOCKRATE / HUNDREDS_OF_NANOS_IN_A_SECOND);
+    RtcConfiguration configuration{};
+    PRtcPeerConnection offerPc = NULL, answerPc = NULL;
+    RtcMediaStreamTrack offerVideoTrack, answerVideoTrack;
+    PRtcRtpTransceiver offerVideoTransceiver, answerVideoTransceiver;
+    PKvsRtpTransceiver pReceiver;
+    RtcOutboundRtpStreamStats senderStats{};
+    RtcInboundRtpStreamStats receiverStats{};
+    UINT32 timestamp = 1000;
+    UINT32 i;
+    UINT16 ringSize;
+
+    EXPECT_EQ(pc_create(&configuration, &offerPc), STATUS_SUCCESS);
+    EXPECT_EQ(pc_create(&configuration, &answerPc), STATUS_SUCCESS);
+    addTrackToPeerConnection(offerPc, &offerVideoTrack, &offerVideoTransceiver, RTC_CODEC_VP8, MEDIA_STREAM_TRACK_KIND_VIDEO);
+    addTrackToPeerConnection(answerPc, &answerVideoTrack, &answerVideoTransceiver, RTC_CODEC_VP8, MEDIA_STREAM_TRACK_KIND_VIDEO);
+    EXPECT_EQ(connectTwoPeers(offerPc, answerPc), TRUE);
+    pReceiver = (PKvsRtpTransceiver) answerVideoTransceiver;
+    ASSERT_NE(0, pReceiver->jitterBufferSsrc);
+    ASSERT_FALSE(pReceiver->keyFrameRequestState.useFir);
+    ringSize = (UINT16) pReceiver->pJitterBuffer->ringSize;
+
+    // the offer sends no media, the packets below are all the jitter buffer of the answer gets
+    pushVp8Packet(pReceiver, 100, timestamp, TRUE);
+    // a packet of the slot of the first one evicts it before the frame expires, none of the dropped frame is left
+    timestamp += maxLatency + 1;
+    pushVp8Packet(pReceiver, 100 + ringSize, timestamp, TRUE);
+
+    for (i = 0; i < 100 && senderStats.pliCount == 0; i++) {
+        THREAD_SLEEP(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpOutboundStats(offerPc, offerVideoTransceiver, &senderStats));
+    }
+    EXPECT_EQ(1, senderStats.pliCount);
+    EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpInboundStats(answerPc, answerVideoTransceiver, &receiverStats));
+    EXPECT_EQ(1, receiverStats.pliCount);
+    EXPECT_EQ(1, receiverStats.received.framesDropped);
+
+    // two more frames dropped right away, the key frame of the first request may still be on its way
+    pushVp8Packet(pReceiver, 102 + ringSize, timestamp + 3000, FALSE);
+    timestamp += 3000 + maxLatency + 1;
+    pushVp8Packet(pReceiver, 103 + ringSize, timestamp, TRUE);
+    EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpInboundStats(answerPc, answerVideoTransceiver, &receiverStats));
+    EXPECT_EQ(1, receiverStats.pliCount);
+    EXPECT_EQ(3, receiverStats.received.framesDropped);
+
+    // a sender which only offered ccm fir is asked with a FIR once the interval passed
+    pReceiver->keyFrameRequestState.useFir = TRUE;
+    pReceiver->keyFrameRequestState.lastRequestTime = 0;
+    timestamp += maxLatency + 1;
+    pushVp8Packet(pReceiver, 105 + ringSize, timestamp, TRUE);
+    for (i = 0; i < 100 && senderStats.firCount == 0; i++) {
+        THREAD_SLEEP(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpOutboundStats(offerPc, offerVideoTransceiver, &senderStats));
+    }
+    EXPECT_EQ(1, senderStats.firCount);
+    EXPECT_EQ(1, senderStats.pliCount);
+    EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpInboundStats(answerPc, answerVideoTransceiver, &receiverStats));
+    EXPECT_EQ(1, receiverStats.pliCount);
+    EXPECT_EQ(1, receiverStats.firCount);
+    EXPECT_EQ(4, receiverStats.received.framesDropped);
+
+    pc_close(offerPc);
+    pc_close(answerPc);
+    pc_free(&offerPc);
+    pc_free(&answerPc);
+}
+
 // Same test as exchangeMedia, but assert that if one side is RSA DTLS and Key Extraction works
 TEST_F(PeerConnectionFunctionalityTest, exchangeMediaRSA)
 {
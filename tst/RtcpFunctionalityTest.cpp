@@ -6,6 +6,26 @@ namespace kinesis {
 namespace video {
 namespace webrtcclient {
 
+#define RETRANSMIT_BENCHMARK_HISTORY_PACKETS 1024
+#define RETRANSMIT_BENCHMARK_RESENDS         20000
+#define RETRANSMIT_BENCHMARK_PAYLOAD_LEN     1100
+
+static volatile SIZE_T gRetransmitBenchmarkAllocations = 0;
+static memAlloc gStoredMemAlloc = NULL;
+static memCalloc gStoredMemCalloc = NULL;
+
+static PVOID countingMemAlloc(SIZE_T size)
+{
+    ATOMIC_INCREMENT(&gRetransmitBenchmarkAllocations);
+    return gStoredMemAlloc(size);
+}
+
+static PVOID countingMemCalloc(SIZE_T num, SIZE_T size)
+{
+    ATOMIC_INCREMENT(&gRetransmitBenchmarkAllocations);
+    return gStoredMemCalloc(num, size);
+}
+
 class RtcpFunctionalityTest : public WebRtcClientTestBase {
   public:
     PKvsRtpTransceiver pKvsRtpTransceiver = nullptr;
@@ -30,6 +50,7 @@ class RtcpFunctionalityTest : public WebRtcClientTestBase {
         PRtcRtpTransceiver out = nullptr;
         EXPECT_EQ(STATUS_SUCCESS, ::pc_addTransceiver(pRtcPeerConnection, &track, nullptr, &out));
         ((PKvsRtpTransceiver) out)->sender.ssrc = ssrc;
+        EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_mapSsrcs((PKvsRtpTransceiver) out));
         return out;
     }
 };
@@ -148,19 +169,254 @@ TEST_F(RtcpFunctionalityTest, rtcpNackListCompound)
 }
 
 
+TEST_F(RtcpFunctionalityTest, rtcpNackRoundTrip)
+{
+    UINT16 sequenceNumbers[] = {3240, 3243, 3256, 3257, 3327, 65535, 2};
+    UINT16 parsed[ARRAY_SIZE(sequenceNumbers)];
+    UINT32 packetLen = 0, parsedLen = ARRAY_SIZE(parsed), senderSsrc = 0, mediaSsrc = 0, i;
+    BYTE buffer[64];
+    RtcpPacket rtcpPacket{};
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_createNackBytes(1, 2, sequenceNumbers, ARRAY_SIZE(sequenceNumbers), NULL, &packetLen));
+    // {3240, 3243, 3256}, {3257}, {3327}, {65535, 2}
+    EXPECT_EQ(RTCP_PACKET_HEADER_LEN + RTCP_NACK_LIST_LEN + 4 * 4, packetLen);
+    packetLen = 8;
+    EXPECT_EQ(STATUS_BUFFER_TOO_SMALL, rtcp_packet_createNackBytes(1, 2, sequenceNumbers, ARRAY_SIZE(sequenceNumbers), buffer, &packetLen));
+    packetLen = SIZEOF(buffer);
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_createNackBytes(1, 2, sequenceNumbers, ARRAY_SIZE(sequenceNumbers), buffer, &packetLen));
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_setFromBytes(buffer, packetLen, &rtcpPacket));
+    EXPECT_EQ(RTCP_PACKET_TYPE_GENERIC_RTP_FEEDBACK, rtcpPacket.header.packetType);
+    EXPECT_EQ(RTCP_FEEDBACK_MESSAGE_TYPE_NACK, rtcpPacket.header.receptionReportCount);
+    EXPECT_EQ(STATUS_SUCCESS,
+              rtcp_packet_getNackList(rtcpPacket.payload, rtcpPacket.payloadLength, &senderSsrc, &mediaSsrc, parsed, &parsedLen));
+    EXPECT_EQ(1, senderSsrc);
+    EXPECT_EQ(2, mediaSsrc);
+    ASSERT_EQ(ARRAY_SIZE(sequenceNumbers), parsedLen);
+    for (i = 0; i < parsedLen; i++) {
+        EXPECT_EQ(sequenceNumbers[i], parsed[i]);
+    }
+}
+
+TEST_F(RtcpFunctionalityTest, rtcpBuilderCompoundRoundTrip)
+{
+    PRtcpBuilder pRtcpBuilder = NULL;
+    RtcpReceptionStats receptionStats{};
+    RtcpReportBlock reportBlock{};
+    RtcpPacket rtcpPacket{};
+    BYTE block[RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN];
+    UINT16 sequenceNumbers[] = {10, 12, 40}, parsed[ARRAY_SIZE(sequenceNumbers)];
+    UINT32 rembSsrcs[] = {0x1111, 0x2222}, parsedSsrcs[ARRAY_SIZE(rembSsrcs)];
+    UINT32 parsedLen = ARRAY_SIZE(parsed), senderSsrc = 0, mediaSsrc = 0, offset = 0, i;
+    UINT8 parsedSsrcsLen = 0;
+    DOUBLE bitrate = 0;
+    CHAR cname[] = "abcdefghijklmnop";
+    RTCP_PACKET_TYPE expectedTypes[] = {RTCP_PACKET_TYPE_SENDER_REPORT, RTCP_PACKET_TYPE_SOURCE_DESCRIPTION, RTCP_PACKET_TYPE_GENERIC_RTP_FEEDBACK,
+                                        RTCP_PACKET_TYPE_PAYLOAD_SPECIFIC_FEEDBACK, RTCP_PACKET_TYPE_PAYLOAD_SPECIFIC_FEEDBACK};
+
+    for (i = 100; i < 110; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_updateReceptionStats(&receptionStats, (UINT16) i));
+    }
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_setReportBlock(&receptionStats, 0xABCD, 7, GETTIME(), block));
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_create(1200, 0, &pRtcpBuilder));
+    // feedback added before the report still ends up behind it
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_addNack(pRtcpBuilder, 0x1234, 0xABCD, sequenceNumbers, ARRAY_SIZE(sequenceNumbers)));
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_addSenderReport(pRtcpBuilder, 0x1234, 0x0102030405060708ULL, 90000, 50, 6000, block, 1));
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_addSdesCname(pRtcpBuilder, 0x1234, cname));
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_addPli(pRtcpBuilder, 0x1234, 0xABCD));
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_addRemb(pRtcpBuilder, 0x1234, 1500000, rembSsrcs, ARRAY_SIZE(rembSsrcs)));
+
+    for (i = 0; offset < pRtcpBuilder->length; i++) {
+        ASSERT_EQ(STATUS_SUCCESS, rtcp_packet_setFromBytes(pRtcpBuilder->pBuffer + offset, pRtcpBuilder->length - offset, &rtcpPacket));
+        ASSERT_LT(i, ARRAY_SIZE(expectedTypes));
+        EXPECT_EQ(expectedTypes[i], rtcpPacket.header.packetType);
+        switch (i) {
+            case 0:
+                EXPECT_EQ(1, rtcpPacket.header.receptionReportCount);
+                EXPECT_EQ(0x1234, getUnalignedInt32BigEndian(rtcpPacket.payload));
+                EXPECT_EQ(0x0102030405060708ULL, getUnalignedInt64BigEndian(rtcpPacket.payload + 4));
+                EXPECT_EQ(90000, getUnalignedInt32BigEndian(rtcpPacket.payload + 12));
+                EXPECT_EQ(50, getUnalignedInt32BigEndian(rtcpPacket.payload + 16));
+                EXPECT_EQ(6000, getUnalignedInt32BigEndian(rtcpPacket.payload + 20));
+                EXPECT_EQ(STATUS_SUCCESS,
+                          rtcp_packet_getReportBlock(rtcpPacket.payload + 24, rtcpPacket.payloadLength - 24, &reportBlock));
+                EXPECT_EQ(0xABCD, reportBlock.ssrc);
+                EXPECT_EQ(109, reportBlock.extendedHighestSequenceNumber);
+                EXPECT_EQ(7, reportBlock.jitter);
+                break;
+            case 1:
+                EXPECT_EQ(1, rtcpPacket.header.receptionReportCount);
+                EXPECT_EQ(0x1234, getUnalignedInt32BigEndian(rtcpPacket.payload));
+                EXPECT_EQ(RTCP_SDES_ITEM_CNAME, rtcpPacket.payload[4]);
+                EXPECT_EQ(STRLEN(cname), rtcpPacket.payload[5]);
+                EXPECT_EQ(0, MEMCMP(cname, rtcpPacket.payload + 6, STRLEN(cname)));
+                // the item list ends with a null octet
+                EXPECT_LT(6 + STRLEN(cname), rtcpPacket.payloadLength);
+                EXPECT_EQ(0, rtcpPacket.payload[6 + STRLEN(cname)]);
+                break;
+            case 2:
+                EXPECT_EQ(RTCP_FEEDBACK_MESSAGE_TYPE_NACK, rtcpPacket.header.receptionReportCount);
+                EXPECT_EQ(STATUS_SUCCESS,
+                          rtcp_packet_getNackList(rtcpPacket.payload, rtcpPacket.payloadLength, &senderSsrc, &mediaSsrc, parsed, &parsedLen));
+                EXPECT_EQ(0x1234, senderSsrc);
+                EXPECT_EQ(0xABCD, mediaSsrc);
+                ASSERT_EQ(ARRAY_SIZE(sequenceNumbers), parsedLen);
+                EXPECT_EQ(0, MEMCMP(sequenceNumbers, parsed, SIZEOF(sequenceNumbers)));
+                break;
+            case 3:
+                EXPECT_EQ(RTCP_PSFB_PLI, rtcpPacket.header.receptionReportCount);
+                EXPECT_EQ(0xABCD, getUnalignedInt32BigEndian(rtcpPacket.payload + 4));
+                break;
+            case 4:
+                EXPECT_EQ(RTCP_FEEDBACK_MESSAGE_TYPE_APPLICATION_LAYER_FEEDBACK, rtcpPacket.header.receptionReportCount);
+                EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_isRemb(rtcpPacket.payload, rtcpPacket.payloadLength));
+                EXPECT_EQ(STATUS_SUCCESS,
+                          rtcp_packet_getRembValue(rtcpPacket.payload, rtcpPacket.payloadLength, &bitrate, parsedSsrcs, &parsedSsrcsLen));
+                EXPECT_EQ(1500000, bitrate);
+                ASSERT_EQ(ARRAY_SIZE(rembSsrcs), parsedSsrcsLen);
+                EXPECT_EQ(0, MEMCMP(rembSsrcs, parsedSsrcs, SIZEOF(rembSsrcs)));
+                break;
+        }
+        offset += rtcpPacket.payloadLength + RTCP_PACKET_HEADER_LEN;
+    }
+    EXPECT_EQ(ARRAY_SIZE(expectedTypes), i);
+    EXPECT_EQ(pRtcpBuilder->length, offset);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_free(&pRtcpBuilder));
+    EXPECT_EQ(NULL, pRtcpBuilder);
+}
+
+TEST_F(RtcpFunctionalityTest, rtcpBuilderIsBoundedByMaxPacketLength)
+{
+    PRtcpBuilder pRtcpBuilder = NULL;
+    CHAR cname[] = "abcdefghijklmnop";
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_create(64, 0, &pRtcpBuilder));
+    // 28 bytes of SR and 28 bytes of SDES
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_addSenderReport(pRtcpBuilder, 1, 2, 3, 4, 5, NULL, 0));
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_addSdesCname(pRtcpBuilder, 1, cname));
+    EXPECT_EQ(56, pRtcpBuilder->length);
+
+    // a PLI does not fit any more and leaves the packet as it was
+    EXPECT_EQ(STATUS_BUFFER_TOO_SMALL, rtcp_builder_addPli(pRtcpBuilder, 1, 2));
+    EXPECT_EQ(56, pRtcpBuilder->length);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_reset(pRtcpBuilder));
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_addPli(pRtcpBuilder, 1, 2));
+    EXPECT_EQ(RTCP_PACKET_HEADER_LEN + RTCP_NACK_LIST_LEN, pRtcpBuilder->length);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_builder_free(&pRtcpBuilder));
+}
+
+TEST_F(RtcpFunctionalityTest, nackGeneratorSchedulesAndCancelsRequests)
+{
+    PNackGenerator pNackGenerator = nullptr;
+    UINT16 list[NACK_GENERATOR_MAX_PENDING];
+    UINT32 listLen;
+    UINT64 now = 1000 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, rtt = 50 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_create(3, &pNackGenerator));
+
+    // 65534, 65535 and 1 are missing across the wrap
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 65533, now));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 0, now));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 2, now));
+    EXPECT_EQ(3, pNackGenerator->requestCount);
+
+    listLen = ARRAY_SIZE(list);
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_getNackList(pNackGenerator, now, rtt, list, &listLen));
+    ASSERT_EQ(3, listLen);
+    EXPECT_EQ(65534, list[0]);
+    EXPECT_EQ(65535, list[1]);
+    EXPECT_EQ(1, list[2]);
+
+    // nothing is repeated within the round trip time
+    listLen = ARRAY_SIZE(list);
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_getNackList(pNackGenerator, now + rtt - 1, rtt, list, &listLen));
+    EXPECT_EQ(0, listLen);
+
+    // the retransmission of 65535 arrives and the frame ending at 65534 is given up
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 65535, now));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_cancelUpTo(pNackGenerator, 65534));
+    listLen = ARRAY_SIZE(list);
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_getNackList(pNackGenerator, now + rtt, rtt, list, &listLen));
+    ASSERT_EQ(1, listLen);
+    EXPECT_EQ(1, list[0]);
+
+    // the third attempt is the last one
+    listLen = ARRAY_SIZE(list);
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_getNackList(pNackGenerator, now + 2 * rtt, rtt, list, &listLen));
+    EXPECT_EQ(1, listLen);
+    EXPECT_EQ(0, pNackGenerator->requestCount);
+
+    // a gap too large to repair is not requested
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 2 + NACK_GENERATOR_MAX_GAP + 2, now));
+    EXPECT_EQ(0, pNackGenerator->requestCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_free(&pNackGenerator));
+    EXPECT_EQ(nullptr, pNackGenerator);
+}
+
+TEST_F(RtcpFunctionalityTest, receiverReportBlockFromReceptionStats)
+{
+    RtcpReceptionStats stats{};
+    RtcpPacket rtcpPacket{};
+    BYTE rawPacket[RTCP_PACKET_HEADER_LEN + 4 + RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN];
+    UINT64 now = 10 * HUNDREDS_OF_NANOS_IN_A_SECOND;
+    UINT16 seq;
+
+    // 65530 - 65535 and 0 - 9 across the wrap, 65533 and 2 are lost, 4 arrives late
+    for (seq = 65530; seq != 10; seq++) {
+        if (seq != 65533 && seq != 2 && seq != 4) {
+            EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_updateReceptionStats(&stats, seq));
+        }
+    }
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_updateReceptionStats(&stats, 4));
+    stats.lastSenderReport = 0x12345678;
+    stats.lastSenderReportTime = now - HUNDREDS_OF_NANOS_IN_A_SECOND / 2;
+
+    rawPacket[0] = (RTCP_PACKET_VERSION_VAL << 6) | 1;
+    rawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_RECEIVER_REPORT;
+    putUnalignedInt16BigEndian(rawPacket + RTCP_PACKET_LEN_OFFSET, SIZEOF(rawPacket) / RTCP_PACKET_LEN_WORD_SIZE - 1);
+    putUnalignedInt32BigEndian(rawPacket + 4, 0x1111);
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_setReportBlock(&stats, 0x2222, 42, now, rawPacket + 8));
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_setFromBytes(rawPacket, SIZEOF(rawPacket), &rtcpPacket));
+    EXPECT_EQ(RTCP_PACKET_TYPE_RECEIVER_REPORT, rtcpPacket.header.packetType);
+    EXPECT_EQ(1, rtcpPacket.header.receptionReportCount);
+    EXPECT_EQ(RTCP_PACKET_RECEIVER_REPORT_MINLEN, rtcpPacket.payloadLength);
+    EXPECT_EQ(0x1111, getUnalignedInt32BigEndian(rtcpPacket.payload));
+    EXPECT_EQ(0x2222, getUnalignedInt32BigEndian(rtcpPacket.payload + 4));
+    // 2 of 16 lost
+    EXPECT_EQ(2 * 256 / 16, rtcpPacket.payload[8]);
+    EXPECT_EQ(2, getUnalignedInt32BigEndian(rtcpPacket.payload + 8) & 0x00FFFFFF);
+    EXPECT_EQ(RTCP_RECEPTION_SEQ_MOD + 9, getUnalignedInt32BigEndian(rtcpPacket.payload + 12));
+    EXPECT_EQ(42, getUnalignedInt32BigEndian(rtcpPacket.payload + 16));
+    EXPECT_EQ(0x12345678, getUnalignedInt32BigEndian(rtcpPacket.payload + 20));
+    EXPECT_EQ(DLSR_TIMESCALE / 2, getUnalignedInt32BigEndian(rtcpPacket.payload + 24));
+
+    // the fraction lost covers the packets since the previous report only
+    for (seq = 10; seq < 20; seq++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_updateReceptionStats(&stats, seq));
+    }
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_setReportBlock(&stats, 0x2222, 42, now, rawPacket + 8));
+    EXPECT_EQ(0, rawPacket[12]);
+    EXPECT_EQ(2, getUnalignedInt32BigEndian(rawPacket + 12) & 0x00FFFFFF);
+}
+
 TEST_F(RtcpFunctionalityTest, onRtcpPacketCompoundNack)
 {
     PRtpPacket pRtpPacket = nullptr;
     BYTE validRtcpPacket[] = {0x81, 0xcd, 0x00, 0x03, 0x2c, 0xd1, 0xa0, 0xde, 0x00, 0x00, 0xab, 0xe0, 0x00, 0x00, 0x00, 0x00};
     initTransceiver(44000);
+    ASSERT_EQ(STATUS_SUCCESS, rtp_history_create(1024, 64 * 1024, RTP_HISTORY_DEFAULT_MAX_AGE_MSEC, &pKvsRtpTransceiver->sender.packetBuffer));
     ASSERT_EQ(STATUS_SUCCESS,
-              rtp_rolling_buffer_create(DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS * HIGHEST_EXPECTED_BIT_RATE / 8 / DEFAULT_MTU_SIZE,
-                                     &pKvsRtpTransceiver->sender.packetBuffer));
-    ASSERT_EQ(STATUS_SUCCESS,
-              retransmitter_create(DEFAULT_SEQ_NUM_BUFFER_SIZE, DEFAULT_VALID_INDEX_BUFFER_SIZE, &pKvsRtpTransceiver->sender.retransmitter));
+              retransmitter_create(DEFAULT_SEQ_NUM_BUFFER_SIZE, DEFAULT_RETRANSMIT_PACKET_BUFFER_SIZE, &pKvsRtpTransceiver->sender.retransmitter));
     ASSERT_EQ(STATUS_SUCCESS, createRtpPacketWithSeqNum(0, &pRtpPacket));
 
-    ASSERT_EQ(STATUS_SUCCESS, rtp_rolling_buffer_addRtpPacket(pKvsRtpTransceiver->sender.packetBuffer, pRtpPacket));
+    ASSERT_EQ(STATUS_SUCCESS,
+              rtp_history_put(pKvsRtpTransceiver->sender.packetBuffer, pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength, GETTIME()));
     ASSERT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, validRtcpPacket, SIZEOF(validRtcpPacket)));
     RtcOutboundRtpStreamStats  stats{};
     metrics_getRtpOutboundStats(pRtcPeerConnection, nullptr, &stats);
@@ -171,6 +427,282 @@ TEST_F(RtcpFunctionalityTest, onRtcpPacketCompoundNack)
     rtp_packet_free(&pRtpPacket);
 }
 
+TEST_F(RtcpFunctionalityTest, onRtcpPacketNackFloodIsRateLimited)
+{
+    PRtpPacket pRtpPacket = nullptr;
+    PRetransmitter pRetransmitter = nullptr;
+    RtcOutboundRtpStreamStats stats{};
+    // nack for seq 0, seq 1 and seq 5
+    BYTE nackSeq0[] = {0x81, 0xcd, 0x00, 0x03, 0x2c, 0xd1, 0xa0, 0xde, 0x00, 0x00, 0xab, 0xe0, 0x00, 0x00, 0x00, 0x00};
+    BYTE nackSeq1[] = {0x81, 0xcd, 0x00, 0x03, 0x2c, 0xd1, 0xa0, 0xde, 0x00, 0x00, 0xab, 0xe0, 0x00, 0x01, 0x00, 0x00};
+    BYTE nackSeq5[] = {0x81, 0xcd, 0x00, 0x03, 0x2c, 0xd1, 0xa0, 0xde, 0x00, 0x00, 0xab, 0xe0, 0x00, 0x05, 0x00, 0x00};
+    UINT32 i;
+
+    initTransceiver(44000);
+    ASSERT_EQ(STATUS_SUCCESS, rtp_history_create(1024, 64 * 1024, RTP_HISTORY_DEFAULT_MAX_AGE_MSEC, &pKvsRtpTransceiver->sender.packetBuffer));
+    ASSERT_EQ(STATUS_SUCCESS,
+              retransmitter_create(DEFAULT_SEQ_NUM_BUFFER_SIZE, DEFAULT_RETRANSMIT_PACKET_BUFFER_SIZE, &pKvsRtpTransceiver->sender.retransmitter));
+    pRetransmitter = pKvsRtpTransceiver->sender.retransmitter;
+    for (i = 0; i < 2; i++) {
+        ASSERT_EQ(STATUS_SUCCESS, createRtpPacketWithSeqNum(i, &pRtpPacket));
+        ASSERT_EQ(STATUS_SUCCESS,
+                  rtp_history_put(pKvsRtpTransceiver->sender.packetBuffer, pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength, GETTIME()));
+        rtp_packet_free(&pRtpPacket);
+    }
+
+    // a flood of nacks for the same packet within one round trip only resends it once
+    for (i = 0; i < 100; i++) {
+        ASSERT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, nackSeq0, SIZEOF(nackSeq0)));
+    }
+    metrics_getRtpOutboundStats(pRtcPeerConnection, nullptr, &stats);
+    EXPECT_EQ(100, stats.nackCount);
+    EXPECT_EQ(1, stats.retransmittedPacketsSent);
+    EXPECT_EQ(99, stats.retransmissionsSuppressed);
+    EXPECT_EQ(0, stats.retransmissionsRateLimited);
+
+    // the packet is kept in the history, it can be resent once the round trip has passed
+    rtp_transceiver_lockStats(pKvsRtpTransceiver);
+    pKvsRtpTransceiver->remoteInboundStats.roundTripTime = 1;
+    rtp_transceiver_unlockStats(pKvsRtpTransceiver);
+    THREAD_SLEEP(2 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    ASSERT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, nackSeq0, SIZEOF(nackSeq0)));
+    metrics_getRtpOutboundStats(pRtcPeerConnection, nullptr, &stats);
+    EXPECT_EQ(2, stats.retransmittedPacketsSent);
+
+    // once the budget is spent nothing is resent until more media has been sent
+    ASSERT_EQ(1, pRetransmitter->streams[0].inUse);
+    EXPECT_EQ(44000, pRetransmitter->streams[0].ssrc);
+    EXPECT_EQ(RETRANSMITTER_MAX_BUDGET_BYTES - 2 * 22, pRetransmitter->streams[0].budgetBytes);
+    pRetransmitter->streams[0].budgetBytes = 0;
+    for (i = 0; i < 10; i++) {
+        ASSERT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, nackSeq1, SIZEOF(nackSeq1)));
+    }
+    metrics_getRtpOutboundStats(pRtcPeerConnection, nullptr, &stats);
+    EXPECT_EQ(2, stats.retransmittedPacketsSent);
+    EXPECT_EQ(10, stats.retransmissionsRateLimited);
+
+    rtp_transceiver_lockStats(pKvsRtpTransceiver);
+    pKvsRtpTransceiver->outboundStats.sent.bytesSent += 100 * 100 / RETRANSMITTER_DEFAULT_BUDGET_PERCENT;
+    rtp_transceiver_unlockStats(pKvsRtpTransceiver);
+    ASSERT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, nackSeq1, SIZEOF(nackSeq1)));
+    metrics_getRtpOutboundStats(pRtcPeerConnection, nullptr, &stats);
+    EXPECT_EQ(3, stats.retransmittedPacketsSent);
+    EXPECT_EQ(100 - 22, pRetransmitter->streams[0].budgetBytes);
+
+    // a packet which was never kept is a miss, not a retransmission
+    EXPECT_EQ(0, stats.nackHistoryMisses);
+    ASSERT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, nackSeq5, SIZEOF(nackSeq5)));
+    metrics_getRtpOutboundStats(pRtcPeerConnection, nullptr, &stats);
+    EXPECT_EQ(3, stats.retransmittedPacketsSent);
+    EXPECT_EQ(1, stats.nackHistoryMisses);
+
+    pc_free(&pRtcPeerConnection);
+}
+
+TEST_F(RtcpFunctionalityTest, onRtcpPacketNackCountsFailedRetransmissions)
+{
+    PRtpPacket pRtpPacket = nullptr;
+    RtcOutboundRtpStreamStats stats{};
+    // nack for seq 0
+    BYTE nackSeq0[] = {0x81, 0xcd, 0x00, 0x03, 0x2c, 0xd1, 0xa0, 0xde, 0x00, 0x00, 0xab, 0xe0, 0x00, 0x00, 0x00, 0x00};
+
+    initTransceiver(44000);
+    ASSERT_EQ(STATUS_SUCCESS, rtp_history_create(1024, 64 * 1024, RTP_HISTORY_DEFAULT_MAX_AGE_MSEC, &pKvsRtpTransceiver->sender.packetBuffer));
+    // the 22 byte packet does not fit the scratch buffer, not even with the room kept for the authentication tag
+    ASSERT_EQ(STATUS_SUCCESS,
+              retransmitter_create(DEFAULT_SEQ_NUM_BUFFER_SIZE, 22 - SRTP_AUTH_TAG_OVERHEAD - 1, &pKvsRtpTransceiver->sender.retransmitter));
+    ASSERT_EQ(STATUS_SUCCESS, createRtpPacketWithSeqNum(0, &pRtpPacket));
+    ASSERT_EQ(22, pRtpPacket->rawPacketLength);
+    ASSERT_EQ(STATUS_SUCCESS,
+              rtp_history_put(pKvsRtpTransceiver->sender.packetBuffer, pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength, GETTIME()));
+    rtp_packet_free(&pRtpPacket);
+
+    // the packet is kept but cannot be read back, that is a failure rather than a miss
+    ASSERT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, nackSeq0, SIZEOF(nackSeq0)));
+    metrics_getRtpOutboundStats(pRtcPeerConnection, nullptr, &stats);
+    EXPECT_EQ(1, stats.nackCount);
+    EXPECT_EQ(0, stats.retransmittedPacketsSent);
+    EXPECT_EQ(0, stats.nackHistoryMisses);
+    EXPECT_EQ(1, stats.retransmissionsFailed);
+
+    pc_free(&pRtcPeerConnection);
+}
+
+TEST_F(RtcpFunctionalityTest, nackStateKeyedByResolvedSsrc)
+{
+    PRtpPacket pRtpPacket = nullptr;
+    PRetransmitter pRetransmitter = nullptr;
+    RtcOutboundRtpStreamStats stats{};
+    // nack for seq 0 from ssrc 0x2cd1a0de, the media ssrc is patched in below
+    BYTE nack[] = {0x81, 0xcd, 0x00, 0x03, 0x2c, 0xd1, 0xa0, 0xde, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    UINT32 i;
+
+    initTransceiver(44000);
+    ASSERT_EQ(STATUS_SUCCESS, rtp_history_create(1024, 64 * 1024, RTP_HISTORY_DEFAULT_MAX_AGE_MSEC, &pKvsRtpTransceiver->sender.packetBuffer));
+    ASSERT_EQ(STATUS_SUCCESS,
+              retransmitter_create(DEFAULT_SEQ_NUM_BUFFER_SIZE, DEFAULT_RETRANSMIT_PACKET_BUFFER_SIZE, &pKvsRtpTransceiver->sender.retransmitter));
+    pRetransmitter = pKvsRtpTransceiver->sender.retransmitter;
+    // the remote sends its own media on the ssrc of the nacks, which finds the transceiver when the media ssrc does not
+    pKvsRtpTransceiver->jitterBufferSsrc = 0x2cd1a0de;
+    ASSERT_EQ(STATUS_SUCCESS, rtp_transceiver_mapSsrcs(pKvsRtpTransceiver));
+    ASSERT_EQ(STATUS_SUCCESS, createRtpPacketWithSeqNum(0, &pRtpPacket));
+    ASSERT_EQ(STATUS_SUCCESS,
+              rtp_history_put(pKvsRtpTransceiver->sender.packetBuffer, pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength, GETTIME()));
+    rtp_packet_free(&pRtpPacket);
+
+    // more unknown media ssrcs than there are slots, they all resolve to the primary encoding
+    for (i = 0; i < 2 * RETRANSMITTER_MAX_STREAMS; i++) {
+        putUnalignedInt32BigEndian(nack + 8, 0x1000 + i);
+        ASSERT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, nack, SIZEOF(nack)));
+    }
+    metrics_getRtpOutboundStats(pRtcPeerConnection, nullptr, &stats);
+    EXPECT_EQ(2 * RETRANSMITTER_MAX_STREAMS, stats.nackCount);
+    EXPECT_EQ(1, stats.retransmittedPacketsSent);
+    EXPECT_EQ(2 * RETRANSMITTER_MAX_STREAMS - 1, stats.retransmissionsSuppressed);
+    EXPECT_TRUE(pRetransmitter->streams[0].inUse);
+    EXPECT_EQ(44000, pRetransmitter->streams[0].ssrc);
+    for (i = 1; i < RETRANSMITTER_MAX_STREAMS; i++) {
+        EXPECT_FALSE(pRetransmitter->streams[i].inUse);
+    }
+
+    // slots left behind by ssrcs which are not nacked anymore are taken over
+    for (i = 0; i < RETRANSMITTER_MAX_STREAMS; i++) {
+        pRetransmitter->streams[i].inUse = TRUE;
+        pRetransmitter->streams[i].ssrc = 0x2000 + i;
+        pRetransmitter->streams[i].lastNackTime = i + 1;
+    }
+    putUnalignedInt32BigEndian(nack + 8, 44000);
+    ASSERT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, nack, SIZEOF(nack)));
+    metrics_getRtpOutboundStats(pRtcPeerConnection, nullptr, &stats);
+    EXPECT_EQ(2, stats.retransmittedPacketsSent);
+    EXPECT_EQ(44000, pRetransmitter->streams[0].ssrc);
+    EXPECT_EQ(0x2001, pRetransmitter->streams[1].ssrc);
+
+    pc_free(&pRtcPeerConnection);
+}
+
+TEST_F(RtcpFunctionalityTest, retransmitPacketInPlaceMatchesReserializedPacket)
+{
+    // a one-byte extension element with id 1 and one byte of data, padded to a word
+    BYTE extension[] = {0x10, 0xAB, 0x00, 0x00};
+    BYTE payload[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    UINT32 csrc[] = {0x11223344};
+    BYTE buffer[RTX_OSN_LENGTH + 64];
+    PRtpPacket pRtpPacket = nullptr, pRtxRtpPacket = nullptr;
+    RtpPacket rtpPacket;
+    PBYTE pRtxPacket = nullptr;
+    UINT32 packetLength = SIZEOF(buffer) - RTX_OSN_LENGTH, rtxPacketLength = 0;
+
+    ASSERT_EQ(STATUS_SUCCESS,
+              rtp_packet_create(2, FALSE, TRUE, 1, TRUE, 96, 1000, 100, 0x1234ABCD, csrc, RTP_ONE_BYTE_EXTENSION_PROFILE, SIZEOF(extension),
+                                extension, payload, SIZEOF(payload), &pRtpPacket));
+    ASSERT_EQ(STATUS_SUCCESS, rtp_packet_createBytesFromPacket(pRtpPacket, buffer + RTX_OSN_LENGTH, &packetLength));
+    ASSERT_EQ(STATUS_SUCCESS, rtp_packet_constructRetransmitPacketFromBytes(buffer + RTX_OSN_LENGTH, packetLength, 7, 97, 0x5678, &pRtxRtpPacket));
+
+    ASSERT_EQ(STATUS_SUCCESS, rtp_packet_setPacketFromBytes(buffer + RTX_OSN_LENGTH, packetLength, &rtpPacket));
+    rtpPacket.pRawPacket = buffer + RTX_OSN_LENGTH;
+    ASSERT_EQ(STATUS_SUCCESS, rtp_packet_constructRetransmitPacketInPlace(&rtpPacket, 7, 97, 0x5678, &pRtxPacket, &rtxPacketLength));
+    EXPECT_EQ(buffer, pRtxPacket);
+    ASSERT_EQ(pRtxRtpPacket->rawPacketLength, rtxPacketLength);
+    // reserializing a parsed packet swaps the bytes of its csrcs, patching in place keeps them as they were sent
+    EXPECT_EQ(0x11223344, (UINT32) getUnalignedInt32BigEndian(pRtxPacket + CSRC_OFFSET));
+    EXPECT_EQ(0, MEMCMP(pRtxRtpPacket->pRawPacket, pRtxPacket, CSRC_OFFSET));
+    EXPECT_EQ(0, MEMCMP(pRtxRtpPacket->pRawPacket + CSRC_OFFSET + CSRC_LENGTH, pRtxPacket + CSRC_OFFSET + CSRC_LENGTH,
+                        rtxPacketLength - CSRC_OFFSET - CSRC_LENGTH));
+
+    rtp_packet_free(&pRtxRtpPacket);
+    rtp_packet_free(&pRtpPacket);
+}
+
+TEST_F(RtcpFunctionalityTest, benchmarkRetransmitPacketConstruction)
+{
+    BYTE key[30] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+                    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D};
+    BYTE payload[RETRANSMIT_BENCHMARK_PAYLOAD_LEN];
+    BYTE buffer[RTX_OSN_LENGTH + DEFAULT_RETRANSMIT_PACKET_BUFFER_SIZE + SRTP_AUTH_TAG_OVERHEAD];
+    PSrtpSession pSrtpSession = nullptr;
+    PRtpHistory pRtpHistory = nullptr;
+    PRtpPacket pRtpPacket = nullptr, pRtxRtpPacket = nullptr;
+    RtpPacket rtpPacket;
+    PBYTE pRtxPacket = nullptr, pEncrypted = nullptr;
+    UINT32 i, packetLength, rtxPacketLength;
+    INT32 encryptedLength;
+    UINT16 rtxSequenceNumber = 0;
+    UINT64 startTime, reserializeTime, inPlaceTime;
+    SIZE_T reserializeAllocations, inPlaceAllocations;
+
+    MEMSET(payload, 0xA5, SIZEOF(payload));
+    ASSERT_EQ(STATUS_SUCCESS, srtp_session_init(key, key, KVS_SRTP_PROFILE_AES128_CM_HMAC_SHA1_80, &pSrtpSession));
+    ASSERT_EQ(STATUS_SUCCESS,
+              rtp_history_create(RETRANSMIT_BENCHMARK_HISTORY_PACKETS, RETRANSMIT_BENCHMARK_HISTORY_PACKETS * DEFAULT_RETRANSMIT_PACKET_BUFFER_SIZE,
+                                 RTP_HISTORY_DEFAULT_MAX_AGE_MSEC, &pRtpHistory));
+    for (i = 0; i < RETRANSMIT_BENCHMARK_HISTORY_PACKETS; i++) {
+        ASSERT_EQ(STATUS_SUCCESS,
+                  rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, (UINT16) i, 100, 0x1234ABCD, NULL, 0, 0, NULL, payload, SIZEOF(payload),
+                                    &pRtpPacket));
+        packetLength = SIZEOF(buffer);
+        ASSERT_EQ(STATUS_SUCCESS, rtp_packet_createBytesFromPacket(pRtpPacket, buffer, &packetLength));
+        ASSERT_EQ(STATUS_SUCCESS, rtp_history_put(pRtpHistory, buffer, packetLength, GETTIME()));
+        rtp_packet_free(&pRtpPacket);
+    }
+
+    gStoredMemAlloc = globalMemAlloc;
+    gStoredMemCalloc = globalMemCalloc;
+    globalMemAlloc = countingMemAlloc;
+    globalMemCalloc = countingMemCalloc;
+
+    // every nacked packet is parsed, reserialized into a new packet and copied once more to be encrypted
+    ATOMIC_STORE(&gRetransmitBenchmarkAllocations, 0);
+    startTime = GETTIME();
+    for (i = 0; i < RETRANSMIT_BENCHMARK_RESENDS; i++) {
+        packetLength = SIZEOF(buffer);
+        ASSERT_EQ(STATUS_SUCCESS,
+                  rtp_history_get(pRtpHistory, (UINT16) (i % RETRANSMIT_BENCHMARK_HISTORY_PACKETS), startTime, buffer, &packetLength));
+        ASSERT_EQ(STATUS_SUCCESS,
+                  rtp_packet_constructRetransmitPacketFromBytes(buffer, packetLength, rtxSequenceNumber++, 97, 0x5678, &pRtxRtpPacket));
+        pEncrypted = (PBYTE) MEMALLOC(pRtxRtpPacket->rawPacketLength + SRTP_AUTH_TAG_OVERHEAD);
+        MEMCPY(pEncrypted, pRtxRtpPacket->pRawPacket, pRtxRtpPacket->rawPacketLength);
+        encryptedLength = (INT32) pRtxRtpPacket->rawPacketLength;
+        ASSERT_EQ(STATUS_SUCCESS, srtp_session_encryptRtpPacket(pSrtpSession, pEncrypted, &encryptedLength));
+        SAFE_MEMFREE(pEncrypted);
+        rtp_packet_free(&pRtxRtpPacket);
+    }
+    reserializeTime = GETTIME() - startTime;
+    reserializeAllocations = ATOMIC_LOAD(&gRetransmitBenchmarkAllocations);
+
+    // the packet is read behind the headroom, patched into the rtx packet and encrypted where it is
+    ATOMIC_STORE(&gRetransmitBenchmarkAllocations, 0);
+    startTime = GETTIME();
+    for (i = 0; i < RETRANSMIT_BENCHMARK_RESENDS; i++) {
+        packetLength = DEFAULT_RETRANSMIT_PACKET_BUFFER_SIZE;
+        ASSERT_EQ(STATUS_SUCCESS,
+                  rtp_history_get(pRtpHistory, (UINT16) (i % RETRANSMIT_BENCHMARK_HISTORY_PACKETS), startTime, buffer + RTX_OSN_LENGTH,
+                                  &packetLength));
+        ASSERT_EQ(STATUS_SUCCESS, rtp_packet_setPacketFromBytes(buffer + RTX_OSN_LENGTH, packetLength, &rtpPacket));
+        rtpPacket.pRawPacket = buffer + RTX_OSN_LENGTH;
+        ASSERT_EQ(STATUS_SUCCESS,
+                  rtp_packet_constructRetransmitPacketInPlace(&rtpPacket, rtxSequenceNumber++, 97, 0x5678, &pRtxPacket, &rtxPacketLength));
+        encryptedLength = (INT32) rtxPacketLength;
+        ASSERT_EQ(STATUS_SUCCESS, srtp_session_encryptRtpPacket(pSrtpSession, pRtxPacket, &encryptedLength));
+    }
+    inPlaceTime = GETTIME() - startTime;
+    inPlaceAllocations = ATOMIC_LOAD(&gRetransmitBenchmarkAllocations);
+
+    globalMemAlloc = gStoredMemAlloc;
+    globalMemCalloc = gStoredMemCalloc;
+
+    EXPECT_EQ(0, inPlaceAllocations);
+    EXPECT_LT(inPlaceAllocations, reserializeAllocations);
+    DLOGI("Resending %u packets of %u bytes: reserialized %" PRIu64 " ns and %.1f allocations per resend, in place %" PRIu64
+          " ns and %.1f allocations per resend",
+          RETRANSMIT_BENCHMARK_RESENDS, RETRANSMIT_BENCHMARK_PAYLOAD_LEN, reserializeTime * DEFAULT_TIME_UNIT_IN_NANOS / RETRANSMIT_BENCHMARK_RESENDS,
+          (DOUBLE) reserializeAllocations / RETRANSMIT_BENCHMARK_RESENDS, inPlaceTime * DEFAULT_TIME_UNIT_IN_NANOS / RETRANSMIT_BENCHMARK_RESENDS,
+          (DOUBLE) inPlaceAllocations / RETRANSMIT_BENCHMARK_RESENDS);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_free(&pRtpHistory));
+    EXPECT_EQ(STATUS_SUCCESS, srtp_session_free(&pSrtpSession));
+}
+
 TEST_F(RtcpFunctionalityTest, onRtcpPacketCompound)
 {
     KvsPeerConnection peerConnection{};
@@ -201,12 +733,64 @@ TEST_F(RtcpFunctionalityTest, onRtcpPacketCompoundSenderReport)
     EXPECT_EQ(1, stats.reportsReceived);
     EXPECT_EQ(1, stats.roundTripTimeMeasurements);
     // rtcp_onInboundPacket uses real time clock GETTIME to calculate roundTripTime, cant test
-    EXPECT_EQ(4.0 / 255.0, stats.fractionLost);
+    EXPECT_EQ(4.0 / 256.0, stats.fractionLost);
     EXPECT_LT(0, stats.totalRoundTripTime);
     EXPECT_LT(0, stats.roundTripTime);
     pc_free(&pRtcPeerConnection);
 }
 
+TEST_F(RtcpFunctionalityTest, onRtcpReceiverReportWithBlockPerTransceiver)
+{
+    BYTE rawPacket[RTCP_PACKET_HEADER_LEN + 4 + 2 * RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN] = {0};
+    RtcpReportBlock reportBlock{};
+    RtcRemoteInboundRtpStreamStats stats{};
+
+    initTransceiver(0x1111);
+    auto t = pc_addTransceiver(0x2222);
+
+    rawPacket[0] = (RTCP_PACKET_VERSION_VAL << 6) | 2;
+    rawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_RECEIVER_REPORT;
+    putUnalignedInt16BigEndian(rawPacket + RTCP_PACKET_LEN_OFFSET, SIZEOF(rawPacket) / RTCP_PACKET_LEN_WORD_SIZE - 1);
+    putUnalignedInt32BigEndian(rawPacket + 4, 0x4242);
+    // first block: 64/256 lost, no sender report received yet
+    putUnalignedInt32BigEndian(rawPacket + 8, 0x1111);
+    putUnalignedInt32BigEndian(rawPacket + 12, 0x40000010);
+    putUnalignedInt32BigEndian(rawPacket + 16, 1000);
+    putUnalignedInt32BigEndian(rawPacket + 20, 900);
+    // second block: duplicates outnumber the losses
+    putUnalignedInt32BigEndian(rawPacket + 32, 0x2222);
+    putUnalignedInt32BigEndian(rawPacket + 36, 0x00FFFFFD);
+    putUnalignedInt32BigEndian(rawPacket + 40, 2000);
+    putUnalignedInt32BigEndian(rawPacket + 44, 1800);
+    putUnalignedInt32BigEndian(rawPacket + 48, 0x01020304);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_getReportBlock(rawPacket + 32, RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN, &reportBlock));
+    EXPECT_EQ(0x2222, reportBlock.ssrc);
+    EXPECT_EQ(0, reportBlock.fractionLost);
+    EXPECT_EQ(-3, reportBlock.cumulativeLost);
+    EXPECT_EQ(2000, reportBlock.extendedHighestSequenceNumber);
+    EXPECT_EQ(0x01020304, reportBlock.lastSenderReport);
+    EXPECT_EQ(STATUS_RTCP_INPUT_PACKET_TOO_SMALL, rtcp_packet_getReportBlock(rawPacket + 32, RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN - 1, &reportBlock));
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, rawPacket, SIZEOF(rawPacket)));
+
+    EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpRemoteInboundStats(pRtcPeerConnection, pRtcRtpTransceiver, &stats));
+    EXPECT_EQ(0x1111, stats.ssrc);
+    EXPECT_EQ(1, stats.reportsReceived);
+    EXPECT_EQ(0, stats.roundTripTimeMeasurements);
+    EXPECT_EQ(64.0 / 256.0, stats.fractionLost);
+    EXPECT_EQ(16, stats.packetsLost);
+    EXPECT_DOUBLE_EQ(900.0 / VIDEO_CLOCKRATE, stats.jitter);
+
+    EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpRemoteInboundStats(pRtcPeerConnection, t, &stats));
+    EXPECT_EQ(0x2222, stats.ssrc);
+    EXPECT_EQ(1, stats.reportsReceived);
+    EXPECT_EQ(1, stats.roundTripTimeMeasurements);
+    EXPECT_EQ(-3, stats.packetsLost);
+    EXPECT_DOUBLE_EQ(1800.0 / VIDEO_CLOCKRATE, stats.jitter);
+    pc_free(&pRtcPeerConnection);
+}
+
 TEST_F(RtcpFunctionalityTest, rtcp_packet_getRembValue)
 {
     BYTE rawRtcpPacket[] = {0x8f, 0xce, 0x00, 0x05, 0x61, 0x7a, 0x37, 0x43, 0x00, 0x00, 0x00, 0x00,
@@ -274,6 +858,29 @@ TEST_F(RtcpFunctionalityTest, onRtcpRembCalled)
     pc_free(&pRtcPeerConnection);
 }
 
+TEST_F(RtcpFunctionalityTest, rtcpKeyFrameRequestBytes)
+{
+    BYTE expectedPli[] = {0x81, 0xCE, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x1D, 0xC8, 0x69, 0x91};
+    BYTE expectedFir[] = {0x84, 0xCE, 0x00, 0x04, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+                          0x1D, 0xC8, 0x69, 0x91, 0x07, 0x00, 0x00, 0x00};
+    BYTE rawPacket[32];
+    UINT32 packetLen = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_createPliBytes(1, 0x1DC86991, nullptr, &packetLen));
+    EXPECT_EQ(SIZEOF(expectedPli), packetLen);
+    packetLen = SIZEOF(expectedPli) - 1;
+    EXPECT_EQ(STATUS_BUFFER_TOO_SMALL, rtcp_packet_createPliBytes(1, 0x1DC86991, rawPacket, &packetLen));
+    packetLen = SIZEOF(rawPacket);
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_createPliBytes(1, 0x1DC86991, rawPacket, &packetLen));
+    EXPECT_EQ(SIZEOF(expectedPli), packetLen);
+    EXPECT_EQ(0, MEMCMP(expectedPli, rawPacket, packetLen));
+
+    packetLen = SIZEOF(rawPacket);
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_createFirBytes(1, 0x1DC86991, 7, rawPacket, &packetLen));
+    EXPECT_EQ(SIZEOF(expectedFir), packetLen);
+    EXPECT_EQ(0, MEMCMP(expectedFir, rawPacket, packetLen));
+}
+
 TEST_F(RtcpFunctionalityTest, onpli)
 {
     BYTE rawRtcpPacket[] = {0x81, 0xCE, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x1D, 0xC8, 0x69, 0x91};
@@ -296,6 +903,235 @@ TEST_F(RtcpFunctionalityTest, onpli)
     pc_free(&pRtcPeerConnection);
 }
 
+TEST_F(RtcpFunctionalityTest, onPLIPacketCoalescedByMediaSource)
+{
+    // PLI for media ssrc 0x1DC86991 and 0x1DC86992
+    BYTE rawPli1[] = {0x81, 0xCE, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x1D, 0xC8, 0x69, 0x91};
+    BYTE rawPli2[] = {0x81, 0xCE, 0x00, 0x02, 0x00, 0x00, 0x00, 0x01, 0x1D, 0xC8, 0x69, 0x92};
+    RtcpPacket pli1{}, pli2{};
+    PRtcMediaSource pMediaSource = nullptr;
+    RtcKeyFrameRequestStats stats{};
+    UINT32 sourceCallbacks = 0, transceiverCallbacks = 0;
+    auto countCallback = [](UINT64 customData) -> void { (*(PUINT32) customData)++; };
+
+    initTransceiver(0x1DC86991);
+    auto pSecondTransceiver = pc_addTransceiver(0x1DC86992);
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_setFromBytes(rawPli1, SIZEOF(rawPli1), &pli1));
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_setFromBytes(rawPli2, SIZEOF(rawPli2), &pli2));
+
+    EXPECT_EQ(STATUS_NULL_ARG, media_source_create(0, 0, nullptr, &pMediaSource));
+    EXPECT_EQ(STATUS_SUCCESS, media_source_create(200 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, (UINT64) &sourceCallbacks, countCallback, &pMediaSource));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_onPictureLoss(pRtcRtpTransceiver, (UINT64) &transceiverCallbacks, countCallback));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_setMediaSource(pRtcRtpTransceiver, pMediaSource));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_setMediaSource(pSecondTransceiver, pMediaSource));
+
+    // the first request fires right away, the one from the other viewer is merged into it
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_onPLIPacket(&pli1, pKvsPeerConnection));
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_onPLIPacket(&pli2, pKvsPeerConnection));
+    EXPECT_EQ(1, sourceCallbacks);
+    EXPECT_EQ(0, transceiverCallbacks);
+
+    // the key frame answers the merged request
+    EXPECT_EQ(STATUS_SUCCESS, media_source_onFrameSent((PKvsMediaSource) pMediaSource, TRUE));
+    EXPECT_EQ(STATUS_SUCCESS, media_source_getKeyFrameRequestStats(pMediaSource, &stats));
+    EXPECT_EQ(2, stats.keyFrameRequestsReceived);
+    EXPECT_EQ(1, stats.keyFrameRequestsCoalesced);
+    EXPECT_EQ(1, stats.keyFrameRequestsSatisfied);
+    EXPECT_EQ(1, stats.keyFrameRequestsFired);
+
+    // without a key frame the merged request fires once at the end of the interval
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_onPLIPacket(&pli1, pKvsPeerConnection));
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_onPLIPacket(&pli2, pKvsPeerConnection));
+    EXPECT_EQ(STATUS_SUCCESS, media_source_onFrameSent((PKvsMediaSource) pMediaSource, FALSE));
+    EXPECT_EQ(1, sourceCallbacks);
+    THREAD_SLEEP(250 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    EXPECT_EQ(STATUS_SUCCESS, media_source_onFrameSent((PKvsMediaSource) pMediaSource, FALSE));
+    EXPECT_EQ(STATUS_SUCCESS, media_source_onFrameSent((PKvsMediaSource) pMediaSource, FALSE));
+    EXPECT_EQ(2, sourceCallbacks);
+    EXPECT_EQ(STATUS_SUCCESS, media_source_getKeyFrameRequestStats(pMediaSource, &stats));
+    EXPECT_EQ(4, stats.keyFrameRequestsReceived);
+    EXPECT_EQ(3, stats.keyFrameRequestsCoalesced);
+    EXPECT_EQ(2, stats.keyFrameRequestsFired);
+
+    // detached transceivers go back to their own callback
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_setMediaSource(pRtcRtpTransceiver, nullptr));
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_onPLIPacket(&pli1, pKvsPeerConnection));
+    EXPECT_EQ(1, transceiverCallbacks);
+
+    pc_free(&pRtcPeerConnection);
+    EXPECT_EQ(STATUS_SUCCESS, media_source_free(&pMediaSource));
+    EXPECT_EQ(nullptr, pMediaSource);
+}
+
+TEST_F(RtcpFunctionalityTest, playoutSyncPresentationTimestampFromSenderReport)
+{
+    PPlayoutSync pPlayoutSync = NULL;
+    UINT64 senderTime = 1600000000ULL * HUNDREDS_OF_NANOS_IN_A_SECOND + 1234567, presentationTs = 42, extraDelay = 1;
+    BOOL claimed = FALSE;
+
+    EXPECT_EQ(senderTime, rtcp_packet_convertNTPToTimestamp(rtcp_packet_convertTimestampToNTP(senderTime)));
+
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_create(&pPlayoutSync));
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_claimStream(pPlayoutSync, PLAYOUT_SYNC_STREAM_AUDIO, &claimed));
+    EXPECT_TRUE(claimed);
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_claimStream(pPlayoutSync, PLAYOUT_SYNC_STREAM_AUDIO, &claimed));
+    EXPECT_FALSE(claimed);
+
+    // nothing to map the rtp timestamps with before the first SR
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_onFrame(pPlayoutSync, PLAYOUT_SYNC_STREAM_AUDIO, 1000, senderTime, &presentationTs, &extraDelay));
+    EXPECT_EQ(42, presentationTs);
+    EXPECT_EQ(0, extraDelay);
+
+    // the rtp timestamp wraps between the SR and the frames around it
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_onSenderReport(pPlayoutSync, PLAYOUT_SYNC_STREAM_AUDIO, senderTime, 0xFFFFFF00, 48000));
+    EXPECT_EQ(STATUS_SUCCESS,
+              playout_sync_onFrame(pPlayoutSync, PLAYOUT_SYNC_STREAM_AUDIO, 0xFFFFFF00 + 4800, senderTime, &presentationTs, &extraDelay));
+    EXPECT_EQ(senderTime + 100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, presentationTs);
+    EXPECT_EQ(STATUS_SUCCESS,
+              playout_sync_onFrame(pPlayoutSync, PLAYOUT_SYNC_STREAM_AUDIO, 0xFFFFFF00 - 960, senderTime, &presentationTs, &extraDelay));
+    EXPECT_EQ(senderTime - 20 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, presentationTs);
+    // a single stream is never held
+    EXPECT_EQ(0, extraDelay);
+
+    EXPECT_EQ(STATUS_INVALID_ARG, playout_sync_onSenderReport(pPlayoutSync, PLAYOUT_SYNC_STREAM_NONE, senderTime, 0, 48000));
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_free(&pPlayoutSync));
+    EXPECT_EQ(nullptr, pPlayoutSync);
+}
+
+TEST_F(RtcpFunctionalityTest, playoutSyncHoldsEarlierStream)
+{
+    PPlayoutSync pPlayoutSync = NULL;
+    // the clock of the receiver is 3 s ahead of the sender, which cancels out
+    UINT64 senderTime = 1600000000ULL * HUNDREDS_OF_NANOS_IN_A_SECOND, clockOffset = 3 * HUNDREDS_OF_NANOS_IN_A_SECOND;
+    UINT64 audioDelay = 40 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, videoDelay = 120 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    UINT64 audioHold = 0, videoHold = 0, audioTs = 0, videoTs = 0, captureTime;
+    UINT32 ms;
+    BOOL claimed = FALSE;
+
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_create(&pPlayoutSync));
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_claimStream(pPlayoutSync, PLAYOUT_SYNC_STREAM_AUDIO, &claimed));
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_claimStream(pPlayoutSync, PLAYOUT_SYNC_STREAM_VIDEO, &claimed));
+    // both streams start at a random rtp timestamp
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_onSenderReport(pPlayoutSync, PLAYOUT_SYNC_STREAM_AUDIO, senderTime, 12345, 48000));
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_onSenderReport(pPlayoutSync, PLAYOUT_SYNC_STREAM_VIDEO, senderTime, 987654, 90000));
+
+    // 20 ms audio frames and 40 ms video frames, released with the hold their jitter buffer was given last
+    for (ms = 0; ms < 3000; ms += 20) {
+        captureTime = senderTime + ms * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+        EXPECT_EQ(STATUS_SUCCESS,
+                  playout_sync_onFrame(pPlayoutSync, PLAYOUT_SYNC_STREAM_AUDIO, 12345 + ms * 48, captureTime + clockOffset + audioDelay + audioHold,
+                                       &audioTs, &audioHold));
+        EXPECT_EQ(captureTime, audioTs);
+        if (ms % 40 == 0) {
+            EXPECT_EQ(STATUS_SUCCESS,
+                      playout_sync_onFrame(pPlayoutSync, PLAYOUT_SYNC_STREAM_VIDEO, 987654 + ms * 90,
+                                           captureTime + clockOffset + videoDelay + videoHold, &videoTs, &videoHold));
+            EXPECT_EQ(captureTime, videoTs);
+        }
+    }
+
+    // audio waits for the video, which is not held
+    EXPECT_EQ(0, videoHold);
+    EXPECT_LE(videoDelay - audioDelay - PLAYOUT_SYNC_TOLERANCE, audioHold);
+    EXPECT_GE(videoDelay - audioDelay + PLAYOUT_SYNC_TOLERANCE, audioHold);
+
+    // the video catches up, the hold is released
+    for (ms = 3000; ms < 6000; ms += 20) {
+        captureTime = senderTime + ms * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+        EXPECT_EQ(STATUS_SUCCESS,
+                  playout_sync_onFrame(pPlayoutSync, PLAYOUT_SYNC_STREAM_AUDIO, 12345 + ms * 48, captureTime + clockOffset + audioDelay + audioHold,
+                                       &audioTs, &audioHold));
+        if (ms % 40 == 0) {
+            EXPECT_EQ(STATUS_SUCCESS,
+                      playout_sync_onFrame(pPlayoutSync, PLAYOUT_SYNC_STREAM_VIDEO, 987654 + ms * 90,
+                                           captureTime + clockOffset + audioDelay + videoHold, &videoTs, &videoHold));
+        }
+    }
+    EXPECT_GE(PLAYOUT_SYNC_TOLERANCE, audioHold);
+    EXPECT_GE(PLAYOUT_SYNC_TOLERANCE, videoHold);
+
+    EXPECT_EQ(STATUS_SUCCESS, playout_sync_free(&pPlayoutSync));
+}
+
+TEST_F(RtcpFunctionalityTest, ssrcMapPutGetRemove)
+{
+    PSsrcMap pSsrcMap = NULL;
+    UINT64 value = 0;
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_INVALID_ARG, ssrc_map_create(0, &pSsrcMap));
+    EXPECT_EQ(STATUS_SUCCESS, ssrc_map_create(4, &pSsrcMap));
+    EXPECT_EQ(STATUS_NOT_FOUND, ssrc_map_get(pSsrcMap, 0, &value));
+
+    // consecutive ssrcs, the map grows several times on the way
+    for (i = 0; i < 1000; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, ssrc_map_put(pSsrcMap, 0x12340000 + i, i));
+    }
+    EXPECT_EQ(1000, pSsrcMap->count);
+    EXPECT_GE(pSsrcMap->capacity, 2000);
+    EXPECT_EQ(STATUS_SUCCESS, ssrc_map_put(pSsrcMap, 0x12340000, 4242));
+    EXPECT_EQ(1000, pSsrcMap->count);
+
+    // every other ssrc leaves, the rest of each probe sequence has to stay reachable
+    for (i = 0; i < 1000; i += 2) {
+        EXPECT_EQ(STATUS_SUCCESS, ssrc_map_remove(pSsrcMap, 0x12340000 + i));
+    }
+    EXPECT_EQ(STATUS_NOT_FOUND, ssrc_map_remove(pSsrcMap, 0x12340000));
+    for (i = 0; i < 1000; i++) {
+        if (i % 2 == 0) {
+            EXPECT_EQ(STATUS_NOT_FOUND, ssrc_map_get(pSsrcMap, 0x12340000 + i, &value));
+        } else {
+            EXPECT_EQ(STATUS_SUCCESS, ssrc_map_get(pSsrcMap, 0x12340000 + i, &value));
+            EXPECT_EQ(i, value);
+        }
+    }
+    EXPECT_EQ(500, pSsrcMap->count);
+
+    // only removed while it still maps to the value
+    EXPECT_EQ(STATUS_NOT_FOUND, ssrc_map_removeValue(pSsrcMap, 0x12340001, 2));
+    EXPECT_EQ(STATUS_SUCCESS, ssrc_map_removeValue(pSsrcMap, 0x12340001, 1));
+    EXPECT_EQ(STATUS_NOT_FOUND, ssrc_map_get(pSsrcMap, 0x12340001, &value));
+    EXPECT_EQ(499, pSsrcMap->count);
+
+    EXPECT_EQ(STATUS_SUCCESS, ssrc_map_free(&pSsrcMap));
+    EXPECT_EQ(NULL, pSsrcMap);
+}
+
+// An SFU like peer connection with many transceivers. The transceiver added first is the last one of the list, which
+// the walk of the transceivers reached last, and is found as fast as the one added last.
+TEST_F(RtcpFunctionalityTest, benchmarkSsrcDemuxWithManyTransceivers)
+{
+    PKvsRtpTransceiver pFirst = NULL, pLast = NULL, pFound = NULL;
+    UINT64 startTime, firstTime, lastTime;
+    UINT32 i;
+
+    initTransceiver(1000);
+    pFirst = pKvsRtpTransceiver;
+    for (i = 1; i < 200; i++) {
+        pLast = (PKvsRtpTransceiver) pc_addTransceiver(1000 + i);
+    }
+    EXPECT_EQ(STATUS_NOT_FOUND, rtp_transceiver_findBySsrc(pKvsPeerConnection, &pFound, 999));
+
+    startTime = GETTIME();
+    for (i = 0; i < 100000; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_findBySsrc(pKvsPeerConnection, &pFound, 1000));
+    }
+    firstTime = GETTIME() - startTime;
+    EXPECT_EQ(pFirst, pFound);
+
+    startTime = GETTIME();
+    for (i = 0; i < 100000; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_findBySsrc(pKvsPeerConnection, &pFound, 1199));
+    }
+    lastTime = GETTIME() - startTime;
+    EXPECT_EQ(pLast, pFound);
+
+    DLOGI("Ssrc lookup with 200 transceivers: first added %" PRIu64 " ns, last added %" PRIu64 " ns",
+          firstTime * DEFAULT_TIME_UNIT_IN_NANOS / 100000, lastTime * DEFAULT_TIME_UNIT_IN_NANOS / 100000);
+
+    pc_free(&pRtcPeerConnection);
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
@@ -486,6 +486,301 @@ TEST_F(RtpFunctionalityTest, trailingZerosWouldBeReturned)
     EXPECT_EQ(7, naluLength);
 }
 
+TEST_F(RtpFunctionalityTest, oneByteHeaderExtensionRoundTrip)
+{
+    BYTE extension[8];
+    BYTE payload[] = {0x00, 0x01, 0x02, 0x03};
+    BYTE rawPacket[64];
+    BYTE mid[] = {'0'};
+    BYTE rid[] = {'h', 'i'};
+    UINT32 filledLen = 0, packetLen = 0, dataLen = 0;
+    PBYTE pData = NULL;
+    RtpPacket rtpPacket, parsedPacket;
+
+    MEMSET(extension, 0xFF, SIZEOF(extension));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_appendOneByteExtension(extension, SIZEOF(extension), &filledLen, 1, mid, SIZEOF(mid)));
+    EXPECT_EQ(2, filledLen);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_appendOneByteExtension(extension, SIZEOF(extension), &filledLen, 2, rid, SIZEOF(rid)));
+    EXPECT_EQ(5, filledLen);
+    EXPECT_EQ(0x10, extension[0]);
+    EXPECT_EQ('0', extension[1]);
+    EXPECT_EQ(0x21, extension[2]);
+    EXPECT_EQ(0x00, extension[5]);
+    EXPECT_EQ(0x00, extension[7]);
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              rtp_packet_set(2, FALSE, TRUE, 0, TRUE, 96, 42, 1000, 0x1234ABCD, NULL, RTP_ONE_BYTE_EXTENSION_PROFILE, ROUND_UP(filledLen, 4),
+                             extension, payload, SIZEOF(payload), &rtpPacket));
+    packetLen = RTP_GET_RAW_PACKET_SIZE(&rtpPacket);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_setBytesFromPacket(&rtpPacket, rawPacket, SIZEOF(rawPacket)));
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_setPacketFromBytes(rawPacket, packetLen, &parsedPacket));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_getOneByteExtension(&parsedPacket, 2, &pData, &dataLen));
+    EXPECT_EQ(2, dataLen);
+    EXPECT_EQ(0, MEMCMP(rid, pData, dataLen));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_getOneByteExtension(&parsedPacket, 1, &pData, &dataLen));
+    EXPECT_EQ(1, dataLen);
+    EXPECT_EQ('0', pData[0]);
+
+    // rtx packets carry the rid in the repaired-rtp-stream-id element
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_rewriteOneByteExtensionId(rawPacket, packetLen, 2, 3));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_setPacketFromBytes(rawPacket, packetLen, &parsedPacket));
+    EXPECT_EQ(STATUS_RTP_EXTENSION_NOT_FOUND, rtp_packet_getOneByteExtension(&parsedPacket, 2, &pData, &dataLen));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_getOneByteExtension(&parsedPacket, 3, &pData, &dataLen));
+    EXPECT_EQ(0, MEMCMP(rid, pData, dataLen));
+    EXPECT_EQ(STATUS_RTP_EXTENSION_NOT_FOUND, rtp_packet_rewriteOneByteExtensionId(rawPacket, packetLen, 4, 5));
+}
+
+TEST_F(RtpFunctionalityTest, oneByteHeaderExtensionInvalidArgs)
+{
+    BYTE extension[32];
+    BYTE data[RTP_ONE_BYTE_EXTENSION_MAX_LEN + 1] = {0};
+    UINT32 filledLen = 0;
+
+    EXPECT_EQ(STATUS_INVALID_ARG, rtp_packet_appendOneByteExtension(extension, SIZEOF(extension), &filledLen, 0, data, 1));
+    EXPECT_EQ(STATUS_INVALID_ARG,
+              rtp_packet_appendOneByteExtension(extension, SIZEOF(extension), &filledLen, RTP_ONE_BYTE_EXTENSION_RESERVED_ID, data, 1));
+    EXPECT_EQ(STATUS_RTP_INVALID_EXTENSION_LEN, rtp_packet_appendOneByteExtension(extension, SIZEOF(extension), &filledLen, 1, data, 0));
+    EXPECT_EQ(STATUS_RTP_INVALID_EXTENSION_LEN, rtp_packet_appendOneByteExtension(extension, SIZEOF(extension), &filledLen, 1, data, SIZEOF(data)));
+    EXPECT_EQ(STATUS_RTP_BUFFER_TOO_SMALL, rtp_packet_appendOneByteExtension(extension, 2, &filledLen, 1, data, 2));
+    EXPECT_EQ(0, filledLen);
+}
+
+TEST_F(RtpFunctionalityTest, h264ReferenceFrameDetection)
+{
+    BOOL isReference = FALSE;
+    // sps, pps and an idr slice
+    BYTE keyFrame[] = {0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84};
+    // sei followed by a slice with nal_ref_idc 2
+    BYTE referenceFrame[] = {0x00, 0x00, 0x00, 0x01, 0x06, 0x05, 0x00, 0x00, 0x00, 0x01, 0x41, 0x9a, 0x02};
+    // slice with nal_ref_idc 0
+    BYTE nonReferenceFrame[] = {0x00, 0x00, 0x00, 0x01, 0x01, 0x9e, 0x04};
+    BYTE invalidFrame[] = {0x01, 0x01, 0x9e, 0x04};
+
+    EXPECT_EQ(STATUS_SUCCESS, isH264ReferenceFrame(keyFrame, SIZEOF(keyFrame), &isReference));
+    EXPECT_TRUE(isReference);
+    EXPECT_EQ(STATUS_SUCCESS, isH264ReferenceFrame(referenceFrame, SIZEOF(referenceFrame), &isReference));
+    EXPECT_TRUE(isReference);
+    EXPECT_EQ(STATUS_SUCCESS, isH264ReferenceFrame(nonReferenceFrame, SIZEOF(nonReferenceFrame), &isReference));
+    EXPECT_FALSE(isReference);
+    // frames that can not be parsed are assumed to be referenced
+    EXPECT_NE(STATUS_SUCCESS, isH264ReferenceFrame(invalidFrame, SIZEOF(invalidFrame), &isReference));
+    EXPECT_TRUE(isReference);
+    EXPECT_EQ(STATUS_NULL_ARG, isH264ReferenceFrame(NULL, 0, &isReference));
+}
+
+TEST_F(RtpFunctionalityTest, deltaFramesDroppedUnderCongestion)
+{
+    RtcConfiguration configuration{};
+    PRtcPeerConnection pRtcPeerConnection = nullptr;
+    RtcMediaStreamTrack track{};
+    PRtcRtpTransceiver pRtcRtpTransceiver = nullptr;
+    PKvsRtpTransceiver pKvsRtpTransceiver = nullptr;
+    RtcOutboundRtpStreamStats stats{};
+    UINT32 keyFrameRequests = 0;
+    Frame frame{};
+    BYTE keyFrame[] = {0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84};
+    BYTE referenceFrame[] = {0x00, 0x00, 0x00, 0x01, 0x41, 0x9a, 0x02};
+    BYTE nonReferenceFrame[] = {0x00, 0x00, 0x00, 0x01, 0x01, 0x9e, 0x04};
+
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
+    STRCPY(track.streamId, "myKvsVideoStream");
+    STRCPY(track.trackId, "myTrack");
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_create(&configuration, &pRtcPeerConnection));
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(pRtcPeerConnection, &track, nullptr, &pRtcRtpTransceiver));
+    pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_onPictureLoss(pRtcRtpTransceiver, (UINT64) &keyFrameRequests, [](UINT64 customData) -> void {
+                  (*(PUINT32) customData)++;
+              }));
+
+    // a packet of the encoding just failed to send
+    pKvsRtpTransceiver->sender.dropState.lastSendFailureTime = GETTIME();
+
+    // non reference frames are dropped without breaking the reference chain
+    frame.frameData = nonReferenceFrame;
+    frame.size = SIZEOF(nonReferenceFrame);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_writeFrame(pRtcRtpTransceiver, &frame));
+    EXPECT_FALSE(pKvsRtpTransceiver->sender.dropState.waitingForKeyFrame);
+    EXPECT_EQ(0, keyFrameRequests);
+
+    // dropping a reference frame breaks the chain, a key frame is requested once
+    frame.frameData = referenceFrame;
+    frame.size = SIZEOF(referenceFrame);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_writeFrame(pRtcRtpTransceiver, &frame));
+    EXPECT_TRUE(pKvsRtpTransceiver->sender.dropState.waitingForKeyFrame);
+    EXPECT_EQ(1, keyFrameRequests);
+
+    // the following delta frames are undecodable and dropped even once the congestion is over
+    pKvsRtpTransceiver->sender.dropState.lastSendFailureTime = 0;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_writeFrame(pRtcRtpTransceiver, &frame));
+    EXPECT_EQ(1, keyFrameRequests);
+
+    EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpOutboundStats(pRtcPeerConnection, pRtcRtpTransceiver, &stats));
+    EXPECT_EQ(3, stats.framesEncoded);
+    EXPECT_EQ(3, stats.framesDiscardedOnSend);
+    EXPECT_EQ(0, stats.framesSent);
+
+    // key frames are never dropped by the policy, this one only fails as srtp is not set up
+    frame.frameData = keyFrame;
+    frame.size = SIZEOF(keyFrame);
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    EXPECT_EQ(STATUS_SRTP_NOT_READY_YET, rtp_writeFrame(pRtcRtpTransceiver, &frame));
+
+    pc_close(pRtcPeerConnection);
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnection));
+}
+
+TEST_F(RtpFunctionalityTest, paddingOnlyRetransmissionIsDropped)
+{
+    RtcConfiguration configuration{};
+    PRtcPeerConnection pRtcPeerConnection = nullptr;
+    RtcMediaStreamTrack track{};
+    PRtcRtpTransceiver pRtcRtpTransceiver = nullptr;
+    PKvsRtpTransceiver pKvsRtpTransceiver = nullptr;
+    RtcInboundRtpStreamStats stats{};
+    // padding bit set, rtx ssrc 0x2000, 4 bytes of padding which is all the payload there is
+    BYTE paddingOnly[] = {0xa0, 0x61, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x04};
+    PBYTE pPacket;
+
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_VP8;
+    STRCPY(track.streamId, "myKvsVideoStream");
+    STRCPY(track.trackId, "myTrack");
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_create(&configuration, &pRtcPeerConnection));
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(pRtcPeerConnection, &track, nullptr, &pRtcRtpTransceiver));
+    pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+    pKvsRtpTransceiver->jitterBufferSsrc = 0x1000;
+    pKvsRtpTransceiver->jitterBufferRtxSsrc = 0x2000;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_mapSsrcs(pKvsRtpTransceiver));
+
+    // the packet is taken over, as it is after decryption
+    pPacket = (PBYTE) MEMALLOC(SIZEOF(paddingOnly));
+    MEMCPY(pPacket, paddingOnly, SIZEOF(paddingOnly));
+    EXPECT_EQ(STATUS_SUCCESS, pc_onDecryptedRtpPacket((UINT64) pRtcPeerConnection, pPacket, SIZEOF(paddingOnly), GETTIME(), STATUS_SUCCESS));
+
+    EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpInboundStats(pRtcPeerConnection, pRtcRtpTransceiver, &stats));
+    EXPECT_EQ(1, stats.received.packetsReceived);
+    EXPECT_EQ(0, stats.bytesReceived);
+
+    pc_close(pRtcPeerConnection);
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnection));
+}
+
+TEST_F(RtpFunctionalityTest, remappedSsrcsLeaveTheSsrcMap)
+{
+    RtcConfiguration configuration{};
+    PRtcPeerConnection pRtcPeerConnection = nullptr;
+    PKvsPeerConnection pKvsPeerConnection = nullptr;
+    RtcMediaStreamTrack track{};
+    PRtcRtpTransceiver pFirst = nullptr, pSecond = nullptr;
+    UINT64 value = 0;
+    UINT32 count;
+
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_VP8;
+    STRCPY(track.streamId, "myKvsVideoStream");
+    STRCPY(track.trackId, "myTrack");
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_create(&configuration, &pRtcPeerConnection));
+    pKvsPeerConnection = (PKvsPeerConnection) pRtcPeerConnection;
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(pRtcPeerConnection, &track, nullptr, &pFirst));
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(pRtcPeerConnection, &track, nullptr, &pSecond));
+    count = pKvsPeerConnection->pSsrcMap->count;
+
+    ((PKvsRtpTransceiver) pFirst)->jitterBufferSsrc = 0x1000;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_mapSsrcs((PKvsRtpTransceiver) pFirst));
+    EXPECT_EQ(count + 1, pKvsPeerConnection->pSsrcMap->count);
+
+    // the ssrc of the remote sender changed, the old one leaves the map
+    ((PKvsRtpTransceiver) pFirst)->jitterBufferSsrc = 0x3000;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_mapSsrcs((PKvsRtpTransceiver) pFirst));
+    EXPECT_EQ(STATUS_NOT_FOUND, ssrc_map_get(pKvsPeerConnection->pSsrcMap, 0x1000, &value));
+    EXPECT_EQ(STATUS_SUCCESS, ssrc_map_get(pKvsPeerConnection->pSsrcMap, 0x3000, &value));
+    EXPECT_EQ((UINT64) pFirst, value);
+    EXPECT_EQ(count + 1, pKvsPeerConnection->pSsrcMap->count);
+
+    // an ssrc another transceiver took over stays with it
+    ((PKvsRtpTransceiver) pSecond)->jitterBufferSsrc = 0x3000;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_mapSsrcs((PKvsRtpTransceiver) pSecond));
+    ((PKvsRtpTransceiver) pFirst)->jitterBufferSsrc = 0x4000;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_mapSsrcs((PKvsRtpTransceiver) pFirst));
+    EXPECT_EQ(STATUS_SUCCESS, ssrc_map_get(pKvsPeerConnection->pSsrcMap, 0x3000, &value));
+    EXPECT_EQ((UINT64) pSecond, value);
+
+    // as on free, every ssrc of the transceiver leaves
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_unmapSsrcs((PKvsRtpTransceiver) pFirst));
+    EXPECT_EQ(STATUS_NOT_FOUND, ssrc_map_get(pKvsPeerConnection->pSsrcMap, 0x4000, &value));
+    EXPECT_EQ(STATUS_NOT_FOUND, ssrc_map_get(pKvsPeerConnection->pSsrcMap, ((PKvsRtpTransceiver) pFirst)->sender.ssrc, &value));
+    EXPECT_EQ(STATUS_SUCCESS, ssrc_map_get(pKvsPeerConnection->pSsrcMap, ((PKvsRtpTransceiver) pSecond)->sender.ssrc, &value));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_mapSsrcs((PKvsRtpTransceiver) pFirst));
+
+    pc_close(pRtcPeerConnection);
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnection));
+}
+
+TEST_F(RtpFunctionalityTest, statsPolledWhileFramesAreWritten)
+{
+    const UINT32 writerCount = 2, framesPerWriter = 20000;
+    RtcConfiguration configuration{};
+    PRtcPeerConnection pRtcPeerConnection = nullptr;
+    RtcMediaStreamTrack track{};
+    PRtcRtpTransceiver pRtcRtpTransceiver = nullptr;
+    RtcOutboundRtpStreamStats stats{};
+    BYTE keyFrame[] = {0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84};
+    std::thread writers[writerCount];
+    UINT64 lastFramesEncoded = 0, polls = 0;
+    volatile SIZE_T writing = writerCount;
+    UINT32 i;
+
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
+    STRCPY(track.streamId, "myKvsVideoStream");
+    STRCPY(track.trackId, "myTrack");
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_create(&configuration, &pRtcPeerConnection));
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(pRtcPeerConnection, &track, nullptr, &pRtcRtpTransceiver));
+
+    // srtp is not set up, every frame only goes through the stats of the sender
+    for (i = 0; i < writerCount; i++) {
+        writers[i] = std::thread([&]() {
+            Frame frame{};
+            frame.frameData = keyFrame;
+            frame.size = SIZEOF(keyFrame);
+            frame.flags = FRAME_FLAG_KEY_FRAME;
+            for (UINT32 j = 0; j < framesPerWriter; j++) {
+                EXPECT_EQ(STATUS_SRTP_NOT_READY_YET, rtp_writeFrame(pRtcRtpTransceiver, &frame));
+            }
+            ATOMIC_DECREMENT(&writing);
+        });
+    }
+
+    // the counters of one frame are changed together, a snapshot never sees them apart
+    while (ATOMIC_LOAD(&writing) != 0) {
+        EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpOutboundStats(pRtcPeerConnection, pRtcRtpTransceiver, &stats));
+        EXPECT_EQ(stats.framesEncoded, stats.keyFramesEncoded);
+        EXPECT_EQ(stats.framesEncoded * SIZEOF(keyFrame), stats.totalEncodedBytesTarget);
+        EXPECT_LE(lastFramesEncoded, stats.framesEncoded);
+        lastFramesEncoded = stats.framesEncoded;
+        polls++;
+        THREAD_SLEEP(HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    }
+
+    for (i = 0; i < writerCount; i++) {
+        writers[i].join();
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpOutboundStats(pRtcPeerConnection, pRtcRtpTransceiver, &stats));
+    EXPECT_EQ(writerCount * framesPerWriter, stats.framesEncoded);
+    EXPECT_EQ(writerCount * framesPerWriter, stats.keyFramesEncoded);
+    EXPECT_LT(0, polls);
+
+    pc_close(pRtcPeerConnection);
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnection));
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
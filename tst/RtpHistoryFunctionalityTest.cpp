@@ -0,0 +1,254 @@
+#include "WebRTCClientTestFixture.h"
+
+namespace com {
+namespace amazonaws {
+namespace kinesis {
+namespace video {
+namespace webrtcclient {
+
+#define TEST_HISTORY_MAX_AGE_MSEC 1000
+#define TEST_HISTORY_TIME         (100 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+class RtpHistoryFunctionalityTest : public WebRtcClientTestBase {
+};
+
+// a packet whose bytes after the header all repeat the low byte of the sequence number
+static VOID fillHistoryPacket(UINT16 seqNum, PBYTE pPacket, UINT32 packetLength)
+{
+    MEMSET(pPacket, (BYTE) seqNum, packetLength);
+    pPacket[0] = 0x80;
+    pPacket[1] = 96;
+    putUnalignedInt16BigEndian((PINT16)(pPacket + SEQ_NUMBER_OFFSET), seqNum);
+}
+
+static BOOL isHistoryPacket(UINT16 seqNum, PBYTE pPacket, UINT32 packetLength)
+{
+    UINT32 i;
+
+    if (packetLength < MIN_HEADER_LENGTH || (UINT16) getUnalignedInt16BigEndian(pPacket + SEQ_NUMBER_OFFSET) != seqNum) {
+        return FALSE;
+    }
+    for (i = MIN_HEADER_LENGTH; i < packetLength; i++) {
+        if (pPacket[i] != (BYTE) seqNum) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+TEST_F(RtpHistoryFunctionalityTest, putAndGet)
+{
+    PRtpHistory pRtpHistory = NULL;
+    BYTE packet[100], buffer[100];
+    UINT32 length;
+    UINT16 seqNum;
+
+    EXPECT_NE(STATUS_SUCCESS, rtp_history_create(0, 1024, TEST_HISTORY_MAX_AGE_MSEC, &pRtpHistory));
+    ASSERT_EQ(STATUS_SUCCESS, rtp_history_create(6, 1024, TEST_HISTORY_MAX_AGE_MSEC, &pRtpHistory));
+    EXPECT_EQ(8, pRtpHistory->entryCount);
+
+    length = SIZEOF(buffer);
+    EXPECT_EQ(STATUS_NOT_FOUND, rtp_history_get(pRtpHistory, 0, TEST_HISTORY_TIME, buffer, &length));
+
+    for (seqNum = 0; seqNum < 5; seqNum++) {
+        fillHistoryPacket(seqNum, packet, 20 + seqNum);
+        EXPECT_EQ(STATUS_SUCCESS, rtp_history_put(pRtpHistory, packet, 20 + seqNum, TEST_HISTORY_TIME));
+    }
+    for (seqNum = 0; seqNum < 5; seqNum++) {
+        length = SIZEOF(buffer);
+        EXPECT_EQ(STATUS_SUCCESS, rtp_history_get(pRtpHistory, seqNum, TEST_HISTORY_TIME, buffer, &length));
+        EXPECT_EQ(20 + seqNum, length);
+        EXPECT_TRUE(isHistoryPacket(seqNum, buffer, length));
+    }
+
+    length = 10;
+    EXPECT_EQ(STATUS_BUFFER_TOO_SMALL, rtp_history_get(pRtpHistory, 0, TEST_HISTORY_TIME, buffer, &length));
+    length = SIZEOF(buffer);
+    EXPECT_EQ(STATUS_NOT_FOUND, rtp_history_get(pRtpHistory, 5, TEST_HISTORY_TIME, buffer, &length));
+    EXPECT_EQ(STATUS_NOT_FOUND, rtp_history_get(pRtpHistory, 8, TEST_HISTORY_TIME, buffer, &length));
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_free(&pRtpHistory));
+    EXPECT_EQ(NULL, pRtpHistory);
+}
+
+TEST_F(RtpHistoryFunctionalityTest, oldestPacketsAreDroppedWhenEntriesRunOut)
+{
+    PRtpHistory pRtpHistory = NULL;
+    BYTE packet[20], buffer[20];
+    UINT32 length, i;
+    UINT16 seqNum = 65530;
+
+    ASSERT_EQ(STATUS_SUCCESS, rtp_history_create(4, 1024, TEST_HISTORY_MAX_AGE_MSEC, &pRtpHistory));
+    // across the wrap of the sequence numbers
+    for (i = 0; i < 10; i++, seqNum++) {
+        fillHistoryPacket(seqNum, packet, SIZEOF(packet));
+        EXPECT_EQ(STATUS_SUCCESS, rtp_history_put(pRtpHistory, packet, SIZEOF(packet), TEST_HISTORY_TIME));
+    }
+    for (i = 0, seqNum = 65530; i < 10; i++, seqNum++) {
+        length = SIZEOF(buffer);
+        EXPECT_EQ(i < 6 ? STATUS_NOT_FOUND : STATUS_SUCCESS, rtp_history_get(pRtpHistory, seqNum, TEST_HISTORY_TIME, buffer, &length));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_free(&pRtpHistory));
+}
+
+TEST_F(RtpHistoryFunctionalityTest, oldestPacketsAreDroppedWhenSlabRunsOut)
+{
+    PRtpHistory pRtpHistory = NULL;
+    BYTE packet[40], buffer[40];
+    UINT32 length;
+    UINT16 seqNum;
+
+    // room for 2 packets of 40 bytes, the third one goes to the start of the slab
+    ASSERT_EQ(STATUS_SUCCESS, rtp_history_create(16, 100, TEST_HISTORY_MAX_AGE_MSEC, &pRtpHistory));
+    for (seqNum = 0; seqNum < 3; seqNum++) {
+        fillHistoryPacket(seqNum, packet, SIZEOF(packet));
+        EXPECT_EQ(STATUS_SUCCESS, rtp_history_put(pRtpHistory, packet, SIZEOF(packet), TEST_HISTORY_TIME));
+    }
+    length = SIZEOF(buffer);
+    EXPECT_EQ(STATUS_NOT_FOUND, rtp_history_get(pRtpHistory, 0, TEST_HISTORY_TIME, buffer, &length));
+    for (seqNum = 1; seqNum < 3; seqNum++) {
+        length = SIZEOF(buffer);
+        EXPECT_EQ(STATUS_SUCCESS, rtp_history_get(pRtpHistory, seqNum, TEST_HISTORY_TIME, buffer, &length));
+        EXPECT_TRUE(isHistoryPacket(seqNum, buffer, length));
+    }
+
+    // the next packet takes the place of the oldest one
+    fillHistoryPacket(3, packet, SIZEOF(packet));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_put(pRtpHistory, packet, SIZEOF(packet), TEST_HISTORY_TIME));
+    length = SIZEOF(buffer);
+    EXPECT_EQ(STATUS_NOT_FOUND, rtp_history_get(pRtpHistory, 1, TEST_HISTORY_TIME, buffer, &length));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_get(pRtpHistory, 2, TEST_HISTORY_TIME, buffer, &length));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_get(pRtpHistory, 3, TEST_HISTORY_TIME, buffer, &length));
+    EXPECT_TRUE(isHistoryPacket(3, buffer, length));
+
+    EXPECT_NE(STATUS_SUCCESS, rtp_history_put(pRtpHistory, packet, 101, TEST_HISTORY_TIME));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_free(&pRtpHistory));
+}
+
+TEST_F(RtpHistoryFunctionalityTest, olderSequenceNumberStartsOver)
+{
+    PRtpHistory pRtpHistory = NULL;
+    BYTE packet[20], buffer[20];
+    UINT32 length;
+    UINT16 seqNum;
+
+    ASSERT_EQ(STATUS_SUCCESS, rtp_history_create(16, 1024, TEST_HISTORY_MAX_AGE_MSEC, &pRtpHistory));
+    for (seqNum = 100; seqNum < 105; seqNum++) {
+        fillHistoryPacket(seqNum, packet, SIZEOF(packet));
+        EXPECT_EQ(STATUS_SUCCESS, rtp_history_put(pRtpHistory, packet, SIZEOF(packet), TEST_HISTORY_TIME));
+    }
+    fillHistoryPacket(7, packet, SIZEOF(packet));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_put(pRtpHistory, packet, SIZEOF(packet), TEST_HISTORY_TIME));
+
+    length = SIZEOF(buffer);
+    EXPECT_EQ(STATUS_NOT_FOUND, rtp_history_get(pRtpHistory, 104, TEST_HISTORY_TIME, buffer, &length));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_get(pRtpHistory, 7, TEST_HISTORY_TIME, buffer, &length));
+    EXPECT_TRUE(isHistoryPacket(7, buffer, length));
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_free(&pRtpHistory));
+}
+
+TEST_F(RtpHistoryFunctionalityTest, packetsExpireAfterMaxAge)
+{
+    PRtpHistory pRtpHistory = NULL;
+    BYTE packet[20], buffer[20];
+    UINT32 length;
+    UINT16 seqNum;
+    UINT64 putTime = TEST_HISTORY_TIME;
+
+    ASSERT_EQ(STATUS_SUCCESS, rtp_history_create(16, 1024, TEST_HISTORY_MAX_AGE_MSEC, &pRtpHistory));
+    // a packet every 100ms
+    for (seqNum = 0; seqNum < 10; seqNum++, putTime += 100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND) {
+        fillHistoryPacket(seqNum, packet, SIZEOF(packet));
+        EXPECT_EQ(STATUS_SUCCESS, rtp_history_put(pRtpHistory, packet, SIZEOF(packet), putTime));
+    }
+
+    // 1s after the first one, it is only just kept
+    length = SIZEOF(buffer);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_get(pRtpHistory, 0, TEST_HISTORY_TIME + HUNDREDS_OF_NANOS_IN_A_SECOND, buffer, &length));
+    EXPECT_EQ(STATUS_NOT_FOUND, rtp_history_get(pRtpHistory, 0, TEST_HISTORY_TIME + HUNDREDS_OF_NANOS_IN_A_SECOND + 1, buffer, &length));
+
+    // a shorter round trip shortens the age, the expired packets are not returned before the writer drops them
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_setMaxAge(pRtpHistory, 250));
+    EXPECT_EQ(STATUS_NOT_FOUND, rtp_history_get(pRtpHistory, 5, putTime, buffer, &length));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_get(pRtpHistory, 8, putTime, buffer, &length));
+
+    // every put drops a few expired packets
+    fillHistoryPacket(seqNum, packet, SIZEOF(packet));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_put(pRtpHistory, packet, SIZEOF(packet), putTime));
+    EXPECT_EQ(4, pRtpHistory->oldestSequenceNumber);
+    fillHistoryPacket(++seqNum, packet, SIZEOF(packet));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_put(pRtpHistory, packet, SIZEOF(packet), putTime));
+    EXPECT_EQ(8, pRtpHistory->oldestSequenceNumber);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_get(pRtpHistory, 8, putTime, buffer, &length));
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_free(&pRtpHistory));
+}
+
+struct RtpHistoryReader {
+    PRtpHistory pRtpHistory;
+    volatile BOOL* pDone;
+    UINT64 found;
+    UINT64 torn;
+};
+
+static PVOID readRtpHistory(PVOID args)
+{
+    RtpHistoryReader* pReader = (RtpHistoryReader*) args;
+    BYTE buffer[256];
+    UINT32 length;
+    UINT16 seqNum = 0;
+
+    while (!*pReader->pDone) {
+        length = SIZEOF(buffer);
+        if (STATUS_SUCCEEDED(rtp_history_get(pReader->pRtpHistory, seqNum, TEST_HISTORY_TIME, buffer, &length))) {
+            pReader->found++;
+            if (!isHistoryPacket(seqNum, buffer, length)) {
+                pReader->torn++;
+            }
+        }
+        seqNum += 7;
+    }
+
+    return NULL;
+}
+
+TEST_F(RtpHistoryFunctionalityTest, readersNeverSeeTornPackets)
+{
+    PRtpHistory pRtpHistory = NULL;
+    BYTE packet[256];
+    volatile BOOL done = FALSE;
+    RtpHistoryReader readers[2];
+    TID threadIds[2];
+    UINT32 i, packetLength;
+    UINT16 seqNum = 0;
+
+    // a small slab is reused all the time under the readers
+    ASSERT_EQ(STATUS_SUCCESS, rtp_history_create(64, 2048, TEST_HISTORY_MAX_AGE_MSEC, &pRtpHistory));
+    for (i = 0; i < ARRAY_SIZE(readers); i++) {
+        readers[i] = {pRtpHistory, &done, 0, 0};
+        ASSERT_EQ(STATUS_SUCCESS, THREAD_CREATE(&threadIds[i], readRtpHistory, (PVOID) &readers[i]));
+    }
+
+    for (i = 0; i < 500000; i++, seqNum++) {
+        packetLength = MIN_HEADER_LENGTH + (seqNum * 31) % (SIZEOF(packet) - MIN_HEADER_LENGTH);
+        fillHistoryPacket(seqNum, packet, packetLength);
+        EXPECT_EQ(STATUS_SUCCESS, rtp_history_put(pRtpHistory, packet, packetLength, TEST_HISTORY_TIME));
+    }
+
+    done = TRUE;
+    for (i = 0; i < ARRAY_SIZE(readers); i++) {
+        THREAD_JOIN(threadIds[i], NULL);
+        EXPECT_EQ(0, readers[i].torn);
+        DLOGI("Reader %u found %llu packets", i, readers[i].found);
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_history_free(&pRtpHistory));
+}
+
+} // namespace webrtcclient
+} // namespace video
+} // namespace kinesis
+} // namespace amazonaws
+} // namespace com
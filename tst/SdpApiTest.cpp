@@ -232,13 +232,13 @@ TEST_F(SdpApiTest, setTransceiverPayloadTypes_NoRtxType)
     EXPECT_EQ(STATUS_SUCCESS, hashTableCreate(&pRtxTable));
     EXPECT_EQ(STATUS_SUCCESS, double_list_create(&pTransceivers));
     EXPECT_EQ(STATUS_SUCCESS, double_list_insertItemHead(pTransceivers, (UINT64)(&transceiver)));
-    EXPECT_EQ(STATUS_SUCCESS, sdp_setTransceiverPayloadTypes(pCodecTable, pRtxTable, pTransceivers));
+    EXPECT_EQ(STATUS_SUCCESS, sdp_setTransceiverPayloadTypes(pCodecTable, pRtxTable, pTransceivers, DEFAULT_RTP_HISTORY_MAX_PEER_BYTES));
     EXPECT_EQ(1, transceiver.sender.payloadType);
-    EXPECT_NE((PRtpRollingBuffer) NULL, transceiver.sender.packetBuffer);
+    EXPECT_NE((PRtpHistory) NULL, transceiver.sender.packetBuffer);
     EXPECT_NE((PRetransmitter) NULL, transceiver.sender.retransmitter);
     hash_table_free(pCodecTable);
     hash_table_free(pRtxTable);
-    rtp_rolling_buffer_free(&transceiver.sender.packetBuffer);
+    rtp_history_free(&transceiver.sender.packetBuffer);
     retransmitter_free(&transceiver.sender.retransmitter);
     doubleListFree(pTransceivers);
 }
@@ -259,14 +259,14 @@ TEST_F(SdpApiTest, setTransceiverPayloadTypes_HasRtxType)
     EXPECT_EQ(STATUS_SUCCESS, hash_table_put(pRtxTable, RTC_RTX_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE, 2));
     EXPECT_EQ(STATUS_SUCCESS, double_list_create(&pTransceivers));
     EXPECT_EQ(STATUS_SUCCESS, double_list_insertItemHead(pTransceivers, (UINT64)(&transceiver)));
-    EXPECT_EQ(STATUS_SUCCESS, sdp_setTransceiverPayloadTypes(pCodecTable, pRtxTable, pTransceivers));
+    EXPECT_EQ(STATUS_SUCCESS, sdp_setTransceiverPayloadTypes(pCodecTable, pRtxTable, pTransceivers, DEFAULT_RTP_HISTORY_MAX_PEER_BYTES));
     EXPECT_EQ(1, transceiver.sender.payloadType);
     EXPECT_EQ(2, transceiver.sender.rtxPayloadType);
-    EXPECT_NE((PRtpRollingBuffer) NULL, transceiver.sender.packetBuffer);
+    EXPECT_NE((PRtpHistory) NULL, transceiver.sender.packetBuffer);
     EXPECT_NE((PRetransmitter) NULL, transceiver.sender.retransmitter);
     hash_table_free(pCodecTable);
     hash_table_free(pRtxTable);
-    rtp_rolling_buffer_free(&transceiver.sender.packetBuffer);
+    rtp_history_free(&transceiver.sender.packetBuffer);
     retransmitter_free(&transceiver.sender.retransmitter);
     doubleListFree(pTransceivers);
 }
@@ -848,6 +848,242 @@ a=fmtp:102 strange
     });
 }
 
+TEST_F(SdpApiTest, setSendEncodings_InvalidEncodings)
+{
+    RtcConfiguration configuration{};
+    PRtcPeerConnection offerPc = nullptr;
+    RtcMediaStreamTrack videoTrack{}, audioTrack{};
+    PRtcRtpTransceiver pVideoTransceiver = nullptr, pAudioTransceiver = nullptr;
+    RtcRtpEncodingParameters encodings[MAX_RTP_SEND_ENCODINGS + 1]{};
+
+    videoTrack.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    videoTrack.codec = RTC_CODEC_VP8;
+    STRCPY(videoTrack.streamId, "myKvsVideoStream");
+    STRCPY(videoTrack.trackId, "myVideoTrack");
+    audioTrack.kind = MEDIA_STREAM_TRACK_KIND_AUDIO;
+    audioTrack.codec = RTC_CODEC_OPUS;
+    STRCPY(audioTrack.streamId, "myKvsVideoStream");
+    STRCPY(audioTrack.trackId, "myAudioTrack");
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_create(&configuration, &offerPc));
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(offerPc, &videoTrack, nullptr, &pVideoTransceiver));
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(offerPc, &audioTrack, nullptr, &pAudioTransceiver));
+
+    STRCPY(encodings[0].rid, "h");
+    STRCPY(encodings[1].rid, "m");
+    STRCPY(encodings[2].rid, "l");
+    STRCPY(encodings[3].rid, "x");
+
+    EXPECT_EQ(STATUS_RTP_NULL_ARG, rtp_transceiver_setSendEncodings(nullptr, encodings, 3));
+    EXPECT_EQ(STATUS_RTP_NULL_ARG, rtp_transceiver_setSendEncodings(pVideoTransceiver, nullptr, 3));
+    EXPECT_EQ(STATUS_RTP_INVALID_ENCODING, rtp_transceiver_setSendEncodings(pVideoTransceiver, encodings, 0));
+    EXPECT_EQ(STATUS_RTP_INVALID_ENCODING, rtp_transceiver_setSendEncodings(pVideoTransceiver, encodings, MAX_RTP_SEND_ENCODINGS + 1));
+    EXPECT_EQ(STATUS_RTP_INVALID_ENCODING, rtp_transceiver_setSendEncodings(pAudioTransceiver, encodings, 3));
+
+    // rids must be unique and alphanumeric
+    STRCPY(encodings[1].rid, "h");
+    EXPECT_EQ(STATUS_RTP_INVALID_ENCODING, rtp_transceiver_setSendEncodings(pVideoTransceiver, encodings, 3));
+    STRCPY(encodings[1].rid, "m;");
+    EXPECT_EQ(STATUS_RTP_INVALID_ENCODING, rtp_transceiver_setSendEncodings(pVideoTransceiver, encodings, 3));
+    STRCPY(encodings[1].rid, "");
+    EXPECT_EQ(STATUS_RTP_INVALID_ENCODING, rtp_transceiver_setSendEncodings(pVideoTransceiver, encodings, 3));
+
+    STRCPY(encodings[1].rid, "m");
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_setSendEncodings(pVideoTransceiver, encodings, 3));
+    // encodings can only be set once
+    EXPECT_EQ(STATUS_INVALID_OPERATION, rtp_transceiver_setSendEncodings(pVideoTransceiver, encodings, 3));
+
+    // the stats of every encoding carry its rid and its own ssrc
+    RtcOutboundRtpStreamStats stats[3];
+    for (UINT32 i = 0; i < 3; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_getSendEncodingStats(pVideoTransceiver, i, &stats[i]));
+        EXPECT_STREQ(encodings[i].rid, stats[i].rid);
+    }
+    EXPECT_EQ(((PKvsRtpTransceiver) pVideoTransceiver)->sender.ssrc, stats[0].sent.rtpStream.ssrc);
+    EXPECT_NE(stats[0].sent.rtpStream.ssrc, stats[1].sent.rtpStream.ssrc);
+    EXPECT_NE(stats[1].sent.rtpStream.ssrc, stats[2].sent.rtpStream.ssrc);
+    EXPECT_EQ(STATUS_RTP_INVALID_ENCODING, rtp_transceiver_getSendEncodingStats(pVideoTransceiver, 3, &stats[0]));
+
+    pc_close(offerPc);
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&offerPc));
+}
+
+TEST_F(SdpApiTest, setSendEncodings_SsrcsDoNotCollide)
+{
+    RtcConfiguration configuration{};
+    PRtcPeerConnection offerPc = nullptr;
+    PKvsPeerConnection pKvsPeerConnection = nullptr;
+    RtcMediaStreamTrack track{};
+    PRtcRtpTransceiver pTransceiver = nullptr, pOtherTransceiver = nullptr;
+    PRtcRtpSender pSender = nullptr;
+    RtcRtpEncodingParameters encodings[2]{};
+    UINT32 first, second;
+
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_VP8;
+    STRCPY(track.streamId, "myKvsVideoStream");
+    STRCPY(track.trackId, "myTrack");
+    STRCPY(encodings[0].rid, "h");
+    STRCPY(encodings[1].rid, "l");
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_create(&configuration, &offerPc));
+    pKvsPeerConnection = (PKvsPeerConnection) offerPc;
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(offerPc, &track, nullptr, &pTransceiver));
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(offerPc, &track, nullptr, &pOtherTransceiver));
+
+    // the next two random ssrcs already belong to the other transceiver
+    SRAND(42);
+    first = (UINT32) RAND();
+    second = (UINT32) RAND();
+    EXPECT_EQ(STATUS_SUCCESS, ssrc_map_put(pKvsPeerConnection->pSsrcMap, first, (UINT64) pOtherTransceiver));
+    EXPECT_EQ(STATUS_SUCCESS, ssrc_map_put(pKvsPeerConnection->pSsrcMap, second, (UINT64) pOtherTransceiver));
+    SRAND(42);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_setSendEncodings(pTransceiver, encodings, 2));
+
+    pSender = &((PKvsRtpTransceiver) pTransceiver)->sender;
+    EXPECT_NE(0, pSender->encodings[1].ssrc);
+    EXPECT_NE(first, pSender->encodings[1].ssrc);
+    EXPECT_NE(second, pSender->encodings[1].ssrc);
+    EXPECT_NE(first, pSender->encodings[1].rtxSsrc);
+    EXPECT_NE(second, pSender->encodings[1].rtxSsrc);
+    EXPECT_NE(pSender->encodings[1].ssrc, pSender->encodings[1].rtxSsrc);
+    EXPECT_NE(pSender->ssrc, pSender->encodings[1].ssrc);
+    EXPECT_NE(pSender->rtxSsrc, pSender->encodings[1].rtxSsrc);
+
+    pc_close(offerPc);
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&offerPc));
+}
+
+TEST_F(SdpApiTest, setSendEncodings_OfferContainsSimulcast)
+{
+    RtcConfiguration configuration{};
+    PRtcPeerConnection offerPc = nullptr;
+    RtcMediaStreamTrack track{};
+    PRtcRtpTransceiver pTransceiver = nullptr;
+    RtcSessionDescriptionInit sessionDescriptionInit{};
+    RtcRtpEncodingParameters encodings[3]{};
+
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
+    STRCPY(track.streamId, "myKvsVideoStream");
+    STRCPY(track.trackId, "myTrack");
+    STRCPY(encodings[0].rid, "h");
+    STRCPY(encodings[1].rid, "m");
+    STRCPY(encodings[2].rid, "l");
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_create(&configuration, &offerPc));
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(offerPc, &track, nullptr, &pTransceiver));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_setSendEncodings(pTransceiver, encodings, 3));
+    EXPECT_EQ(STATUS_SUCCESS, pc_createOffer(offerPc, &sessionDescriptionInit));
+
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:1 urn:ietf:params:rtp-hdrext:sdes:mid", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:2 urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:3 urn:ietf:params:rtp-hdrext:sdes:repaired-rtp-stream-id", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=rid:h send", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=rid:m send", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=rid:l send", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=simulcast:send h;m;l", sessionDescriptionInit.sdp);
+    EXPECT_STREQ("0", ((PKvsRtpTransceiver) pTransceiver)->sender.mid);
+    EXPECT_FALSE(((PKvsRtpTransceiver) pTransceiver)->sender.simulcastNegotiated);
+
+    pc_close(offerPc);
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&offerPc));
+}
+
+// the answer keeps simulcast only when the offer receives it, with the extension ids and the rids of the offer
+TEST_F(SdpApiTest, setSendEncodings_AnswerLatchesSimulcastFromOffer)
+{
+    auto offerHead = std::string(R"(v=0
+o=- 481034601 1588366671 IN IP4 0.0.0.0
+s=-
+t=0 0
+a=fingerprint:sha-256 87:E6:EC:59:93:76:9F:42:7D:15:17:F6:8F:C4:29:AB:EA:3F:28:B6:DF:F8:14:2F:96:62:2F:16:98:F5:76:E5
+a=group:BUNDLE 0
+)");
+    auto simulcastOffer = offerHead + sdpvideo + R"(
+a=extmap:4 urn:ietf:params:rtp-hdrext:sdes:mid
+a=extmap:10/recvonly urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id
+a=rid:h recv
+a=rid:l recv
+a=simulcast:recv h;l
+)";
+    auto plainOffer = offerHead + sdpvideo + "\n";
+    // the remote sends simulcast itself, it does not receive ours
+    auto sendOnlyOffer = offerHead + sdpvideo + R"(
+a=extmap:4 urn:ietf:params:rtp-hdrext:sdes:mid
+a=extmap:10 urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id
+a=rid:h send
+a=rid:l send
+a=simulcast:send h;l
+)";
+    // only l is received, h is paused and x is not one of ours
+    auto subsetOffer = offerHead + sdpvideo + R"(
+a=extmap:4 urn:ietf:params:rtp-hdrext:sdes:mid
+a=extmap:10/recvonly urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id
+a=rid:x send
+a=rid:h recv
+a=rid:l recv
+a=simulcast:send x recv ~h;l
+)";
+
+    auto createAnswer = [](PCHAR sdp, BOOL expectSimulcast, BOOL expectHigh, PCHAR expectedSimulcast) {
+        RtcConfiguration configuration{};
+        PRtcPeerConnection pRtcPeerConnection = nullptr;
+        RtcMediaStreamTrack track{};
+        PRtcRtpTransceiver pTransceiver = nullptr;
+        RtcSessionDescriptionInit offerSdp{};
+        RtcSessionDescriptionInit answerSdp{};
+        RtcRtpEncodingParameters encodings[2]{};
+
+        track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+        track.codec = RTC_CODEC_VP8;
+        STRNCPY(track.streamId, "track1", MAX_MEDIA_STREAM_ID_LEN);
+        STRNCPY(track.trackId, "track1", MAX_MEDIA_STREAM_ID_LEN);
+        STRCPY(encodings[0].rid, "h");
+        STRCPY(encodings[1].rid, "l");
+
+        offerSdp.type = SDP_TYPE_OFFER;
+        STRNCPY(offerSdp.sdp, sdp, MAX_SESSION_DESCRIPTION_INIT_SDP_LEN);
+
+        EXPECT_EQ(STATUS_SUCCESS, pc_create(&configuration, &pRtcPeerConnection));
+        EXPECT_EQ(STATUS_SUCCESS, pc_addSupportedCodec(pRtcPeerConnection, RTC_CODEC_VP8));
+        EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(pRtcPeerConnection, &track, nullptr, &pTransceiver));
+        EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_setSendEncodings(pTransceiver, encodings, 2));
+
+        EXPECT_EQ(STATUS_SUCCESS, pc_setRemoteDescription(pRtcPeerConnection, &offerSdp));
+        EXPECT_EQ(STATUS_SUCCESS, pc_createAnswer(pRtcPeerConnection, &answerSdp));
+
+        EXPECT_EQ(expectSimulcast, ((PKvsRtpTransceiver) pTransceiver)->sender.simulcastNegotiated);
+        if (expectSimulcast) {
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:4 urn:ietf:params:rtp-hdrext:sdes:mid", answerSdp.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:10 urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id", answerSdp.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsNotSubstring, "repaired-rtp-stream-id", answerSdp.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, expectedSimulcast, answerSdp.sdp);
+            EXPECT_EQ(expectHigh, ((PKvsRtpTransceiver) pTransceiver)->sender.encodings[0].accepted);
+            EXPECT_TRUE(((PKvsRtpTransceiver) pTransceiver)->sender.encodings[1].accepted);
+            if (expectHigh) {
+                EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=rid:h send", answerSdp.sdp);
+            } else {
+                EXPECT_PRED_FORMAT2(testing::IsNotSubstring, "a=rid:h", answerSdp.sdp);
+            }
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=rid:l send", answerSdp.sdp);
+        } else {
+            EXPECT_PRED_FORMAT2(testing::IsNotSubstring, "a=simulcast", answerSdp.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsNotSubstring, "a=rid", answerSdp.sdp);
+        }
+
+        pc_close(pRtcPeerConnection);
+        EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnection));
+    };
+
+    assertLFAndCRLF((PCHAR) simulcastOffer.c_str(), simulcastOffer.size(),
+                    [&](PCHAR sdp) { createAnswer(sdp, TRUE, TRUE, (PCHAR) "a=simulcast:send h;l"); });
+    assertLFAndCRLF((PCHAR) plainOffer.c_str(), plainOffer.size(), [&](PCHAR sdp) { createAnswer(sdp, FALSE, FALSE, nullptr); });
+    assertLFAndCRLF((PCHAR) sendOnlyOffer.c_str(), sendOnlyOffer.size(), [&](PCHAR sdp) { createAnswer(sdp, FALSE, FALSE, nullptr); });
+    assertLFAndCRLF((PCHAR) subsetOffer.c_str(), subsetOffer.size(),
+                    [&](PCHAR sdp) { createAnswer(sdp, TRUE, FALSE, (PCHAR) "a=simulcast:send l\r\n"); });
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
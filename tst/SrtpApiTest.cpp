@@ -76,6 +76,138 @@ TEST_F(SrtpApiTest, noSrtpKeyReturnsFailure)
     EXPECT_EQ(STATUS_SUCCESS, srtp_session_free(&pSrtpSession));
 }
 
+#define TEST_PIPELINE_PACKET_LEN 1200
+
+typedef struct {
+    volatile SIZE_T deliveredCount;
+    UINT32 failedCount;
+    UINT32 outOfOrderCount;
+    UINT16 nextSequenceNumber;
+} PipelineTestDelivery, *PPipelineTestDelivery;
+
+STATUS pipelineTestDeliver(UINT64 customData, PBYTE pPacket, UINT32 packetLen, UINT64 receivedTime, STATUS decryptStatus)
+{
+    UNUSED_PARAM(receivedTime);
+    PPipelineTestDelivery pDelivery = (PPipelineTestDelivery) customData;
+
+    if (STATUS_FAILED(decryptStatus) || packetLen != TEST_PIPELINE_PACKET_LEN) {
+        pDelivery->failedCount++;
+    }
+    if (getUnalignedInt16BigEndian(pPacket + SEQ_NUMBER_OFFSET) != pDelivery->nextSequenceNumber) {
+        pDelivery->outOfOrderCount++;
+    }
+    pDelivery->nextSequenceNumber = (UINT16) (getUnalignedInt16BigEndian(pPacket + SEQ_NUMBER_OFFSET) + 1);
+    MEMFREE(pPacket);
+    ATOMIC_INCREMENT(&pDelivery->deliveredCount);
+    return STATUS_SUCCESS;
+}
+
+// encrypted packets with consecutive sequence numbers from firstSequenceNumber, a sender does not encrypt one twice
+static VOID createEncryptedPackets(PSrtpSession pSrtpSession, UINT16 firstSequenceNumber, UINT32 packetCount, PBYTE* pPackets, PINT32 pLen)
+{
+    UINT32 i;
+
+    for (i = 0; i < packetCount; i++) {
+        pPackets[i] = (PBYTE) MEMCALLOC(1, TEST_PIPELINE_PACKET_LEN + SRTP_MAX_TRAILER_LEN);
+        MEMCPY(pPackets[i], SKEL_RTP_PACKET, SIZEOF(SKEL_RTP_PACKET));
+        putUnalignedInt16BigEndian(pPackets[i] + SEQ_NUMBER_OFFSET, (UINT16) (firstSequenceNumber + i));
+        *pLen = TEST_PIPELINE_PACKET_LEN;
+        EXPECT_EQ(STATUS_SUCCESS, srtp_session_encryptRtpPacket(pSrtpSession, pPackets[i], pLen));
+    }
+}
+
+TEST_F(SrtpApiTest, decryptPipelineDeliversInArrivalOrder)
+{
+    BYTE test_key[30] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+                         0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D};
+    const UINT32 packetCount = 1000;
+    PSrtpSession pSrtpSession = NULL;
+    PSrtpPipeline pSrtpPipeline = NULL;
+    PipelineTestDelivery delivery;
+    PBYTE packets[packetCount], pDuplicate;
+    INT32 len = 0;
+    UINT32 i;
+
+    MEMSET(&delivery, 0x00, SIZEOF(delivery));
+    EXPECT_EQ(STATUS_SUCCESS, srtp_session_initWithReceiveShards(test_key, test_key, DEFAULT_TEST_PROFILE, 4, &pSrtpSession));
+    EXPECT_EQ(STATUS_INVALID_ARG, srtp_pipeline_create(pSrtpSession, 5, 16, pipelineTestDeliver, (UINT64) &delivery, &pSrtpPipeline));
+    // a ring smaller than the packets makes the submitting thread wait for the delivery
+    EXPECT_EQ(STATUS_SUCCESS, srtp_pipeline_create(pSrtpSession, 4, 16, pipelineTestDeliver, (UINT64) &delivery, &pSrtpPipeline));
+
+    createEncryptedPackets(pSrtpSession, 0, packetCount, packets, &len);
+    pDuplicate = (PBYTE) MEMALLOC(len);
+    MEMCPY(pDuplicate, packets[0], len);
+    EXPECT_EQ(STATUS_SUCCESS, srtp_pipeline_submit(pSrtpPipeline, 0, packets[0], len, GETTIME()));
+    // a duplicate meets the receive shard which saw the original, whose replay window rejects it
+    EXPECT_EQ(STATUS_SUCCESS, srtp_pipeline_submit(pSrtpPipeline, 0, pDuplicate, len, GETTIME()));
+    for (i = 1; i < packetCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, srtp_pipeline_submit(pSrtpPipeline, (UINT16) i, packets[i], len, GETTIME()));
+    }
+    for (i = 0; i < 1000 && ATOMIC_LOAD(&delivery.deliveredCount) != packetCount + 1; i++) {
+        THREAD_SLEEP(HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    }
+
+    EXPECT_EQ(packetCount + 1, ATOMIC_LOAD(&delivery.deliveredCount));
+    EXPECT_EQ(1, delivery.failedCount);
+    EXPECT_EQ(1, delivery.outOfOrderCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, srtp_pipeline_free(&pSrtpPipeline));
+    EXPECT_EQ(STATUS_SUCCESS, srtp_pipeline_free(&pSrtpPipeline));
+    EXPECT_EQ(STATUS_SUCCESS, srtp_session_free(&pSrtpSession));
+}
+
+TEST_F(SrtpApiTest, benchmarkDecryptPipelineThroughput)
+{
+    BYTE test_key[30] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+                         0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D};
+    // about two seconds of a 40 Mbps stream
+    const UINT32 packetCount = 8000, workerCount = 4;
+    PSrtpSession pSrtpSession = NULL;
+    PSrtpPipeline pSrtpPipeline = NULL;
+    PipelineTestDelivery delivery;
+    PBYTE* pPackets = (PBYTE*) MEMCALLOC(packetCount, SIZEOF(PBYTE));
+    INT32 len = 0, decryptedLen;
+    UINT32 i;
+    UINT64 startTime, serialTime, pipelineTime;
+
+    MEMSET(&delivery, 0x00, SIZEOF(delivery));
+    EXPECT_EQ(STATUS_SUCCESS, srtp_session_initWithReceiveShards(test_key, test_key, DEFAULT_TEST_PROFILE, workerCount, &pSrtpSession));
+
+    // the serial path decrypts on the calling thread with the receive session
+    createEncryptedPackets(pSrtpSession, 0, packetCount, pPackets, &len);
+    startTime = GETTIME();
+    for (i = 0; i < packetCount; i++) {
+        decryptedLen = len;
+        EXPECT_EQ(STATUS_SUCCESS, srtp_session_decryptSrtpPacket(pSrtpSession, pPackets[i], &decryptedLen));
+        pipelineTestDeliver((UINT64) &delivery, pPackets[i], decryptedLen, startTime, STATUS_SUCCESS);
+    }
+    serialTime = GETTIME() - startTime;
+
+    MEMSET(&delivery, 0x00, SIZEOF(delivery));
+    delivery.nextSequenceNumber = packetCount;
+    EXPECT_EQ(STATUS_SUCCESS,
+              srtp_pipeline_create(pSrtpSession, workerCount, SRTP_PIPELINE_DEFAULT_DEPTH, pipelineTestDeliver, (UINT64) &delivery, &pSrtpPipeline));
+    createEncryptedPackets(pSrtpSession, packetCount, packetCount, pPackets, &len);
+    startTime = GETTIME();
+    for (i = 0; i < packetCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, srtp_pipeline_submit(pSrtpPipeline, (UINT16) (packetCount + i), pPackets[i], len, startTime));
+    }
+    while (ATOMIC_LOAD(&delivery.deliveredCount) != packetCount && GETTIME() - startTime < 10 * HUNDREDS_OF_NANOS_IN_A_SECOND) {
+        THREAD_SLEEP(HUNDREDS_OF_NANOS_IN_A_MICROSECOND * 100);
+    }
+    pipelineTime = GETTIME() - startTime;
+
+    EXPECT_EQ(packetCount, ATOMIC_LOAD(&delivery.deliveredCount));
+    EXPECT_EQ(0, delivery.failedCount);
+    EXPECT_EQ(0, delivery.outOfOrderCount);
+    DLOGI("Decrypting %u packets of %u bytes: serial %" PRIu64 " us, %u workers %" PRIu64 " us", packetCount, TEST_PIPELINE_PACKET_LEN,
+          serialTime / HUNDREDS_OF_NANOS_IN_A_MICROSECOND, workerCount, pipelineTime / HUNDREDS_OF_NANOS_IN_A_MICROSECOND);
+
+    EXPECT_EQ(STATUS_SUCCESS, srtp_pipeline_free(&pSrtpPipeline));
+    EXPECT_EQ(STATUS_SUCCESS, srtp_session_free(&pSrtpSession));
+    MEMFREE(pPackets);
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
@@ -0,0 +1,633 @@
+#include "WebRTCClientTestFixture.h"
+
+namespace com {
+namespace amazonaws {
+namespace kinesis {
+namespace video {
+namespace webrtcclient {
+
+#define TIMER_QUEUE_BENCHMARK_PEER_COUNT      100
+#define TIMER_QUEUE_BENCHMARK_TIMERS_PER_PEER 40
+#define TIMER_QUEUE_BENCHMARK_TIMER_COUNT     (TIMER_QUEUE_BENCHMARK_PEER_COUNT * TIMER_QUEUE_BENCHMARK_TIMERS_PER_PEER)
+#define TIMER_QUEUE_SHARED_PEER_COUNT         100
+#define TIMER_QUEUE_SHARED_TIMERS_PER_PEER    4
+
+class TimerQueueFunctionalityTest : public WebRtcClientTestBase {
+};
+
+typedef struct {
+    MUTEX lock;
+    UINT32 firedIds[DEFAULT_TIMER_QUEUE_TIMER_COUNT];
+    UINT32 firedCount;
+    TIMER_QUEUE_HANDLE timerQueueHandle;
+    UINT32 addedTimerId;
+    volatile SIZE_T invocationCount;
+    volatile SIZE_T runningCount;
+    UINT64 callbackDuration;
+    volatile STATUS addStatus;
+    volatile INT32 cpu;
+} TimerQueueTestContext, *PTimerQueueTestContext;
+
+static STATUS recordTimerCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(currentTime);
+    PTimerQueueTestContext pContext = (PTimerQueueTestContext) customData;
+
+    MUTEX_LOCK(pContext->lock);
+    if (pContext->firedCount < DEFAULT_TIMER_QUEUE_TIMER_COUNT) {
+        pContext->firedIds[pContext->firedCount++] = timerId;
+    }
+    MUTEX_UNLOCK(pContext->lock);
+
+    return STATUS_SUCCESS;
+}
+
+// cancels its own timer and adds a periodic one, which is handed the id that was just freed
+static STATUS replaceTimerCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(currentTime);
+    PTimerQueueTestContext pContext = (PTimerQueueTestContext) customData;
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimer(pContext->timerQueueHandle, timerId, customData));
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(pContext->timerQueueHandle, 10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, 10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
+                                   recordTimerCallback, customData, &pContext->addedTimerId));
+
+    return STATUS_SUCCESS;
+}
+
+static STATUS countTimerCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(timerId);
+    UNUSED_PARAM(currentTime);
+    ATOMIC_INCREMENT(&((PTimerQueueTestContext) customData)->invocationCount);
+
+    return STATUS_SUCCESS;
+}
+
+static STATUS recordCpuTimerCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(timerId);
+    UNUSED_PARAM(currentTime);
+    PTimerQueueTestContext pContext = (PTimerQueueTestContext) customData;
+
+#ifdef __linux__
+    pContext->cpu = sched_getcpu();
+#endif
+    ATOMIC_INCREMENT(&pContext->invocationCount);
+
+    return STATUS_SUCCESS;
+}
+
+static STATUS slowTimerCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(timerId);
+    UNUSED_PARAM(currentTime);
+    PTimerQueueTestContext pContext = (PTimerQueueTestContext) customData;
+
+    ATOMIC_INCREMENT(&pContext->runningCount);
+    THREAD_SLEEP(pContext->callbackDuration);
+    ATOMIC_INCREMENT(&pContext->invocationCount);
+    ATOMIC_DECREMENT(&pContext->runningCount);
+
+    return STATUS_SUCCESS;
+}
+
+// uses the timer queue from its own callback, then cancels its own timers including itself
+static STATUS reentrantTimerCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(currentTime);
+    PTimerQueueTestContext pContext = (PTimerQueueTestContext) customData;
+    UINT32 timerCount, newTimerCount;
+
+    ATOMIC_INCREMENT(&pContext->invocationCount);
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(pContext->timerQueueHandle, &timerCount));
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(pContext->timerQueueHandle, HUNDREDS_OF_NANOS_IN_A_SECOND, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD,
+                                   recordTimerCallback, customData, &pContext->addedTimerId));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(pContext->timerQueueHandle, &newTimerCount));
+    EXPECT_EQ(timerCount + 1, newTimerCount);
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_updateTimerPeriod(pContext->timerQueueHandle, customData, timerId, HUNDREDS_OF_NANOS_IN_A_SECOND));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimersByCustomData(pContext->timerQueueHandle, customData));
+
+    return STATUS_SUCCESS;
+}
+
+// reschedules itself like the rtcp reports do, the reschedule fails once the queue is shut down
+static STATUS rescheduleTimerCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(timerId);
+    UNUSED_PARAM(currentTime);
+    PTimerQueueTestContext pContext = (PTimerQueueTestContext) customData;
+
+    ATOMIC_INCREMENT(&pContext->runningCount);
+    THREAD_SLEEP(pContext->callbackDuration);
+    ATOMIC_INCREMENT(&pContext->invocationCount);
+    pContext->addStatus = timer_queue_addTimer(pContext->timerQueueHandle, MIN_TIMER_QUEUE_PERIOD_DURATION, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD,
+                                               rescheduleTimerCallback, customData, &pContext->addedTimerId);
+    ATOMIC_DECREMENT(&pContext->runningCount);
+
+    return STATUS_SUCCESS;
+}
+
+// the threads of the process, 0 when they can not be counted
+static UINT32 getThreadCount()
+{
+    UINT32 threadCount = 0;
+#ifdef __linux__
+    CHAR line[128];
+    FILE* pFile = FOPEN("/proc/self/status", "r");
+
+    if (pFile != NULL) {
+        while (threadCount == 0 && fgets(line, SIZEOF(line), pFile) != NULL) {
+            sscanf(line, "Threads: %u", &threadCount);
+        }
+        FCLOSE(pFile);
+    }
+#endif
+    return threadCount;
+}
+
+static BOOL waitForRunningCallback(PTimerQueueTestContext pContext)
+{
+    UINT32 i;
+
+    for (i = 0; i < 1000 && ATOMIC_LOAD(&pContext->runningCount) == 0; i++) {
+        THREAD_SLEEP(HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    }
+
+    return ATOMIC_LOAD(&pContext->runningCount) != 0;
+}
+
+TEST_F(TimerQueueFunctionalityTest, timersFireInInvokeTimeOrder)
+{
+    TIMER_QUEUE_HANDLE handle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    TimerQueueTestContext context;
+    UINT32 startMsec[] = {50, 10, 40, 20, 30}, expectedIds[] = {1, 3, 4, 2, 0};
+    UINT32 i, timerId, timerCount;
+
+    MEMSET(&context, 0x00, SIZEOF(context));
+    context.lock = MUTEX_CREATE(FALSE);
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_create(&handle));
+
+    for (i = 0; i < ARRAY_SIZE(startMsec); i++) {
+        EXPECT_EQ(STATUS_SUCCESS,
+                  timer_queue_addTimer(handle, startMsec[i] * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD,
+                                       recordTimerCallback, (UINT64) &context, &timerId));
+        EXPECT_EQ(i, timerId);
+    }
+    THREAD_SLEEP(200 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(handle, &timerCount));
+    EXPECT_EQ(0, timerCount);
+    MUTEX_LOCK(context.lock);
+    ASSERT_EQ(ARRAY_SIZE(expectedIds), context.firedCount);
+    for (i = 0; i < ARRAY_SIZE(expectedIds); i++) {
+        EXPECT_EQ(expectedIds[i], context.firedIds[i]);
+    }
+    MUTEX_UNLOCK(context.lock);
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handle));
+    MUTEX_FREE(context.lock);
+}
+
+TEST_F(TimerQueueFunctionalityTest, cancelAndUpdateKeepTheOrder)
+{
+    TIMER_QUEUE_HANDLE handle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    TimerQueueTestContext context;
+    UINT32 i, timerId, timerCount;
+
+    MEMSET(&context, 0x00, SIZEOF(context));
+    context.lock = MUTEX_CREATE(FALSE);
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_create(&handle));
+
+    // fill the queue with timers far out, the ids are handed out in order
+    for (i = 0; i < DEFAULT_TIMER_QUEUE_TIMER_COUNT; i++) {
+        EXPECT_EQ(STATUS_SUCCESS,
+                  timer_queue_addTimer(handle, (10 + i) * HUNDREDS_OF_NANOS_IN_A_SECOND, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, recordTimerCallback,
+                                       (UINT64) &context, &timerId));
+        EXPECT_EQ(i, timerId);
+    }
+    EXPECT_EQ(STATUS_MAX_TIMER_COUNT_REACHED,
+              timer_queue_addTimer(handle, 0, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, recordTimerCallback, (UINT64) &context, &timerId));
+
+    // a freed id is reused, the earliest and a middle timer are cancelled
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimer(handle, 0, (UINT64) &context));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimer(handle, 7, (UINT64) &context));
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(handle, 30 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, recordTimerCallback,
+                                   (UINT64) &context, &timerId));
+    EXPECT_EQ(7, timerId);
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(handle, &timerCount));
+    EXPECT_EQ(DEFAULT_TIMER_QUEUE_TIMER_COUNT - 1, timerCount);
+    // a far timer moved to the front of the queue, it fires once right away
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_updateTimerPeriod(handle, (UINT64) &context, 12, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD));
+
+    THREAD_SLEEP(100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    MUTEX_LOCK(context.lock);
+    ASSERT_EQ(2, context.firedCount);
+    EXPECT_EQ(12, context.firedIds[0]);
+    EXPECT_EQ(7, context.firedIds[1]);
+    MUTEX_UNLOCK(context.lock);
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimersByCustomData(handle, (UINT64) &context));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(handle, &timerCount));
+    EXPECT_EQ(0, timerCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handle));
+    MUTEX_FREE(context.lock);
+}
+
+TEST_F(TimerQueueFunctionalityTest, timerAddedWithTheIdOfTheFiringTimerIsKept)
+{
+    TimerQueueTestContext context;
+    UINT32 timerId, timerCount;
+
+    MEMSET(&context, 0x00, SIZEOF(context));
+    context.lock = MUTEX_CREATE(FALSE);
+    context.addedTimerId = MAX_UINT32;
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_create(&context.timerQueueHandle));
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(context.timerQueueHandle, 10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD,
+                                   replaceTimerCallback, (UINT64) &context, &timerId));
+    THREAD_SLEEP(100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+
+    // the single invocation timer is gone, the periodic one which took its id keeps firing
+    EXPECT_EQ(timerId, context.addedTimerId);
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(context.timerQueueHandle, &timerCount));
+    EXPECT_EQ(1, timerCount);
+    MUTEX_LOCK(context.lock);
+    EXPECT_LE(2, context.firedCount);
+    MUTEX_UNLOCK(context.lock);
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&context.timerQueueHandle));
+    MUTEX_FREE(context.lock);
+}
+
+TEST_F(TimerQueueFunctionalityTest, callbackUsesTheTimerQueueApis)
+{
+    TimerQueueTestContext context;
+    UINT32 timerId, timerCount;
+
+    MEMSET(&context, 0x00, SIZEOF(context));
+    context.lock = MUTEX_CREATE(FALSE);
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_create(&context.timerQueueHandle));
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(context.timerQueueHandle, 10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, 10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
+                                   reentrantTimerCallback, (UINT64) &context, &timerId));
+    THREAD_SLEEP(100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+
+    // the callback did not wait for itself, and its periodic timer is not rescheduled after it cancelled it
+    EXPECT_EQ(1, ATOMIC_LOAD(&context.invocationCount));
+    EXPECT_NE(timerId, context.addedTimerId);
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(context.timerQueueHandle, &timerCount));
+    EXPECT_EQ(0, timerCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&context.timerQueueHandle));
+    MUTEX_FREE(context.lock);
+}
+
+TEST_F(TimerQueueFunctionalityTest, slowCallbackDoesNotHoldUpTheTimerQueue)
+{
+    TIMER_QUEUE_HANDLE handle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    TimerQueueTestContext slowContext, context;
+    UINT32 slowTimerId, timerId, timerCount;
+    UINT64 startTime;
+
+    MEMSET(&slowContext, 0x00, SIZEOF(slowContext));
+    MEMSET(&context, 0x00, SIZEOF(context));
+    context.lock = MUTEX_CREATE(FALSE);
+    slowContext.callbackDuration = 300 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_create(&handle));
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(handle, 0, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, slowTimerCallback, (UINT64) &slowContext, &slowTimerId));
+    ASSERT_TRUE(waitForRunningCallback(&slowContext));
+
+    // the other timers are added, cancelled and counted while the slow callback runs
+    startTime = GETTIME();
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(handle, HUNDREDS_OF_NANOS_IN_A_SECOND, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, recordTimerCallback,
+                                   (UINT64) &context, &timerId));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(handle, &timerCount));
+    EXPECT_EQ(2, timerCount);
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimer(handle, timerId, (UINT64) &context));
+    EXPECT_GT(100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, GETTIME() - startTime);
+    EXPECT_EQ(1, ATOMIC_LOAD(&slowContext.runningCount));
+
+    // cancelling the running timer returns once its callback is done
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimer(handle, slowTimerId, (UINT64) &slowContext));
+    EXPECT_EQ(0, ATOMIC_LOAD(&slowContext.runningCount));
+    EXPECT_EQ(1, ATOMIC_LOAD(&slowContext.invocationCount));
+
+    // so does the shutdown
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(handle, 0, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, slowTimerCallback, (UINT64) &slowContext, &slowTimerId));
+    ASSERT_TRUE(waitForRunningCallback(&slowContext));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_shutdown(handle));
+    EXPECT_EQ(0, ATOMIC_LOAD(&slowContext.runningCount));
+    EXPECT_EQ(2, ATOMIC_LOAD(&slowContext.invocationCount));
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handle));
+    MUTEX_FREE(context.lock);
+}
+
+TEST_F(TimerQueueFunctionalityTest, cancelRacingTheCallbackStopsTheTimer)
+{
+    TIMER_QUEUE_HANDLE handle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    TimerQueueTestContext contexts[2];
+    UINT32 i, timerId, otherTimerId, timerCount;
+    SIZE_T invocationCount;
+
+    MEMSET(contexts, 0x00, SIZEOF(contexts));
+    contexts[0].callbackDuration = 2 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    contexts[1].callbackDuration = 2 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_create(&handle));
+
+    // the timers of another peer keep firing meanwhile
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(handle, 0, MIN_TIMER_QUEUE_PERIOD_DURATION, slowTimerCallback, (UINT64) &contexts[1], &otherTimerId));
+
+    for (i = 0; i < 50; i++) {
+        EXPECT_EQ(STATUS_SUCCESS,
+                  timer_queue_addTimer(handle, 0, MIN_TIMER_QUEUE_PERIOD_DURATION, slowTimerCallback, (UINT64) &contexts[0], &timerId));
+        THREAD_SLEEP((i % 5) * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+
+        if (i % 2 == 0) {
+            EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimer(handle, timerId, (UINT64) &contexts[0]));
+        } else {
+            EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimersByCustomData(handle, (UINT64) &contexts[0]));
+        }
+
+        // no callback of the cancelled timer runs once the cancel returned, the custom data could be freed here
+        EXPECT_EQ(0, ATOMIC_LOAD(&contexts[0].runningCount));
+        invocationCount = ATOMIC_LOAD(&contexts[0].invocationCount);
+        THREAD_SLEEP(5 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        EXPECT_EQ(invocationCount, ATOMIC_LOAD(&contexts[0].invocationCount));
+        EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(handle, &timerCount));
+        EXPECT_EQ(1, timerCount);
+    }
+
+    EXPECT_LT(0, ATOMIC_LOAD(&contexts[1].invocationCount));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelAllTimers(handle));
+    EXPECT_EQ(0, ATOMIC_LOAD(&contexts[1].runningCount));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handle));
+}
+
+TEST_F(TimerQueueFunctionalityTest, attachRefusedOnceTheReservedTimersFillTheQueue)
+{
+    TIMER_QUEUE_HANDLE sharedHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE, handles[TIMER_QUEUE_SHARED_PEER_COUNT + 1];
+    UINT32 i;
+
+    ASSERT_EQ(STATUS_SUCCESS,
+              timer_queue_createWithCapacity(&sharedHandle, NULL, 0, TIMER_QUEUE_SHARED_PEER_COUNT * TIMER_QUEUE_SHARED_TIMERS_PER_PEER));
+    for (i = 0; i < TIMER_QUEUE_SHARED_PEER_COUNT; i++) {
+        ASSERT_EQ(STATUS_SUCCESS, timer_queue_attachWithReserve(sharedHandle, TIMER_QUEUE_SHARED_TIMERS_PER_PEER, &handles[i]));
+    }
+
+    // nothing is left to promise, before any timer was added
+    EXPECT_EQ(STATUS_MAX_TIMER_COUNT_REACHED, timer_queue_attachWithReserve(sharedHandle, 1, &handles[TIMER_QUEUE_SHARED_PEER_COUNT]));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_attachWithReserve(sharedHandle, 0, &handles[TIMER_QUEUE_SHARED_PEER_COUNT]));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handles[TIMER_QUEUE_SHARED_PEER_COUNT]));
+
+    // a freed queue gives its timers back
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handles[0]));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_attachWithReserve(sharedHandle, TIMER_QUEUE_SHARED_TIMERS_PER_PEER, &handles[0]));
+
+    for (i = 0; i < TIMER_QUEUE_SHARED_PEER_COUNT; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handles[i]));
+    }
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&sharedHandle));
+}
+
+TEST_F(TimerQueueFunctionalityTest, reservedTimersAreLeftToTheirQueue)
+{
+    TIMER_QUEUE_HANDLE sharedHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE, greedyHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    TIMER_QUEUE_HANDLE reservedHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE, plainHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    TimerQueueTestContext context;
+    UINT32 i, timerId;
+
+    MEMSET(&context, 0x00, SIZEOF(context));
+    // one entry is left unreserved
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_createWithCapacity(&sharedHandle, NULL, 0, 2 * TIMER_QUEUE_SHARED_TIMERS_PER_PEER + 1));
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_attachWithReserve(sharedHandle, TIMER_QUEUE_SHARED_TIMERS_PER_PEER, &greedyHandle));
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_attachWithReserve(sharedHandle, TIMER_QUEUE_SHARED_TIMERS_PER_PEER, &reservedHandle));
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_attach(sharedHandle, &plainHandle));
+
+    // the greedy queue gets its reserve and the unreserved entry, not the reserve of the other queue
+    for (i = 0; i < TIMER_QUEUE_SHARED_TIMERS_PER_PEER + 1; i++) {
+        EXPECT_EQ(STATUS_SUCCESS,
+                  timer_queue_addTimer(greedyHandle, HUNDREDS_OF_NANOS_IN_AN_HOUR, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, countTimerCallback,
+                                       (UINT64) &context, &timerId));
+    }
+    EXPECT_EQ(STATUS_MAX_TIMER_COUNT_REACHED,
+              timer_queue_addTimer(greedyHandle, HUNDREDS_OF_NANOS_IN_AN_HOUR, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, countTimerCallback,
+                                   (UINT64) &context, &timerId));
+    EXPECT_EQ(STATUS_MAX_TIMER_COUNT_REACHED,
+              timer_queue_addTimer(plainHandle, HUNDREDS_OF_NANOS_IN_AN_HOUR, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, countTimerCallback,
+                                   (UINT64) &context, &timerId));
+    EXPECT_EQ(STATUS_MAX_TIMER_COUNT_REACHED,
+              timer_queue_addTimer(sharedHandle, HUNDREDS_OF_NANOS_IN_AN_HOUR, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, countTimerCallback,
+                                   (UINT64) &context, &timerId));
+    for (i = 0; i < TIMER_QUEUE_SHARED_TIMERS_PER_PEER; i++) {
+        EXPECT_EQ(STATUS_SUCCESS,
+                  timer_queue_addTimer(reservedHandle, HUNDREDS_OF_NANOS_IN_AN_HOUR, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, countTimerCallback,
+                                       (UINT64) &context, &timerId));
+    }
+    EXPECT_EQ(STATUS_MAX_TIMER_COUNT_REACHED,
+              timer_queue_addTimer(reservedHandle, HUNDREDS_OF_NANOS_IN_AN_HOUR, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, countTimerCallback,
+                                   (UINT64) &context, &timerId));
+
+    // the unreserved entry in use can not be promised to a new queue, it is free again once the greedy queue is gone
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&reservedHandle));
+    EXPECT_EQ(STATUS_MAX_TIMER_COUNT_REACHED, timer_queue_attachWithReserve(sharedHandle, TIMER_QUEUE_SHARED_TIMERS_PER_PEER + 1, &reservedHandle));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&greedyHandle));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_attachWithReserve(sharedHandle, 2 * TIMER_QUEUE_SHARED_TIMERS_PER_PEER + 1, &reservedHandle));
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&reservedHandle));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&plainHandle));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&sharedHandle));
+}
+
+TEST_F(TimerQueueFunctionalityTest, attachedQueuesShareOneThread)
+{
+    TIMER_QUEUE_HANDLE sharedHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE, handles[TIMER_QUEUE_SHARED_PEER_COUNT];
+    TimerQueueTestContext contexts[TIMER_QUEUE_SHARED_PEER_COUNT];
+    UINT32 i, j, timerId, timerCount, threadCount;
+    SIZE_T invocationCounts[TIMER_QUEUE_SHARED_PEER_COUNT];
+
+    MEMSET(contexts, 0x00, SIZEOF(contexts));
+    ASSERT_EQ(STATUS_SUCCESS,
+              timer_queue_createWithCapacity(&sharedHandle, NULL, 0, TIMER_QUEUE_SHARED_PEER_COUNT * TIMER_QUEUE_SHARED_TIMERS_PER_PEER));
+    threadCount = getThreadCount();
+
+    // every peer connection attaches and adds its keepalive and report timers
+    for (i = 0; i < TIMER_QUEUE_SHARED_PEER_COUNT; i++) {
+        ASSERT_EQ(STATUS_SUCCESS, timer_queue_attach(sharedHandle, &handles[i]));
+        for (j = 0; j < TIMER_QUEUE_SHARED_TIMERS_PER_PEER; j++) {
+            EXPECT_EQ(STATUS_SUCCESS,
+                      timer_queue_addTimer(handles[i], 0, (10 + j * 10) * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, countTimerCallback,
+                                           (UINT64) &contexts[i], &timerId));
+        }
+    }
+    EXPECT_EQ(threadCount, getThreadCount());
+    EXPECT_EQ(STATUS_MAX_TIMER_COUNT_REACHED,
+              timer_queue_addTimer(handles[0], 0, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, countTimerCallback, (UINT64) &contexts[0], &timerId));
+
+    // each queue only counts and cancels its own timers, even with the custom data of another one
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(handles[0], &timerCount));
+    EXPECT_EQ(TIMER_QUEUE_SHARED_TIMERS_PER_PEER, timerCount);
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(sharedHandle, &timerCount));
+    EXPECT_EQ(0, timerCount);
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimersByCustomData(handles[0], (UINT64) &contexts[1]));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(handles[1], &timerCount));
+    EXPECT_EQ(TIMER_QUEUE_SHARED_TIMERS_PER_PEER, timerCount);
+
+    THREAD_SLEEP(200 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+
+    // half of the peer connections go away, and the shared queue is freed before the others
+    for (i = 0; i < TIMER_QUEUE_SHARED_PEER_COUNT; i += 2) {
+        EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handles[i]));
+        EXPECT_FALSE(IS_VALID_TIMER_QUEUE_HANDLE(handles[i]));
+    }
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&sharedHandle));
+    for (i = 0; i < TIMER_QUEUE_SHARED_PEER_COUNT; i++) {
+        EXPECT_LT(0, ATOMIC_LOAD(&contexts[i].invocationCount));
+        invocationCounts[i] = ATOMIC_LOAD(&contexts[i].invocationCount);
+    }
+
+    THREAD_SLEEP(100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    for (i = 0; i < TIMER_QUEUE_SHARED_PEER_COUNT; i++) {
+        if (i % 2 == 0) {
+            EXPECT_EQ(invocationCounts[i], ATOMIC_LOAD(&contexts[i].invocationCount));
+        } else {
+            EXPECT_LT(invocationCounts[i], ATOMIC_LOAD(&contexts[i].invocationCount));
+        }
+    }
+
+    // the thread goes away with the last attached queue
+    for (i = 1; i < TIMER_QUEUE_SHARED_PEER_COUNT; i += 2) {
+        EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handles[i]));
+    }
+    for (i = 0; i < 100 && threadCount != 0 && getThreadCount() != threadCount - 1; i++) {
+        THREAD_SLEEP(HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    }
+    if (threadCount != 0) {
+        EXPECT_EQ(threadCount - 1, getThreadCount());
+    }
+}
+
+TEST_F(TimerQueueFunctionalityTest, executorRunsOnItsCpu)
+{
+    TIMER_QUEUE_HANDLE handle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    TimerQueueTestContext context;
+    UINT32 i, timerId;
+
+    MEMSET(&context, 0x00, SIZEOF(context));
+    context.cpu = THREAD_ANY_CPU;
+    EXPECT_NE(STATUS_SUCCESS, timer_queue_createOnCpu(&handle, NULL, 0, DEFAULT_TIMER_QUEUE_TIMER_COUNT, THREAD_ANY_CPU - 1));
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_createOnCpu(&handle, NULL, 0, DEFAULT_TIMER_QUEUE_TIMER_COUNT, 0));
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(handle, 0, MIN_TIMER_QUEUE_PERIOD_DURATION, recordCpuTimerCallback, (UINT64) &context, &timerId));
+    for (i = 0; i < 100 && ATOMIC_LOAD(&context.invocationCount) < 3; i++) {
+        THREAD_SLEEP(HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    }
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handle));
+
+    EXPECT_LE(3, ATOMIC_LOAD(&context.invocationCount));
+#ifdef __linux__
+    EXPECT_EQ(0, context.cpu);
+#endif
+}
+
+TEST_F(TimerQueueFunctionalityTest, attachedQueueShutdownWaitsForItsCallback)
+{
+    TIMER_QUEUE_HANDLE sharedHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    TimerQueueTestContext contexts[2];
+    UINT32 timerId, timerCount;
+    SIZE_T invocationCount;
+
+    MEMSET(contexts, 0x00, SIZEOF(contexts));
+    contexts[0].callbackDuration = 100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_create(&sharedHandle));
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_attach(sharedHandle, &contexts[0].timerQueueHandle));
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_attach(contexts[0].timerQueueHandle, &contexts[1].timerQueueHandle));
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(contexts[0].timerQueueHandle, 0, TIMER_QUEUE_SINGLE_INVOCATION_PERIOD, rescheduleTimerCallback,
+                                   (UINT64) &contexts[0], &timerId));
+    EXPECT_EQ(STATUS_SUCCESS,
+              timer_queue_addTimer(contexts[1].timerQueueHandle, 0, MIN_TIMER_QUEUE_PERIOD_DURATION, countTimerCallback, (UINT64) &contexts[1],
+                                   &timerId));
+    ASSERT_TRUE(waitForRunningCallback(&contexts[0]));
+
+    // the shutdown returns once the callback is done, its reschedule is refused so nothing outlives the peer connection
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_shutdown(contexts[0].timerQueueHandle));
+    EXPECT_EQ(0, ATOMIC_LOAD(&contexts[0].runningCount));
+    EXPECT_EQ(STATUS_TIMER_QUEUE_SHUTDOWN, contexts[0].addStatus);
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(contexts[0].timerQueueHandle, &timerCount));
+    EXPECT_EQ(0, timerCount);
+    EXPECT_EQ(1, FROM_TIMER_QUEUE_HANDLE(sharedHandle)->activeTimerCount);
+
+    // the other peer connection keeps its timer
+    invocationCount = ATOMIC_LOAD(&contexts[1].invocationCount);
+    THREAD_SLEEP(20 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    EXPECT_LT(invocationCount, ATOMIC_LOAD(&contexts[1].invocationCount));
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&contexts[0].timerQueueHandle));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&contexts[1].timerQueueHandle));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&sharedHandle));
+}
+
+TEST_F(TimerQueueFunctionalityTest, benchmarkThousandsOfTimersAcrossPeerConnections)
+{
+    TIMER_QUEUE_HANDLE handle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    TimerQueueTestContext contexts[TIMER_QUEUE_BENCHMARK_PEER_COUNT];
+    UINT32 i, j, timerId, timerCount;
+    UINT64 period, startTime, addTime, cancelTime;
+    SIZE_T invocationCount = 0;
+
+    MEMSET(contexts, 0x00, SIZEOF(contexts));
+    ASSERT_EQ(STATUS_SUCCESS, timer_queue_createWithCapacity(&handle, NULL, 0, TIMER_QUEUE_BENCHMARK_TIMER_COUNT));
+
+    // every peer connection has keepalives, rtcp and retransmission timers between 20 ms and 2 s
+    startTime = GETTIME();
+    for (i = 0; i < TIMER_QUEUE_BENCHMARK_PEER_COUNT; i++) {
+        for (j = 0; j < TIMER_QUEUE_BENCHMARK_TIMERS_PER_PEER; j++) {
+            period = (20 + (i * 7 + j * 13) % 1980) * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+            ASSERT_EQ(STATUS_SUCCESS, timer_queue_addTimer(handle, period, period, countTimerCallback, (UINT64) &contexts[i], &timerId));
+        }
+    }
+    addTime = GETTIME() - startTime;
+
+    THREAD_SLEEP(HUNDREDS_OF_NANOS_IN_A_SECOND);
+
+    // the peer connections go away one at a time
+    startTime = GETTIME();
+    for (i = 0; i < TIMER_QUEUE_BENCHMARK_PEER_COUNT; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimersByCustomData(handle, (UINT64) &contexts[i]));
+    }
+    cancelTime = GETTIME() - startTime;
+
+    for (i = 0; i < TIMER_QUEUE_BENCHMARK_PEER_COUNT; i++) {
+        invocationCount += ATOMIC_LOAD(&contexts[i].invocationCount);
+    }
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_getTimerCount(handle, &timerCount));
+    EXPECT_EQ(0, timerCount);
+    EXPECT_LT(0, invocationCount);
+    DLOGI("%u timers of %u peer connections: %" PRIu64 " ns per add, %" PRIu64 " ns per cancel, %u invocations in 1 s",
+          TIMER_QUEUE_BENCHMARK_TIMER_COUNT, TIMER_QUEUE_BENCHMARK_PEER_COUNT,
+          addTime * DEFAULT_TIME_UNIT_IN_NANOS / TIMER_QUEUE_BENCHMARK_TIMER_COUNT,
+          cancelTime * DEFAULT_TIME_UNIT_IN_NANOS / TIMER_QUEUE_BENCHMARK_TIMER_COUNT, (UINT32) invocationCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&handle));
+}
+
+} // namespace webrtcclient
+} // namespace video
+} // namespace kinesis
+} // namespace amazonaws
+} // namespace com